@@ -0,0 +1,1174 @@
+#include "PacketCapture.h"
+#include "../xLights/FSEQFile.h"
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/socket.h>
+#include <wx/stdpaths.h>
+
+#include <log4cpp/Category.hh>
+#include <zstd.h>
+
+#include <algorithm>
+#include <chrono>
+
+// This must be below the wx includes
+#ifdef __WXMSW__
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define INVALID_CAPTURESOCKET ((CaptureSocket)INVALID_SOCKET)
+    #define CLOSE_SOCKET(s) closesocket(s)
+#else
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define INVALID_CAPTURESOCKET ((CaptureSocket)-1)
+    #define CLOSE_SOCKET(s) close(s)
+#endif
+
+//#define DETAILED_LOGGING
+
+#define E131PORT 5568
+#define ARTNETPORT 0x1936
+
+// 32768 slots is a bit over a second of 800 universes at 25fps
+#define CAPTURE_RING_SIZE 32768
+#define CAPTURE_BATCH 64
+#define CAPTURE_RECEIVE_BUFFER (8 * 1024 * 1024)
+#define CAPTURE_SPOOL_BUFFER (1024 * 1024)
+#define CAPTURE_SPOOL_LEVEL 1
+#define CAPTURE_RESUMED 0x80000000
+
+static uint64_t NowUS()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool SetNonBlocking(CaptureSocket socket)
+{
+#ifdef __WXMSW__
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// How many output frames a captured frame occupies. Gaps longer than a frame mean
+// frames were lost so the previous data is held, except across a pause in capture.
+static int FramesToWrite(uint32_t last, uint32_t time, bool first, int frameMS)
+{
+    if (first || (time & CAPTURE_RESUMED) || frameMS <= 0) return 1;
+
+    int gap = (int)(time & ~CAPTURE_RESUMED) - (int)(last & ~CAPTURE_RESUMED);
+    int frames = (gap + frameMS / 2) / frameMS;
+    return std::max(1, frames);
+}
+
+class CaptureReceiveThread : public wxThread
+{
+    PacketCapture* _capture;
+
+public:
+    CaptureReceiveThread(PacketCapture* capture) : wxThread(wxTHREAD_JOINABLE), _capture(capture) { }
+
+    virtual void* Entry() override
+    {
+        _capture->ReceiveLoop();
+        return nullptr;
+    }
+};
+
+class CaptureAssemblerThread : public wxThread
+{
+    PacketCapture* _capture;
+
+public:
+    CaptureAssemblerThread(PacketCapture* capture) : wxThread(wxTHREAD_JOINABLE), _capture(capture) { }
+
+    virtual void* Entry() override
+    {
+        _capture->AssembleLoop();
+        return nullptr;
+    }
+};
+
+// Pulls exactly the requested number of bytes out of the compressed spool
+class SpoolReader
+{
+    FILE* _file;
+    ZSTD_DStream* _dstream;
+    std::vector<uint8_t> _buffer;
+    ZSTD_inBuffer _in;
+
+public:
+    SpoolReader(FILE* file) : _file(file), _buffer(CAPTURE_SPOOL_BUFFER)
+    {
+        _dstream = ZSTD_createDStream();
+        ZSTD_initDStream(_dstream);
+        _in.src = _buffer.data();
+        _in.size = 0;
+        _in.pos = 0;
+    }
+    virtual ~SpoolReader()
+    {
+        ZSTD_freeDStream(_dstream);
+    }
+
+    bool Read(void* data, size_t length)
+    {
+        ZSTD_outBuffer out = { data, length, 0 };
+        while (out.pos < out.size)
+        {
+            if (_in.pos == _in.size)
+            {
+                size_t read = fread(_buffer.data(), 1, _buffer.size(), _file);
+                if (read == 0) return false;
+                _in.src = _buffer.data();
+                _in.size = read;
+                _in.pos = 0;
+            }
+            size_t rc = ZSTD_decompressStream(_dstream, &out, &_in);
+            if (ZSTD_isError(rc)) return false;
+        }
+        return true;
+    }
+};
+
+bool Collector::operator<(const Collector& c) const
+{
+    if (_universe == c._universe)
+    {
+        return _protocol == CAPTURE_PROTOCOL_E131 && c._protocol != CAPTURE_PROTOCOL_E131;
+    }
+
+    return _universe < c._universe;
+}
+
+PacketCapture::PacketCapture() :
+    _receiveThread(nullptr),
+    _ringMask(CAPTURE_RING_SIZE - 1),
+    _ringHead(0),
+    _ringTail(0),
+    _stopReceive(false),
+    _droppedPackets(0),
+    _assemblerThread(nullptr),
+    _stopAssembler(false),
+    _capturing(false),
+    _capturedPackets(0),
+    _frames(0),
+    _captureAll(false),
+    _triggerEnabled(false),
+    _triggerUniverse(0),
+    _triggerChannel(0),
+    _triggerStart(0),
+    _frameOpen(false),
+    _resumed(false),
+    _syncSeen(false),
+    _captureStartUS(0),
+    _frameStartUS(0),
+    _lastFrameStartUS(0),
+    _lastPacketUS(0),
+    _intervalEstimateUS(0),
+    _spool(nullptr),
+    _cctx(nullptr)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    // makes sure the platform socket library is started
+    wxSocketBase::Initialize();
+
+    _sockets[CAPTURE_PROTOCOL_E131] = INVALID_CAPTURESOCKET;
+    _sockets[CAPTURE_PROTOCOL_ARTNET] = INVALID_CAPTURESOCKET;
+
+    _ring = new CapturePacket[CAPTURE_RING_SIZE];
+
+    _assemblerThread = new CaptureAssemblerThread(this);
+    if (_assemblerThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        logger_base.error("Unable to start capture assembler thread.");
+        delete _assemblerThread;
+        _assemblerThread = nullptr;
+    }
+}
+
+PacketCapture::~PacketCapture()
+{
+    StopReceiveThread();
+
+    if (_assemblerThread != nullptr)
+    {
+        _stopAssembler = true;
+        _wakeSignal.notify_all();
+        _assemblerThread->Wait();
+        delete _assemblerThread;
+        _assemblerThread = nullptr;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (_sockets[i] != INVALID_CAPTURESOCKET)
+        {
+            CLOSE_SOCKET(_sockets[i]);
+            _sockets[i] = INVALID_CAPTURESOCKET;
+        }
+    }
+
+    Clear();
+
+    delete[] _ring;
+}
+
+#pragma region Sockets
+
+void PacketCapture::StartReceiveThread()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (_receiveThread != nullptr || !IsListening()) return;
+
+    _stopReceive = false;
+    _receiveThread = new CaptureReceiveThread(this);
+    if (_receiveThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        logger_base.error("Unable to start capture receive thread.");
+        delete _receiveThread;
+        _receiveThread = nullptr;
+    }
+}
+
+void PacketCapture::StopReceiveThread()
+{
+    if (_receiveThread == nullptr) return;
+
+    _stopReceive = true;
+    _receiveThread->Wait();
+    delete _receiveThread;
+    _receiveThread = nullptr;
+}
+
+bool PacketCapture::Listen(long protocol, const std::string& localIP, const std::vector<std::pair<int, int>>& multicastUniverses)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (IsListening(protocol)) return true;
+
+    const char* name = protocol == CAPTURE_PROTOCOL_E131 ? "E131" : "ARTNet";
+
+    CaptureSocket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_CAPTURESOCKET)
+    {
+        logger_base.warn("Error creating socket to listen for %s data.", name);
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+    // give the kernel room to hold a few frames if we are briefly descheduled
+    int bufferSize = CAPTURE_RECEIVE_BUFFER;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char *)&bufferSize, sizeof(bufferSize));
+
+    sockaddr_in addr;
+    memset(&addr, 0x00, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(protocol == CAPTURE_PROTOCOL_E131 ? E131PORT : ARTNETPORT);
+
+    if (bind(s, (sockaddr *)&addr, sizeof(addr)) != 0 || !SetNonBlocking(s))
+    {
+        logger_base.warn("Error opening socket to listen for %s data.", name);
+        CLOSE_SOCKET(s);
+        return false;
+    }
+
+    logger_base.debug("%s listening on %s", name, (const char*)localIP.c_str());
+
+    for (auto it = multicastUniverses.begin(); it != multicastUniverses.end(); ++it)
+    {
+        for (int u = it->first; u <= it->second; u++)
+        {
+            struct ip_mreq mreq;
+            wxString ip = wxString::Format("239.255.%d.%d", u >> 8, u & 0xFF);
+            logger_base.debug("%s registering for multicast on %s.", name, (const char *)ip.c_str());
+            mreq.imr_multiaddr.s_addr = inet_addr(ip.c_str());
+            mreq.imr_interface.s_addr = inet_addr(localIP.c_str()); // this will only listen on the default interface
+            if (setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&mreq, sizeof(mreq)) != 0)
+            {
+                logger_base.warn("    Error opening %s multicast listener %s.", name, (const char *)ip.c_str());
+            }
+        }
+    }
+
+    // the receive thread polls a fixed socket set so swap it while the thread is down
+    StopReceiveThread();
+    _sockets[protocol] = s;
+    StartReceiveThread();
+
+    return true;
+}
+
+void PacketCapture::CloseListener(long protocol)
+{
+    if (!IsListening(protocol)) return;
+
+    StopReceiveThread();
+    CLOSE_SOCKET(_sockets[protocol]);
+    _sockets[protocol] = INVALID_CAPTURESOCKET;
+    StartReceiveThread();
+}
+
+bool PacketCapture::IsListening(long protocol) const
+{
+    return _sockets[protocol] != INVALID_CAPTURESOCKET;
+}
+
+#pragma endregion
+
+#pragma region Receive
+
+// Reads whatever is waiting on the socket straight into free ring slots
+void PacketCapture::ReceiveBatch(long protocol)
+{
+    CaptureSocket s = _sockets[protocol];
+
+    for (;;)
+    {
+        uint32_t head = _ringHead.load(std::memory_order_relaxed);
+        uint32_t tail = _ringTail.load(std::memory_order_acquire);
+        uint32_t space = CAPTURE_RING_SIZE - (head - tail);
+
+        if (space == 0)
+        {
+            // the assembler has fallen behind ... count what we throw away
+            uint8_t scratch[CAPTURE_MAX_PACKET];
+            while (recv(s, (char*)scratch, sizeof(scratch), 0) > 0)
+            {
+                _droppedPackets++;
+            }
+            return;
+        }
+
+        int count = std::min((int)space, CAPTURE_BATCH);
+        int received = 0;
+
+#ifdef __linux__
+        struct mmsghdr msgs[CAPTURE_BATCH];
+        struct iovec iovs[CAPTURE_BATCH];
+        memset(msgs, 0x00, sizeof(struct mmsghdr) * count);
+        for (int i = 0; i < count; i++)
+        {
+            iovs[i].iov_base = _ring[(head + i) & _ringMask]._data;
+            iovs[i].iov_len = CAPTURE_MAX_PACKET;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        received = recvmmsg(s, msgs, count, MSG_DONTWAIT, nullptr);
+        if (received <= 0) return;
+
+        uint64_t now = NowUS();
+        for (int i = 0; i < received; i++)
+        {
+            CapturePacket& p = _ring[(head + i) & _ringMask];
+            p._timeUS = now;
+            p._length = msgs[i].msg_len;
+            p._protocol = protocol;
+        }
+#else
+        while (received < count)
+        {
+            CapturePacket& p = _ring[(head + received) & _ringMask];
+            int n = recv(s, (char*)p._data, CAPTURE_MAX_PACKET, 0);
+            if (n <= 0) break;
+            p._timeUS = NowUS();
+            p._length = n;
+            p._protocol = protocol;
+            received++;
+        }
+        if (received == 0) return;
+#endif
+
+        _ringHead.store(head + received, std::memory_order_release);
+        _wakeSignal.notify_one();
+
+        // a short batch means the socket is drained
+        if (received < count) return;
+    }
+}
+
+void PacketCapture::ReceiveLoop()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.debug("Capture receive thread started.");
+
+    while (!_stopReceive)
+    {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        CaptureSocket maxSocket = 0;
+        for (int i = 0; i < 2; i++)
+        {
+            if (_sockets[i] != INVALID_CAPTURESOCKET)
+            {
+                FD_SET(_sockets[i], &readSet);
+                maxSocket = std::max(maxSocket, _sockets[i]);
+            }
+        }
+
+        // wake up regularly so we notice when we are asked to stop
+        timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 100000;
+        if (select((int)maxSocket + 1, &readSet, nullptr, nullptr, &timeout) <= 0) continue;
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (_sockets[i] != INVALID_CAPTURESOCKET && FD_ISSET(_sockets[i], &readSet))
+            {
+                ReceiveBatch(i);
+            }
+        }
+    }
+
+    logger_base.debug("Capture receive thread stopped.");
+}
+
+#pragma endregion
+
+#pragma region Assembly
+
+// How long the wire has to be quiet before we decide a frame is complete
+uint64_t PacketCapture::QuietUS() const
+{
+    if (_intervalEstimateUS <= 0) return 10000;
+
+    // when the sender uses sync packets we only fall back to the quiet time if syncs go missing
+    if (_syncSeen) return (uint64_t)(_intervalEstimateUS * 3);
+
+    return std::max((uint64_t)3000, (uint64_t)(_intervalEstimateUS * 0.4));
+}
+
+void PacketCapture::AssembleLoop()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.debug("Capture assembler thread started.");
+
+    while (!_stopAssembler)
+    {
+        uint32_t tail = _ringTail.load(std::memory_order_relaxed);
+        uint32_t head = _ringHead.load(std::memory_order_acquire);
+
+        if (tail == head)
+        {
+            {
+                std::unique_lock<std::mutex> wl(_wakeLock);
+                _wakeSignal.wait_for(wl, std::chrono::milliseconds(2));
+            }
+
+            std::lock_guard<std::recursive_mutex> lock(_lock);
+            if (_frameOpen && NowUS() - _lastPacketUS > QuietUS())
+            {
+                CloseFrame();
+            }
+            continue;
+        }
+
+        // dont hold the lock for too long so the UI stays responsive
+        if (head - tail > 1024) head = tail + 1024;
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(_lock);
+            for (; tail != head; ++tail)
+            {
+                ProcessPacket(_ring[tail & _ringMask]);
+            }
+        }
+        _ringTail.store(tail, std::memory_order_release);
+    }
+
+    logger_base.debug("Capture assembler thread stopped.");
+}
+
+void PacketCapture::ProcessPacket(const CapturePacket& p)
+{
+    const uint8_t* d = p._data;
+    int len = p._length;
+
+    if (p._protocol == CAPTURE_PROTOCOL_E131)
+    {
+        if (len < 22) return;
+        if (memcmp(&d[4], "ASC-E1.17", 9) != 0) return;
+
+        uint32_t rootVector = ((uint32_t)d[18] << 24) + ((uint32_t)d[19] << 16) + ((uint32_t)d[20] << 8) + d[21];
+
+        // VECTOR_ROOT_E131_EXTENDED carries sync packets
+        if (rootVector == 0x08)
+        {
+            if (len >= 44 && d[40] == 0 && d[41] == 0 && d[42] == 0 && d[43] == 0x01)
+            {
+                OnSync();
+            }
+            return;
+        }
+
+        if (rootVector != 0x04 || len < 126) return;
+
+        // only the null start code carries levels ... 0xDD is per address priority
+        if (d[125] != 0x00) return;
+
+        int universe = ((int)d[113] << 8) + (int)d[114];
+        int length = ((((int)d[115] & 0x0F) << 8) + (int)d[116]) - 11;
+        if (length > len - 126)
+        {
+            static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+            logger_base.warn("E131 packet of claimed length %d truncated to actual packet length %d.", length, len - 126);
+            length = len - 126;
+        }
+        ProcessDataPacket(CAPTURE_PROTOCOL_E131, universe, d[111], &d[126], length, p._timeUS);
+    }
+    else
+    {
+        if (len < 10) return;
+        if (memcmp(d, "Art-Net", 8) != 0) return;
+
+        int opcode = (int)d[8] + ((int)d[9] << 8);
+
+        if (opcode == 0x5200)
+        {
+            // ArtSync
+            OnSync();
+            return;
+        }
+
+        if (opcode != 0x5000 || len < 18) return;
+
+        int universe = ((int)d[15] << 8) + (int)d[14];
+        int length = ((int)d[16] << 8) + (int)d[17];
+        if (length > len - 18)
+        {
+            static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+            logger_base.warn("ArtNet packet of claimed length %d truncated to actual packet length %d.", length, len - 18);
+            length = len - 18;
+        }
+        ProcessDataPacket(CAPTURE_PROTOCOL_ARTNET, universe, d[12], &d[18], length, p._timeUS);
+    }
+}
+
+void PacketCapture::OnSync()
+{
+    if (!_syncSeen)
+    {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        logger_base.debug("Sync packets detected. Using them to mark frame boundaries.");
+        _syncSeen = true;
+    }
+
+    if (_capturing)
+    {
+        CloseFrame();
+    }
+}
+
+void PacketCapture::CheckTrigger(int universe, const uint8_t* data, int length)
+{
+    if (universe != _triggerUniverse) return;
+
+    int channel = _triggerChannel - 1;
+    if (channel < 0 || channel >= length) return;
+
+    bool on = data[channel] >= _triggerStart;
+    if (on == _capturing) return;
+
+    if (on)
+    {
+        Resume();
+    }
+    else
+    {
+        _capturing = false;
+        Pause();
+    }
+
+    if (_onTriggered) _onTriggered(on);
+}
+
+bool PacketCapture::IsUniverseToBeCaptured(int universe) const
+{
+    if (_captureAll) return true;
+
+    for (auto it = _universeRanges.begin(); it != _universeRanges.end(); ++it)
+    {
+        if (universe >= it->first && universe <= it->second) return true;
+    }
+
+    return false;
+}
+
+void PacketCapture::ProcessDataPacket(long protocol, int universe, int seq, const uint8_t* data, int length, uint64_t timeUS)
+{
+    if (_triggerEnabled) CheckTrigger(universe, data, length);
+
+    if (!_capturing) return;
+
+    if (length < 0) length = 0;
+    if (length > CAPTURE_UNIVERSE_SIZE) length = CAPTURE_UNIVERSE_SIZE;
+
+    uint32_t key = ((uint32_t)protocol << 16) + (uint32_t)universe;
+    Collector* c = nullptr;
+    auto it = _collectorIndex.find(key);
+    if (it == _collectorIndex.end())
+    {
+        // remember universes we are ignoring too so we only check the list once
+        if (IsUniverseToBeCaptured(universe))
+        {
+            c = new Collector(protocol, universe, (int)_collectors.size());
+            _collectors.push_back(c);
+            _frame.resize(_collectors.size() * CAPTURE_UNIVERSE_SIZE, 0x00);
+            _present.resize(_collectors.size(), 0);
+        }
+        _collectorIndex[key] = c;
+    }
+    else
+    {
+        c = it->second;
+    }
+
+    if (c == nullptr) return;
+
+    if (_frameOpen)
+    {
+        // a quiet wire or a universe we already have both mean the last frame is done
+        if (timeUS - _lastPacketUS > QuietUS() || _present[c->_slot])
+        {
+            CloseFrame();
+        }
+    }
+
+    if (!_frameOpen)
+    {
+        _frameOpen = true;
+        _frameStartUS = timeUS;
+    }
+    _lastPacketUS = timeUS;
+
+    memcpy(&_frame[c->_slot * CAPTURE_UNIVERSE_SIZE], data, length);
+    _present[c->_slot] = 1;
+
+    if (length > c->_size) c->_size = length;
+
+    // artnet uses a sequence of 0 to mean sequencing is disabled
+    if (c->_lastSeq >= 0 && !(protocol == CAPTURE_PROTOCOL_ARTNET && seq == 0))
+    {
+        int expected = (c->_lastSeq + 1) & 0xFF;
+        if (protocol == CAPTURE_PROTOCOL_ARTNET && expected == 0) expected = 1;
+        if (seq != expected)
+        {
+            int missed = (seq - expected) & 0xFF;
+#ifdef DETAILED_LOGGING
+            static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+            logger_base.debug("Universe %d missing %d packets from sequence %d", universe, missed, expected);
+#endif
+            c->_missedPackets += missed;
+        }
+    }
+    c->_lastSeq = seq;
+
+    c->_packets++;
+    if (c->_firstFrame < 0) c->_firstFrame = _frames;
+    c->_lastFrame = _frames;
+    _capturedPackets++;
+}
+
+void PacketCapture::CloseFrame()
+{
+    if (!_frameOpen) return;
+    _frameOpen = false;
+
+    if (!_frameTimes.empty() && !_resumed)
+    {
+        double interval = (double)(_frameStartUS - _lastFrameStartUS);
+        _intervalEstimateUS = _intervalEstimateUS <= 0 ? interval : _intervalEstimateUS * 0.9 + interval * 0.1;
+    }
+    _lastFrameStartUS = _frameStartUS;
+
+    uint32_t header[2];
+    header[0] = (uint32_t)((_frameStartUS - _captureStartUS) / 1000) | (_resumed ? CAPTURE_RESUMED : 0);
+    header[1] = (uint32_t)_collectors.size();
+    _frameTimes.push_back(header[0]);
+    _resumed = false;
+
+    // universes missing from this frame keep their previous levels
+    WriteSpool(header, sizeof(header), false);
+    WriteSpool(_frame.data(), _frame.size(), false);
+
+    std::fill(_present.begin(), _present.end(), 0);
+    _frames++;
+}
+
+#pragma endregion
+
+#pragma region Spool
+
+bool PacketCapture::OpenSpool()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (_spool != nullptr) return true;
+
+    _spoolFile = wxFileName::CreateTempFileName(wxStandardPaths::Get().GetTempDir() + wxFileName::GetPathSeparator() + "xCapture").ToStdString();
+    if (_spoolFile == "")
+    {
+        logger_base.error("Unable to create capture spool file.");
+        return false;
+    }
+
+    _spool = fopen(_spoolFile.c_str(), "wb");
+    if (_spool == nullptr)
+    {
+        logger_base.error("Unable to open capture spool file %s.", (const char*)_spoolFile.c_str());
+        wxRemoveFile(_spoolFile);
+        _spoolFile = "";
+        return false;
+    }
+
+    _cctx = ZSTD_createCStream();
+    ZSTD_initCStream(_cctx, CAPTURE_SPOOL_LEVEL);
+    _spoolBuffer.resize(CAPTURE_SPOOL_BUFFER);
+
+    logger_base.debug("Capturing to spool file %s.", (const char*)_spoolFile.c_str());
+
+    return true;
+}
+
+void PacketCapture::WriteSpool(const void* data, size_t length, bool flush)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (_spool == nullptr) return;
+
+    ZSTD_inBuffer in = { data, length, 0 };
+    ZSTD_outBuffer out = { _spoolBuffer.data(), _spoolBuffer.size(), 0 };
+
+    while (in.pos < in.size)
+    {
+        size_t rc = ZSTD_compressStream(_cctx, &out, &in);
+        if (ZSTD_isError(rc))
+        {
+            logger_base.error("Error compressing capture data: %s", ZSTD_getErrorName(rc));
+            return;
+        }
+        if (out.pos == out.size)
+        {
+            fwrite(out.dst, 1, out.pos, _spool);
+            out.pos = 0;
+        }
+    }
+
+    if (flush)
+    {
+        size_t remaining = 0;
+        do
+        {
+            remaining = ZSTD_flushStream(_cctx, &out);
+            fwrite(out.dst, 1, out.pos, _spool);
+            out.pos = 0;
+        } while (remaining > 0 && !ZSTD_isError(remaining));
+        fflush(_spool);
+    }
+    else if (out.pos > 0)
+    {
+        fwrite(out.dst, 1, out.pos, _spool);
+    }
+}
+
+void PacketCapture::CloseSpool()
+{
+    if (_spool != nullptr)
+    {
+        fclose(_spool);
+        _spool = nullptr;
+    }
+
+    if (_cctx != nullptr)
+    {
+        ZSTD_freeCStream(_cctx);
+        _cctx = nullptr;
+    }
+
+    if (_spoolFile != "")
+    {
+        wxRemoveFile(_spoolFile);
+        _spoolFile = "";
+    }
+
+    _spoolBuffer.clear();
+    _spoolBuffer.shrink_to_fit();
+}
+
+bool PacketCapture::ReplaySpool(int frameMS, long channelsPerFrame, const FrameWriter& writer)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::list<Collector> collectors;
+    std::string spoolFile;
+    size_t frames = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_lock);
+        // make sure everything captured so far is readable
+        CloseFrame();
+        WriteSpool(nullptr, 0, true);
+        for (auto it = _collectors.begin(); it != _collectors.end(); ++it)
+        {
+            collectors.push_back(**it);
+        }
+        spoolFile = _spoolFile;
+        frames = _frameTimes.size();
+    }
+
+    FILE* in = spoolFile == "" ? nullptr : fopen(spoolFile.c_str(), "rb");
+    if (in == nullptr)
+    {
+        logger_base.error("Unable to read capture spool file %s.", (const char*)spoolFile.c_str());
+        return false;
+    }
+
+    SpoolReader reader(in);
+    std::vector<uint8_t> slots;
+    std::vector<uint8_t> out(std::max(channelsPerFrame, 1L), 0x00);
+
+    bool ok = true;
+    uint32_t last = 0;
+    for (size_t i = 0; i < frames; i++)
+    {
+        uint32_t header[2];
+        if (!reader.Read(header, sizeof(header)))
+        {
+            ok = false;
+            break;
+        }
+
+        slots.resize((size_t)header[1] * CAPTURE_UNIVERSE_SIZE);
+        if (!reader.Read(slots.data(), slots.size()))
+        {
+            ok = false;
+            break;
+        }
+
+        for (auto it = collectors.begin(); it != collectors.end(); ++it)
+        {
+            if (it->_startChannel < 1 || it->_slot >= (int)header[1]) continue;
+
+            long size = std::min((long)it->_size, channelsPerFrame - (it->_startChannel - 1));
+            if (size > 0)
+            {
+                memcpy(&out[it->_startChannel - 1], &slots[it->_slot * CAPTURE_UNIVERSE_SIZE], size);
+            }
+        }
+
+        int copies = FramesToWrite(last, header[0], i == 0, frameMS);
+#ifdef DETAILED_LOGGING
+        if (copies > 1) logger_base.debug("   Frame at %dms repeated %d times to cover lost frames.", (int)(header[0] & ~CAPTURE_RESUMED), copies);
+#endif
+        for (int j = 0; j < copies; j++)
+        {
+            writer(out.data());
+        }
+        last = header[0];
+    }
+
+    fclose(in);
+
+    if (!ok)
+    {
+        logger_base.error("Capture spool file %s ended early.", (const char*)spoolFile.c_str());
+    }
+
+    return ok;
+}
+
+#pragma endregion
+
+#pragma region Control
+
+void PacketCapture::SetUniverses(bool all, const std::vector<std::pair<int, int>>& ranges)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    _captureAll = all;
+    _universeRanges = ranges;
+
+    // forget the universes we decided to ignore so they are checked against the new list
+    for (auto it = _collectorIndex.begin(); it != _collectorIndex.end(); )
+    {
+        if (it->second == nullptr)
+        {
+            it = _collectorIndex.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void PacketCapture::SetTrigger(bool enabled, int universe, int channel, int start, std::function<void(bool)> onTriggered)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    _triggerEnabled = enabled;
+    _triggerUniverse = universe;
+    _triggerChannel = channel;
+    _triggerStart = start;
+    _onTriggered = onTriggered;
+}
+
+void PacketCapture::Resume()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    if (_capturing) return;
+
+    if (!OpenSpool()) return;
+
+    if (_frameTimes.empty())
+    {
+        _captureStartUS = NowUS();
+        _resumed = false;
+    }
+    else
+    {
+        _resumed = true;
+    }
+    _capturing = true;
+}
+
+void PacketCapture::Pause()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    CloseFrame();
+    WriteSpool(nullptr, 0, true);
+}
+
+void PacketCapture::Start()
+{
+    Clear();
+    Resume();
+}
+
+void PacketCapture::Stop()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    _capturing = false;
+    Pause();
+}
+
+void PacketCapture::Clear()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    _capturing = false;
+    _frameOpen = false;
+    CloseSpool();
+
+    for (auto it = _collectors.begin(); it != _collectors.end(); ++it)
+    {
+        delete *it;
+    }
+    _collectors.clear();
+    _collectorIndex.clear();
+    _frame.clear();
+    _present.clear();
+    _frameTimes.clear();
+    _frames = 0;
+    _capturedPackets = 0;
+    _droppedPackets = 0;
+    _syncSeen = false;
+    _resumed = false;
+    _intervalEstimateUS = 0;
+}
+
+#pragma endregion
+
+#pragma region Results
+
+int PacketCapture::GetUniverseCount() const
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    return (int)_collectors.size();
+}
+
+int PacketCapture::GuessFrameMS() const
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    double total = 0;
+    int count = 0;
+    for (size_t i = 1; i < _frameTimes.size(); i++)
+    {
+        if ((_frameTimes[i] & CAPTURE_RESUMED) == 0)
+        {
+            total += (double)(_frameTimes[i] - (_frameTimes[i - 1] & ~CAPTURE_RESUMED));
+            count++;
+        }
+    }
+
+    if (count == 0) return 50;
+
+    logger_base.debug("Guessing frame time. Total time %fms. Intervals %d, Average Frame %fms, Estimate %dms",
+        total,
+        count,
+        total / count,
+        (int)(total / count + 0.5));
+
+    return std::max(1, (int)(total / count + 0.5));
+}
+
+int PacketCapture::GetOutputFrames(int frameMS) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    int frames = 0;
+    for (size_t i = 0; i < _frameTimes.size(); i++)
+    {
+        frames += FramesToWrite(i == 0 ? 0 : _frameTimes[i - 1], _frameTimes[i], i == 0, frameMS);
+    }
+    return frames;
+}
+
+long PacketCapture::GetChannelsPerFrame()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    // make sure the collectors are sorted ... the slot keeps track of where each lives in the spool
+    _collectors.sort([](const Collector* a, const Collector* b) { return *a < *b; });
+
+    long size = 0;
+    for (auto it = _collectors.begin(); it != _collectors.end(); ++it)
+    {
+        (*it)->_startChannel = size + 1;
+        size += (*it)->_size;
+    }
+
+    return size;
+}
+
+std::list<Collector> PacketCapture::GetCollectors() const
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    std::list<Collector> res;
+    for (auto it = _collectors.begin(); it != _collectors.end(); ++it)
+    {
+        res.push_back(**it);
+    }
+    return res;
+}
+
+bool PacketCapture::SaveFSEQ(const std::string& file, int frameMS, int stepTime, long channelsPerFrame, int frames)
+{
+    // FSEQFile quietly writes to memory if it cant open the file so check first
+    wxFile f;
+    if (!f.Create(file, true)) return false;
+    f.Close();
+
+    FSEQFile* fseq = FSEQFile::createFSEQFile(file, 2, FSEQFile::CompressionType::zstd);
+    fseq->setChannelCount(channelsPerFrame);
+    fseq->setNumFrames(frames);
+    fseq->setStepTime(stepTime);
+    fseq->writeHeader();
+
+    uint32_t frame = 0;
+    bool ok = ReplaySpool(frameMS, channelsPerFrame, [fseq, &frame, frames](const uint8_t* data)
+    {
+        if (frame < (uint32_t)frames)
+        {
+            fseq->addFrame(frame++, data);
+        }
+    });
+
+    // pad out if the spool came up short so the header frame count holds
+    if (frame < (uint32_t)frames)
+    {
+        std::vector<uint8_t> blank(channelsPerFrame, 0x00);
+        while (frame < (uint32_t)frames)
+        {
+            fseq->addFrame(frame++, blank.data());
+        }
+    }
+
+    fseq->finalize();
+    delete fseq;
+
+    return ok;
+}
+
+inline long RoundTo4(long i) {
+    long remainder = i % 4;
+    if (remainder == 0) {
+        return i;
+    }
+    return i + 4 - remainder;
+}
+
+bool PacketCapture::SaveESEQ(const std::string& file, int frameMS, long startAddr, long channelsPerFrame, int frames)
+{
+    wxUint16 fixedHeaderLength = 20;
+    wxUint32 modelSize = channelsPerFrame;
+    wxUint32 frameSize = RoundTo4(channelsPerFrame);
+    wxFile f;
+
+    if (!f.Create(file, true)) return false;
+
+    wxUint8 buf[20];
+    memset(buf, 0x00, sizeof(buf));
+
+    buf[0] = 'E';
+    buf[1] = 'S';
+    buf[2] = 'E';
+    buf[3] = 'Q';
+    // Data offset
+    buf[4] = (wxUint8)1; //Hard coded to export a single model for now
+    buf[5] = 0; //Pad byte
+    buf[6] = 0; //Pad byte
+    buf[7] = 0; //Pad byte
+                // Step Size
+    buf[8] = (wxUint8)(frameSize & 0xFF);
+    buf[9] = (wxUint8)((frameSize >> 8) & 0xFF);
+    buf[10] = (wxUint8)((frameSize >> 16) & 0xFF);
+    buf[11] = (wxUint8)((frameSize >> 24) & 0xFF);
+    //Model Start address
+    buf[12] = (wxUint8)(startAddr & 0xFF);
+    buf[13] = (wxUint8)((startAddr >> 8) & 0xFF);
+    buf[14] = (wxUint8)((startAddr >> 16) & 0xFF);
+    buf[15] = (wxUint8)((startAddr >> 24) & 0xFF);
+    // Model Size
+    buf[16] = (wxUint8)(modelSize & 0xFF);
+    buf[17] = (wxUint8)((modelSize >> 8) & 0xFF);
+    buf[18] = (wxUint8)((modelSize >> 16) & 0xFF);
+    buf[19] = (wxUint8)((modelSize >> 24) & 0xFF);
+    f.Write(buf, fixedHeaderLength);
+
+    int written = 0;
+    bool ok = ReplaySpool(frameMS, frameSize, [&f, &written, frames, frameSize](const uint8_t* data)
+    {
+        if (written < frames)
+        {
+            f.Write(data, frameSize);
+            written++;
+        }
+    });
+
+    f.Close();
+
+    return ok;
+}
+
+#pragma endregion
@@ -0,0 +1,174 @@
+#ifndef PACKETCAPTURE_H
+#define PACKETCAPTURE_H
+
+#include <wx/wx.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __WXMSW__
+typedef wxUIntPtr CaptureSocket;
+#else
+typedef int CaptureSocket;
+#endif
+
+#define CAPTURE_PROTOCOL_E131 0
+#define CAPTURE_PROTOCOL_ARTNET 1
+
+// big enough for a full E1.31 data packet
+#define CAPTURE_MAX_PACKET 640
+#define CAPTURE_UNIVERSE_SIZE 512
+
+class CaptureReceiveThread;
+class CaptureAssemblerThread;
+struct ZSTD_CCtx_s;
+
+// A received datagram. These live in a fixed ring allocated once so the receive
+// thread never touches the heap.
+struct CapturePacket
+{
+    uint64_t _timeUS;
+    uint16_t _length;
+    uint8_t _protocol;
+    uint8_t _data[CAPTURE_MAX_PACKET];
+};
+
+// Everything we know about one captured universe. Packet data itself goes straight
+// into the assembled frame and then the spool file.
+class Collector
+{
+public:
+    int _universe;
+    long _protocol;
+    long _startChannel; // 1 based start channel
+    int _slot;          // position of this universe in the spooled frames
+    int _size;          // largest payload seen
+    long _packets;
+    long _missedPackets;
+    long _firstFrame;
+    long _lastFrame;
+    int _lastSeq;
+
+    Collector(long protocol, int universe, int slot)
+    {
+        _startChannel = -1; _universe = universe; _protocol = protocol; _slot = slot; _size = 0;
+        _packets = 0; _missedPackets = 0; _firstFrame = -1; _lastFrame = -1; _lastSeq = -1;
+    }
+    bool operator<(const Collector& c) const;
+};
+
+// Receives E1.31 and ArtNET on a background thread, assembles universes into frames
+// and streams the frames to a compressed spool file while capturing. Saving then
+// transcodes the spool in a single pass so memory use does not grow with capture length.
+class PacketCapture
+{
+    friend class CaptureReceiveThread;
+    friend class CaptureAssemblerThread;
+
+    // receive side
+    CaptureSocket _sockets[2];
+    CaptureReceiveThread* _receiveThread;
+    CapturePacket* _ring;
+    uint32_t _ringMask;
+    std::atomic<uint32_t> _ringHead;
+    std::atomic<uint32_t> _ringTail;
+    std::atomic<bool> _stopReceive;
+    std::atomic<long> _droppedPackets;
+
+    // assembly side
+    CaptureAssemblerThread* _assemblerThread;
+    std::atomic<bool> _stopAssembler;
+    std::mutex _wakeLock;
+    std::condition_variable _wakeSignal;
+    std::atomic<bool> _capturing;
+    std::atomic<long> _capturedPackets;
+    std::atomic<long> _frames;
+
+    mutable std::recursive_mutex _lock; // protects everything below
+    bool _captureAll;
+    std::vector<std::pair<int, int>> _universeRanges;
+    bool _triggerEnabled;
+    int _triggerUniverse;
+    int _triggerChannel;
+    int _triggerStart;
+    std::function<void(bool)> _onTriggered;
+    std::map<uint32_t, Collector*> _collectorIndex;
+    std::list<Collector*> _collectors;
+    std::vector<uint8_t> _frame;
+    std::vector<uint32_t> _frameTimes; // ms since capture start, top bit set when capture resumed after a pause
+    bool _frameOpen;
+    bool _resumed;
+    bool _syncSeen;
+    uint64_t _captureStartUS;
+    uint64_t _frameStartUS;
+    uint64_t _lastFrameStartUS;
+    uint64_t _lastPacketUS;
+    double _intervalEstimateUS;
+    std::vector<uint8_t> _present;
+
+    // spool
+    std::string _spoolFile;
+    FILE* _spool;
+    ZSTD_CCtx_s* _cctx;
+    std::vector<uint8_t> _spoolBuffer;
+
+    void StartReceiveThread();
+    void StopReceiveThread();
+    void ReceiveLoop();
+    void ReceiveBatch(long protocol);
+    void AssembleLoop();
+    uint64_t QuietUS() const;
+    void ProcessPacket(const CapturePacket& p);
+    void ProcessDataPacket(long protocol, int universe, int seq, const uint8_t* data, int length, uint64_t timeUS);
+    void OnSync();
+    void CheckTrigger(int universe, const uint8_t* data, int length);
+    bool IsUniverseToBeCaptured(int universe) const;
+    void CloseFrame();
+    bool OpenSpool();
+    void WriteSpool(const void* data, size_t length, bool flush);
+    void CloseSpool();
+    void Resume();
+    void Pause();
+
+public:
+
+    PacketCapture();
+    virtual ~PacketCapture();
+
+    bool Listen(long protocol, const std::string& localIP, const std::vector<std::pair<int, int>>& multicastUniverses);
+    void CloseListener(long protocol);
+    bool IsListening(long protocol) const;
+    bool IsListening() const { return IsListening(CAPTURE_PROTOCOL_E131) || IsListening(CAPTURE_PROTOCOL_ARTNET); }
+
+    void SetUniverses(bool all, const std::vector<std::pair<int, int>>& ranges);
+    void SetTrigger(bool enabled, int universe, int channel, int start, std::function<void(bool)> onTriggered);
+
+    void Start();
+    void Stop();
+    void Clear();
+    bool IsCapturing() const { return _capturing; }
+    bool HasData() const { return _frames > 0; }
+
+    long GetCapturedPackets() const { return _capturedPackets; }
+    long GetDroppedPackets() const { return _droppedPackets; }
+    long GetFrames() const { return _frames; }
+    int GetUniverseCount() const;
+    int GuessFrameMS() const;
+    int GetOutputFrames(int frameMS) const;
+    long GetChannelsPerFrame();
+    std::list<Collector> GetCollectors() const;
+
+    bool SaveFSEQ(const std::string& file, int frameMS, int stepTime, long channelsPerFrame, int frames);
+    bool SaveESEQ(const std::string& file, int frameMS, long startAddr, long channelsPerFrame, int frames);
+
+    typedef std::function<void(const uint8_t* data)> FrameWriter;
+    bool ReplaySpool(int frameMS, long channelsPerFrame, const FrameWriter& writer);
+};
+
+#endif
@@ -8,8 +8,6 @@
  **************************************************************/
 
 #define ZERO 0
-#define E131PORT 5568
-#define ARTNETPORT 0x1936
 
 #include "xCaptureMain.h"
 #include <wx/msgdlg.h>
@@ -26,11 +24,7 @@
 #include <wx/numdlg.h>
 #include "ResultDialog.h"
 #include "../xLights/IPEntryDialog.h"
-
-#ifndef __WXMSW__
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#endif
+#include <wx/socket.h>
 
 #include "../include/xLights.xpm"
 #include "../include/xLights-16.xpm"
@@ -104,143 +98,66 @@ const long xCaptureFrame::ID_STATUSBAR1 = wxNewId();
 const long xCaptureFrame::ID_TIMER1 = wxNewId();
 //*)
 
-const long xCaptureFrame::ID_E131SOCKET = wxNewId();
-const long xCaptureFrame::ID_ARTNETSOCKET = wxNewId();
-
 BEGIN_EVENT_TABLE(xCaptureFrame,wxFrame)
     //(*EventTable(xCaptureFrame)
     //*)
 END_EVENT_TABLE()
 
-void xCaptureFrame::PurgeCollectedData()
+std::vector<std::pair<int, int>> xCaptureFrame::GetUniverseRanges(bool& all)
 {
-    while (_capturedData.size() > 0)
-    {
-        auto toDelete = _capturedData.front();
-        _capturedData.pop_front();
-        delete toDelete;
-    }
-}
-
-void xCaptureFrame::StashPacket(long type, wxByte* packet, int len)
-{
-    int universe = -1;
-    if (type == ID_E131SOCKET)
-    {
-        universe = ((int)packet[113] << 8) + (int)packet[114];
-    }
-    else if (type == ID_ARTNETSOCKET)
-    {
-        // we only handle artdmx packets
-        if (packet[9] != 0x50) return;
-
-        universe = ((int)packet[15] << 8) + (int)packet[14];
-    }
-
-    if (universe == -1) return;
-
-    if (CheckBox_TriggerOnChannel->GetValue())
-    {
-        if (universe == SpinCtrl_Universe->GetValue())
-        {
-            wxByte c = packet[125 + SpinCtrl_Channel->GetValue()];
-
-            if (c >= SpinCtrl_TriggerStart->GetValue())
-            {
-                _capturing = true;
-                _capturedDesc = "";
-                ValidateWindow();
-            }
-            else
-            {
-                _capturing = false;
-                UpdateCaptureDesc();
-                ValidateWindow();
-            }
-        }
-    }
-
-    if (!_capturing) return;
-
-    for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-    {
-        if ((*it)->_protocol == type && (*it)->_universe == universe)
-        {
-            _capturedPackets++;
-            (*it)->AddPacket(type, packet, len);
-            return;
-        }
-    }
-
-    // Doing thise here means we only need to check the list when it isnt already captured
-    if (!IsUniverseToBeCaptured(universe)) return;
-
-    Collector* c = new Collector(type, universe);
-    _capturedData.push_back(c);
-    c->AddPacket(type, packet, len);
-    _capturedPackets++;
-}
+    std::vector<std::pair<int, int>> res;
+    all = false;
 
-bool xCaptureFrame::IsUniverseToBeCaptured(int universe, bool ignoreall /*= false*/)
-{
     if (ListView_Universes->GetItemCount() == 1 &&
-        ListView_Universes->GetItemText(0) == "All" && !ignoreall)
+        ListView_Universes->GetItemText(0) == "All")
     {
-        return true;
+        all = true;
+        return res;
     }
 
     for (int i = 0; i < ListView_Universes->GetItemCount(); i++)
     {
         int start = wxAtoi(ListView_Universes->GetItemText(i));
         int end = wxAtoi(ListView_Universes->GetItemText(i, 1));
-
-        if (universe >= start && universe <= end) return true;
+        res.push_back(std::pair<int, int>(start, end));
     }
 
-    return false;
+    return res;
 }
 
-int xCaptureFrame::GuessFrameMS()
+// push the universe list and trigger settings down to the capture threads
+void xCaptureFrame::UpdateCaptureSettings()
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    Collector* c = _capturedData.front();
-
-    bool first = true;
-    wxDateTime last;
-    double totalgap = 0;
-    int count = 0;
-    // look at the first 10 intervals
-    for (auto it = c->_packets.begin(); count < 10 && it != c->_packets.end(); ++it)
+    bool all = false;
+    auto ranges = GetUniverseRanges(all);
+    _capture->SetUniverses(all, ranges);
+
+    _capture->SetTrigger(CheckBox_TriggerOnChannel->GetValue(),
+        SpinCtrl_Universe->GetValue(),
+        SpinCtrl_Channel->GetValue(),
+        SpinCtrl_TriggerStart->GetValue(),
+        [this](bool capturing) { CallAfter(&xCaptureFrame::OnCaptureTriggered, capturing); });
+}
+
+// called on the main thread when the trigger channel starts or stops a capture
+void xCaptureFrame::OnCaptureTriggered(bool capturing)
+{
+    if (capturing)
     {
-        if (first)
-        {
-            first = false;
-        }
-        else
-        {
-            totalgap += ((*it)->_timeStamp - last).GetValue().ToDouble();
-            count++;
-        }
-        last = (*it)->_timeStamp;
+        _capturedDesc = "";
     }
-    logger_base.debug("Guessing frame time. Total time %fms. Intervals %d, Average Frame %fms, Estimate %dms",
-        totalgap,
-        count,
-        totalgap / count,
-        ((int)((totalgap / count)) / 5) * 5);
-    totalgap /= count;
-    //totalgap += 2.5;
-    return ((int)(totalgap / 5)) * 5;
+    else
+    {
+        UpdateCaptureDesc();
+    }
+    ValidateWindow();
 }
 
 xCaptureFrame::xCaptureFrame(wxWindow* parent, const std::string& showdir, const std::string& playlist, wxWindowID id)
 {
     // static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    _e131Socket = nullptr;
-    _artNETSocket = nullptr;
-    _capturing = false;
-    _capturedPackets = 0;
+    _capture = new PacketCapture();
     _capturedDesc = "";
 
     //(*Initialize(xCaptureFrame)
@@ -379,8 +296,10 @@ xCaptureFrame::xCaptureFrame(wxWindow* parent, const std::string& showdir, const
     Connect(wxEVT_SIZE,(wxObjectEventFunction)&xCaptureFrame::OnResize);
     //*)
 
-    Connect(ID_E131SOCKET, wxEVT_SOCKET, (wxObjectEventFunction)&xCaptureFrame::OnE131SocketEvent);
-    Connect(ID_ARTNETSOCKET, wxEVT_SOCKET, (wxObjectEventFunction)&xCaptureFrame::OnArtNETSocketEvent);
+    Connect(ID_SPINCTRL_UNIVERSE, wxEVT_SPINCTRL, (wxObjectEventFunction)&xCaptureFrame::OnTriggerSpinChange);
+    Connect(ID_SPINCTRL_CHANNEL, wxEVT_SPINCTRL, (wxObjectEventFunction)&xCaptureFrame::OnTriggerSpinChange);
+    Connect(ID_SPINCTRL_START, wxEVT_SPINCTRL, (wxObjectEventFunction)&xCaptureFrame::OnTriggerSpinChange);
+    Connect(ID_SPINCTRL_END, wxEVT_SPINCTRL, (wxObjectEventFunction)&xCaptureFrame::OnTriggerSpinChange);
 
     SetTitle("xLights Capture " + GetDisplayVersionString());
 
@@ -496,7 +415,8 @@ xCaptureFrame::~xCaptureFrame()
 
     CloseSockets(true);
 
-    PurgeCollectedData();
+    delete _capture;
+    _capture = nullptr;
 
     //(*Destroy(xCaptureFrame)
     //*)
@@ -560,22 +480,12 @@ void xCaptureFrame::CloseSockets(bool force)
 {
     if (force || !CheckBox_E131->GetValue())
     {
-        if (_e131Socket != nullptr)
-        {
-            _e131Socket->Close();
-            delete _e131Socket;
-            _e131Socket = nullptr;
-        }
+        _capture->CloseListener(CAPTURE_PROTOCOL_E131);
     }
 
     if (force || !CheckBox_ArtNET->GetValue())
     {
-        if (_artNETSocket != nullptr)
-        {
-            _artNETSocket->Close();
-            delete _artNETSocket;
-            _artNETSocket = nullptr;
-        }
+        _capture->CloseListener(CAPTURE_PROTOCOL_ARTNET);
     }
 }
 
@@ -590,160 +500,6 @@ void xCaptureFrame::OnAbout(wxCommandEvent& event)
     wxMessageBox(about, _("Welcome to..."));
 }
 
-PacketData::PacketData(long type, wxByte* packet, int len)
-{
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    _timeStamp = wxDateTime::UNow();
-    _frameTimeMS = -1;
-    _seq = 0;
-    _length = 0;
-    _pdata = nullptr;
-
-    if (type == xCaptureFrame::ID_E131SOCKET)
-    {
-        // validate the packet
-        if (len < 126) return;
-        if (packet[4] != 0x41) return;
-        if (packet[5] != 0x53) return;
-        if (packet[6] != 0x43) return;
-        if (packet[7] != 0x2d) return;
-        if (packet[8] != 0x45) return;
-        if (packet[9] != 0x31) return;
-        if (packet[10] != 0x2e) return;
-        if (packet[11] != 0x31) return;
-        if (packet[12] != 0x37) return;
-
-        _seq = (int)packet[111];
-        _length = (((int)packet[115] - 0x70) << 8) + (int)packet[116] - 11;
-        if (_length > len - 126)
-        {
-            logger_base.warn("E131 packet of claimed length %d truncated to actual packet length %d.", _length, len - 126);
-            logger_base.warn("    Packet looks unlikely to be valid.");
-            _length = len - 126;
-        }
-        _pdata = (wxByte*)malloc(_length);
-        memcpy(_pdata, &packet[126], _length);
-    }
-    else if (type == xCaptureFrame::ID_ARTNETSOCKET)
-    {
-        // validate the packet
-        if (len < 18) return;
-        if (packet[0] != 'A') return;
-        if (packet[1] != 'r') return;
-        if (packet[2] != 't') return;
-        if (packet[3] != '-') return;
-        if (packet[4] != 'N') return;
-        if (packet[5] != 'e') return;
-        if (packet[6] != 't') return;
-        if (packet[9] != 0x50) return;
-
-        _seq = (int)packet[12];
-        _length = ((int)packet[16] << 8) + (int)packet[17];
-        if (_length > len - 18)
-        {
-            logger_base.warn("ArtNet packet of claimed length %d truncated to actual packet length %d.", _length, len - 18);
-            logger_base.warn("    Packet looks unlikely to be valid.");
-            _length = len - 18;
-        }
-        _pdata = (wxByte*)malloc(_length);
-        memcpy(_pdata, &packet[18], _length);
-    }
-}
-
-Collector::~Collector()
-{
-    while (_packets.size() > 0)
-    {
-        auto toDelete = _packets.front();
-        _packets.pop_front();
-        delete toDelete;
-    }
-}
-
-// relies on missing sequence numbers to detect missing frames
-void Collector::CalculateFrames(wxDateTime startTime, int frameMS)
-{
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    bool first = true;
-    int ms = 0;
-    int lastseq = 255;
-
-    // rebase the start time to the start time in this universe if possible
-    if (_packets.size() > 0)
-    {
-        double rawFrameMS = (_packets.front()->_timeStamp - startTime).GetValue().ToDouble();
-        ms = ((int)(rawFrameMS / frameMS)) * frameMS;
-        lastseq = _packets.front()->_seq - 1;
-        if (lastseq < 0) lastseq = 255;
-    }
-
-    //logger_base.debug("Allocating frames for universe %d", _universe);
-    for (auto it = _packets.begin(); it != _packets.end(); ++it)
-    {
-        lastseq += 1;
-        if (lastseq > 255) lastseq = 0;
-
-        if (lastseq != (*it)->_seq)
-        {
-            // a frame is missing
-            // check it is only one
-            auto next = it;
-            ++next;
-
-            if (next != _packets.end() && (*next)->_seq == lastseq)
-            {
-                logger_base.warn("Universe %d missing one packet sequence lastSeq %d", _universe, lastseq);
-                // only one frame was missing so assume it was lost
-                ms += frameMS;
-                lastseq += 1;
-                if (lastseq > 255) lastseq = 0;
-            }
-            else
-            {
-                if (!first)
-                {
-                    logger_base.warn("Universe %d missing multiple packets from sequence %d", _universe, lastseq);
-                }
-                lastseq = (*it)->_seq;
-            }
-        }
-        (*it)->_frameTimeMS = ms;
-        ms += frameMS;
-        first = false;
-    }
-}
-
-PacketData* Collector::GetPacket(long ms)
-{
-    auto it = _packets.begin();
-    while (it != _packets.end() && ms > (*it)->_frameTimeMS)
-    {
-        ++it;
-    }
-
-    if (it != _packets.end() && ms == (*it)->_frameTimeMS)
-    {
-        return (*it);
-    }
-
-    return nullptr;
-}
-
-bool Collector::operator<(const Collector& c) const
-{
-    if (_universe == c._universe)
-    {
-        if (_protocol == xCaptureFrame::ID_E131SOCKET)
-        {
-            return true;
-        }
-        return false;
-    }
-
-    return _universe < c._universe;
-}
-
 void xCaptureFrame::ValidateWindow()
 {
     if (Choice_Timing->GetStringSelection() == "Manual")
@@ -772,12 +528,14 @@ void xCaptureFrame::ValidateWindow()
         Button_StartStop->Enable(true);
     }
 
-    if (_artNETSocket == nullptr && _e131Socket == nullptr)
+    if (!_capture->IsListening())
     {
         Button_StartStop->Enable(false);
     }
 
-    if (_capturedData.size() > 0 && !_capturing)
+    Button_StartStop->SetLabel(_capture->IsCapturing() ? "Stop" : "Start");
+
+    if (_capture->HasData() && !_capture->IsCapturing())
     {
         Button_Save->Enable(true);
         Button_Analyse->Enable(true);
@@ -807,56 +565,19 @@ void xCaptureFrame::ValidateWindow()
         }
         Button_Delete->Enable(true);
     }
+
+    UpdateCaptureSettings();
 }
 
 void xCaptureFrame::CreateE131Listener()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    if (_e131Socket != nullptr) return;
-
-    //Local address to bind to
-    wxIPV4address addr;
-    addr.AnyAddress();
-    addr.Service(E131PORT);
-    //create and bind to the address above
-    _e131Socket = new wxDatagramSocket(addr);
+    if (_capture->IsListening(CAPTURE_PROTOCOL_E131)) return;
 
-    if (_e131Socket->IsOk())
+    bool all = false;
+    auto multicast = GetUniverseRanges(all);
+    if (!_capture->Listen(CAPTURE_PROTOCOL_E131, _localIP.ToStdString(), multicast))
     {
-        logger_base.debug("E131 listening on %s", (const char*)_localIP.c_str());
-
-        for (int i = 0; i < ListView_Universes->GetItemCount(); i++)
-        {
-            if (ListView_Universes->GetItemText(i) != "All")
-            {
-                int start = wxAtoi(ListView_Universes->GetItemText(i));
-                int end = wxAtoi(ListView_Universes->GetItemText(i, 1));
-                for (int u = start; u <= end; u++)
-                {
-                    struct ip_mreq mreq;
-                    wxString ip = wxString::Format("239.255.%d.%d", u >> 8, u & 0xFF);
-                    logger_base.debug("E131 registering for multicast on %s.", (const char *)ip.c_str());
-                    mreq.imr_multiaddr.s_addr = inet_addr(ip.c_str());
-                    mreq.imr_interface.s_addr = inet_addr(_localIP.c_str()); // this will only listen on the default interface
-                    if (!_e131Socket->SetOption(IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&mreq, sizeof(mreq)))
-                    {
-                        logger_base.warn("    Error opening E131 multicast listener %s.", (const char *)ip.c_str());
-                    }
-                }
-            }
-        }
-
-        //enable event handling
-        _e131Socket->SetEventHandler(*this, ID_E131SOCKET);
-        //Notify us about incomming data
-        _e131Socket->SetNotify(wxSOCKET_INPUT_FLAG);
-        //enable event handling
-        _e131Socket->Notify(true);
-    }
-    else
-    {
-        delete _e131Socket;
-        _e131Socket = nullptr;
         logger_base.warn("Error opening socket to listen for e131 data");
         wxMessageBox("Error listening for E1.31 data.");
     }
@@ -865,51 +586,12 @@ void xCaptureFrame::CreateE131Listener()
 void xCaptureFrame::CreateArtNETListener()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    if (_artNETSocket != nullptr) return;
-
-    //Local address to bind to
-    wxIPV4address addr;
-    addr.AnyAddress();
-    addr.Service(ARTNETPORT);
-    //create and bind to the address above
-    _artNETSocket = new wxDatagramSocket(addr);
-
-    if (_artNETSocket->IsOk())
-    {
-        logger_base.debug("ARTNet listening on %s", (const char*)_localIP.c_str());
-
-        for (int i = 0; i < ListView_Universes->GetItemCount(); i++)
-        {
-            if (ListView_Universes->GetItemText(i) != "All")
-            {
-                int start = wxAtoi(ListView_Universes->GetItemText(i));
-                int end = wxAtoi(ListView_Universes->GetItemText(i, 1));
-                for (int u = start; u <= end; u++)
-                {
-                    struct ip_mreq mreq;
-                    wxString ip = wxString::Format("239.255.%d.%d", u >> 8, u & 0xFF);
-                    logger_base.debug("ARTNet registering for multicast on %s.", (const char *)ip.c_str());
-                    mreq.imr_multiaddr.s_addr = inet_addr(ip.c_str());
-                    mreq.imr_interface.s_addr = inet_addr(_localIP.c_str()); // this will only listen on the default interface
-                    if (!_artNETSocket->SetOption(IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&mreq, sizeof(mreq)))
-                    {
-                        logger_base.warn("    Error opening ARTNet multicast listener %s.", (const char *)ip.c_str());
-                    }
-                }
-            }
-        }
+    if (_capture->IsListening(CAPTURE_PROTOCOL_ARTNET)) return;
 
-        //enable event handling
-        _artNETSocket->SetEventHandler(*this, ID_ARTNETSOCKET);
-        //Notify us about incomming data
-        _artNETSocket->SetNotify(wxSOCKET_INPUT_FLAG);
-        //enable event handling
-        _artNETSocket->Notify(true);
-    }
-    else
+    bool all = false;
+    auto multicast = GetUniverseRanges(all);
+    if (!_capture->Listen(CAPTURE_PROTOCOL_ARTNET, _localIP.ToStdString(), multicast))
     {
-        delete _artNETSocket;
-        _artNETSocket = nullptr;
         logger_base.warn("Error opening socket to listen for ArtNET data");
         wxMessageBox("Error listening for E1.ArtNET data.");
     }
@@ -1060,39 +742,33 @@ void xCaptureFrame::OnButton_StartStopClick(wxCommandEvent& event)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    _capturing = !_capturing;
-    if (_capturing)
+    if (!_capture->IsCapturing())
     {
         _capturedDesc = "";
-        _capturedPackets = 0;
-        PurgeCollectedData();
-        Button_StartStop->SetLabel("Stop");
-        _capturedDesc = "";
+        UpdateCaptureSettings();
+        _capture->Start();
     }
     else
     {
-        Button_StartStop->SetLabel("Start");
+        _capture->Stop();
         UpdateCaptureDesc();
 
-        logger_base.debug("Capture stopped.");
-        for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
+        logger_base.debug("Capture stopped. Frames %ld, Packets %ld, Dropped %ld.", _capture->GetFrames(), _capture->GetCapturedPackets(), _capture->GetDroppedPackets());
+        auto collectors = _capture->GetCollectors();
+        for (auto it = collectors.begin(); it != collectors.end(); ++it)
         {
-            logger_base.debug("    Protocol %s, Universe %d, Size %d, Frames %d",
-                (*it)->_protocol == ID_E131SOCKET ? "E131" : "ArtNET",
-                (*it)->_universe,
-                (*it)->_packets.size() > 0 ? (*it)->_packets.front()->_length : 0,
-                (int)(*it)->_packets.size()
+            logger_base.debug("    Protocol %s, Universe %d, Size %d, Packets %ld, Missed %ld",
+                it->_protocol == CAPTURE_PROTOCOL_E131 ? "E131" : "ArtNET",
+                it->_universe,
+                it->_size,
+                it->_packets,
+                it->_missedPackets
             );
         }
     }
     ValidateWindow();
 }
 
-bool cmp(const Collector *a, const Collector *b)
-{
-    return *a < *b;
-}
-
 inline long RoundTo4(long i) {
     long remainder = i % 4;
     if (remainder == 0) {
@@ -1101,13 +777,39 @@ inline long RoundTo4(long i) {
     return i + 4 - remainder;
 }
 
+wxString xCaptureFrame::DescribeCapture(int frameMS, long& channelsPerFrame, int& frames)
+{
+    wxString log = wxString::Format("Frame Time: %dms\n", frameMS);
+
+    log += wxString::Format("Universes: %d\n", _capture->GetUniverseCount());
+
+    channelsPerFrame = RoundTo4(_capture->GetChannelsPerFrame());
+    log += wxString::Format("Channels Per Frame: %ld\n", channelsPerFrame);
+
+    frames = _capture->GetOutputFrames(frameMS);
+    log += wxString::Format("Frames: %d\n", frames);
+    log += wxString::Format("Captured Frames: %ld, Packets: %ld, Dropped Packets: %ld\n", _capture->GetFrames(), _capture->GetCapturedPackets(), _capture->GetDroppedPackets());
+
+    log += wxString::Format("Channel Structure Start:\n");
+    auto collectors = _capture->GetCollectors();
+    for (auto it = collectors.begin(); it != collectors.end(); ++it)
+    {
+        log += wxString::Format("Channel %ld, Protocol %s, Universe %d, Size %d, Packets %ld, Missed %ld, StartFrameMS %ldms, EndFrameMS %ldms\n",
+            it->_startChannel, it->_protocol == CAPTURE_PROTOCOL_E131 ? "E131" : "ArtNET",
+            it->_universe, it->_size,
+            it->_packets, it->_missedPackets,
+            it->_firstFrame * frameMS,
+            it->_lastFrame * frameMS);
+    }
+    log += wxString::Format("Channel Structure End!\n");
+
+    return log;
+}
+
 void xCaptureFrame::OnButton_SaveClick(wxCommandEvent& event)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    // make sure the collectors are sorted
-    _capturedData.sort(cmp);
-
     wxFileDialog dlg(this, _("Save sequence"), "", "",
         "FSEQ (*.fseq)|*.fseq|ESEQ (*.eseq)|*.eseq", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
     if (dlg.ShowModal() == wxID_OK)
@@ -1115,31 +817,10 @@ void xCaptureFrame::OnButton_SaveClick(wxCommandEvent& event)
         wxFileName fn(dlg.GetDirectory() + "/" + dlg.GetFilename());
         wxString log = "Saving to "+ fn.GetExt().Upper() + " file " + fn.GetFullName() + "\n";
 
-        int frameMS = GuessFrameMS();
-        log += wxString::Format("Frame Time: %dms\n", frameMS);
-
-        log += wxString::Format("Universes: %d\n", (int)_capturedData.size());
-
-        long channelsPerFrame = RoundTo4(GetChannelsPerFrame());
-        log += wxString::Format("Channels Per Frame: %ld\n", channelsPerFrame);
-
-        wxDateTime startTime = GetStartTime();
-
-        int frames = GetFrames();
-        log += wxString::Format("Frames: %d\n", frames);
-
-        log += wxString::Format("Channel Structure Start:\n");
-        for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-        {
-            (*it)->CalculateFrames(startTime, frameMS);
-
-            log += wxString::Format("Channel %ld, Protocol %s, Universe %d, Size %d, Frames %d, StartFrameMS %dms, EndFrameMS %dms\n",
-                (*it)->_startChannel, (*it)->_protocol == ID_E131SOCKET ? "E131" : "ArtNET",
-                (*it)->_universe, (*it)->_packets.size() > 0 ? (*it)->_packets.front()->_length : 0,
-                (int)(*it)->_packets.size(), (*it)->_packets.size() > 0 ? (*it)->_packets.front()->_frameTimeMS : -1,
-                (*it)->_packets.size() > 0 ? (*it)->_packets.back()->_frameTimeMS : -1);
-        }
-        log += wxString::Format("Channel Structure End!\n");
+        int frameMS = _capture->GuessFrameMS();
+        long channelsPerFrame = 0;
+        int frames = 0;
+        log += DescribeCapture(frameMS, channelsPerFrame, frames);
 
         if (fn.GetExt().Lower() == "fseq")
         {
@@ -1157,38 +838,6 @@ void xCaptureFrame::OnButton_SaveClick(wxCommandEvent& event)
     }
 }
 
-long xCaptureFrame::GetChannelsPerFrame()
-{
-    long size = 0;
-    for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-    {
-        (*it)->_startChannel = size + 1;
-        if ((*it)->_packets.size() > 0)
-        {
-            size += (*it)->_packets.front()->_length;
-        }
-    }
-
-    return size;
-}
-
-wxDateTime xCaptureFrame::GetStartTime()
-{
-    wxDateTime startTime = wxDateTime::Now();
-    for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-    {
-        if ((*it)->_packets.size() > 0)
-        {
-            if ((*it)->_packets.front()->_timeStamp < startTime)
-            {
-                startTime = (*it)->_packets.front()->_timeStamp;
-            }
-        }
-    }
-
-    return startTime;
-}
-
 void xCaptureFrame::OnCheckBox_TriggerOnChannelClick(wxCommandEvent& event)
 {
     ValidateWindow();
@@ -1230,8 +879,7 @@ void xCaptureFrame::OnButton_AllClick(wxCommandEvent& event)
 void xCaptureFrame::OnButton_ClearClick(wxCommandEvent& event)
 {
     _capturedDesc = "";
-    _capturedPackets = 0;
-    PurgeCollectedData();
+    _capture->Clear();
     ValidateWindow();
 }
 
@@ -1255,60 +903,9 @@ void xCaptureFrame::OnCheckBox_ArtNETClick(wxCommandEvent& event)
     ValidateWindow();
 }
 
-void xCaptureFrame::OnE131SocketEvent(wxSocketEvent& event)
+void xCaptureFrame::OnTriggerSpinChange(wxSpinEvent& event)
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    wxIPV4address addr;
-    addr.Service(E131PORT);
-    wxByte buf[126+512];
-    switch (event.GetSocketEvent())
-    {
-    case wxSOCKET_INPUT:
-    {
-        _e131Socket->Notify(false);
-        size_t n = _e131Socket->RecvFrom(addr, buf, sizeof(buf)).LastCount();
-        if (!n) {
-            logger_base.error("ERROR: failed to receive E131 data");
-            return;
-        }
-        //logger_base.debug("E131 packet received.");
-        StashPacket(ID_E131SOCKET, buf, n);
-        _e131Socket->Notify(true);
-    }
-        break;
-    default:
-        logger_base.warn("OnE131SocketEvent: Unexpected event !");
-        break;
-    }
-}
-
-void xCaptureFrame::OnArtNETSocketEvent(wxSocketEvent & event)
-{
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    wxIPV4address addr;
-    addr.Service(ARTNETPORT);
-    wxByte buf[18 + 512];
-    switch (event.GetSocketEvent())
-    {
-    case wxSOCKET_INPUT:
-    {
-        _artNETSocket->Notify(false);
-        size_t n = _artNETSocket->RecvFrom(addr, buf, sizeof(buf)).LastCount();
-        if (!n) {
-            logger_base.error("ERROR: failed to receive ArtNET data");
-            return;
-        }
-        //logger_base.debug("ArtNet packet received.");
-        StashPacket(ID_ARTNETSOCKET, buf, n);
-        _artNETSocket->Notify(true);
-    }
-        break;
-    default:
-        logger_base.warn("OnArtNETSocketEvent: Unexpected event !");
-        break;
-    }
+    UpdateCaptureSettings();
 }
 
 void xCaptureFrame::OnButton_AddClick(wxCommandEvent& event)
@@ -1341,37 +938,34 @@ void xCaptureFrame::OnButton_DeleteClick(wxCommandEvent& event)
     {
         ListView_Universes->DeleteItem(ListView_Universes->GetFirstSelected());
     }
+    ValidateWindow();
 }
 
 void xCaptureFrame::OnUITimerTrigger(wxTimerEvent& event)
 {
-    StatusBar1->SetStatusText(wxString::Format("Universes: %d Total Packets: %ld %s", (int)_capturedData.size(), _capturedPackets, _capturedDesc));
+    wxString dropped;
+    if (_capture->GetDroppedPackets() > 0)
+    {
+        dropped = wxString::Format(" Dropped: %ld", _capture->GetDroppedPackets());
+    }
+    StatusBar1->SetStatusText(wxString::Format("Universes: %d Total Packets: %ld Frames: %ld%s %s", _capture->GetUniverseCount(), _capture->GetCapturedPackets(), _capture->GetFrames(), dropped, _capturedDesc));
 }
 
-void xCaptureFrame::SaveFSEQ(wxString file, int frameMS, long channelsPerFrame, int frames, wxString& log)
+int xCaptureFrame::GetOverrideFrameMS()
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-    wxUint8 vMinor = 0;
-    wxUint8 vMajor = 1;
-    wxUint16 fixedHeaderLength = 28;
-    wxUint32 stepSize = channelsPerFrame;
-    wxUint16 stepTime = frameMS;
-    wxUint16 numUniverses = 0;
-    wxUint16 universeSize = 0;
-    wxUint8 gamma = 1;
-    wxUint8 colorEncoding = 2;
-
-    int overrideFrameMS = 0;
     if (Choice_Timing->GetStringSelection() == "Manual")
     {
-        overrideFrameMS = SpinCtrl_ManualTime->GetValue();
-    }
-    else
-    {
-        overrideFrameMS = wxAtoi(Choice_Timing->GetStringSelection());
+        return SpinCtrl_ManualTime->GetValue();
     }
+    return wxAtoi(Choice_Timing->GetStringSelection());
+}
 
+void xCaptureFrame::SaveFSEQ(wxString file, int frameMS, long channelsPerFrame, int frames, wxString& log)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    int stepTime = frameMS;
+    int overrideFrameMS = GetOverrideFrameMS();
     if (overrideFrameMS != 0)
     {
         logger_base.debug("Frame time overriden to %s->%d. It was %d.", (const char*)Choice_Timing->GetStringSelection().c_str(), overrideFrameMS, stepTime);
@@ -1379,75 +973,8 @@ void xCaptureFrame::SaveFSEQ(wxString file, int frameMS, long channelsPerFrame,
         stepTime = overrideFrameMS;
     }
 
-    wxFile f;
-
-    if (f.Create(file, true))
-    {
-        int bufsize = stepSize < 1024 ? 1024 : stepSize;
-        wxUint8* buf = (wxUint8 *)calloc(sizeof(wxUint8), bufsize);
-        memset(buf, 0x00, bufsize);
-
-        buf[0] = 'P';
-        buf[1] = 'S';
-        buf[2] = 'E';
-        buf[3] = 'Q';
-
-        buf[6] = vMinor;
-        buf[7] = vMajor;
-        // Fixed header length
-        buf[8] = (wxUint8)(fixedHeaderLength % 256);
-        buf[9] = (wxUint8)(fixedHeaderLength / 256);
-        // Step Size
-        buf[10] = (wxUint8)(stepSize & 0xFF);
-        buf[11] = (wxUint8)((stepSize >> 8) & 0xFF);
-        buf[12] = (wxUint8)((stepSize >> 16) & 0xFF);
-        buf[13] = (wxUint8)((stepSize >> 24) & 0xFF);
-        // Number of Steps
-        buf[14] = (wxUint8)(frames & 0xFF);
-        buf[15] = (wxUint8)((frames >> 8) & 0xFF);
-        buf[16] = (wxUint8)((frames >> 16) & 0xFF);
-        buf[17] = (wxUint8)((frames >> 24) & 0xFF);
-        // Step time in ms
-        buf[18] = (wxUint8)(stepTime & 0xFF);
-        buf[19] = (wxUint8)((stepTime >> 8) & 0xFF);
-        // universe count
-        buf[20] = (wxUint8)(numUniverses & 0xFF);
-        buf[21] = (wxUint8)((numUniverses >> 8) & 0xFF);
-        // universe Size
-        buf[22] = (wxUint8)(universeSize & 0xFF);
-        buf[23] = (wxUint8)((universeSize >> 8) & 0xFF);
-        // universe Size
-        buf[24] = gamma;
-        // universe Size
-        buf[25] = colorEncoding;
-        buf[26] = 0;
-        buf[27] = 0;
-
-        buf[4] = (wxUint8)(fixedHeaderLength % 256);
-        buf[5] = (wxUint8)(fixedHeaderLength / 256);
-        f.Write(buf, fixedHeaderLength);
-
-        for (int i = 0; i < frames; i++)
-        {
-            for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-            {
-                PacketData* p = (*it)->GetPacket(i * frameMS);
-                if (p != nullptr)
-                {
-                    memcpy(buf + (*it)->_startChannel - 1, p->_pdata, p->_length);
-                }
-                else
-                {
-                    logger_base.debug("   No data found uni %d ch %ld ", (*it)->_universe, (*it)->_startChannel);
-                }
-            }
-            f.Write(buf, stepSize);
-        }
-
-        f.Close();
-        free(buf);
-    }
-    else
+    wxBusyCursor wait;
+    if (!_capture->SaveFSEQ(file.ToStdString(), frameMS, stepTime, channelsPerFrame, frames))
     {
         log += "ERROR: Unable to create file.\n";
     }
@@ -1469,14 +996,14 @@ void xCaptureFrame::RestartInterfaces()
 
 void xCaptureFrame::UpdateCaptureDesc()
 {
-    if (_capturedData.size() == 0)
+    if (!_capture->HasData())
     {
         _capturedDesc = "";
     }
     else
     {
-        int frameMS = GuessFrameMS();
-        int frames = GetFrames();
+        int frameMS = _capture->GuessFrameMS();
+        int frames = _capture->GetOutputFrames(frameMS);
         _capturedDesc = wxString::Format("Frame Interval %dms Frames %d",
             frameMS, frames).ToStdString();
     }
@@ -1492,125 +1019,26 @@ void xCaptureFrame::SaveESEQ(wxString file, int frameMS, long channelsPerFrame,
         startAddr = 1;
     }
 
-    int overrideFrameMS = 0;
-    if (Choice_Timing->GetStringSelection() == "Manual")
-    {
-        overrideFrameMS = SpinCtrl_ManualTime->GetValue();
-    }
-    else
-    {
-        overrideFrameMS = wxAtoi(Choice_Timing->GetStringSelection());
-    }
-
+    int overrideFrameMS = GetOverrideFrameMS();
     if (overrideFrameMS != 0)
     {
         logger_base.debug("Frame time overriden to %s->%d. It was detected as %d", (const char*)Choice_Timing->GetStringSelection().c_str(), overrideFrameMS, frameMS);
         log += "Frame time override to " + wxString::Format("%d", overrideFrameMS) + "ms";
-        frameMS = overrideFrameMS;
     }
 
-    wxUint16 fixedHeaderLength = 20;
-    wxUint32 modelSize = channelsPerFrame;
-    wxUint32 frameSize = RoundTo4(channelsPerFrame);
-    wxFile f;
-
-    if (f.Create(file, true))
-    {
-        int bufsize = frameSize < 1024 ? 1024 : frameSize;
-        wxUint8* buf = (wxUint8 *)calloc(sizeof(wxUint8), bufsize);
-        memset(buf, 0x00, bufsize);
-
-        buf[0] = 'E';
-        buf[1] = 'S';
-        buf[2] = 'E';
-        buf[3] = 'Q';
-        // Data offset
-        buf[4] = (wxUint8)1; //Hard coded to export a single model for now
-        buf[5] = 0; //Pad byte
-        buf[6] = 0; //Pad byte
-        buf[7] = 0; //Pad byte
-                    // Step Size
-        buf[8] = (wxUint8)(frameSize & 0xFF);
-        buf[9] = (wxUint8)((frameSize >> 8) & 0xFF);
-        buf[10] = (wxUint8)((frameSize >> 16) & 0xFF);
-        buf[11] = (wxUint8)((frameSize >> 24) & 0xFF);
-        //Model Start address
-        buf[12] = (wxUint8)(startAddr & 0xFF);
-        buf[13] = (wxUint8)((startAddr >> 8) & 0xFF);
-        buf[14] = (wxUint8)((startAddr >> 16) & 0xFF);
-        buf[15] = (wxUint8)((startAddr >> 24) & 0xFF);
-        // Model Size
-        buf[16] = (wxUint8)(modelSize & 0xFF);
-        buf[17] = (wxUint8)((modelSize >> 8) & 0xFF);
-        buf[18] = (wxUint8)((modelSize >> 16) & 0xFF);
-        buf[19] = (wxUint8)((modelSize >> 24) & 0xFF);
-        f.Write(buf, fixedHeaderLength);
-
-        for (int i = 0; i < frames; i++)
-        {
-            //logger_base.debug("Writing frame %d %dms", i + 1, i * frameMS);
-            for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-            {
-                PacketData* p = (*it)->GetPacket(i * frameMS);
-                if (p != nullptr)
-                {
-                    //logger_base.debug("   Adding data uni %d ch %ld time %dms len %d seq %d time %d.%03d", (*it)->_universe, (*it)->_startChannel, p->_frameTimeMS, p->_length, p->_seq, p->_timeStamp.GetSecond(), p->_timeStamp.GetMillisecond());
-                    memcpy(buf + (*it)->_startChannel - 1, p->_pdata, p->_length);
-                }
-                else
-                {
-                    logger_base.debug("   No data found uni %d ch %ld ", (*it)->_universe, (*it)->_startChannel);
-                }
-            }
-            f.Write(buf, frameSize);
-        }
-
-        f.Close();
-        free(buf);
-    }
-    else
+    wxBusyCursor wait;
+    if (!_capture->SaveESEQ(file.ToStdString(), frameMS, startAddr, channelsPerFrame, frames))
     {
         log += "ERROR: Unable to create file.\n";
     }
 }
 
-int xCaptureFrame::GetFrames()
-{
-    int frames = 0;
-    for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-    {
-        frames = std::max(frames, (int)(*it)->_packets.size());
-    }
-    return frames;
-}
-
 void xCaptureFrame::OnButton_AnalyseClick(wxCommandEvent& event)
 {
-    int frameMS = GuessFrameMS();
-    wxString log = wxString::Format("Frame Time: %dms\n", frameMS);
-
-    log += wxString::Format("Universes: %d\n", (int)_capturedData.size());
-
-    long channelsPerFrame = RoundTo4(GetChannelsPerFrame());
-    log += wxString::Format("Channels Per Frame: %ld\n", channelsPerFrame);
-
-    wxDateTime startTime = GetStartTime();
-
-    int frames = GetFrames();
-    log += wxString::Format("Frames: %d\n", frames);
-
-    log += wxString::Format("Channel Structure Start:\n");
-    for (auto it = _capturedData.begin(); it != _capturedData.end(); ++it)
-    {
-        (*it)->CalculateFrames(startTime, frameMS);
-
-        log += wxString::Format("Channel %ld, Protocol %s, Universe %d, Size %d, Frames %d, StartFrameMS %dms, EndFrameMS %dms\n",
-            (*it)->_startChannel, (*it)->_protocol == ID_E131SOCKET ? "E131" : "ArtNET",
-            (*it)->_universe, (*it)->_packets.size() > 0 ? (*it)->_packets.front()->_length : 0,
-            (int)(*it)->_packets.size(), (*it)->_packets.size() > 0 ? (*it)->_packets.front()->_frameTimeMS : -1,
-            (*it)->_packets.size() > 0 ? (*it)->_packets.back()->_frameTimeMS : -1);
-    }
-    log += wxString::Format("Channel Structure End!\n");
+    int frameMS = _capture->GuessFrameMS();
+    long channelsPerFrame = 0;
+    int frames = 0;
+    wxString log = DescribeCapture(frameMS, channelsPerFrame, frames);
 
     ResultDialog dlgLog(this, log);
     dlgLog.ShowModal();
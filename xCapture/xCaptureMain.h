@@ -37,48 +37,15 @@
 //*)
 
 #include "../xLights/xLightsTimer.h"
-#include <list>
-#include <wx/socket.h>
+#include "PacketCapture.h"
 
 class wxDebugReportCompress;
-class wxDatagramSocket;
-
-class PacketData
-{
-public:
-    wxDateTime _timeStamp;
-    int _seq;
-    int _length;
-    wxByte* _pdata;
-    int _frameTimeMS;
-    virtual ~PacketData() { if (_pdata != nullptr) free(_pdata); }
-    PacketData(long type, wxByte* packet, int len);
-};
-
-class Collector
-{
-public:
-    int _universe;
-    long _protocol;
-    long _startChannel; // 1 based start channel
-    std::list<PacketData*> _packets;
-    virtual ~Collector();
-    Collector(long type, int universe) { _startChannel = -1; _universe = universe; _protocol = type; }
-    void AddPacket(long type, wxByte* packet, int len) { _packets.push_back(new PacketData(type, packet, len)); }
-    void CalculateFrames(wxDateTime startTime, int frameMS);
-    PacketData* GetPacket(long ms);
-    bool operator<(const Collector& c) const;
-};
 
 class xCaptureFrame : public wxFrame
 {
     void ValidateWindow();
 
-    std::list<Collector*> _capturedData;
-    wxDatagramSocket* _e131Socket;
-    wxDatagramSocket* _artNETSocket;
-    bool _capturing;
-    long _capturedPackets;
+    PacketCapture* _capture;
     std::string _capturedDesc;
     wxString _localIP;
     wxString _defaultIP;
@@ -87,16 +54,14 @@ class xCaptureFrame : public wxFrame
     void CloseSockets(bool force = false);
     void CreateE131Listener();
     void CreateArtNETListener();
+    std::vector<std::pair<int, int>> GetUniverseRanges(bool& all);
     void AddUniverseRange(int low, int high);
-    void PurgeCollectedData();
-    void StashPacket(long type, wxByte* packet, int len);
-    bool IsUniverseToBeCaptured(int universe, bool ignoreall = false);
-    int GuessFrameMS();
-    long GetChannelsPerFrame();
-    wxDateTime GetStartTime();
+    void UpdateCaptureSettings();
+    void OnCaptureTriggered(bool capturing);
     void SaveFSEQ(wxString file, int frameMS, long channelsPerFrame, int frames, wxString& log);
     void SaveESEQ(wxString file, int frameMS, long channelsPerFrame, int frames, wxString& log);
-    int GetFrames();
+    int GetOverrideFrameMS();
+    wxString DescribeCapture(int frameMS, long& channelsPerFrame, int& frames);
     void UpdateCaptureDesc();
     void LoadState();
     void SaveState();
@@ -108,9 +73,6 @@ public:
         void CreateDebugReport(wxDebugReportCompress *report);
         void SendReport(const wxString &loc, wxDebugReportCompress &report);
 
-        static const long ID_E131SOCKET;
-        static const long ID_ARTNETSOCKET;
-
 private:
 
         //(*Handlers(xCaptureFrame)
@@ -208,8 +170,7 @@ private:
 
         DECLARE_EVENT_TABLE()
 
-        void OnE131SocketEvent(wxSocketEvent& event);
-        void OnArtNETSocketEvent(wxSocketEvent& event);
+        void OnTriggerSpinChange(wxSpinEvent& event);
 };
 
 #endif // xCAPTUREMAIN_H
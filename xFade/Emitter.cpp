@@ -5,6 +5,11 @@
 #include "xFadeMain.h"
 #include "Settings.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD
+#include "emmintrin.h"
+#endif
+
 class EmitterThread : public wxThread
 {
     Emitter* _emitter;
@@ -34,111 +39,20 @@ public:
         logger_base.debug("Asking emitter thread to stop");
         _stop = true;
     }
-    
-    void Blend(wxByte* buffer, wxByte* blendBuffer, size_t channels, float pos, std::list<int> excludeChannels)
-    {
-        float inv = 1.0 - pos;
-        for (size_t i = 0; i < channels; ++i)
-        {
-            if (std::find(excludeChannels.begin(), excludeChannels.end(), i+1) != excludeChannels.end())
-            {
-                if (pos < 0.5)
-                {
-                    // dont change anything
-                }
-                else
-                {
-                    *(buffer + i) = *(blendBuffer + i);
-                }
-            }
-            else
-            {
-                *(buffer + i) = (wxByte)((float)*(buffer + i) * inv + (float)*(blendBuffer + i) * pos);
-            }
-        }
-    }
-
-    void PrepareData(PacketData* target, PacketData* source, long protocol)
-    {
-        if (protocol == 0 || source->_type == protocol)
-        {
-            // no conversion required
-            target->CopyFrom(source, source->_type);
-        }
-        else
-        {
-            // conversion required
-            target->CopyFrom(source, protocol);
-        }
-    }
 
     virtual void* Entry() override
     {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         logger_base.debug("Emitter thread started");
 
-        PacketData sendData;
-        sendData.SetLocalIP(_emitter->GetLocalIP());
-
         while (!_stop)
         {
             auto start = wxDateTime::UNow();
-            int diffMS = 0;
 
-            {
-                // output the frames now
-                auto ips = _emitter->GetIps();
-
-                for (auto it = ips.begin(); it != ips.end(); ++it)
-                {
-                    std::list<int> excludeChannels = _emitter->GetSettings()->GetExcludeChannels(it->first);
-
-                    auto l = _emitter->GetLeft(it->first);
-                    auto r = _emitter->GetRight(it->first);
-
-                    if (l._length == 0 && r._length > 0)
-                    {
-                        l.InitialiseLength(r._type, r._length, it->first);
-                    }
-                    else if (r._length == 0 && l._length > 0)
-                    {
-                        r.InitialiseLength(l._type, l._length, it->first);
-                    }
-
-                    auto protocol = _emitter->GetProtocol(it->first);
-
-                    float pos = _emitter->GetPos();
-
-                    if (pos == 0.0)
-                    {
-                        PrepareData(&sendData, &l, protocol);
-                        sendData.ApplyBrightness(_emitter->GetLeftBrightness(), excludeChannels);
-                    }
-                    else if (pos == 1.0)
-                    {
-                        PrepareData(&sendData, &r, protocol);
-                        sendData.ApplyBrightness(_emitter->GetRightBrightness(), excludeChannels);
-                    }
-                    else
-                    {
-                        int sz = std::min(l.GetDataLength(), r.GetDataLength());
-
-                        l.ApplyBrightness(_emitter->GetLeftBrightness(), excludeChannels);
-                        r.ApplyBrightness(_emitter->GetRightBrightness(), excludeChannels);
-
-                        Blend(l.GetDataPtr(), r.GetDataPtr(), sz, pos, excludeChannels);
-                        PrepareData(&sendData, &l, protocol);
-                    }
-
-                    sendData.Send(it->second);
-                    _emitter->IncrementSent();
-                }
-
-                // int ms = _emitter->GetFrameMS();
-
-                auto diff = wxDateTime::UNow() - start;
-                diffMS = _emitter->GetFrameMS() - diff.GetMilliseconds().ToLong();
-            }
+            _emitter->SendFrame();
+
+            auto diff = wxDateTime::UNow() - start;
+            int diffMS = _emitter->GetFrameMS() - diff.GetMilliseconds().ToLong();
 
             if (diffMS > 0)
                 wxMilliSleep(diffMS);
@@ -148,21 +62,93 @@ public:
     }
 };
 
-Emitter::Emitter(std::map<int, std::string>* ip, std::map<int, PacketData>* left, std::map<int, PacketData>* right, std::map<int, std::string>* protocol, std::mutex* lock, std::string localIP, Settings* settings)
+// out = (left * leftWeight + right * rightWeight) / 256 ... the weights must add up to no more than 256
+static void BlendFrame(wxByte* out, const wxByte* left, const wxByte* right, size_t channels, uint16_t leftWeight, uint16_t rightWeight)
+{
+    size_t i = 0;
+
+#ifdef SIMD
+    __m128i zero = _mm_setzero_si128();
+    __m128i lw = _mm_set1_epi16(leftWeight);
+    __m128i rw = _mm_set1_epi16(rightWeight);
+
+    for (; i + 16 <= channels; i += 16)
+    {
+        __m128i l = _mm_loadu_si128((const __m128i*)(left + i));
+        __m128i r = _mm_loadu_si128((const __m128i*)(right + i));
+
+        // widen to 16 bits, weight and sum then keep the high byte
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(l, zero), lw), _mm_mullo_epi16(_mm_unpacklo_epi8(r, zero), rw));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(l, zero), lw), _mm_mullo_epi16(_mm_unpackhi_epi8(r, zero), rw));
+
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+#endif
+
+    for (; i < channels; ++i)
+    {
+        out[i] = (wxByte)((left[i] * leftWeight + right[i] * rightWeight) >> 8);
+    }
+}
+
+EmitterOutput::EmitterOutput(int universe, int slot, const std::string& ip, long protocol, const std::list<int>& excludeChannels, const std::string& localIP)
+{
+    _universe = universe;
+    _slot = slot;
+    _ip = ip;
+    _protocol = protocol;
+    for (auto it = excludeChannels.begin(); it != excludeChannels.end(); ++it)
+    {
+        if (*it >= 1 && *it <= 512)
+        {
+            _excludeChannels.push_back(*it - 1);
+        }
+    }
+    _packet.SetLocalIP(localIP);
+    _leftType = 0;
+    _rightType = 0;
+    _leftLength = 0;
+    _rightLength = 0;
+}
+
+Emitter::Emitter(std::map<int, std::string>* ip, UniverseBuffers* left, UniverseBuffers* right, std::map<int, std::string>* protocol, std::string localIP, Settings* settings)
 {
     _settings = settings;
     _sent = 0;
     _localIP = localIP;
-    _stop = false;
-    _lock = lock;
     _frameMS = 50;
-    _targetIP = ip;
+    _pos = 0.0;
+    _leftBrightness = 100;
+    _rightBrightness = 100;
     _leftData = left;
     _rightData = right;
-    _protocol = protocol;
-    _emitterThread = new EmitterThread(this);
-    _emitterThread->Create();
-    _emitterThread->Run();
+    _emitterThread = nullptr;
+
+    // settings can only change while we are stopped so work out everything about each universe once
+    for (auto it = ip->begin(); it != ip->end(); ++it)
+    {
+        long p = 0;
+        auto pit = protocol->find(it->first);
+        if (pit != protocol->end())
+        {
+            if (pit->second == "E1.31")
+            {
+                p = xFadeFrame::ID_E131SOCKET;
+            }
+            else if (pit->second == "ArtNET")
+            {
+                p = xFadeFrame::ID_ARTNETSOCKET;
+            }
+        }
+
+        _outputs.push_back(EmitterOutput(it->first, _leftData->GetSlot(it->first), it->second, p, settings->GetExcludeChannels(it->first), localIP));
+    }
+
+    _leftFrame.resize(_outputs.size() * 512);
+    _rightFrame.resize(_outputs.size() * 512);
+    _outFrame.resize(_outputs.size() * 512);
+
+    StartThread();
 }
 
 Emitter::~Emitter()
@@ -170,24 +156,15 @@ Emitter::~Emitter()
     Stop();
 }
 
-void Emitter::Stop()
+void Emitter::StartThread()
 {
-    _stop = true;
-
-    // tell it to stop ... but it may take a bit of time to stop
-    if (_emitterThread != nullptr)
-    {
-        _emitterThread->Stop();
-        _emitterThread->Wait();
-        delete _emitterThread;
-        _emitterThread = nullptr;
-    }
+    _emitterThread = new EmitterThread(this);
+    _emitterThread->Create();
+    _emitterThread->Run();
 }
 
-void Emitter::Restart()
+void Emitter::StopThread()
 {
-    _stop = true;
-
     // tell it to stop ... but it may take a bit of time to stop
     if (_emitterThread != nullptr)
     {
@@ -196,86 +173,128 @@ void Emitter::Restart()
         delete _emitterThread;
         _emitterThread = nullptr;
     }
+}
 
-    _stop = false;
-    _emitterThread = new EmitterThread(this);
-    _emitterThread->Create();
-    _emitterThread->Run();
+void Emitter::Stop()
+{
+    StopThread();
 }
 
-std::map<int, std::string> Emitter::GetIps() const
+void Emitter::Restart()
 {
-    std::unique_lock<std::mutex> mutLock(*_lock);
+    StopThread();
+    StartThread();
+}
 
-    std::map<int, std::string> res;
+// copy the latest data for a universe into the frame zero filling anything not received
+int Emitter::GatherUniverse(UniverseBuffers* buffers, int slot, wxByte* frame, long& type)
+{
+    type = 0;
+    int length = 0;
 
-    if (!_stop)
+    if (slot >= 0 && slot < (int)buffers->GetCount())
     {
-        for (auto it = _targetIP->begin(); it != _targetIP->end(); ++it)
+        PacketData* packet = buffers->GetBuffer(slot)->GetLatest();
+        if (packet->_length > 0)
         {
-            res[it->first] = it->second;
+            length = std::max(0, std::min(packet->GetDataLength(), 512));
+            if (length > 0)
+            {
+                type = packet->_type;
+                memcpy(frame, packet->GetDataPtr(), length);
+            }
         }
     }
 
-    return res;
-}
-
-PacketData Emitter::GetLeft(int u) const
-{
-    std::unique_lock<std::mutex> mutLock(*_lock);
-
-    if (!_stop)
+    if (length < 512)
     {
-        if (_leftData->find(u) != _leftData->end())
-        {
-            PacketData d((*_leftData)[u]);
-            return d;
-        }
+        memset(frame + length, 0x00, 512 - length);
     }
 
-    return PacketData();
+    return length;
 }
 
-PacketData Emitter::GetRight(int u) const
+void Emitter::SendFrame()
 {
-    std::unique_lock<std::mutex> mutLock(*_lock);
+    if (_outputs.size() == 0) return;
 
-    if (!_stop)
+    // grab everything once so a fader move mid frame cant tear the frame
+    float pos = _pos;
+    int leftBrightness = _leftBrightness;
+    int rightBrightness = _rightBrightness;
+
+    for (size_t i = 0; i < _outputs.size(); ++i)
     {
-        if (_rightData->find(u) != _rightData->end())
-        {
-            PacketData d((*_rightData)[u]);
-            return d;
-        }
+        auto& o = _outputs[i];
+        o._leftLength = GatherUniverse(_leftData, o._slot, &_leftFrame[i * 512], o._leftType);
+        o._rightLength = GatherUniverse(_rightData, o._slot, &_rightFrame[i * 512], o._rightType);
     }
 
-    return PacketData();
-}
+    int leftWeight = (int)(256.0 * (1.0 - pos) * leftBrightness / 100.0 + 0.5);
+    leftWeight = std::max(0, std::min(256, leftWeight));
+    int rightWeight = (int)(256.0 * pos * rightBrightness / 100.0 + 0.5);
+    rightWeight = std::max(0, std::min(256 - leftWeight, rightWeight));
 
-long Emitter::GetProtocol(int u) const
-{
-    std::unique_lock<std::mutex> mutLock(*_lock);
+    BlendFrame(&_outFrame[0], &_leftFrame[0], &_rightFrame[0], _outFrame.size(), leftWeight, rightWeight);
 
-    if (!_stop)
+    for (size_t i = 0; i < _outputs.size(); ++i)
     {
-        if (_protocol->find(u) != _protocol->end())
+        auto& o = _outputs[i];
+        wxByte* out = &_outFrame[i * 512];
+
+        // excluded channels dont fade or dim ... they snap across at the midpoint
+        const wxByte* snap = pos < 0.5 ? &_leftFrame[i * 512] : &_rightFrame[i * 512];
+        for (auto it = o._excludeChannels.begin(); it != o._excludeChannels.end(); ++it)
         {
-            auto p = (*_protocol)[u];
+            out[*it] = snap[*it];
+        }
 
-            if (p == "As per input")
-            {
-                return 0;
-            }
-            else if (p == "E1.31")
+        int length;
+        if (pos == 0.0 && o._leftLength > 0)
+        {
+            length = o._leftLength;
+        }
+        else if (pos == 1.0 && o._rightLength > 0)
+        {
+            length = o._rightLength;
+        }
+        else
+        {
+            length = std::max(o._leftLength, o._rightLength);
+        }
+        if (length == 0) continue;
+
+        long type = o._protocol;
+        if (type == 0)
+        {
+            if (pos == 1.0)
             {
-                return xFadeFrame::ID_E131SOCKET;
+                type = o._rightType != 0 ? o._rightType : o._leftType;
             }
-            else if (p == "ArtNET")
+            else
             {
-                return xFadeFrame::ID_ARTNETSOCKET;
+                type = o._leftType != 0 ? o._leftType : o._rightType;
             }
         }
-    }
 
-    return 0;
+        PacketData& packet = o._packet;
+        int packetLength = length + (type == xFadeFrame::ID_E131SOCKET ? E131_PACKET_HEADERLEN : ARTNET_PACKET_HEADERLEN);
+        if (packet._type != type || packet._length != packetLength)
+        {
+            packet.InitialiseLength(type, packetLength, o._universe);
+        }
+
+        memcpy(packet.GetDataPtr(), out, length);
+        if (type == xFadeFrame::ID_E131SOCKET)
+        {
+            packet._data[111] = packet.GetNextSequenceNum(o._universe);
+        }
+        else
+        {
+            packet._data[12] = packet.GetNextSequenceNum(o._universe);
+        }
+
+        packet.Send(o._ip);
+        _sent++;
+    }
 }
@@ -2,8 +2,10 @@
 #define EMITTER_H
 
 #include <string>
-#include <mutex>
+#include <atomic>
 #include <map>
+#include <list>
+#include <vector>
 #include "PacketData.h"
 
 #define PINGINTERVAL 60
@@ -13,47 +15,64 @@ class EmitterThread;
 class ListenerManager;
 class Settings;
 
+// One universe we send. Built when the emitter starts as settings cant change while it runs.
+class EmitterOutput
+{
+public:
+    int _universe;
+    int _slot;
+    std::string _ip;
+    long _protocol; // 0 = as per input
+    std::vector<int> _excludeChannels; // 0 based
+    PacketData _packet;
+    long _leftType;
+    long _rightType;
+    int _leftLength;
+    int _rightLength;
+
+    EmitterOutput(int universe, int slot, const std::string& ip, long protocol, const std::list<int>& excludeChannels, const std::string& localIP);
+};
+
 class Emitter
 {
-    unsigned long _sent = 0;
+    std::atomic<unsigned long> _sent;
     EmitterThread* _emitterThread;
-    std::map<int, std::string>* _targetIP;
-    std::map<int, std::string>* _protocol;
-    std::map<int, PacketData>* _leftData;
-    std::map<int, PacketData>* _rightData;
-    int _frameMS;
-    float _pos;
-    bool _stop;
-    std::mutex* _lock;
+    UniverseBuffers* _leftData;
+    UniverseBuffers* _rightData;
+    std::vector<EmitterOutput> _outputs;
+    std::vector<wxByte> _leftFrame;
+    std::vector<wxByte> _rightFrame;
+    std::vector<wxByte> _outFrame;
+    std::atomic<int> _frameMS;
+    std::atomic<float> _pos;
     std::string _localIP;
-    int _leftBrightness;
-    int _rightBrightness;
+    std::atomic<int> _leftBrightness;
+    std::atomic<int> _rightBrightness;
     Settings* _settings;
 
+    void StartThread();
+    void StopThread();
+    static int GatherUniverse(UniverseBuffers* buffers, int slot, wxByte* frame, long& type);
+
     public:
 
-	Emitter(std::map<int, std::string>* ip, std::map<int, PacketData>* left, std::map<int, PacketData>* right, std::map<int, std::string>* protocol, std::mutex* mutex, std::string localIP, Settings* settings);
+	Emitter(std::map<int, std::string>* ip, UniverseBuffers* left, UniverseBuffers* right, std::map<int, std::string>* protocol, std::string localIP, Settings* settings);
 	virtual ~Emitter();
     void Stop();
     void Restart();
-    int GetFrameMS() const { std::unique_lock<std::mutex> mutLock(*_lock); return _frameMS; }
-    float GetPos() const { std::unique_lock<std::mutex> mutLock(*_lock); return _pos; }
-    void SetFrameMS(int ms) { std::unique_lock<std::mutex> mutLock(*_lock); _frameMS = ms; }
-    void SetPos(float pos) { std::unique_lock<std::mutex> mutLock(*_lock); _pos = pos; }
-    std::map<int, std::string> GetIps() const;
-    PacketData GetLeft(int u) const;
-    PacketData GetRight(int u) const;
-    long GetProtocol(int u) const;
+    void SendFrame();
+    int GetFrameMS() const { return _frameMS; }
+    float GetPos() const { return _pos; }
+    void SetFrameMS(int ms) { _frameMS = ms; }
+    void SetPos(float pos) { _pos = pos; }
     std::string GetLocalIP() const { return _localIP; }
-    void SetLocalIP(std::string localIP) { _localIP = localIP; }
     void SetLeftBrightness(int brightness) { _leftBrightness = brightness; }
     void SetRightBrightness(int brightness) { _rightBrightness = brightness; }
     int GetLeftBrightness() const { return _leftBrightness; }
     int GetRightBrightness() const { return _rightBrightness; }
     unsigned long GetSent() const { return _sent; }
-    void IncrementSent() { _sent++; }
     void ZeroSent() { _sent = 0; }
     Settings* GetSettings() const { return _settings; }
 };
 
-#endif 
\ No newline at end of file
+#endif
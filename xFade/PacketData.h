@@ -2,7 +2,9 @@
 #define PACKETDATA_H
 
 #include <wx/wx.h>
+#include <atomic>
 #include <map>
+#include <vector>
 
 #define ARTNET_PACKET_HEADERLEN 18
 #define ARTNET_PACKET_LEN (ARTNET_PACKET_HEADERLEN + 512)
@@ -40,4 +42,55 @@ public:
     void ApplyBrightness(int brightness, std::list<int> excludeChannels);
 };
 
+// The latest packet for one universe on one side of the fader. The receiver and the emitter
+// thread each own one of the three packets and trade through the third so neither ever waits.
+class UniverseBuffer
+{
+    static const int FRESH = 0x04;
+
+    PacketData _packets[3];
+    std::atomic<int> _shared;
+    int _writing;
+    int _reading;
+
+public:
+
+    UniverseBuffer() : _shared(1), _writing(0), _reading(2) { }
+
+    // receive side
+    PacketData* GetWriteBuffer() { return &_packets[_writing]; }
+    void Publish() { _writing = _shared.exchange(_writing | FRESH) & ~FRESH; }
+
+    // emitter side ... returns the most recently published packet
+    PacketData* GetLatest()
+    {
+        if (_shared.load() & FRESH)
+        {
+            _reading = _shared.exchange(_reading) & ~FRESH;
+        }
+        return &_packets[_reading];
+    }
+};
+
+// Universe buffers for one side of the fader indexed directly by universe number.
+// Only reconfigure when nothing is receiving or emitting.
+class UniverseBuffers
+{
+    std::vector<int> _slots;
+    std::vector<UniverseBuffer*> _buffers;
+    std::vector<int> _universes;
+
+public:
+
+    UniverseBuffers() : _slots(65536, -1) { }
+    virtual ~UniverseBuffers() { Clear(); }
+    void Clear();
+    void Configure(const std::map<int, std::string>& universes);
+    int GetSlot(int universe) const { return (universe >= 0 && universe < (int)_slots.size()) ? _slots[universe] : -1; }
+    UniverseBuffer* GetBuffer(int slot) const { return _buffers[slot]; }
+    UniverseBuffer* GetUniverse(int universe) const { int slot = GetSlot(universe); return slot < 0 ? nullptr : _buffers[slot]; }
+    size_t GetCount() const { return _buffers.size(); }
+    int GetFirstUniverse() const { return _universes.size() == 0 ? -1 : _universes.front(); }
+};
+
 #endif 
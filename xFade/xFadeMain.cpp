@@ -140,46 +140,51 @@ void xFadeFrame::StashPacket(long type, wxByte* packet, int len)
 
     if (!IsUniverseToBeCaptured(universe)) return;
 
-    {
-        std::unique_lock<std::mutex> mutLock(_lock);
+    // we only handle artdmx packets
+    if (type == ID_ARTNETSOCKET && packet[9] != 0x50) return;
 
-        if (left)
+    if (left)
+    {
+        UniverseBuffer* buffer = _leftData.GetUniverse(universe);
+        PacketData* pd = buffer->GetWriteBuffer();
+        if (!pd->Update(type, packet, len))
         {
-            if (!_leftData[universe].Update(type, packet, len))
-            {
-                logger_base.debug("Invalid packet.");
-            }
-            else
+            logger_base.debug("Invalid packet.");
+        }
+        else
+        {
+            _leftReceived++;
+            // only flash the LED based on receipt of data for the first universe
+            if (universe == _leftData.GetFirstUniverse())
             {
-                _leftReceived++;
-                // only flash the LED based on receipt of data for the first universe
-                if (universe == _leftData.begin()->second._universe)
+                if (pd->GetSequenceNum() % 10 == 0)
                 {
-                    if (_leftData[universe].GetSequenceNum() % 10 == 0)
-                    {
-                        Led_Left->Enable(!Led_Left->IsEnabled());
-                    }
+                    Led_Left->Enable(!Led_Left->IsEnabled());
                 }
             }
+            buffer->Publish();
         }
-        else if (right)
+    }
+    else if (right)
+    {
+        UniverseBuffer* buffer = _rightData.GetUniverse(universe);
+        PacketData* pd = buffer->GetWriteBuffer();
+        if (!pd->Update(type, packet, len))
         {
-            if (!_rightData[universe].Update(type, packet, len))
-            {
-                logger_base.debug("Invalid packet.");
-            }
-            else
+            logger_base.debug("Invalid packet.");
+        }
+        else
+        {
+            _rightReceived++;
+            // only flash the LED based on receipt of data for the first universe
+            if (universe == _rightData.GetFirstUniverse())
             {
-                _rightReceived++;
-                // only flash the LED based on receipt of data for the first universe
-                if (universe == _rightData.begin()->second._universe)
+                if (pd->GetSequenceNum() % 10 == 0)
                 {
-                    if (_rightData[universe].GetSequenceNum() % 10 == 0)
-                    {
-                        Led_Right->Enable(!Led_Right->IsEnabled());
-                    }
+                    Led_Right->Enable(!Led_Right->IsEnabled());
                 }
             }
+            buffer->Publish();
         }
     }
 }
@@ -244,7 +249,7 @@ bool xFadeFrame::IsRight(long type, wxByte* packet, int len)
 
 bool xFadeFrame::IsUniverseToBeCaptured(int universe)
 {
-    return _settings._targetIP.find(universe) != _settings._targetIP.end();
+    return _leftData.GetSlot(universe) >= 0;
 }
 
 xFadeFrame::xFadeFrame(wxWindow* parent, wxWindowID id)
@@ -449,7 +454,9 @@ xFadeFrame::xFadeFrame(wxWindow* parent, wxWindowID id)
     _leftReceived = 0;
     _rightReceived = 0;
 
-    _emitter = new Emitter(&_settings._targetIP, &_leftData, &_rightData, &_settings._targetProtocol, &_lock, _settings._localOutputIP, &_settings);
+    _leftData.Configure(_settings._targetIP);
+    _rightData.Configure(_settings._targetIP);
+    _emitter = new Emitter(&_settings._targetIP, &_leftData, &_rightData, &_settings._targetProtocol, _settings._localOutputIP, &_settings);
 
     for (int i = 0; i < JUKEBOXBUTTONS; i++)
     {
@@ -708,10 +715,10 @@ bool PacketData::Update(long type, wxByte* packet, int len)
         if (packet[11] != 0x31) return false;
         if (packet[12] != 0x37) return false;
 
-        _universe = ((int)_data[113] << 8) + (int)_data[114];
         _type = type;
         _length = len;
         memcpy(_data, packet, len);
+        _universe = ((int)_data[113] << 8) + (int)_data[114];
     }
     else if (type == xFadeFrame::ID_ARTNETSOCKET)
     {
@@ -726,10 +733,10 @@ bool PacketData::Update(long type, wxByte* packet, int len)
         if (packet[6] != 't') return false;
         if (packet[9] != 0x50) return true; // pretend success as otherwise I will log excessively
 
-        _universe = ((int)_data[15] << 8) + (int)_data[14];
         _type = type;
         _length = len;
         memcpy(_data, packet, len);
+        _universe = ((int)_data[15] << 8) + (int)_data[14];
     }
 
     return true;
@@ -1037,6 +1044,35 @@ void PacketData::CopyFrom(PacketData* source, long targetType)
     }
 }
 
+void UniverseBuffers::Clear()
+{
+    for (auto it = _universes.begin(); it != _universes.end(); ++it)
+    {
+        _slots[*it] = -1;
+    }
+    _universes.clear();
+
+    for (auto it = _buffers.begin(); it != _buffers.end(); ++it)
+    {
+        delete *it;
+    }
+    _buffers.clear();
+}
+
+void UniverseBuffers::Configure(const std::map<int, std::string>& universes)
+{
+    Clear();
+
+    for (auto it = universes.begin(); it != universes.end(); ++it)
+    {
+        if (it->first < 0 || it->first >= (int)_slots.size()) continue;
+
+        _slots[it->first] = _buffers.size();
+        _universes.push_back(it->first);
+        _buffers.push_back(new UniverseBuffer());
+    }
+}
+
 void xFadeFrame::CreateE131Listener()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -1849,7 +1885,9 @@ void xFadeFrame::OnButton_ConfigureClick(wxCommandEvent& event)
         SaveState();
     }
 
-    _emitter = new Emitter(&_settings._targetIP, &_leftData, &_rightData, &_settings._targetProtocol, &_lock, _settings._localOutputIP, &_settings);
+    _leftData.Configure(_settings._targetIP);
+    _rightData.Configure(_settings._targetIP);
+    _emitter = new Emitter(&_settings._targetIP, &_leftData, &_rightData, &_settings._targetProtocol, _settings._localOutputIP, &_settings);
     _emitter->SetLeftBrightness(Slider_LeftBrightness->GetValue());
     _emitter->SetRightBrightness(Slider_RightBrightness->GetValue());
     SetTiming();
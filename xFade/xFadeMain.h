@@ -37,7 +37,6 @@
 #include "../xLights/xLightsTimer.h"
 #include <map>
 #include <wx/socket.h>
-#include <mutex>
 #include "Settings.h"
 #include "PacketData.h"
 #include "wxLED.h"
@@ -57,8 +56,8 @@ class xFadeFrame : public wxFrame
     void ValidateWindow();
     void AddFadeTimeButton(std::string label);
 
-    std::map<int, PacketData> _leftData;
-    std::map<int, PacketData> _rightData;
+    UniverseBuffers _leftData;
+    UniverseBuffers _rightData;
     unsigned long _leftReceived;
     unsigned long _rightReceived;
     bool _suspendListen;
@@ -69,7 +68,6 @@ class xFadeFrame : public wxFrame
     wxDatagramSocket* _artNETSocketReceive;
     Emitter* _emitter;
     MIDIListener* _midiListener;
-    std::mutex _lock;
     int _direction; // auto fade direction
     wxLed* Led_Left;
     wxLed* Led_Right;
@@ -20,6 +20,7 @@ wxColourData ColorCurveButton::_colorData;
 ColorCurve::ColorCurve(const std::string& id, const std::string type, xlColor c)
 {
     _type = type;
+    _typeId = GetTypeId(type);
     _id = id;
     _timecurve = TC_TIME;
     _values.push_back(ccSortableColorPoint(0.5, c));
@@ -42,9 +43,11 @@ ColorCurve::ColorCurve(const std::string& s)
 
 void ColorCurve::Deserialise(const std::string& s)
 {
+    _lut.clear();
     if (s == "")
     {
         _type = "Gradient";
+        _typeId = CC_TYPE::Gradient;
         _active = false;
         _timecurve = TC_TIME;
         _values.clear();
@@ -62,6 +65,7 @@ void ColorCurve::Deserialise(const std::string& s)
         _timecurve = TC_TIME;
         _values.clear();
         _type = "Gradient";
+        _typeId = CC_TYPE::Gradient;
         wxArrayString v = wxSplit(wxString(s.c_str()), '|');
         for (auto vs = v.begin(); vs != v.end(); vs++)
         {
@@ -140,6 +144,7 @@ void ColorCurve::SetSerialisedValue(std::string k, std::string s)
     else if (kk == "Type")
     {
         _type = s;
+        _typeId = GetTypeId(s);
     }
     else if (kk == "Timecurve")
     {
@@ -162,6 +167,29 @@ void ColorCurve::SetSerialisedValue(std::string k, std::string s)
 void ColorCurve::SetType(std::string type)
 {
     _type = type;
+    _typeId = GetTypeId(type);
+    _lut.clear();
+}
+
+CC_TYPE ColorCurve::GetTypeId(const std::string& type)
+{
+    if (type == "None") return CC_TYPE::None;
+    if (type == "Random") return CC_TYPE::Random;
+    return CC_TYPE::Gradient;
+}
+
+void ColorCurve::Bake()
+{
+    _lut.clear();
+    if (_typeId == CC_TYPE::Random) return;
+
+    std::vector<xlColor> lut;
+    lut.reserve(CC_LUT_SIZE);
+    for (int i = 0; i < CC_LUT_SIZE; i++)
+    {
+        lut.push_back(CalcValueAt((float)i / (float)(CC_LUT_SIZE - 1)));
+    }
+    _lut.swap(lut);
 }
 
 uint8_t ChannelBlend(uint8_t c1, uint8_t c2, float ratio)
@@ -176,6 +204,8 @@ xlColor GetGradientColor(float ratio, xlColor& c1, xlColor& c2)
 
 ccSortableColorPoint* ColorCurve::GetPointAt(float offset)
 {
+    // the caller may change the point
+    _lut.clear();
     float x = ccSortableColorPoint::Normalise(offset);
     for (auto it = _values.begin(); it != _values.end(); ++it)
     {
@@ -188,9 +218,9 @@ ccSortableColorPoint* ColorCurve::GetPointAt(float offset)
     return nullptr;
 }
 
-xlColor ColorCurve::GetValueAt(float offset) const
+xlColor ColorCurve::CalcValueAt(float offset) const
 {
-    if (_type == "Gradient")
+    if (_typeId == CC_TYPE::Gradient)
     {
         float start;
         float end;
@@ -251,7 +281,7 @@ xlColor ColorCurve::GetValueAt(float offset) const
 
         return GetGradientColor((offset - start) / (end - start), startc, endc);
     }
-    else if (_type == "None")
+    else if (_typeId == CC_TYPE::None)
     {
         // find the value immediately before the offset ... that is the color to return
         float d = 0;
@@ -263,7 +293,7 @@ xlColor ColorCurve::GetValueAt(float offset) const
         }
         return pt->color;
     }
-    else if (_type == "Random")
+    else if (_typeId == CC_TYPE::Random)
     {
         xlColor c1;
         float d = 0;
@@ -329,6 +359,7 @@ bool ColorCurve::IsSetPoint(float offset)
 
 void ColorCurve::DeletePoint(float offset)
 {
+    _lut.clear();
     if (GetPointCount() > 1)
     {
         auto it = _values.begin();
@@ -350,6 +381,7 @@ void ColorCurve::DeletePoint(float offset)
 
 void ColorCurve::Flip()
 {
+    _lut.clear();
     auto oldvalues = _values;
     _values.clear();
     for (auto it = oldvalues.begin(); it != oldvalues.end(); ++it)
@@ -364,12 +396,14 @@ void ColorCurve::SetDefault(const wxColor& color)
     // we should only set default if the current CC only has one point
     if (_values.size() == 1)
     {
+        _lut.clear();
         _values.front().color = color;
     }
 }
 
 void ColorCurve::SetValueAt(float offset, xlColor c)
 {
+    _lut.clear();
     auto it = _values.begin();
     while (it != _values.end() && *it <= offset)
     {
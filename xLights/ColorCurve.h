@@ -7,10 +7,13 @@
 #include <wx/colour.h>
 #include <wx/colourdata.h>
 #include <list>
+#include <vector>
 
 #include "Color.h"
 
 #define CC_X_POINTS 100.0
+// number of entries in a baked colour curve
+#define CC_LUT_SIZE 1024
 
 class ccSortableColorPoint
 {
@@ -145,15 +148,26 @@ public:
 #define TC_CW 7
 #define TC_CCW 8
 
+enum class CC_TYPE
+{
+    Gradient,
+    None,
+    Random
+};
+
 class ColorCurve
 {
     std::list<ccSortableColorPoint> _values;
     std::string _type;
+    CC_TYPE _typeId = CC_TYPE::Gradient;
     std::string _id;
     bool _active;
     int _timecurve;
+    std::vector<xlColor> _lut; // empty unless baked
 
+    static CC_TYPE GetTypeId(const std::string& type);
     void SetSerialisedValue(std::string k, std::string v);
+    xlColor CalcValueAt(float offset) const;
     const ccSortableColorPoint* GetActivePoint(float x, float& duration) const;
     const ccSortableColorPoint* GetPriorActivePoint(float x, float& duration) const;
     const ccSortableColorPoint* GetNextActivePoint(float x, float& duration) const;
@@ -172,7 +186,16 @@ public:
     { return _id != ""; }
     void Deserialise(const std::string& s);
     void SetType(std::string type);
-    xlColor GetValueAt(float offset) const;
+    // Evaluates the curve into a lookup table so GetValueAt no longer walks the points.
+    // Random curves are never baked as every lookup is different. Any change to the curve discards the table.
+    void Bake();
+    xlColor GetValueAt(float offset) const
+    {
+        if (_lut.empty()) return CalcValueAt(offset);
+        if (!(offset > 0.0f)) return _lut.front();
+        if (offset >= 1.0f) return _lut.back();
+        return _lut[(int)(offset * (CC_LUT_SIZE - 1) + 0.5f)];
+    }
     ccSortableColorPoint* GetPointAt(float offset);
 	wxBitmap GetImage(int x, int y, bool bars);
     void SetActive(bool a) { _active = a; }
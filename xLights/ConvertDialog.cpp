@@ -107,6 +107,7 @@ ConvertDialog::ConvertDialog(wxWindow* parent, SeqDataType& SeqData_, OutputMana
 	ChoiceOutputFormat->Append(_("Lcb, LOR clipboard *.lcb"));
 	ChoiceOutputFormat->Append(_("HLS *.hlsnc"));
 	ChoiceOutputFormat->Append(_("LedBlinky Animation *.lwax"));
+	ChoiceOutputFormat->Append(_("FPP sparse file per controller, *.fseq"));
 	FlexGridSizer4->Add(ChoiceOutputFormat, 1, wxALL|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 2);
 	StaticText7 = new wxStaticText(this, ID_STATICTEXT8, _("All channels off at end:"), wxDefaultPosition, wxDefaultSize, 0, _T("ID_STATICTEXT8"));
 	FlexGridSizer4->Add(StaticText7, 1, wxALL|wxALIGN_LEFT|wxALIGN_CENTER_VERTICAL, 2);
@@ -2072,6 +2073,14 @@ void ConvertDialog::DoConversion(const wxString& Filename, const wxString& Outpu
         _parent->WriteFalconPiFile(fullpath);
         AppendConvertStatus(wxString("Finished writing new file: ") + fullpath + wxString("\n"));
     }
+    else if (Out3 == "FPP")
+    {
+        oName.SetExt(wxString("fseq"));
+        fullpath = oName.GetFullPath();
+        AppendConvertStatus(wxString("Writing Falcon Player sequence per controller\n"));
+        _parent->WriteFalconPiControllerFiles(fullpath);
+        AppendConvertStatus(wxString("Finished writing controller files for: ") + fullpath + wxString("\n"));
+    }
 #ifndef FPP
     else if (Out3 == "Lyn")
     {
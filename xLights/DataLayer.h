@@ -3,6 +3,8 @@
 
 #include <wx/string.h>
 #include <vector>
+#include <cstdint>
+#include <ctime>
 #include "SequenceData.h"
 
 class DataLayer
@@ -35,6 +37,20 @@ class DataLayer
 
         SequenceData& GetSequenceData() { return sequence_data; }
 
+        // Decoded copy of the data source kept between renders so an unchanged layer isn't read and
+        // decoded again. Only the channel ranges that are lit in some frame are held.
+        struct DecodedData {
+            wxString file;
+            time_t modified = 0;
+            uint64_t size = 0;
+            size_t channels = 0;    // channels in the file
+            size_t frames = 0;
+            size_t frameSize = 0;   // bytes held per frame ... the sum of the range lengths
+            std::vector<std::pair<uint32_t, uint32_t>> ranges; // file channel start, length
+            std::vector<uint8_t> data;
+        };
+        DecodedData& GetDecodedData() { return decoded_data; }
+
     private:
         wxString mName;
         wxString mSource;
@@ -44,6 +60,7 @@ class DataLayer
         int channel_offset;
         int lor_convert_params;
         SequenceData sequence_data;
+        DecodedData decoded_data;
 };
 
 class DataLayerSet
@@ -6,6 +6,7 @@
 
 
 #include <cmath>
+#include <atomic>
 
 
 class BaseDimmingCurve : public DimmingCurve {
@@ -236,6 +237,8 @@ public:
 
 DimmingCurve::DimmingCurve()
 {
+    static std::atomic<unsigned long long> __nextId(1);
+    _id = __nextId++;
 }
 
 DimmingCurve::~DimmingCurve()
@@ -19,9 +19,13 @@ class DimmingCurve
         static DimmingCurve *createFromXML(wxXmlNode *node);
         static DimmingCurve *createBrightnessGamma(int brightness, float gamma);
         static DimmingCurve *createFromFile(const wxString &file);
+
+        // unique for the life of the process so caches can tell a new curve from a freed one at the same address
+        unsigned long long GetId() const { return _id; }
     
     protected:
     private:
+        unsigned long long _id;
 };
 
 #endif // DIMMINGCURVE_H
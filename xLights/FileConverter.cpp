@@ -1,10 +1,13 @@
 #include <algorithm>
+#include <functional>
 #include <map>
+#include <random>
 
 #include <wx/app.h>
 #include <wx/arrstr.h>
 #include <wx/file.h>
 #include <wx/filename.h>
+#include <wx/stopwatch.h>
 #include <wx/xml/xml.h>
 
 #include "../include/spxml-0.5/spxmlparser.hpp"
@@ -19,11 +22,17 @@
     #include "ConvertDialog.h"
     #include "ConvertLogDialog.h"
     #include "outputs/Output.h"
+    #include "Parallel.h"
     #define string_format wxString::Format
 #endif
 #include "xLightsVersion.h"
 #include <log4cpp/Category.hh>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD
+#include "emmintrin.h"
+#endif
+
 static const int MAX_READ_BLOCK_SIZE = 4096 * 1024;
 
 void ConvertParameters::AppendConvertStatus(const wxString& msg, bool flushbuffer)
@@ -157,6 +166,29 @@ static void ClearLastPeriod( SequenceData& seq_data)
     }
 }
 
+// imported channels are drawn into the sequence data in blocks this wide so each job
+// writes whole cache lines of a frame
+static const size_t IMPORT_CHANNEL_BLOCK = 64;
+
+// Call f(start, end) for each block of channels. Blocks run in parallel so f must only
+// write the channels it is given.
+static void ForEachChannelBlock(size_t channels, const std::function<void(size_t, size_t)>& f)
+{
+    int blocks = (channels + IMPORT_CHANNEL_BLOCK - 1) / IMPORT_CHANNEL_BLOCK;
+#ifdef FPP
+    for (int b = 0; b < blocks; b++)
+#else
+    parallel_for(0, blocks, [&](int b)
+#endif
+    {
+        size_t start = b * IMPORT_CHANNEL_BLOCK;
+        f(start, std::min(channels, start + IMPORT_CHANNEL_BLOCK));
+    }
+#ifndef FPP
+    );
+#endif
+}
+
 class LORInfo
 {
 public:
@@ -188,6 +220,128 @@ public:
 
 typedef std::map<int, LORInfo> LORInfoMap;
 
+// A LOR effect as parsed. They are drawn into the sequence data later a block of
+// channels at a time.
+class LOREffect
+{
+public:
+    enum Type { INTENSITY, TWINKLE, SHIMMER };
+
+    Type type;
+    int startper;
+    int perdiff;
+    int intensity;
+    int startIntensity;
+    int endIntensity;
+    uint32_t seed; // twinkles draw their own random sequence so the result does not depend on drawing order
+
+    LOREffect(Type t, int sp, int pd, int i, int si, int ei, uint32_t s) :
+        type(t), startper(sp), perdiff(pd), intensity(i), startIntensity(si), endIntensity(ei), seed(s)
+    {
+    }
+};
+
+// flush parsed LOR effects to the sequence data once this many are waiting
+static const size_t LOR_MAX_PENDING_EFFECTS = 1024 * 1024;
+
+static void DrawLOREffect(SequenceData& seq_data, int channel, const LOREffect& e, int sequence_interval)
+{
+    static const int twinkleperiod = 400;
+
+    // the effect may run off either end of the sequence
+    int first = std::max(0, -e.startper);
+    int last = std::min(e.perdiff, (int)seq_data.NumFrames() - e.startper);
+    int rampdiff = e.endIntensity - e.startIntensity;
+    int i, intensity;
+
+    switch (e.type)
+    {
+    case LOREffect::INTENSITY:
+        if (e.intensity > 0)
+        {
+            for (i = first; i < last; i++)
+            {
+                seq_data[e.startper + i][channel] = e.intensity;
+            }
+        }
+        else if (e.startIntensity > 0 || e.endIntensity > 0)
+        {
+            // ramp
+            for (i = first; i < last; i++)
+            {
+                intensity = (int)((double)(i) / e.perdiff * rampdiff + e.startIntensity);
+                seq_data[e.startper + i][channel] = intensity;
+            }
+        }
+        break;
+    case LOREffect::TWINKLE:
+    {
+        std::minstd_rand rng(e.seed);
+        auto rnd = [&rng]() { return (double)(rng() - rng.min()) / (double)(rng.max() - rng.min()); };
+        int twinklestate = static_cast<int>(rnd()*2.0) & 0x01;
+        int nexttwinkle = static_cast<int>(rnd()*twinkleperiod + 100) / sequence_interval;
+        bool ramp = e.intensity <= 0;
+        if (ramp && e.startIntensity <= 0 && e.endIntensity <= 0)
+        {
+            break;
+        }
+        // the twinkle sequence has to be stepped through any frames before the start of the sequence
+        for (i = 0; i < last; i++)
+        {
+            if (i >= first)
+            {
+                intensity = ramp ? (int)((double)(i) / e.perdiff * rampdiff + e.startIntensity) : e.intensity;
+                seq_data[e.startper + i][channel] = intensity * twinklestate;
+            }
+            nexttwinkle--;
+            if (nexttwinkle <= 0)
+            {
+                twinklestate = 1 - twinklestate;
+                nexttwinkle = static_cast<int>(rnd()*twinkleperiod + 100) / sequence_interval;
+            }
+        }
+    }
+        break;
+    case LOREffect::SHIMMER:
+        if (e.intensity > 0)
+        {
+            for (i = first; i < last; i++)
+            {
+                int twinklestate = (e.startper + i) & 0x01;
+                seq_data[e.startper + i][channel] = e.intensity * twinklestate;
+            }
+        }
+        else if (e.startIntensity > 0 || e.endIntensity > 0)
+        {
+            // ramp
+            for (i = first; i < last; i++)
+            {
+                int twinklestate = (e.startper + i) & 0x01;
+                intensity = (int)((double)(i) / e.perdiff * rampdiff + e.startIntensity);
+                seq_data[e.startper + i][channel] = intensity * twinklestate;
+            }
+        }
+        break;
+    }
+}
+
+// Draw everything parsed so far. Each channel keeps its effects in file order so later
+// effects still overwrite earlier ones.
+static void DrawLOREffects(SequenceData& seq_data, std::vector<std::vector<LOREffect>>& channelEffects, int sequence_interval)
+{
+    size_t channels = std::min(channelEffects.size(), (size_t)seq_data.NumChannels());
+    ForEachChannelBlock(channels, [&](size_t start, size_t end) {
+        for (size_t ch = start; ch < end; ch++)
+        {
+            for (const auto& e : channelEffects[ch])
+            {
+                DrawLOREffect(seq_data, ch, e, sequence_interval);
+            }
+            std::vector<LOREffect>().swap(channelEffects[ch]);
+        }
+    });
+}
+
 
 void mapLORInfo(const LORInfo &info, std::vector< std::vector<int> > *unitSizes)
 {
@@ -230,9 +384,7 @@ void FileConverter::ReadLorFile(ConvertParameters& params)
 
     wxString NodeName, msg, deviceType, networkAsString;
     wxArrayString context;
-    int unit, circuit, rampdiff;
-    int i, twinklestate;
-    int twinkleperiod = 400;
+    int unit, circuit;
     int curchannel = -1;
     int MappedChannelCnt = 0;
     int MaxIntensity = 100;
@@ -440,7 +592,9 @@ void FileConverter::ReadLorFile(ConvertParameters& params)
     read = file.Read(bytes, MAX_READ_BLOCK_SIZE);
     parser->append(bytes, read);
 
-    //pass 2, convert the data
+    //pass 2, parse the effects ... they are drawn in parallel once we have a batch of them
+    std::vector<std::vector<LOREffect>> channelEffects(params.seq_data.NumChannels());
+    size_t pendingEffects = 0;
     event = parser->getNext();
     done = 0;
     bool empty = false;
@@ -612,87 +766,31 @@ void FileConverter::ReadLorFile(ConvertParameters& params)
                         }
                         if (EffectType == "intensity" || EffectType == "DMX intensity")
                         {
-                            if (intensity > 0)
-                            {
-                                for (i = 0; i < perdiff; i++)
-                                {
-                                    params.seq_data[startper + i][curchannel] = intensity;
-                                }
-                            }
-                            else if (startIntensity > 0 || endIntensity > 0)
-                            {
-                                // ramp
-                                rampdiff = endIntensity - startIntensity;
-                                for (i = 0; i < perdiff; i++)
-                                {
-                                    intensity = (int)((double)(i) / perdiff * rampdiff + startIntensity);
-                                    params.seq_data[startper + i][curchannel] = intensity;
-                                }
-                            }
+                            channelEffects[curchannel].push_back(LOREffect(LOREffect::INTENSITY, startper, perdiff, intensity, startIntensity, endIntensity, 0));
+                            pendingEffects++;
                         }
-                        else if (EffectType == "twinkle")
+                        else if (EffectType == "twinkle" || EffectType == "shimmer")
                         {
                             if (intensity == 0 && startIntensity == 0 && endIntensity == 0)
                             {
                                 intensity = MaxIntensity;
                             }
-                            twinklestate = static_cast<int>(rand01()*2.0) & 0x01;
-                            int nexttwinkle = static_cast<int>(rand01()*twinkleperiod + 100) / params.sequence_interval;
-                            if (intensity > 0)
+                            if (EffectType == "twinkle")
                             {
-                                for (i = 0; i < perdiff; i++)
-                                {
-                                    params.seq_data[startper + i][curchannel] = intensity * twinklestate;
-                                    nexttwinkle--;
-                                    if (nexttwinkle <= 0)
-                                    {
-                                        twinklestate = 1 - twinklestate;
-                                        nexttwinkle = static_cast<int>(rand01()*twinkleperiod + 100) / params.sequence_interval;
-                                    }
-                                }
+                                uint32_t seed = static_cast<uint32_t>(rand01() * 2147483645.0) + 1;
+                                channelEffects[curchannel].push_back(LOREffect(LOREffect::TWINKLE, startper, perdiff, intensity, startIntensity, endIntensity, seed));
                             }
-                            else if (startIntensity > 0 || endIntensity > 0)
+                            else
                             {
-                                // ramp
-                                rampdiff = endIntensity - startIntensity;
-                                for (i = 0; i < perdiff; i++)
-                                {
-                                    intensity = (int)((double)(i) / perdiff * rampdiff + startIntensity);
-                                    params.seq_data[startper + i][curchannel] = intensity * twinklestate;
-                                    nexttwinkle--;
-                                    if (nexttwinkle <= 0)
-                                    {
-                                        twinklestate = 1 - twinklestate;
-                                        nexttwinkle = static_cast<int>(rand01()*twinkleperiod + 100) / params.sequence_interval;
-                                    }
-                                }
+                                channelEffects[curchannel].push_back(LOREffect(LOREffect::SHIMMER, startper, perdiff, intensity, startIntensity, endIntensity, 0));
                             }
+                            pendingEffects++;
                         }
-                        else if (EffectType == "shimmer")
+
+                        if (pendingEffects >= LOR_MAX_PENDING_EFFECTS)
                         {
-                            if (intensity == 0 && startIntensity == 0 && endIntensity == 0)
-                            {
-                                intensity = MaxIntensity;
-                            }
-                            if (intensity > 0)
-                            {
-                                for (i = 0; i < perdiff; i++)
-                                {
-                                    twinklestate = (startper + i) & 0x01;
-                                    params.seq_data[startper + i][curchannel] = intensity * twinklestate;
-                                }
-                            }
-                            else if (startIntensity > 0 || endIntensity > 0)
-                            {
-                                // ramp
-                                rampdiff = endIntensity - startIntensity;
-                                for (i = 0; i < perdiff; i++)
-                                {
-                                    twinklestate = (startper + i) & 0x01;
-                                    intensity = (int)((double)(i) / perdiff * rampdiff + startIntensity);
-                                    params.seq_data[startper + i][curchannel] = intensity * twinklestate;
-                                }
-                            }
+                            DrawLOREffects(params.seq_data, channelEffects, params.sequence_interval);
+                            pendingEffects = 0;
                         }
                     }
                 }
@@ -711,6 +809,8 @@ void FileConverter::ReadLorFile(ConvertParameters& params)
     delete parser;
     file.Close();
 
+    DrawLOREffects(params.seq_data, channelEffects, params.sequence_interval);
+
     if (params.data_layer != nullptr)
     {
         params.data_layer->SetNumFrames(params.seq_data.NumFrames());
@@ -807,6 +907,82 @@ void FileConverter::ReadXlightsFile(ConvertParameters& params)
 
 }
 
+// HLS channel data waiting to be decoded into the sequence
+class HLSChannelData
+{
+public:
+    long channel;
+    std::string data;
+
+    HLSChannelData(long c, std::string& d) : channel(c)
+    {
+        data.swap(d);
+    }
+};
+
+// decode pending HLS channels once they hold this much data so large files are not held in memory
+static const size_t HLS_MAX_PENDING_DATA = 64 * 1024 * 1024;
+
+static int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// each frame is two hex digits and a separator
+static unsigned char DecodeHLSIntensity(const std::string& data, size_t frame)
+{
+    size_t pos = frame * 3;
+    if (pos + 2 <= data.size())
+    {
+        int hi = HexDigit(data[pos]);
+        int lo = HexDigit(data[pos + 1]);
+        if (hi >= 0 && lo >= 0)
+        {
+            return (hi << 4) | lo;
+        }
+    }
+    if (pos >= data.size())
+    {
+        return 0;
+    }
+    // anything odd gets the same treatment it always did
+    return strtoul(data.substr(pos, 2).c_str(), NULL, 16);
+}
+
+static void DrawHLSChannels(SequenceData& seq_data, std::vector<HLSChannelData>& pending)
+{
+    // a channel read twice keeps the last data read for it
+    std::map<long, size_t> last;
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        auto it = last.find(pending[i].channel);
+        if (it != last.end())
+        {
+            pending[it->second].channel = -1;
+        }
+        last[pending[i].channel] = i;
+    }
+
+    size_t frames = seq_data.NumFrames();
+    ForEachChannelBlock(pending.size(), [&](size_t start, size_t end) {
+        for (size_t f = 0; f < frames; f++)
+        {
+            unsigned char *frame = &seq_data[f][0];
+            for (size_t i = start; i < end; i++)
+            {
+                if (pending[i].channel >= 0 && pending[i].channel < (long)seq_data.NumChannels())
+                {
+                    frame[pending[i].channel] = DecodeHLSIntensity(pending[i].data, f);
+                }
+            }
+        }
+    });
+    pending.clear();
+}
+
 void FileConverter::ReadHLSFile(ConvertParameters& params)
 {
     long timeCells = 0;
@@ -816,7 +992,10 @@ void FileConverter::ReadHLSFile(ConvertParameters& params)
     long tmp;
     long universe = 0;
     long channelsInUniverse = 0;
-    wxString NodeName, NodeValue, Data, ChannelName;
+    wxString NodeName, NodeValue, ChannelName;
+    std::string Data;
+    std::vector<HLSChannelData> pending;
+    size_t pendingData = 0;
     wxArrayString context;
     wxArrayInt map;
     wxArrayString ChannelNames;
@@ -1034,8 +1213,9 @@ void FileConverter::ReadHLSFile(ConvertParameters& params)
                     }
                     if (NodeName == wxString("Block"))
                     {
-                        int idx = NodeValue.find("-");
-                        Data.append(NodeValue.substr(idx + 1));
+                        const char* text = stagEvent->getText();
+                        const char* dash = strchr(text, '-');
+                        Data.append(dash == nullptr ? text : dash + 1);
                     }
                     if (NodeName == wxString("UniverseNumber"))
                     {
@@ -1095,13 +1275,14 @@ void FileConverter::ReadHLSFile(ConvertParameters& params)
                             ChannelNames[channels].c_str(),
                             origName.c_str(),
                             o2.c_str()), false);
-                        for (unsigned long newper = 0; newper < params.seq_data.NumFrames(); newper++)
+                        pendingData += Data.size();
+                        pending.push_back(HLSChannelData(channels, Data));
+                        Data.clear();
+                        if (pendingData >= HLS_MAX_PENDING_DATA)
                         {
-                            long intensity;
-                            intensity = strtoul(Data.substr(newper * 3, 2).c_str(), NULL, 16);
-                            params.seq_data[newper][channels] = intensity;
+                            DrawHLSChannels(params.seq_data, pending);
+                            pendingData = 0;
                         }
-                        Data.clear();
                         channels++;
                     }
 
@@ -1122,6 +1303,8 @@ void FileConverter::ReadHLSFile(ConvertParameters& params)
     delete parser;
     file.Close();
 
+    DrawHLSChannels(params.seq_data, pending);
+
     if (params.data_layer != nullptr)
     {
         params.data_layer->SetNumFrames(params.seq_data.NumFrames());
@@ -1393,23 +1576,39 @@ void FileConverter::ReadVixFile(ConvertParameters& params)
     }
     params.seq_data.init(numChannels, VixNumPeriods, VixEventPeriod);
 
-    for (size_t ch=0; ch < params.seq_data.NumChannels(); ch++)
+    // work out which vixen channel ends up in each output channel ... if two share an output the last one wins
+    std::vector<long> source(params.seq_data.NumChannels(), -1);
+    for (size_t ch=0; ch < params.seq_data.NumChannels() && ch < VixChannels.size(); ch++)
     {
         int OutputChannel = VixChannels[ch] - min;
         if (ch < VixChannelNames.size())
         {
             ChannelNames[OutputChannel] = VixChannelNames[ch];
         }
-        for (size_t newper=0; newper < params.seq_data.NumFrames(); newper++)
+        source[OutputChannel] = ch;
+    }
+
+    unsigned char scale[256];
+    for (int i = 0; i < 256; i++)
+    {
+        scale[i] = (MaxIntensity != 255 && MaxIntensity != 0) ? i * 255 / MaxIntensity : i;
+    }
+
+    // vixen data is channel major so transpose it a block of output channels at a time
+    size_t frames = params.seq_data.NumFrames();
+    ForEachChannelBlock(params.seq_data.NumChannels(), [&](size_t start, size_t end) {
+        for (size_t newper=0; newper < frames; newper++)
         {
-            int intensity = VixSeqData[ch*VixNumPeriods+newper];
-            if (MaxIntensity != 255)
+            unsigned char *frame = &params.seq_data[newper][0];
+            for (size_t OutputChannel = start; OutputChannel < end; OutputChannel++)
             {
-                intensity=intensity * 255 / MaxIntensity;
+                if (source[OutputChannel] >= 0)
+                {
+                    frame[OutputChannel] = scale[VixSeqData[source[OutputChannel]*VixNumPeriods+newper]];
+                }
             }
-            params.seq_data[newper][OutputChannel] = intensity;
         }
-    }
+    });
 
     if( params.data_layer != nullptr )
     {
@@ -1671,25 +1870,278 @@ void FileConverter::ReadFalconFile(ConvertParameters& params)
     delete file;
 }
 
-void FileConverter::WriteFalconPiFile(ConvertParameters& params)
+#ifndef FPP
+// data layer channels are tracked as lit or not in chunks this big
+static const size_t DATALAYER_CHUNK = 64;
+// frames decoded by each parallel job
+static const size_t DATALAYER_BLOCK_FRAMES = 128;
+// layers whose full width frames would need more than this are read straight into the sequence rather than decoded and cached
+static const size_t DATALAYER_MAX_CACHE = 512 * 1024 * 1024;
+
+static bool GetDataLayerSize(const wxString& filename, size_t& channels, size_t& frames)
 {
-    static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
-    logger_conversion.debug("Start fseq write");
-    
-    
-    const wxUint8 vMajor = params.xLightsFrm->_fseqVersion;
-    FSEQFile *file = FSEQFile::createFSEQFile(params.out_filename, vMajor, FSEQFile::CompressionType::zstd, 2);
+    FSEQFile *file = FSEQFile::openFSEQFile(filename.ToStdString());
     if (!file) {
-        params.ConversionError(wxString("Unable to create file: ") + params.out_filename);
+        return false;
+    }
+    channels = file->getMaxChannel();
+    frames = channels > 0 ? file->getNumFrames() : 0;
+    delete file;
+    return true;
+}
+
+// Decode every frame of the file in parallel blocks and keep just the channel ranges lit in some frame.
+// Each block is compacted to the chunks lit within it as soon as it is decoded so at most one full width
+// block per job is held.
+static void DecodeDataLayer(const wxString& filename, size_t channels, size_t frames, DataLayer::DecodedData& decoded)
+{
+    size_t chunks = (channels + DATALAYER_CHUNK - 1) / DATALAYER_CHUNK;
+    size_t blocks = (frames + DATALAYER_BLOCK_FRAMES - 1) / DATALAYER_BLOCK_FRAMES;
+    std::vector<std::vector<uint8_t>> blockData(blocks);
+    std::vector<std::vector<uint8_t>> blockLit(blocks);
+
+    parallel_for(0, blocks, [&](int b) {
+        static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
+
+        size_t start = b * DATALAYER_BLOCK_FRAMES;
+        size_t end = std::min(frames, start + DATALAYER_BLOCK_FRAMES);
+        std::vector<uint8_t> raw((end - start) * channels);
+        std::vector<uint8_t>& lit = blockLit[b];
+        lit.resize(chunks);
+
+        // each job needs its own reader as they hold the decompression state
+        FSEQFile *f = FSEQFile::openFSEQFile(filename.ToStdString());
+        if (f == nullptr) {
+            return;
+        }
+        std::vector<std::pair<uint32_t, uint32_t>> rng;
+        rng.push_back(std::pair<uint32_t, uint32_t>(0, channels));
+        f->prepareRead(rng);
+
+        for (size_t fr = start; fr < end; fr++) {
+            FSEQFile::FrameData *fd = f->getFrame(fr);
+            if (fd == nullptr) {
+                // what we couldnt read stays black just as it did when reading straight into the sequence
+                logger_conversion.warn("Data layer %s stopped reading at frame %d.", (const char *)filename.c_str(), (int)fr);
+                break;
+            }
+            uint8_t *d = &raw[(fr - start) * channels];
+            fd->readFrame(d);
+            delete fd;
+
+            for (size_t c = 0; c < chunks; c++) {
+                if (!lit[c]) {
+                    size_t ce = std::min(channels, (c + 1) * DATALAYER_CHUNK);
+                    for (size_t i = c * DATALAYER_CHUNK; i < ce; i++) {
+                        if (d[i] != 0) {
+                            lit[c] = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        delete f;
+
+        // keep only the chunks lit in this block
+        size_t blockFrameSize = 0;
+        for (size_t c = 0; c < chunks; c++) {
+            if (lit[c]) {
+                blockFrameSize += std::min(channels, (c + 1) * DATALAYER_CHUNK) - c * DATALAYER_CHUNK;
+            }
+        }
+        std::vector<uint8_t>& data = blockData[b];
+        data.resize((end - start) * blockFrameSize);
+        uint8_t *out = data.data();
+        for (size_t fr = start; fr < end; fr++) {
+            const uint8_t *in = &raw[(fr - start) * channels];
+            for (size_t c = 0; c < chunks; c++) {
+                if (lit[c]) {
+                    size_t cs = c * DATALAYER_CHUNK;
+                    size_t length = std::min(channels, cs + DATALAYER_CHUNK) - cs;
+                    memcpy(out, in + cs, length);
+                    out += length;
+                }
+            }
+        }
+    });
+
+    std::vector<uint8_t> lit(chunks);
+    for (const auto& bl : blockLit) {
+        for (size_t c = 0; c < chunks; c++) {
+            lit[c] |= bl[c];
+        }
+    }
+
+    decoded.ranges.clear();
+    decoded.frameSize = 0;
+    for (size_t c = 0; c < chunks; c++) {
+        if (lit[c]) {
+            size_t ce = c;
+            while (ce < chunks && lit[ce]) ce++;
+            uint32_t start = c * DATALAYER_CHUNK;
+            uint32_t length = std::min(channels, ce * DATALAYER_CHUNK) - start;
+            decoded.ranges.push_back(std::pair<uint32_t, uint32_t>(start, length));
+            decoded.frameSize += length;
+            c = ce;
+        }
+    }
+
+    decoded.file = filename;
+    decoded.channels = channels;
+    decoded.frames = frames;
+    decoded.data.clear();
+    decoded.data.shrink_to_fit();
+    decoded.data.resize(frames * decoded.frameSize);
+
+    // the ranges are runs of lit chunks in order so walking the chunks lays each frame out the same way
+    parallel_for(0, blocks, [&](int b) {
+        size_t start = b * DATALAYER_BLOCK_FRAMES;
+        size_t end = std::min(frames, start + DATALAYER_BLOCK_FRAMES);
+        const std::vector<uint8_t>& bl = blockLit[b];
+        const uint8_t *in = blockData[b].data();
+        for (size_t fr = start; fr < end; fr++) {
+            uint8_t *out = &decoded.data[fr * decoded.frameSize];
+            for (size_t c = 0; c < chunks; c++) {
+                if (lit[c]) {
+                    size_t cs = c * DATALAYER_CHUNK;
+                    size_t length = std::min(channels, cs + DATALAYER_CHUNK) - cs;
+                    if (bl[c]) {
+                        memcpy(out, in, length);
+                        in += length;
+                    } else {
+                        memset(out, 0, length);
+                    }
+                    out += length;
+                }
+            }
+        }
+        std::vector<uint8_t>().swap(blockData[b]);
+    });
+}
+
+// out = in wherever in isn't black
+static void OverlayNonBlack(uint8_t *out, const uint8_t *in, size_t length)
+{
+    size_t i = 0;
+
+#ifdef SIMD
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(out + i));
+        __m128i black = _mm_cmpeq_epi8(s, zero);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_or_si128(_mm_and_si128(black, d), _mm_andnot_si128(black, s)));
+    }
+#endif
+
+    for (; i < length; i++) {
+        if (in[i] != 0) {
+            out[i] = in[i];
+        }
+    }
+}
+
+static void CompositeDataLayer(const DataLayer::DecodedData& decoded, SequenceData& seqData, int channelOffset, bool ignoreBlack)
+{
+    struct Span {
+        size_t src;
+        size_t dst;
+        size_t length;
+    };
+
+    // where each held range lands once offset ... anything past the end of the file channels or the
+    // sequence is dropped as ReadFalconFile does
+    long limit = std::min(decoded.channels, (size_t)seqData.NumChannels());
+    std::vector<Span> spans;
+    size_t src = 0;
+    for (const auto& r : decoded.ranges) {
+        long s = (long)r.first + channelOffset;
+        long e = s + r.second;
+        long cs = std::max(s, 0L);
+        long ce = std::min(e, limit);
+        if (cs < ce) {
+            spans.push_back({ src + (cs - s), (size_t)cs, (size_t)(ce - cs) });
+        }
+        src += r.second;
+    }
+    if (spans.empty()) {
         return;
     }
 
-    size_t stepSize = roundTo4(params.seq_data.NumChannels());
-    wxUint16 stepTime = params.seq_data.FrameTime();
+    int frames = std::min(decoded.frames, (size_t)seqData.NumFrames());
+    parallel_for(0, frames, [&](int f) {
+        const uint8_t *in = &decoded.data[f * decoded.frameSize];
+        uint8_t *out = &seqData[f][0];
+        for (const auto& sp : spans) {
+            if (ignoreBlack) {
+                OverlayNonBlack(out + sp.dst, in + sp.src, sp.length);
+            } else {
+                memcpy(out + sp.dst, in + sp.src, sp.length);
+            }
+        }
+    }, 50);
+}
+#endif
 
-    file->setChannelCount(stepSize);
-    file->setStepTime(stepTime);
-    file->setNumFrames(params.seq_data.NumFrames());
+void FileConverter::ReadDataLayer(ConvertParameters& params)
+{
+#ifdef FPP
+    ReadFalconFile(params);
+#else
+    static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
+
+    if (params.data_layer == nullptr ||
+        (params.read_mode != ConvertParameters::READ_MODE_NORMAL && params.read_mode != ConvertParameters::READ_MODE_IGNORE_BLACK)) {
+        ReadFalconFile(params);
+        return;
+    }
+
+    DataLayer::DecodedData& decoded = params.data_layer->GetDecodedData();
+    wxFileName fn(params.inp_filename);
+    time_t modified = 0;
+    uint64_t size = 0;
+    if (fn.FileExists()) {
+        modified = fn.GetModificationTime().GetTicks();
+        size = fn.GetSize().GetValue();
+    }
+
+    if (decoded.file != params.inp_filename || decoded.modified != modified || decoded.size != size) {
+        size_t channels = 0;
+        size_t frames = 0;
+        if (!GetDataLayerSize(params.inp_filename, channels, frames)) {
+            decoded = DataLayer::DecodedData();
+            logger_conversion.debug("Unable to load sequence: %s.", (const char *)params.inp_filename.c_str());
+            params.PlayerError(wxString("Unable to load sequence:\n") + params.inp_filename);
+            return;
+        }
+        if ((uint64_t)frames * channels > DATALAYER_MAX_CACHE) {
+            logger_conversion.debug("Data layer %s too big to cache ... reading it frame by frame.", (const char *)params.inp_filename.c_str());
+            decoded = DataLayer::DecodedData();
+            ReadFalconFile(params);
+            return;
+        }
+
+        wxStopWatch sw;
+        DecodeDataLayer(params.inp_filename, channels, frames, decoded);
+        decoded.modified = modified;
+        decoded.size = size;
+        logger_conversion.debug("Decoded data layer %s: %d frames, %d of %d channels lit in %ldms.",
+            (const char *)params.inp_filename.c_str(), (int)decoded.frames, (int)decoded.frameSize, (int)decoded.channels, sw.Time());
+    } else {
+        logger_conversion.debug("Using cached data layer %s.", (const char *)params.inp_filename.c_str());
+    }
+
+    params.data_layer->SetNumFrames(decoded.frames);
+    params.data_layer->SetNumChannels(decoded.channels);
+
+    CompositeDataLayer(decoded, params.seq_data, params.data_layer->GetChannelOffset(), params.read_mode == ConvertParameters::READ_MODE_IGNORE_BLACK);
+#endif
+}
+
+// media and creator headers every fseq we write carries
+static void AddFalconPiHeaders(FSEQFile *file, ConvertParameters& params)
+{
     if (params.media_filename) {
         if ((*params.media_filename).length() > 0) {
             FSEQFile::VariableHeader header;
@@ -1710,6 +2162,28 @@ void FileConverter::WriteFalconPiFile(ConvertParameters& params)
     header.data.resize(len);
     strcpy((char *)&header.data[0], ver.c_str());
     file->addVariableHeader(header);
+}
+
+void FileConverter::WriteFalconPiFile(ConvertParameters& params)
+{
+    static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
+    logger_conversion.debug("Start fseq write");
+    
+    
+    const wxUint8 vMajor = params.xLightsFrm->_fseqVersion;
+    FSEQFile *file = FSEQFile::createFSEQFile(params.out_filename, vMajor, FSEQFile::CompressionType::zstd, 2);
+    if (!file) {
+        params.ConversionError(wxString("Unable to create file: ") + params.out_filename);
+        return;
+    }
+
+    size_t stepSize = roundTo4(params.seq_data.NumChannels());
+    wxUint16 stepTime = params.seq_data.FrameTime();
+
+    file->setChannelCount(stepSize);
+    file->setStepTime(stepTime);
+    file->setNumFrames(params.seq_data.NumFrames());
+    AddFalconPiHeaders(file, params);
 
     file->writeHeader();
     size_t size = params.seq_data.NumFrames();
@@ -1720,3 +2194,99 @@ void FileConverter::WriteFalconPiFile(ConvertParameters& params)
     delete file;
     logger_conversion.debug("End fseq write");
 }
+
+#ifndef FPP
+// frames each controller file is handed at a time ... enough to keep the compressors busy between
+// trips through parallel_for while the frames are still in cache
+static const int CONTROLLER_FSEQ_FRAME_BLOCK = 32;
+
+void FileConverter::WriteFalconPiControllerFiles(ConvertParameters& params)
+{
+    static log4cpp::Category &logger_conversion = log4cpp::Category::getInstance(std::string("log_conversion"));
+    logger_conversion.debug("Start controller fseq write");
+    wxStopWatch sw;
+
+    size_t channels = params.seq_data.NumChannels();
+    size_t stepSize = roundTo4(channels);
+    wxFileName fn(params.out_filename);
+
+    std::vector<V2FSEQFile*> files;
+    for (const auto& ip : params._outputManager->GetIps()) {
+        // the channels this controller listens to, merged into as few ranges as possible
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (auto o : params._outputManager->GetAllOutputs(ip)) {
+            if (!o->IsEnabled()) continue;
+            long start = o->GetStartChannel() - 1;
+            long end = std::min((long)channels, start + o->GetChannels());
+            if (start >= 0 && start < end) {
+                ranges.push_back(std::pair<uint32_t, uint32_t>(start, end - start));
+            }
+        }
+        if (ranges.empty()) continue;
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<uint32_t, uint32_t>> merged;
+        for (const auto& r : ranges) {
+            if (!merged.empty() && r.first <= merged.back().first + merged.back().second) {
+                merged.back().second = std::max(merged.back().first + merged.back().second, r.first + r.second) - merged.back().first;
+            } else {
+                merged.push_back(r);
+            }
+        }
+        // the header only has room for 255 ranges so close the smallest gaps until it fits
+        while (merged.size() > 255) {
+            size_t best = 0;
+            for (size_t i = 1; i + 1 < merged.size(); i++) {
+                if (merged[i + 1].first - (merged[i].first + merged[i].second) < merged[best + 1].first - (merged[best].first + merged[best].second)) {
+                    best = i;
+                }
+            }
+            merged[best].second = merged[best + 1].first + merged[best + 1].second - merged[best].first;
+            merged.erase(merged.begin() + best + 1);
+        }
+        uint32_t controllerChannels = 0;
+        for (const auto& r : merged) {
+            controllerChannels += r.second;
+        }
+
+        std::string name = ip;
+        std::replace_if(name.begin(), name.end(), [](char c) { return !isalnum(c) && c != '.' && c != '-'; }, '_');
+        wxFileName cfn(fn);
+        cfn.SetName(fn.GetName() + "_" + name);
+        cfn.SetExt("fseq");
+
+        // sparse ranges need a V2 file whatever the normal fseq version is
+        V2FSEQFile *file = (V2FSEQFile*)FSEQFile::createFSEQFile(cfn.GetFullPath().ToStdString(), 2, FSEQFile::CompressionType::zstd, 2);
+        if (!file) {
+            params.ConversionError(wxString("Unable to create file: ") + cfn.GetFullPath());
+            continue;
+        }
+        file->setChannelCount(stepSize);
+        file->setStepTime(params.seq_data.FrameTime());
+        file->setNumFrames(params.seq_data.NumFrames());
+        file->m_sparseRanges = merged;
+        AddFalconPiHeaders(file, params);
+        file->writeHeader();
+        files.push_back(file);
+
+        params.AppendConvertStatus(string_format(wxString("Controller %s: %d channels in %d ranges -> %s"), ip, (int)controllerChannels, (int)merged.size(), cfn.GetFullPath()), false);
+    }
+
+    // one pass over the sequence with every controller file compressing its slice of each block in parallel
+    int frames = params.seq_data.NumFrames();
+    for (int start = 0; start < frames; start += CONTROLLER_FSEQ_FRAME_BLOCK) {
+        int end = std::min(frames, start + CONTROLLER_FSEQ_FRAME_BLOCK);
+        parallel_for(0, files.size(), [&](int f) {
+            for (int x = start; x < end; x++) {
+                files[f]->addFrame(x, &params.seq_data[x][0]);
+            }
+        });
+    }
+
+    parallel_for(0, files.size(), [&](int f) {
+        files[f]->finalize();
+        delete files[f];
+    });
+
+    logger_conversion.debug("End controller fseq write: %d files in %ldms", (int)files.size(), sw.Time());
+}
+#endif
@@ -78,7 +78,14 @@ class FileConverter
         static void ReadGlediatorFile(ConvertParameters& params);
         static void ReadConductorFile(ConvertParameters& params);
         static void ReadFalconFile(ConvertParameters& params);
+        // ReadFalconFile for data layers in the normal and ignore black modes but reusing the frames cached
+        // on params.data_layer when the file hasn't changed. Channels the layer never lights are skipped so
+        // the normal mode expects the sequence data to have been cleared.
+        static void ReadDataLayer(ConvertParameters& params);
         static void WriteFalconPiFile(ConvertParameters& params);
+        // One sparse V2 fseq per controller IP holding just the channels of that controller's outputs.
+        // Files are named after out_filename with the controller appended.
+        static void WriteFalconPiControllerFiles(ConvertParameters& params);
 
     
         static bool LoadVixenProfile(ConvertParameters& params, const wxString& ProfileName,
@@ -3,20 +3,220 @@
 #include <wx/filename.h>
 #include <wx/stdpaths.h>
 #include <wx/progdlg.h>
+#include <wx/file.h>
 
 #include "PhonemeDictionary.h"
+#include "Parallel.h"
 
+#include <algorithm>
+#include <cstring>
 #include <log4cpp/Category.hh>
 #include "UtilFunctions.h"
 
+// Compiled dictionary file layout, native byte order as it is only a local cache
+//   char[4] magic, uint32 version, uint64 source size, int64 source modified time, uint32 line count, uint32 line bytes
+//   uint32 offset of each line, sorted by word
+//   the lines, UTF-8 and nul terminated
+#define COMPILED_DICTIONARY_MAGIC "XPD1"
+#define COMPILED_DICTIONARY_VERSION 1
+#define COMPILED_DICTIONARY_HEADER_SIZE 32
+
+// compares the word at the start of a dictionary line with a word
+static int CompareWord(const char* line, size_t lineWordLen, const char* word, size_t wordLen)
+{
+    int res = memcmp(line, word, std::min(lineWordLen, wordLen));
+    if (res != 0) return res;
+    if (lineWordLen < wordLen) return -1;
+    if (lineWordLen > wordLen) return 1;
+    return 0;
+}
+
+static size_t GetLineWordLength(const char* line)
+{
+    const char* space = strchr(line, ' ');
+    return space == nullptr ? strlen(line) : space - line;
+}
+
+static bool ReadFile(const wxString& filename, std::vector<char>& data)
+{
+    wxFile f;
+    if (!wxFile::Exists(filename) || !f.Open(filename)) return false;
+    wxFileOffset len = f.Length();
+    if (len < 0) return false;
+    data.resize(len);
+    return len == 0 || f.Read(&data[0], len) == len;
+}
+
+bool PhonemeDictionary::CompiledDictionary::Load(const wxString& filename, unsigned long long srcSize, long long srcModified)
+{
+    std::vector<char> file;
+    if (!ReadFile(filename, file) || file.size() < COMPILED_DICTIONARY_HEADER_SIZE) return false;
+
+    uint32_t version;
+    unsigned long long size;
+    long long modified;
+    uint32_t lines;
+    uint32_t lineBytes;
+    memcpy(&version, &file[4], sizeof(version));
+    memcpy(&size, &file[8], sizeof(size));
+    memcpy(&modified, &file[16], sizeof(modified));
+    memcpy(&lines, &file[24], sizeof(lines));
+    memcpy(&lineBytes, &file[28], sizeof(lineBytes));
+
+    if (memcmp(&file[0], COMPILED_DICTIONARY_MAGIC, 4) != 0 ||
+        version != COMPILED_DICTIONARY_VERSION ||
+        size != srcSize || modified != srcModified ||
+        file.size() != COMPILED_DICTIONARY_HEADER_SIZE + (size_t)lines * sizeof(uint32_t) + lineBytes ||
+        (lineBytes > 0 && file.back() != 0))
+    {
+        // out of date or damaged
+        return false;
+    }
+    for (size_t i = 0; i < lines; i++)
+    {
+        uint32_t offset;
+        memcpy(&offset, &file[COMPILED_DICTIONARY_HEADER_SIZE + i * sizeof(uint32_t)], sizeof(offset));
+        if (offset >= lineBytes) return false;
+    }
+
+    sourceSize = srcSize;
+    sourceModified = srcModified;
+    count = lines;
+    data.swap(file);
+    return true;
+}
+
+bool PhonemeDictionary::CompiledDictionary::Compile(const wxString& source, wxFontEncoding defEnc, unsigned long long srcSize, long long srcModified)
+{
+    std::vector<char> raw;
+    if (!ReadFile(source, raw)) return false;
+
+    std::string text;
+    if (!raw.empty())
+    {
+        wxString content(&raw[0], wxConvAuto(defEnc), raw.size());
+        text = (const char*)content.ToUTF8();
+    }
+
+    struct Line
+    {
+        size_t start;
+        size_t wordLen;
+        size_t len;
+    };
+    std::vector<Line> entries;
+    entries.reserve(text.size() / 16);
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        size_t e = end;
+        while (e > pos && isspace((unsigned char)text[e - 1])) e--;
+        if (e > pos && text.compare(pos, 2, "##") != 0 && text.compare(pos, 2, ";;") != 0) // skip comments
+        {
+            size_t space = text.find(' ', pos);
+            if (space < e)
+            {
+                entries.push_back({ pos, space - pos, e - pos });
+            }
+        }
+        pos = end + 1;
+    }
+
+    // stable so the first definition of a word in the file is the one kept
+    std::stable_sort(entries.begin(), entries.end(), [&text](const Line& a, const Line& b) {
+        return CompareWord(&text[a.start], a.wordLen, &text[b.start], b.wordLen) < 0;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(), [&text](const Line& a, const Line& b) {
+        return CompareWord(&text[a.start], a.wordLen, &text[b.start], b.wordLen) == 0;
+    }), entries.end());
+
+    size_t lineBytes = 0;
+    for (const auto& it : entries)
+    {
+        lineBytes += it.len + 1;
+    }
+    if (lineBytes > 0xFFFFFFFF) return false;
+
+    uint32_t version = COMPILED_DICTIONARY_VERSION;
+    uint32_t lines = entries.size();
+    uint32_t lb = lineBytes;
+    data.assign(COMPILED_DICTIONARY_HEADER_SIZE + entries.size() * sizeof(uint32_t) + lineBytes, 0);
+    memcpy(&data[0], COMPILED_DICTIONARY_MAGIC, 4);
+    memcpy(&data[4], &version, sizeof(version));
+    memcpy(&data[8], &srcSize, sizeof(srcSize));
+    memcpy(&data[16], &srcModified, sizeof(srcModified));
+    memcpy(&data[24], &lines, sizeof(lines));
+    memcpy(&data[28], &lb, sizeof(lb));
+
+    char* offsets = &data[COMPILED_DICTIONARY_HEADER_SIZE];
+    char* strings = offsets + entries.size() * sizeof(uint32_t);
+    uint32_t offset = 0;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        memcpy(offsets + i * sizeof(uint32_t), &offset, sizeof(offset));
+        memcpy(strings + offset, &text[entries[i].start], entries[i].len);
+        offset += entries[i].len + 1;
+    }
+
+    sourceSize = srcSize;
+    sourceModified = srcModified;
+    count = entries.size();
+    return true;
+}
+
+bool PhonemeDictionary::CompiledDictionary::Save(const wxString& filename) const
+{
+    wxFile f;
+    if (!f.Create(filename, true)) return false;
+    return data.empty() || f.Write(&data[0], data.size()) == data.size();
+}
+
+const char* PhonemeDictionary::CompiledDictionary::GetLine(size_t index) const
+{
+    uint32_t offset;
+    memcpy(&offset, &data[COMPILED_DICTIONARY_HEADER_SIZE + index * sizeof(uint32_t)], sizeof(offset));
+    return &data[COMPILED_DICTIONARY_HEADER_SIZE + count * sizeof(uint32_t) + offset];
+}
+
+std::string PhonemeDictionary::CompiledDictionary::GetWord(size_t index) const
+{
+    const char* line = GetLine(index);
+    return std::string(line, GetLineWordLength(line));
+}
+
+const char* PhonemeDictionary::CompiledDictionary::Find(const std::string& word) const
+{
+    size_t low = 0;
+    size_t high = count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        const char* line = GetLine(mid);
+        int res = CompareWord(line, GetLineWordLength(line), word.c_str(), word.size());
+        if (res == 0) return line;
+        if (res < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
 void PhonemeDictionary::LoadDictionaries(const wxString &showDir, wxWindow* parent)
 {
-	if (phoneme_dict.size() > 0)
+	if (loaded)
 		return;
 
     LoadDictionary("user_dictionary", showDir, parent);
-    LoadDictionary("standard_dictionary", showDir, parent, wxFONTENCODING_ISO8859_1);
-    LoadDictionary("extended_dictionary", showDir, parent, wxFONTENCODING_ISO8859_1);
+    LoadCompiledDictionary("standard_dictionary", showDir, parent, wxFONTENCODING_ISO8859_1);
+    LoadCompiledDictionary("extended_dictionary", showDir, parent, wxFONTENCODING_ISO8859_1);
+    loaded = true;
 
     wxFileName phonemeFile = wxFileName::FileName(wxStandardPaths::Get().GetExecutablePath());
     phonemeFile.SetFullName("phoneme_mapping");
@@ -42,15 +242,13 @@ void PhonemeDictionary::LoadDictionaries(const wxString &showDir, wxWindow* pare
             if (strList[0] == ".")
                 phonemes.push_back(strList[1]);
             else
-				phoneme_map.insert( std::pair<wxString, wxString>(strList[0], strList[1]));
+				phoneme_map.insert( std::pair<std::string, std::string>(strList[0].ToStdString(), strList[1].ToStdString()));
         }
     }
 }
 
-void PhonemeDictionary::LoadDictionary(const wxString &filename, const wxString &showDir, wxWindow* parent, wxFontEncoding defEnc)
+wxString PhonemeDictionary::FindDictionary(const wxString &filename, const wxString &showDir)
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
     // start looking for dictionary in the show folder
     wxFileName phonemeFile = wxFileName::DirName(showDir);
     phonemeFile.SetFullName(filename);
@@ -67,41 +265,88 @@ void PhonemeDictionary::LoadDictionary(const wxString &filename, const wxString
     }
 
     if (!wxFile::Exists(phonemeFile.GetFullPath())) {
+        return "";
+    }
+    return phonemeFile.GetFullPath();
+}
+
+void PhonemeDictionary::LoadDictionary(const wxString &filename, const wxString &showDir, wxWindow* parent, wxFontEncoding defEnc)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxString phonemeFile = FindDictionary(filename, showDir);
+    if (phonemeFile == "") {
         logger_base.warn("Failed to open phoneme dictionary. '%s'", (const char *)filename.c_str());
         DisplayError("Failed to open Phoneme dictionary!");
         return;
     }
 
-    logger_base.debug("Loading phoneme dictionary. '%s'", (const char *)phonemeFile.GetFullPath().c_str());
-
-    wxProgressDialog dlg("Loading", "Loading dictionary " + phonemeFile.GetName(), 100, parent, wxPD_APP_MODAL | wxPD_AUTO_HIDE);
+    logger_base.debug("Loading phoneme dictionary. '%s'", (const char *)phonemeFile.c_str());
 
-    wxFileInputStream input(phonemeFile.GetFullPath());
+    wxFileInputStream input(phonemeFile);
     wxTextInputStream text(input, " \t", wxConvAuto(defEnc));
 
-    auto size = input.GetSize();
-    long linenum = 0;
     while(input.IsOk() && !input.Eof()) {
 		wxString line = text.ReadLine();
 		line = line.Trim();
         if (line.Length() == 0 || line.Left(2) == "##" || line.Left(2) == ";;")
 			continue; // skip comments
 
-		wxArrayString strList = wxSplit(line,' ');
-		if (strList.size() > 1) {
-			if (phoneme_dict.find(strList[0]) == phoneme_dict.end())
-				phoneme_dict.emplace(std::pair<wxString, wxArrayString>(strList[0], strList));
+        int space = line.Find(' ');
+		if (space != wxNOT_FOUND) {
+            std::string word = (const char*)line.Left(space).ToUTF8();
+			if (phoneme_dict.find(word) == phoneme_dict.end())
+				phoneme_dict.emplace(word, (const char*)line.ToUTF8());
 		}
-        linenum++;
-        if (linenum % 1000 == 0)
-        {
-            dlg.Update(input.TellI() * 100 / size);
-        }
     }
+}
+
+void PhonemeDictionary::LoadCompiledDictionary(const wxString &filename, const wxString &showDir, wxWindow* parent, wxFontEncoding defEnc)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxString source = FindDictionary(filename, showDir);
+    if (source == "") {
+        logger_base.warn("Failed to open phoneme dictionary. '%s'", (const char *)filename.c_str());
+        DisplayError("Failed to open Phoneme dictionary!");
+        return;
+    }
+
+    wxFileName sourceFile(source);
+    unsigned long long sourceSize = sourceFile.GetSize().GetValue();
+    long long sourceModified = sourceFile.GetModificationTime().GetTicks();
+
+    wxFileName compiledFile = wxFileName::DirName(showDir);
+    compiledFile.SetFullName(filename + ".compiled");
+
+    auto dict = std::make_unique<CompiledDictionary>();
+    if (showDir != "" && dict->Load(compiledFile.GetFullPath(), sourceSize, sourceModified)) {
+        logger_base.debug("Loaded compiled phoneme dictionary. '%s' %d words.", (const char *)compiledFile.GetFullPath().c_str(), (int)dict->GetCount());
+        compiled.push_back(std::move(dict));
+        return;
+    }
+
+    logger_base.debug("Compiling phoneme dictionary. '%s'", (const char *)source.c_str());
+
+    wxProgressDialog dlg("Loading", "Compiling dictionary " + sourceFile.GetName(), 100, parent, wxPD_APP_MODAL | wxPD_AUTO_HIDE);
+
+    if (!dict->Compile(source, defEnc, sourceSize, sourceModified)) {
+        logger_base.warn("Failed to read phoneme dictionary. '%s'", (const char *)source.c_str());
+        DisplayError("Failed to open Phoneme dictionary!");
+        return;
+    }
+    dlg.Update(80);
+
+    if (showDir != "" && !dict->Save(compiledFile.GetFullPath())) {
+        // we can still use it this time
+        logger_base.warn("Failed to save compiled phoneme dictionary. '%s'", (const char *)compiledFile.GetFullPath().c_str());
+    }
+    logger_base.debug("    %d words.", (int)dict->GetCount());
+    compiled.push_back(std::move(dict));
     dlg.Update(100);
 }
 
-void PhonemeDictionary::BreakdownWord(const wxString& text, wxArrayString& phonemes)
+std::string PhonemeDictionary::GetWordKey(const wxString& text)
 {
     wxString word = text;
     word.Replace("/", "");
@@ -134,45 +379,76 @@ void PhonemeDictionary::BreakdownWord(const wxString& text, wxArrayString& phone
     word.Replace("`", "");
     word.Replace("\t", " ");
 
-    phonemes.Clear();
+    return (const char*)word.Upper().ToUTF8();
+}
 
-    if (!phoneme_dict.count(word.Upper())) return;
-
-    wxArrayString pronunciation = phoneme_dict.at(word.Upper());
-    if (pronunciation.size() > 1) {
-        for (int i = 1; i < pronunciation.size(); i++) {
-
-            wxString p = pronunciation[i];
-            if (p.length() == 0) continue;
-            
-            if (phoneme_map.count(p)) {
-                bool skip = false;
-                if (phoneme_map[p] == "etc") {
-                    if (phonemes.Count() > 0) {
-                        if (phonemes.Last() == "etc") {
-                            skip = true;
-                        }
-                    }
-                }
-                if (!skip) {
-                    phonemes.push_back(phoneme_map[p]);
-                }
-            }
-            else {
-                bool skip = false;
-                if (phonemes.Count() > 0) {
-                    if (phonemes.Last() == "etc") {
-                        skip = true;
-                    }
-                }
-                if (!skip) {
-                    phonemes.push_back(phoneme_map[p]);
-                }
+bool PhonemeDictionary::FindPronunciation(const std::string& word, std::string& line) const
+{
+    auto it = phoneme_dict.find(word);
+    if (it != phoneme_dict.end()) {
+        line = it->second;
+        return true;
+    }
+    if (removed.find(word) != removed.end()) {
+        return false;
+    }
+    for (const auto& dict : compiled) {
+        const char* l = dict->Find(word);
+        if (l != nullptr) {
+            line = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PhonemeDictionary::BreakdownKey(const std::string& key, std::vector<std::string>& phonemes) const
+{
+    phonemes.clear();
+
+    std::string pronunciation;
+    if (!FindPronunciation(key, pronunciation)) return;
+
+    // skip the word itself
+    size_t pos = pronunciation.find(' ');
+    while (pos != std::string::npos) {
+        size_t start = pos + 1;
+        pos = pronunciation.find(' ', start);
+        std::string p = pronunciation.substr(start, pos == std::string::npos ? std::string::npos : pos - start);
+        if (p.length() == 0) continue;
+
+        bool lastEtc = phonemes.size() > 0 && phonemes.back() == "etc";
+        auto it = phoneme_map.find(p);
+        if (it != phoneme_map.end()) {
+            if (!(it->second == "etc" && lastEtc)) {
+                phonemes.push_back(it->second);
             }
         }
+        else if (!lastEtc) {
+            phonemes.push_back("");
+        }
+    }
+}
+
+void PhonemeDictionary::BreakdownWord(const wxString& text, wxArrayString& phonemes)
+{
+    phonemes.Clear();
+
+    std::vector<std::string> p;
+    BreakdownKey(GetWordKey(text), p);
+    for (const auto& it : p) {
+        phonemes.push_back(it);
     }
 }
 
+void PhonemeDictionary::BreakdownWords(const std::vector<std::string>& words, std::vector<std::vector<std::string>>& phonemes) const
+{
+    phonemes.resize(words.size());
+    parallel_for(0, (int)words.size(), [this, &words, &phonemes](int i) {
+        BreakdownKey(GetWordKey(words[i]), phonemes[i]);
+    }, 100);
+}
+
 void PhonemeDictionary::InsertSpacesAfterPunctuation(wxString& text)
 {
     // make sure there is a space after all punctuation marks
@@ -196,22 +472,51 @@ void PhonemeDictionary::InsertSpacesAfterPunctuation(wxString& text)
 
 void PhonemeDictionary::InsertPhoneme(const wxArrayString& phonemes)
 {
-    if (phoneme_dict.count(phonemes[0]))
-    {
-        phoneme_dict.erase(phonemes[0]);
-    }
-    phoneme_dict.insert(std::pair<wxString, wxArrayString>(phonemes[0], phonemes));
+    std::string word = (const char*)phonemes[0].ToUTF8();
+    phoneme_dict[word] = (const char*)wxJoin(phonemes, ' ', '\0').ToUTF8();
+    removed.erase(word);
 }
 
 void PhonemeDictionary::RemovePhoneme(const wxString & text)
 {
-    phoneme_dict.erase(text);
+    std::string word = (const char*)text.ToUTF8();
+    phoneme_dict.erase(word);
+    removed.insert(word);
+}
+
+bool PhonemeDictionary::ContainsPhoneme(const wxString& text) const
+{
+    std::string line;
+    return FindPronunciation((const char*)text.ToUTF8(), line);
+}
+
+wxArrayString PhonemeDictionary::GetPhoneme(const wxString& word) const
+{
+    std::string line;
+    if (!FindPronunciation((const char*)word.Upper().ToUTF8(), line)) {
+        return wxArrayString();
+    }
+    return wxSplit(wxString::FromUTF8(line.c_str()), ' ', '\0');
 }
 
 wxArrayString PhonemeDictionary::GetPhonemeList()
 {
     wxArrayString keys;
-    std::transform(std::begin(phoneme_dict), std::end(phoneme_dict), std::back_inserter(keys),
-        [](auto const& val) { return wxString(val.first); });
+    for (const auto& it : phoneme_dict) {
+        keys.push_back(wxString::FromUTF8(it.first.c_str()));
+    }
+    for (size_t d = 0; d < compiled.size(); d++) {
+        for (size_t i = 0; i < compiled[d]->GetCount(); i++) {
+            std::string word = compiled[d]->GetWord(i);
+            if (phoneme_dict.find(word) != phoneme_dict.end() || removed.find(word) != removed.end()) continue;
+            bool earlier = false;
+            for (size_t e = 0; e < d && !earlier; e++) {
+                earlier = compiled[e]->Find(word) != nullptr;
+            }
+            if (!earlier) {
+                keys.push_back(wxString::FromUTF8(word.c_str()));
+            }
+        }
+    }
     return keys;
 }
@@ -3,33 +3,72 @@
 
 #include <vector>
 #include <map>
+#include <set>
+#include <string>
+#include <memory>
 #include <wx/string.h>
 #include <wx/arrstr.h>
+#include <wx/fontenc.h>
 
 class wxWindow;
 
 class PhonemeDictionary
 {
     public:
-        PhonemeDictionary() {}
+        PhonemeDictionary() : loaded(false) {}
         virtual ~PhonemeDictionary() {}
 
         void LoadDictionaries(const wxString &showDir, wxWindow* parent);
         void LoadDictionary(const wxString &filename, const wxString &showDir, wxWindow* parent, wxFontEncoding defEnc = wxFONTENCODING_UTF8);
+        void LoadCompiledDictionary(const wxString &filename, const wxString &showDir, wxWindow* parent, wxFontEncoding defEnc);
         void BreakdownWord(const wxString& text, wxArrayString& phonemes);
+        // Breaks down all the words at once spreading the work across the parallel pool.
+        // Dictionaries must already be loaded. phonemes is resized to match words.
+        void BreakdownWords(const std::vector<std::string>& words, std::vector<std::vector<std::string>>& phonemes) const;
         void InsertSpacesAfterPunctuation(wxString& text);
         void InsertPhoneme(const wxArrayString& phonemes);
         void RemovePhoneme(const wxString& text);
-        bool ContainsPhoneme(const wxString& text) { return phoneme_dict.count(text); }
-        bool ContainsPhonemeMap(const wxString& text) { return phoneme_map.count(text); }
+        bool ContainsPhoneme(const wxString& text) const;
+        bool ContainsPhonemeMap(const wxString& text) const { return phoneme_map.count(text.ToStdString()); }
         wxArrayString GetPhonemeList();
-        wxArrayString GetPhoneme(const wxString& word) { return phoneme_dict[word.Upper()]; }
+        wxArrayString GetPhoneme(const wxString& word) const;
 
     protected:
     private:
+        // A dictionary compiled to a sorted table of lines with an offset per line so lookups are a
+        // binary search. It is cached in the show folder next to where the source would be looked for.
+        class CompiledDictionary
+        {
+            public:
+                bool Load(const wxString& filename, unsigned long long sourceSize, long long sourceModified);
+                bool Compile(const wxString& source, wxFontEncoding defEnc, unsigned long long sourceSize, long long sourceModified);
+                bool Save(const wxString& filename) const;
+                // returns the whole line including the word or nullptr
+                const char* Find(const std::string& word) const;
+                size_t GetCount() const { return count; }
+                std::string GetWord(size_t index) const;
+
+            private:
+                const char* GetLine(size_t index) const;
+                unsigned long long sourceSize = 0;
+                long long sourceModified = 0;
+                size_t count = 0;
+                std::vector<char> data;
+        };
+
+        static wxString FindDictionary(const wxString &filename, const wxString &showDir);
+        static std::string GetWordKey(const wxString& text);
+        bool FindPronunciation(const std::string& word, std::string& line) const;
+        void BreakdownKey(const std::string& key, std::vector<std::string>& phonemes) const;
+
+        bool loaded;
         std::vector<wxString> phonemes;
-        std::map<wxString, wxString> phoneme_map;
-        std::map<wxString, wxArrayString> phoneme_dict;
+        std::map<std::string, std::string> phoneme_map;
+        // user dictionary and words added while running. word -> line, UTF-8
+        std::map<std::string, std::string> phoneme_dict;
+        // words removed while running which may still be in the compiled dictionaries
+        std::set<std::string> removed;
+        std::vector<std::unique_ptr<CompiledDictionary>> compiled;
 };
 
 #endif // PHONEMEDICTIONARY_H
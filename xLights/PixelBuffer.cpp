@@ -83,7 +83,7 @@ void PixelBufferClass::reset(int nlayers, int timing, bool isNode)
     {
         layers[x] = new LayerInfo(frame);
         layers[x]->buffer.SetFrameTimeInMs(frameTimeInMs);
-        model->InitRenderBufferNodes("Default", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
+        model->GetRenderBufferNodes("Default", "2D", "None", layers[x]->buffer.Nodes, layers[x]->BufferWi, layers[x]->BufferHt);
         layers[x]->bufferType = "Default";
         layers[x]->camera = "2D";
         layers[x]->bufferTransform = "None";
@@ -117,7 +117,7 @@ void PixelBufferClass::InitPerModelBuffers(const ModelGroup &model, int layer, i
         Model *m = *it;
         RenderBuffer *buf = new RenderBuffer(frame);
         buf->SetFrameTimeInMs(timing);
-        m->InitRenderBufferNodes("Default", "2D", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
+        m->GetRenderBufferNodes("Default", "2D", "None", buf->Nodes, buf->BufferWi, buf->BufferHt);
         buf->InitBuffer(buf->BufferHt, buf->BufferWi, buf->BufferHt, buf->BufferWi, "None");
         layers[layer]->modelBuffers.push_back(std::unique_ptr<RenderBuffer>(buf));
     }
@@ -1557,6 +1557,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
     {
         int origNodeCount = inf->buffer.Nodes.size();
         inf->buffer.Nodes.clear();
+        inf->channelPlan.Invalidate();
 
         // If we are a 'Per Model Default' render buffer then we need to ensure we create a full set of pixels
         // so we change the type of the render buffer but just for model initialisation
@@ -1566,7 +1567,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
         if (StartsWith(type, "Per Model")) {
             tt = "Single Line";
         }
-        model->InitRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
+        model->GetRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
         if (origNodeCount != 0 && origNodeCount != inf->buffer.Nodes.size()) {
             inf->buffer.Nodes.clear();
             model->InitRenderBufferNodes(tt, camera, transform, inf->buffer.Nodes, inf->BufferWi, inf->BufferHt);
@@ -1627,7 +1628,7 @@ void PixelBufferClass::SetLayerSettings(int layer, const SettingsMap &settingsMa
                 std::string ntype = type.substr(10, type.length() - 10);
                 int bw, bh;
                 (*it)->Nodes.clear();
-                gp->Models()[cnt]->InitRenderBufferNodes(ntype, camera, transform, (*it)->Nodes, bw, bh);
+                gp->Models()[cnt]->GetRenderBufferNodes(ntype, camera, transform, (*it)->Nodes, bw, bh);
                 if (bw == 0) bw = 1; // zero sized buffers are a problem
                 if (bh == 0) bh = 1;
                 (*it)->InitBuffer(bh, bw, bh, bw, transform);
@@ -1713,56 +1714,291 @@ static inline bool IsInRange(const std::vector<bool> &restrictRange, size_t star
     return restrictRange[start];
 }
 
-void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange) {
+// Original per node output ... only used for nodes the channel plan couldnt flatten
+static void GetNodeChannels(NodeBaseClass *n, unsigned char *fdata) {
+    if (n->model != nullptr) { // I dont like this ... it should never be null
+        DimmingCurve *curve = n->model->modelDimmingCurve;
+        if (curve != nullptr) {
+            if (n->GetChanCount() == 1) {
+                uint8_t buf[3];
+                n->GetForChannels(buf);
+                xlColor color(buf[0], buf[0], buf[0]);
+                curve->apply(color);
+                n->SetColor(color);
+            } else {
+                xlColor color;
+                n->GetColor(color);
+                curve->apply(color);
+                n->SetColor(color);
+            }
+        }
+    }
+    n->GetForChannels(&fdata[n->ActChan]);
+}
+
+static void SetNodeChannels(NodeBaseClass *n, const unsigned char *fdata, RenderBuffer &buffer) {
+    xlColor color;
+    n->SetFromChannels(&fdata[n->ActChan]);
+    n->GetColor(color);
+
+    DimmingCurve *curve = n->model->modelDimmingCurve;
+    if (curve != nullptr) {
+        curve->reverse(color);
+    }
+    for (auto &a : n->Coords) {
+        buffer.SetPixel(a.bufX, a.bufY, color);
+    }
+}
 
-    // KW ... I think this needs to be optimised
-
-    if (layers[0] != nullptr) { // I dont like this ... it should never be null
-        for (auto &n : layers[0]->buffer.Nodes) {
-            size_t start = n->ActChan;
-            if (IsInRange(restrictRange, start)) {
-                if (n->model != nullptr) { // nor this
-                    DimmingCurve *curve = n->model->modelDimmingCurve;
-                    if (curve != nullptr) {
-                        if (n->GetChanCount() == 1) {
-                            uint8_t buf[3];
-                            n->GetForChannels(buf);
-                            xlColor color(buf[0], buf[0], buf[0]);
-                            curve->apply(color);
-                            
-                            n->SetColor(color);
-                        } else {
-                            xlColor color;
-                            n->GetColor(color);
-                            curve->apply(color);
-                            n->SetColor(color);
+DimmingCurve *PixelBufferClass::ChannelPlan::CurveFor(const NodeBaseClass *node) {
+    if (node->model == nullptr) {
+        return nullptr;
+    }
+    for (const auto &it : curves) {
+        if (it.model == node->model) {
+            return it.curve;
+        }
+    }
+    DimmingCurve *curve = node->model->modelDimmingCurve;
+    curves.push_back({ node->model, curve, curve == nullptr ? 0 : curve->GetId() });
+    return curve;
+}
+
+// The curves live on the models and can be replaced while we hold a plan so throw away
+// everything derived from them if any have changed
+void PixelBufferClass::ChannelPlan::CheckCurves() {
+    for (const auto &it : curves) {
+        const DimmingCurve *curve = it.model->modelDimmingCurve;
+        if ((curve == nullptr ? 0 : curve->GetId()) != it.id) {
+            curves.clear();
+            luts.clear();
+            separable.clear();
+            Invalidate();
+            return;
+        }
+    }
+}
+
+// Table of output component 'out' for a colour with v in component 'in' (or all three when in is -1)
+// after the curve is applied or reversed. With no curve this is an identity or zero table.
+const uint8_t *PixelBufferClass::ChannelPlan::Lut(DimmingCurve *curve, bool reverse, int in, int out) {
+    auto key = std::make_tuple(curve == nullptr ? 0ULL : curve->GetId(), reverse, in, out);
+    auto it = luts.find(key);
+    if (it != luts.end()) {
+        return it->second.data();
+    }
+
+    std::vector<uint8_t> &lut = luts[key];
+    lut.resize(256);
+    for (int v = 0; v < 256; v++) {
+        uint8_t c[3] = { 0, 0, 0 };
+        for (int x = 0; x < 3; x++) {
+            if (in == -1 || in == x) {
+                c[x] = v;
+            }
+        }
+        xlColor color(c[0], c[1], c[2]);
+        if (curve != nullptr) {
+            if (reverse) {
+                curve->reverse(color);
+            } else {
+                curve->apply(color);
+            }
+        }
+        lut[v] = out == 0 ? color.red : out == 1 ? color.green : color.blue;
+    }
+    return lut.data();
+}
+
+// A 3 channel node can only use per channel tables if every component of the curve depends on
+// that component alone. Gray only curves for instance leave coloured pixels untouched.
+bool PixelBufferClass::ChannelPlan::IsSeparable(DimmingCurve *curve, bool reverse) {
+    if (curve == nullptr) {
+        return true;
+    }
+    auto key = std::make_pair(curve->GetId(), reverse);
+    auto it = separable.find(key);
+    if (it != separable.end()) {
+        return it->second;
+    }
+
+    const uint8_t *lut[3];
+    for (int x = 0; x < 3; x++) {
+        lut[x] = Lut(curve, reverse, -1, x);
+    }
+    bool result = true;
+    for (int v = 0; v < 256 && result; v++) {
+        const uint8_t probes[5][3] = {
+            { (uint8_t)v, 0, 0 },
+            { 0, (uint8_t)v, 0 },
+            { 0, 0, (uint8_t)v },
+            { (uint8_t)v, (uint8_t)(v + 85), (uint8_t)(v + 170) },
+            { (uint8_t)(255 - v), (uint8_t)(v / 2), (uint8_t)v }
+        };
+        for (const auto &p : probes) {
+            xlColor color(p[0], p[1], p[2]);
+            if (reverse) {
+                curve->reverse(color);
+            } else {
+                curve->apply(color);
+            }
+            if (color.red != lut[0][p[0]] || color.green != lut[1][p[1]] || color.blue != lut[2][p[2]]) {
+                result = false;
+                break;
+            }
+        }
+    }
+    separable[key] = result;
+    return result;
+}
+
+void PixelBufferClass::ChannelPlan::BuildScatter(const std::vector<NodeBaseClassPtr> &nodes) {
+    scatter.clear();
+    scatterRuns.clear();
+    scatter.reserve(nodes.size() * 3);
+
+    for (const auto &n : nodes) {
+        DimmingCurve *curve = CurveFor(n.get());
+        bool flat = false;
+        if (n->IsChannelMapped()) {
+            if (n->GetChanCount() == 1) {
+                // single colour nodes put their value through the curve as a gray
+                flat = true;
+            } else if (n->GetChanCount() == 3) {
+                flat = IsSeparable(curve, false);
+            }
+        }
+
+        if (flat) {
+            const uint8_t *c = n->GetColorComponents();
+            for (int x = 0; x < 3; x++) {
+                uint8_t offset = n->GetChannelOffset(x);
+                if (offset != 255) {
+                    scatter.push_back({ c + x, Lut(curve, false, -1, x), n->ActChan + offset, n->ActChan });
+                }
+            }
+        } else {
+            scatterRuns.push_back({ (uint32_t)scatter.size(), n.get() });
+        }
+    }
+    scatterRuns.push_back({ (uint32_t)scatter.size(), nullptr });
+    scatterValid = true;
+}
+
+void PixelBufferClass::ChannelPlan::BuildGather(const RenderBuffer &buffer) {
+    gather.clear();
+    gatherRuns.clear();
+    pixelIndex.clear();
+    gather.reserve(buffer.Nodes.size());
+    gatherPixels = buffer.pixels.size();
+    gatherWi = buffer.BufferWi;
+    gatherHt = buffer.BufferHt;
+
+    for (const auto &n : buffer.Nodes) {
+        DimmingCurve *curve = CurveFor(n.get());
+        Gather g;
+        bool flat = false;
+        if (n->IsChannelMapped()) {
+            if (n->GetChanCount() == 1) {
+                // the node colour is just its own component so every output component comes from that one channel
+                for (int x = 0; x < 3; x++) {
+                    uint8_t offset = n->GetChannelOffset(x);
+                    if (offset != 255) {
+                        for (int y = 0; y < 3; y++) {
+                            g.chan[y] = n->ActChan + offset;
+                            g.lut[y] = Lut(curve, true, x, y);
                         }
+                        flat = true;
+                        break;
                     }
                 }
-                n->GetForChannels(&fdata[start]);
+            } else if (n->GetChanCount() == 3 && IsSeparable(curve, true)) {
+                flat = true;
+                for (int x = 0; x < 3; x++) {
+                    uint8_t offset = n->GetChannelOffset(x);
+                    if (offset == 255) {
+                        // component keeps whatever the node last held
+                        flat = false;
+                        break;
+                    }
+                    g.chan[x] = n->ActChan + offset;
+                    g.lut[x] = Lut(curve, true, -1, x);
+                }
+            }
+        }
+
+        if (flat) {
+            for (const auto &a : n->Coords) {
+                // same bounds SetPixel applies
+                if (a.bufX >= 0 && a.bufX < gatherWi && a.bufY >= 0 && a.bufY < gatherHt && (size_t)(a.bufY * gatherWi + a.bufX) < gatherPixels) {
+                    pixelIndex.push_back(a.bufY * gatherWi + a.bufX);
+                }
+            }
+            g.pixelEnd = pixelIndex.size();
+            gather.push_back(g);
+        } else {
+            gatherRuns.push_back({ (uint32_t)gather.size(), n.get() });
+        }
+    }
+    gatherRuns.push_back({ (uint32_t)gather.size(), nullptr });
+    gatherValid = true;
+}
+
+void PixelBufferClass::GetColors(unsigned char *fdata, const std::vector<bool> &restrictRange) {
+
+    if (layers[0] == nullptr) { // I dont like this ... it should never be null
+        return;
+    }
+
+    ChannelPlan &plan = layers[0]->channelPlan;
+    plan.CheckCurves();
+    if (!plan.scatterValid) {
+        plan.BuildScatter(layers[0]->buffer.Nodes);
+    }
+
+    const ChannelPlan::Scatter *s = plan.scatter.data();
+    size_t i = 0;
+    for (const auto &run : plan.scatterRuns) {
+        if (restrictRange.empty()) {
+            for (; i < run.end; ++i) {
+                fdata[s[i].chan] = s[i].lut[*s[i].src];
+            }
+        } else {
+            for (; i < run.end; ++i) {
+                if (IsInRange(restrictRange, s[i].nodeChan)) {
+                    fdata[s[i].chan] = s[i].lut[*s[i].src];
+                }
             }
         }
+        if (run.node != nullptr && IsInRange(restrictRange, run.node->ActChan)) {
+            GetNodeChannels(run.node, fdata);
+        }
     }
 }
 
 void PixelBufferClass::SetColors(int layer, const unsigned char *fdata)
 {
-    xlColor color;
-    for (auto &n : layers[layer]->buffer.Nodes) {
-        size_t start = n->ActChan;
-        
-        n->SetFromChannels(&fdata[start]);
-        n->GetColor(color);
-        
-        DimmingCurve *curve = n->model->modelDimmingCurve;
-        if (curve != nullptr) {
-            curve->reverse(color);
+    RenderBuffer &buffer = layers[layer]->buffer;
+    ChannelPlan &plan = layers[layer]->channelPlan;
+    plan.CheckCurves();
+    if (!plan.gatherValid || plan.gatherPixels != buffer.pixels.size() || plan.gatherWi != buffer.BufferWi || plan.gatherHt != buffer.BufferHt) {
+        plan.BuildGather(buffer);
+    }
+
+    const ChannelPlan::Gather *g = plan.gather.data();
+    const uint32_t *pi = plan.pixelIndex.data();
+    xlColor *pixels = buffer.pixels.data();
+    size_t i = 0;
+    size_t p = 0;
+    for (const auto &run : plan.gatherRuns) {
+        for (; i < run.end; ++i) {
+            xlColor color(g[i].lut[0][fdata[g[i].chan[0]]], g[i].lut[1][fdata[g[i].chan[1]]], g[i].lut[2][fdata[g[i].chan[2]]]);
+            for (; p < g[i].pixelEnd; ++p) {
+                pixels[pi[p]] = color;
+            }
         }
-        for (auto &a : n->Coords) {
-            layers[layer]->buffer.SetPixel(a.bufX,
-                                           a.bufY,
-                                           color);
-
+        if (run.node != nullptr) {
+            SetNodeChannels(run.node, fdata, buffer);
         }
     }
 }
@@ -1997,7 +2233,8 @@ void PixelBufferClass::PrepareVariableSubBuffer(int EffectPeriod, int layer)
     const std::string &camera = layers[layer]->camera;
     const std::string &transform = layers[layer]->transform;
     layers[layer]->buffer.Nodes.clear();
-    model->InitRenderBufferNodes(type, camera, transform, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt);
+    layers[layer]->channelPlan.Invalidate();
+    model->GetRenderBufferNodes(type, camera, transform, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt);
     ComputeSubBuffer(subBuffer, layers[layer]->buffer.Nodes, layers[layer]->BufferWi, layers[layer]->BufferHt, offset, layers[layer]->buffer.GetStartTimeMS(), layers[layer]->buffer.GetEndTimeMS());
     layers[layer]->buffer.BufferWi = layers[layer]->BufferWi;
     layers[layer]->buffer.BufferHt = layers[layer]->BufferHt;
@@ -26,6 +26,9 @@
 
 #include <wx/xml/xml.h>
 
+#include <map>
+#include <tuple>
+
 #include "models/Model.h"
 #include "models/SingleLineModel.h"
 #include "RenderBuffer.h"
@@ -93,6 +96,61 @@ class ModelGroup;
 class PixelBufferClass
 {
 private:
+    // GetColors/SetColors run for every model on every frame so the node to channel mapping of a layer
+    // is flattened the first time it is needed with the model dimming curves folded into 256 entry
+    // lookup tables. Nodes that cant be flattened (custom, intensity, white and rgbw nodes or a 3 channel
+    // node whose curve doesnt work channel by channel) keep using the node calls in their original order.
+    class ChannelPlan {
+    public:
+        struct Scatter {            // one output channel
+            const uint8_t *src;     // node colour component
+            const uint8_t *lut;
+            uint32_t chan;
+            uint32_t nodeChan;      // first channel of the node for the range restriction
+        };
+        struct Gather {             // one node read back into the buffer
+            uint32_t chan[3];       // channel red, green and blue are derived from
+            const uint8_t *lut[3];
+            uint32_t pixelEnd;      // end of this nodes pixels in pixelIndex
+        };
+        struct Run {                // flat entries up to end followed by a node that couldnt be flattened
+            uint32_t end;
+            NodeBaseClass *node;
+        };
+
+        bool scatterValid = false;
+        std::vector<Scatter> scatter;
+        std::vector<Run> scatterRuns;
+
+        bool gatherValid = false;
+        std::vector<Gather> gather;
+        std::vector<Run> gatherRuns;
+        std::vector<uint32_t> pixelIndex;
+        size_t gatherPixels = 0;
+        int gatherWi = 0;
+        int gatherHt = 0;
+
+        void Invalidate() { scatterValid = false; gatherValid = false; }
+        void CheckCurves();
+        void BuildScatter(const std::vector<NodeBaseClassPtr> &nodes);
+        void BuildGather(const RenderBuffer &buffer);
+
+    private:
+        struct ModelCurve {
+            const Model *model;
+            DimmingCurve *curve;
+            unsigned long long id;  // curve id as pointers can be reused once a curve is freed
+        };
+        std::vector<ModelCurve> curves;
+        // keyed by curve id
+        std::map<std::tuple<unsigned long long, bool, int, int>, std::vector<uint8_t>> luts;
+        std::map<std::pair<unsigned long long, bool>, bool> separable;
+
+        DimmingCurve *CurveFor(const NodeBaseClass *node);
+        const uint8_t *Lut(DimmingCurve *curve, bool reverse, int in, int out);
+        bool IsSeparable(DimmingCurve *curve, bool reverse);
+    };
+
     class LayerInfo {
     public:
         LayerInfo(xLightsFrame *frame) : buffer(frame) {
@@ -215,6 +273,7 @@ private:
         std::vector<std::unique_ptr<RenderBuffer>> modelBuffers;
 
         std::vector<uint8_t> mask;
+        ChannelPlan channelPlan;
         void calculateMask(bool isFirstFrame);
         void calculateMask(const std::string &type, bool mode, bool isFirstFrame);
         bool isMasked(int x, int y);
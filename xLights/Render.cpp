@@ -15,6 +15,7 @@
 #include "UtilFunctions.h"
 #include "PixelBuffer.h"
 #include "Parallel.h"
+#include "RenderProfile.h"
 
 #include <log4cpp/Category.hh>
 
@@ -71,6 +72,7 @@ public:
     PixelBufferClass *buffer;
     bool *ResetEffectState;
     bool returnVal = true;
+    RenderModelProfile *profile = nullptr;
 };
 
 class NextRenderer {
@@ -214,7 +216,7 @@ public:
     RenderJob(ModelElement *row, SequenceData &data, xLightsFrame *xframe, bool zeroBased = false)
         : Job(), NextRenderer(), rowToRender(row), seqData(&data), xLights(xframe),
             gauge(nullptr), currentFrame(0), renderLog(log4cpp::Category::getInstance(std::string("log_render"))),
-            supportsModelBlending(false), abort(false), statusMap(nullptr)
+            supportsModelBlending(false), abort(false), statusMap(nullptr), renderProfile(nullptr)
     {
         name = "";
         if (row != nullptr) {
@@ -290,6 +292,7 @@ public:
         }
         startFrame = 0;
         renderEvent.buffer = mainBuffer;
+        renderEvent.profile = &profile;
     }
 
     virtual ~RenderJob() {
@@ -494,6 +497,10 @@ public:
         supportsModelBlending = true;
     }
 
+    void SetRenderProfile(RenderProfile *p) {
+        renderProfile = p;
+    }
+
     bool ProcessFrame(int frame, Element *el, EffectLayerInfo &info, PixelBufferClass *buffer, int strand = -1, bool blend = false) {
 
         wxStopWatch sw;
@@ -561,7 +568,9 @@ public:
                 RenderBuffer& rb = buffer->BufferForLayer(layer, -1);
 
                 // I have to calc the output here to apply blend, rotozoom and transitions
+                wxStopWatch csw;
                 buffer->CalcOutput(frame, vl, layer);
+                profile.calcOutput.Add(csw.TimeInMicro().GetValue());
                 std::vector<bool> done;
                 done.resize(rb.pixels.size());
                 rb.CopyNodeColorsToPixels(done);
@@ -577,19 +586,32 @@ public:
                 });
             }
 
+            wxStopWatch esw;
             info.validLayers[layer] = xLights->RenderEffectFromMap(ef, layer, frame, info.settingsMaps[layer], *buffer, b, true, &renderEvent);
+            if (ef != nullptr && ef->GetEffectIndex() >= 0) {
+                long long us = esw.TimeInMicro().GetValue();
+                profile.AddEffect(ef->GetEffectIndex(), us);
+                if (el == rowToRender) {
+                    profile.AddLayer(layer, us);
+                }
+            }
             info.effectStates[layer] = b;
             effectsToUpdate |= info.validLayers[layer];
         }
 
         if (effectsToUpdate) {
             SetCalOutputStatus(frame, strand);
+            wxStopWatch csw;
             if (blend) {
                 buffer->SetColors(numLayers, &((*seqData)[frame][0]));
                 info.validLayers[numLayers] = true;
             }
             buffer->CalcOutput(frame, info.validLayers);
-            buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+            {
+                std::shared_lock<std::shared_timed_mutex> frameLock(seqData->GetFrameLock());
+                buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+            }
+            profile.calcOutput.Add(csw.TimeInMicro().GetValue());
         }
 
         if (sw.Time() > 500)
@@ -675,12 +697,14 @@ public:
                 if (frame >= maxFrameBeforeCheck) {
                     wxStopWatch sw;
                     maxFrameBeforeCheck = waitForFrame(frame);
+                    profile.wait.Add(sw.TimeInMicro().GetValue());
 
                     if (sw.Time() > 500)
                     {
                         renderLog.info("Model %s rendering frame %d waited %dms waiting for other models to finish.", (const char *)(mainModelInfo.element != nullptr) ? mainModelInfo.element->GetName().c_str() : "", frame, sw.Time());
                     }
                 }
+                wxStopWatch fsw;
                 bool cleared = ProcessFrame(frame, rowToRender, mainModelInfo, mainBuffer, -1, supportsModelBlending);
                 if (!subModelInfos.empty()) {
                     for (auto a = subModelInfos.begin(); a != subModelInfos.end(); ++a) {
@@ -724,16 +748,27 @@ public:
                         }
 
                         SetRenderingStatus(frame, &nodeSettingsMaps[node], -1, strand, inode, cleared);
-                        if (xLights->RenderEffectFromMap(el, 0, frame, nodeSettingsMaps[node], *buffer, nodeEffectStates[node], true, &renderEvent)) {
+                        wxStopWatch esw;
+                        bool nodeValid = xLights->RenderEffectFromMap(el, 0, frame, nodeSettingsMaps[node], *buffer, nodeEffectStates[node], true, &renderEvent);
+                        if (el != nullptr && el->GetEffectIndex() >= 0) {
+                            profile.AddEffect(el->GetEffectIndex(), esw.TimeInMicro().GetValue());
+                        }
+                        if (nodeValid) {
                             SetCalOutputStatus(frame, strand, inode);
                             //copy to output
+                            wxStopWatch csw;
                             std::vector<bool> valid(2, true);
                             buffer->SetColors(1, &((*seqData)[frame][0]));
                             buffer->CalcOutput(frame, valid);
-                            buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+                            {
+                                std::shared_lock<std::shared_timed_mutex> frameLock(seqData->GetFrameLock());
+                                buffer->GetColors(&((*seqData)[frame][0]), rangeRestriction);
+                            }
+                            profile.calcOutput.Add(csw.TimeInMicro().GetValue());
                         }
                     }
                 }
+                profile.frames.Add(fsw.TimeInMicro().GetValue());
                 //mainBuffer->ApplyDimmingCurves(&((*seqData)[frame][0]));
                 if (HasNext()) {
                     SetGenericStatus("%s: Notifying next renderer of frame %d done", frame);
@@ -751,6 +786,14 @@ public:
 			renderLog.error("Caught an unknown exception on rendering thread.");
             logger_base.error("Caught an unknown exception on rendering thread.");
         }
+        if (renderProfile != nullptr) {
+            std::vector<std::string> effectNames;
+            for (size_t x = 0; x < xLights->GetEffectManager().size(); ++x) {
+                RenderableEffect *reff = xLights->GetEffectManager().GetEffect(x);
+                effectNames.push_back(reff == nullptr ? STR_EMPTY : reff->Name());
+            }
+            renderProfile->AddModel(name, profile, effectNames);
+        }
         if (HasNext()) {
             //make sure the previous has told us we're at the end.  If we return before waiting, the previous
             //may try sending the END_OF_RENDER_FRAME to us and we'll have been deleted
@@ -853,6 +896,9 @@ private:
     std::vector<EffectLayerInfo *> subModelInfos;
 
     std::map<SNPair, PixelBufferClassPtr> nodeBuffers;
+
+    RenderModelProfile profile;
+    RenderProfile *renderProfile;
 };
 
 
@@ -907,6 +953,7 @@ public:
         jobs = nullptr;
         aggregators = nullptr;
         renderProgressDialog = nullptr;
+        profile = nullptr;
     };
     std::function<void()> callback;
     int numRows;
@@ -916,8 +963,29 @@ public:
     AggregatorRenderer **aggregators;
     RenderProgressDialog *renderProgressDialog;
     std::list<Model *> restriction;
+    RenderProfile *profile;
+    wxStopWatch stopWatch;
 };
 
+// the profile of the last full render is written next to the log file
+static std::string GetRenderProfileFileName(const std::string& ext)
+{
+    wxString fileName = "xLights_render_profile." + ext;
+#ifdef __WXMSW__
+    wxString dir;
+    wxGetEnv("APPDATA", &dir);
+    return (dir + "/" + fileName).ToStdString();
+#endif
+#ifdef __WXOSX_MAC__
+    wxFileName home;
+    home.AssignHomeDir();
+    return (home.GetFullPath() + "/Library/Logs/" + fileName).ToStdString();
+#endif
+#ifdef __LINUX__
+    return ("/tmp/" + fileName).ToStdString();
+#endif
+}
+
 void xLightsFrame::LogRenderStatus()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
@@ -980,6 +1048,13 @@ static bool HasEffects(ModelElement *me) {
 
 void xLightsFrame::OnProgressBarDoubleClick(wxMouseEvent &evt) {
     if (renderProgressInfo.empty()) {
+        if (_lastRenderProfile != nullptr) {
+            RenderProgressDialog dlg(this);
+            dlg.ShowProfile(_lastRenderProfile->AsText(50) +
+                            "\nFull report: " + GetRenderProfileFileName("json") +
+                            "\n             " + GetRenderProfileFileName("csv"));
+            dlg.ShowModal();
+        }
         return;
     }
     for (auto it = renderProgressInfo.begin(); it != renderProgressInfo.end(); ++it) {
@@ -1068,6 +1143,13 @@ void xLightsFrame::UpdateRenderStatus() {
                 delete rpi->renderProgressDialog;
                 rpi->renderProgressDialog = nullptr;
             }
+            if (rpi->profile != nullptr) {
+                rpi->profile->SetElapsedMS(rpi->stopWatch.Time());
+                rpi->profile->Log();
+                rpi->profile->Save(GetRenderProfileFileName("json"), GetRenderProfileFileName("csv"));
+                _lastRenderProfile.reset(rpi->profile);
+                rpi->profile = nullptr;
+            }
             RenderDone();
             delete []rpi->jobs;
             delete []rpi->aggregators;
@@ -1318,8 +1400,17 @@ void xLightsFrame::Render(const std::list<Model*> models,
 
     channelMaps.clear();
     RenderProgressDialog *renderProgressDialog = nullptr;
+    RenderProfile *profile = nullptr;
     if (progressDialog) {
         renderProgressDialog = new RenderProgressDialog(this);
+
+        // only the renders the user waits on are profiled, the small incremental renders would just overwrite them
+        profile = new RenderProfile(wxFileName(xlightsFilename).GetName().ToStdString(), startFrame, endFrame);
+        for (row = 0; row < numRows; ++row) {
+            if (jobs[row]) {
+                jobs[row]->SetRenderProfile(profile);
+            }
+        }
     }
     unsigned int count = 0;
     if (clear) {
@@ -1383,12 +1474,14 @@ void xLightsFrame::Render(const std::list<Model*> models,
         pi->renderProgressDialog = renderProgressDialog;
         pi->restriction = restrictToModels;
         pi->aggregators = aggregators;
+        pi->profile = profile;
 
         renderProgressInfo.push_back(pi);
     } else {
         callback();
         if (progressDialog) {
             delete renderProgressDialog;
+            delete profile;
         }
     }
 }
@@ -1884,6 +1977,7 @@ bool xLightsFrame::RenderEffectFromMap(Effect *effectObj, int layer, int period,
                 event->settingsMap = &SettingsMap;
                 event->ResetEffectState = &resetEffectState;
 
+                wxStopWatch sw;
                 std::unique_lock<std::mutex> lock(event->mutex);
 
                 std::unique_lock<std::mutex> qlock(renderEventLock);
@@ -1897,6 +1991,9 @@ bool xLightsFrame::RenderEffectFromMap(Effect *effectObj, int layer, int period,
                     logger_base.warn("Frame #%d render on model %s (%dx%d) layer %d effect %s from %dms (#%d) to %dms (#%d) timed out.", b.curPeriod, (const char *)buffer.GetModelName().c_str(), b.BufferWi, b.BufferHt, layer, (const char *)reff->Name().c_str(), effectObj->GetStartTimeMS(), b.curEffStartPer, effectObj->GetEndTimeMS(), b.curEffEndPer);
                     printf("HELP!!!!   Frame #%d render on model %s (%dx%d) layer %d effect %s from %dms (#%d) to %dms (#%d) timed out.\n", b.curPeriod, (const char *)buffer.GetModelName().c_str(), b.BufferWi, b.BufferHt, layer, (const char *)reff->Name().c_str(), effectObj->GetStartTimeMS(), b.curEffStartPer, effectObj->GetEndTimeMS(), b.curEffEndPer);
                 }
+                if (event->profile != nullptr) {
+                    event->profile->mainThread.Add(sw.TimeInMicro().GetValue());
+                }
                 if (period % 10 == 0) {
                     //constantly putting stuff on CallAfter can result in the main
                     //dispatch thread never being able to empty the CallAfter
@@ -0,0 +1,359 @@
+#include "RenderBenchmark.h"
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/textfile.h>
+#include <wx/xml/xml.h>
+
+#include "xLightsMain.h"
+#include "xLightsXmlFile.h"
+#include "effects/RenderableEffect.h"
+#include "TimingPanel.h"
+#include "BufferPanel.h"
+#include "outputs/Output.h"
+#include "outputs/OutputManager.h"
+#include "sequencer/Element.h"
+#include "sequencer/EffectLayer.h"
+#include "models/Model.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <log4cpp/Category.hh>
+
+// a fixed palette so results dont depend on the users default palette
+static const std::string BENCHMARK_PALETTE = "C_BUTTON_Palette1=#FF0000,C_CHECKBOX_Palette1=1,"
+                                             "C_BUTTON_Palette2=#00FF00,C_CHECKBOX_Palette2=1,"
+                                             "C_BUTTON_Palette3=#0000FF,C_CHECKBOX_Palette3=1";
+
+static wxXmlNode* AddBenchmarkModel(wxXmlNode* models, const std::string& name, const std::string& displayAs,
+                                    int parm1, int parm2, int parm3, int nodes, unsigned int& startChannel, int x, int y)
+{
+    wxXmlNode* node = new wxXmlNode(wxXML_ELEMENT_NODE, "model");
+    node->AddAttribute("name", name);
+    node->AddAttribute("DisplayAs", displayAs);
+    node->AddAttribute("StringType", "RGB Nodes");
+    node->AddAttribute("StartSide", "B");
+    node->AddAttribute("Dir", "L");
+    node->AddAttribute("Antialias", "1");
+    node->AddAttribute("PixelSize", "2");
+    node->AddAttribute("Transparency", "0");
+    node->AddAttribute("parm1", wxString::Format("%d", parm1));
+    node->AddAttribute("parm2", wxString::Format("%d", parm2));
+    node->AddAttribute("parm3", wxString::Format("%d", parm3));
+    node->AddAttribute("StartChannel", wxString::Format("%u", startChannel));
+    node->AddAttribute("LayoutGroup", "Default");
+    node->AddAttribute("versionNumber", "3");
+    node->AddAttribute("WorldPosX", wxString::Format("%d.0000", x));
+    node->AddAttribute("WorldPosY", wxString::Format("%d.0000", y));
+    node->AddAttribute("WorldPosZ", "0.0000");
+    if (displayAs == "Arches")
+    {
+        node->AddAttribute("X2", "60.0000");
+        node->AddAttribute("Y2", "0.0000");
+        node->AddAttribute("Z2", "0.0000");
+        node->AddAttribute("Height", "1.0");
+    }
+    else
+    {
+        node->AddAttribute("ScaleX", "1.0000");
+        node->AddAttribute("ScaleY", "1.0000");
+        node->AddAttribute("ScaleZ", "1.0000");
+    }
+    models->AddChild(node);
+    startChannel += nodes * 3;
+    return node;
+}
+
+static void AddBenchmarkGroup(wxXmlNode* groups, const std::string& name, const std::string& models)
+{
+    wxXmlNode* node = new wxXmlNode(wxXML_ELEMENT_NODE, "modelGroup");
+    node->AddAttribute("name", name);
+    node->AddAttribute("models", models);
+    node->AddAttribute("layout", "minimalGrid");
+    node->AddAttribute("GridSize", "400");
+    node->AddAttribute("LayoutGroup", "Default");
+    node->AddAttribute("selected", "0");
+    groups->AddChild(node);
+}
+
+bool RenderBenchmark::CreateShowFolder(const std::string& dir)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!wxDirExists(dir) && !wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+    {
+        logger_base.error("Unable to create render benchmark show folder %s.", (const char *)dir.c_str());
+        return false;
+    }
+
+    wxXmlDocument doc;
+    wxXmlNode* root = new wxXmlNode(wxXML_ELEMENT_NODE, "xrgb");
+    doc.SetRoot(root);
+    wxXmlNode* models = new wxXmlNode(wxXML_ELEMENT_NODE, "models");
+    root->AddChild(models);
+    wxXmlNode* groups = new wxXmlNode(wxXML_ELEMENT_NODE, "modelGroups");
+    root->AddChild(groups);
+
+    unsigned int startChannel = 1;
+    std::string all;
+    AddBenchmarkModel(models, "Bench Matrix 32x16", "Horiz Matrix", 16, 32, 1, 16 * 32, startChannel, 100, 500);
+    AddBenchmarkModel(models, "Bench Matrix 150x50", "Horiz Matrix", 50, 150, 1, 50 * 150, startChannel, 400, 500);
+    AddBenchmarkModel(models, "Bench Tree", "Tree 360", 16, 50, 1, 16 * 50, startChannel, 800, 300);
+    all = "Bench Matrix 32x16,Bench Matrix 150x50,Bench Tree";
+
+    // a ring of nodes on a custom grid
+    const int customSize = 24;
+    std::string custom;
+    int customNodes = 0;
+    for (int y = 0; y < customSize; ++y)
+    {
+        if (y != 0) custom += ";";
+        for (int x = 0; x < customSize; ++x)
+        {
+            if (x != 0) custom += ",";
+            float dx = x - (customSize - 1) / 2.0f;
+            float dy = y - (customSize - 1) / 2.0f;
+            float d = sqrt(dx * dx + dy * dy);
+            if (d >= customSize / 2.0f - 3.0f && d < customSize / 2.0f)
+            {
+                custom += wxString::Format("%d", ++customNodes).ToStdString();
+            }
+        }
+    }
+    wxXmlNode* node = AddBenchmarkModel(models, "Bench Custom", "Custom", customSize, customSize, 1, customNodes, startChannel, 1000, 300);
+    node->AddAttribute("CustomModel", custom);
+    all += ",Bench Custom";
+
+    // lots of small models in one group
+    std::string arches;
+    for (int i = 0; i < 16; ++i)
+    {
+        std::string name = wxString::Format("Bench Arch %d", i + 1).ToStdString();
+        AddBenchmarkModel(models, name, "Arches", 1, 50, 1, 50, startChannel, 100 + i * 70, 100);
+        if (i != 0) arches += ",";
+        arches += name;
+    }
+    all += "," + arches;
+    AddBenchmarkGroup(groups, "Bench Arches", arches);
+    AddBenchmarkGroup(groups, "Bench Everything", all);
+
+    if (!doc.Save(wxFileName(dir, "xlights_rgbeffects.xml").GetFullPath()))
+    {
+        logger_base.error("Unable to write render benchmark layout to %s.", (const char *)dir.c_str());
+        return false;
+    }
+
+    wxXmlDocument networks;
+    wxXmlNode* nroot = new wxXmlNode(wxXML_ELEMENT_NODE, "Networks");
+    networks.SetRoot(nroot);
+    wxXmlNode* output = new wxXmlNode(wxXML_ELEMENT_NODE, "network");
+    output->AddAttribute("NetworkType", OUTPUT_NULL);
+    output->AddAttribute("MaxChannels", wxString::Format("%u", startChannel - 1));
+    output->AddAttribute("Description", "Render benchmark");
+    nroot->AddChild(output);
+    if (!networks.Save(wxFileName(dir, OutputManager::GetNetworksFileName()).GetFullPath()))
+    {
+        logger_base.error("Unable to write render benchmark networks to %s.", (const char *)dir.c_str());
+        return false;
+    }
+
+    logger_base.info("Render benchmark show created in %s with %u channels.", (const char *)dir.c_str(), startChannel - 1);
+    return true;
+}
+
+std::map<std::string, RenderBenchmarkResult> RenderBenchmark::LoadResults(const std::string& file)
+{
+    std::map<std::string, RenderBenchmarkResult> res;
+
+    wxTextFile f;
+    if (!wxFile::Exists(file) || !f.Open(file))
+    {
+        return res;
+    }
+
+    // first line is the header
+    for (size_t i = 1; i < f.GetLineCount(); ++i)
+    {
+        wxArrayString fields = wxSplit(f.GetLine(i), ',');
+        if (fields.size() < 5) continue;
+
+        RenderBenchmarkResult& r = res[fields[0].ToStdString()];
+        r.frames = wxAtol(fields[1]);
+        fields[2].ToCDouble(&r.totalMS);
+        fields[3].ToCDouble(&r.fps);
+        fields[4].ToCDouble(&r.nsPerPixel);
+    }
+    return res;
+}
+
+bool RenderBenchmark::SaveResults(const std::string& file, const std::map<std::string, RenderBenchmarkResult>& results)
+{
+    wxFile f;
+    if (!f.Create(file, true))
+    {
+        return false;
+    }
+
+    f.Write("Effect,Frames,Total ms,Frames/s,ns/pixel\n");
+    for (auto it = results.begin(); it != results.end(); ++it)
+    {
+        f.Write(wxString::Format("%s,%llu,", it->first, it->second.frames) +
+                wxString::FromCDouble(it->second.totalMS, 3) + "," +
+                wxString::FromCDouble(it->second.fps, 1) + "," +
+                wxString::FromCDouble(it->second.nsPerPixel, 2) + "\n");
+    }
+    return true;
+}
+
+std::string RenderBenchmark::Compare(const std::map<std::string, RenderBenchmarkResult>& results, const std::map<std::string, RenderBenchmarkResult>& baseline, int& regressions)
+{
+    regressions = 0;
+
+    std::string res = wxString::Format("%-20s %12s %12s %8s\n", "Effect", "ns/pixel", "baseline", "change").ToStdString();
+    for (auto it = results.begin(); it != results.end(); ++it)
+    {
+        auto b = baseline.find(it->first);
+        if (b == baseline.end() || b->second.nsPerPixel <= 0.0)
+        {
+            res += wxString::Format("%-20s %12.2f %12s\n", it->first, it->second.nsPerPixel, "-").ToStdString();
+            continue;
+        }
+
+        double change = (it->second.nsPerPixel - b->second.nsPerPixel) * 100.0 / b->second.nsPerPixel;
+        bool regressed = change > BENCHMARK_REGRESSION_PERCENT &&
+                         std::max(it->second.totalMS, b->second.totalMS) >= BENCHMARK_MIN_COMPARE_MS;
+        if (regressed) ++regressions;
+        res += wxString::Format("%-20s %12.2f %12.2f %+7.1f%%%s\n", it->first, it->second.nsPerPixel, b->second.nsPerPixel, change,
+                                regressed ? " REGRESSION" : "").ToStdString();
+    }
+    return res;
+}
+
+void xLightsFrame::RunRenderBenchmark(const wxString& resultsFile, const wxString& baselineFile)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.info("Render benchmark starting in %s.", (const char *)CurrentDir.c_str());
+    printf("Render benchmark starting.\n");
+
+    // typical settings are the defaults the panels give a newly dropped effect
+    timingPanel->SetDefaultControls(nullptr);
+    bufferPanel->SetDefaultControls(nullptr);
+    std::string common = timingPanel->GetTimingString() + bufferPanel->GetBufferString();
+
+    std::vector<std::string> effects;
+    std::vector<std::string> settings;
+    for (size_t i = 0; i < effectManager.size(); ++i)
+    {
+        RenderableEffect* reff = effectManager.GetEffect(i);
+        if (reff == nullptr) continue;
+
+        reff->SetDefaultParameters();
+        std::string s = reff->GetEffectString();
+        if (s.size() > 0 && s[s.size() - 1] != ',')
+        {
+            s += ",";
+        }
+        effects.push_back(reff->Name());
+        settings.push_back(s + common);
+    }
+    int durationMS = effects.size() * BENCHMARK_EFFECT_MS;
+
+    wxFileName xml_file;
+    xml_file.SetPath(CurrentDir);
+    xml_file.SetName("RenderBenchmark");
+    CurrentSeqXmlFile = new xLightsXmlFile(xml_file);
+    CurrentSeqXmlFile->SetSequenceType("Animation");
+    CurrentSeqXmlFile->SetSequenceTiming(wxString::Format("%d ms", BENCHMARK_FRAME_MS));
+    CurrentSeqXmlFile->SetSequenceDurationMS(durationMS);
+    LoadSequencer(*CurrentSeqXmlFile);
+    CurrentSeqXmlFile->SetSequenceLoaded(true);
+    AddAllModelsToSequence();
+    SeqData.init(GetMaxNumChannels(), durationMS / BENCHMARK_FRAME_MS, BENCHMARK_FRAME_MS);
+
+    // every effect one after the other on every model and group
+    std::map<std::string, int> modelNodes;
+    for (size_t i = 0; i < mSequenceElements.GetElementCount(MASTER_VIEW); ++i)
+    {
+        Element* el = mSequenceElements.GetElement(i, MASTER_VIEW);
+        Model* model = el == nullptr ? nullptr : GetModel(el->GetModelName());
+        if (model == nullptr || el->GetType() != ELEMENT_TYPE_MODEL) continue;
+
+        modelNodes[model->GetName()] = model->GetNodeCount();
+        EffectLayer* layer = el->GetEffectLayer(0);
+        for (size_t e = 0; e < effects.size(); ++e)
+        {
+            layer->AddEffect(0, effects[e], settings[e], BENCHMARK_PALETTE, e * BENCHMARK_EFFECT_MS, (e + 1) * BENCHMARK_EFFECT_MS, 0, false);
+        }
+    }
+    logger_base.info("Render benchmark sequence has %d effects on %d models, %d frames.", (int)effects.size(), (int)modelNodes.size(), (int)SeqData.NumFrames());
+
+    wxStopWatch sw;
+    RenderGridToSeqData([this, sw, effects, modelNodes, resultsFile, baselineFile] {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+        long elapsed = sw.Time();
+        std::map<std::string, RenderBenchmarkResult> results;
+        const RenderProfile* profile = GetLastRenderProfile();
+        if (profile != nullptr)
+        {
+            std::map<std::string, unsigned long long> pixels;
+            std::map<std::string, long long> totalUS;
+            for (auto m = modelNodes.begin(); m != modelNodes.end(); ++m)
+            {
+                auto me = profile->GetModelEffects(m->first);
+                for (auto e = me.begin(); e != me.end(); ++e)
+                {
+                    RenderBenchmarkResult& r = results[e->first];
+                    r.frames += e->second.GetCount();
+                    totalUS[e->first] += e->second.GetTotalUS();
+                    pixels[e->first] += e->second.GetCount() * (unsigned long long)m->second;
+                }
+            }
+
+            RenderBenchmarkResult& total = results["Total"];
+            long long allUS = 0;
+            unsigned long long allPixels = 0;
+            for (auto it = results.begin(); it != results.end(); ++it)
+            {
+                if (it->first == "Total") continue;
+                long long us = totalUS[it->first];
+                it->second.totalMS = us / 1000.0;
+                it->second.fps = us == 0 ? 0.0 : it->second.frames * 1000000.0 / us;
+                it->second.nsPerPixel = pixels[it->first] == 0 ? 0.0 : us * 1000.0 / pixels[it->first];
+                allUS += us;
+                allPixels += pixels[it->first];
+            }
+            // overall throughput is sequence frames against wall clock time
+            total.frames = SeqData.NumFrames();
+            total.totalMS = elapsed;
+            total.fps = elapsed == 0 ? 0.0 : SeqData.NumFrames() * 1000.0 / elapsed;
+            total.nsPerPixel = allPixels == 0 ? 0.0 : allUS * 1000.0 / allPixels;
+        }
+
+        int regressions = 0;
+        std::string report = RenderBenchmark::Compare(results, RenderBenchmark::LoadResults(baselineFile.ToStdString()), regressions);
+        printf("%s", report.c_str());
+        logger_base.info("Render benchmark results\n%s", (const char *)report.c_str());
+        if (regressions > 0)
+        {
+            printf("%d effects are slower than the baseline.\n", regressions);
+            logger_base.warn("Render benchmark: %d effects are slower than the baseline.", regressions);
+        }
+
+        if (resultsFile != "")
+        {
+            if (RenderBenchmark::SaveResults(resultsFile.ToStdString(), results))
+            {
+                printf("Results saved to %s\n", (const char *)resultsFile.c_str());
+            }
+            else
+            {
+                logger_base.error("Unable to save render benchmark results to %s.", (const char *)resultsFile.c_str());
+            }
+        }
+
+        CallAfter([this] { Destroy(); });
+    });
+}
@@ -0,0 +1,37 @@
+#ifndef RENDERBENCHMARK_H
+#define RENDERBENCHMARK_H
+
+#include <string>
+#include <map>
+
+// Headless render benchmark run with "xLights -b results.csv [--baseline old.csv]".
+// A synthetic show is generated in the temp directory, every effect is laid one after
+// another across every model and group and the sequence is rendered with profiling on.
+#define BENCHMARK_FRAME_MS 50
+#define BENCHMARK_EFFECT_MS 5000
+// ns/pixel increases bigger than this are reported as regressions
+#define BENCHMARK_REGRESSION_PERCENT 10.0
+// effects which took less than this in total are too quick to compare reliably
+#define BENCHMARK_MIN_COMPARE_MS 20.0
+
+class RenderBenchmarkResult
+{
+public:
+    RenderBenchmarkResult() : frames(0), totalMS(0.0), fps(0.0), nsPerPixel(0.0) {}
+
+    unsigned long long frames; // model frames rendered
+    double totalMS;
+    double fps;
+    double nsPerPixel;
+};
+
+class RenderBenchmark
+{
+public:
+    static bool CreateShowFolder(const std::string& dir);
+    static std::map<std::string, RenderBenchmarkResult> LoadResults(const std::string& file);
+    static bool SaveResults(const std::string& file, const std::map<std::string, RenderBenchmarkResult>& results);
+    static std::string Compare(const std::map<std::string, RenderBenchmarkResult>& results, const std::map<std::string, RenderBenchmarkResult>& baseline, int& regressions);
+};
+
+#endif
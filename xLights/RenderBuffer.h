@@ -175,6 +175,14 @@ public:
         wxASSERT(newcolors.size() == newcc.size());
 
         cc = newcc;
+        // colour curves are looked up per pixel for spatial curves so evaluate them once per effect
+        for (auto it = cc.begin(); it != cc.end(); ++it)
+        {
+            if (it->IsActive())
+            {
+                it->Bake();
+            }
+        }
         color=newcolors;
         hsv.clear();
         for(size_t i=0; i<newcolors.size(); i++)
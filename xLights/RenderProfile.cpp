@@ -0,0 +1,395 @@
+#include "RenderProfile.h"
+
+#include <wx/wx.h>
+#include <wx/file.h>
+
+#include <algorithm>
+
+#include <log4cpp/Category.hh>
+
+static const long long BUCKET_LIMITS_US[RenderProfileHistogram::NUM_BUCKETS - 1] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 2000000 };
+
+RenderProfileHistogram::RenderProfileHistogram()
+{
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        _counts[i] = 0;
+    }
+}
+
+void RenderProfileHistogram::Add(long long us)
+{
+    int b = 0;
+    while (b < NUM_BUCKETS - 1 && us >= BUCKET_LIMITS_US[b])
+    {
+        ++b;
+    }
+    ++_counts[b];
+}
+
+void RenderProfileHistogram::Merge(const RenderProfileHistogram& h)
+{
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        _counts[i] += h._counts[i];
+    }
+}
+
+std::string RenderProfileHistogram::GetBucketLabel(int bucket)
+{
+    if (bucket < NUM_BUCKETS - 1)
+    {
+        return wxString::Format("<%lldms", BUCKET_LIMITS_US[bucket] / 1000).ToStdString();
+    }
+    return wxString::Format(">=%lldms", BUCKET_LIMITS_US[NUM_BUCKETS - 2] / 1000).ToStdString();
+}
+
+void RenderProfileTiming::Add(long long us)
+{
+    ++_count;
+    _totalUS += us;
+    _maxUS = std::max(_maxUS, us);
+    _histogram.Add(us);
+}
+
+void RenderProfileTiming::Merge(const RenderProfileTiming& t)
+{
+    _count += t._count;
+    _totalUS += t._totalUS;
+    _maxUS = std::max(_maxUS, t._maxUS);
+    _histogram.Merge(t._histogram);
+}
+
+void RenderModelProfile::AddLayer(int layer, long long us)
+{
+    if (layer < 0) return;
+    if (layer >= (int)layers.size())
+    {
+        layers.resize(layer + 1);
+    }
+    layers[layer].Add(us);
+}
+
+void RenderModelProfile::AddEffect(int effectIndex, long long us)
+{
+    if (effectIndex < 0) return;
+    if (effectIndex >= (int)effects.size())
+    {
+        effects.resize(effectIndex + 1);
+    }
+    effects[effectIndex].Add(us);
+}
+
+void RenderModelProfile::Merge(const RenderModelProfile& p)
+{
+    frames.Merge(p.frames);
+    wait.Merge(p.wait);
+    calcOutput.Merge(p.calcOutput);
+    mainThread.Merge(p.mainThread);
+    if (layers.size() < p.layers.size())
+    {
+        layers.resize(p.layers.size());
+    }
+    for (size_t i = 0; i < p.layers.size(); ++i)
+    {
+        layers[i].Merge(p.layers[i]);
+    }
+}
+
+RenderProfile::RenderProfile(const std::string& title, int startFrame, int endFrame) :
+    _title(title), _startFrame(startFrame), _endFrame(endFrame), _elapsedMS(0)
+{
+}
+
+void RenderProfile::AddModel(const std::string& model, const RenderModelProfile& profile, const std::vector<std::string>& effectNames)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    _models[model].Merge(profile);
+    _total.frames.Merge(profile.frames);
+    _total.wait.Merge(profile.wait);
+    _total.calcOutput.Merge(profile.calcOutput);
+    _total.mainThread.Merge(profile.mainThread);
+
+    auto& modelEffects = _modelEffects[model];
+    for (size_t i = 0; i < profile.effects.size() && i < effectNames.size(); ++i)
+    {
+        if (profile.effects[i].GetCount() > 0)
+        {
+            _effects[effectNames[i]].Merge(profile.effects[i]);
+            modelEffects[effectNames[i]].Merge(profile.effects[i]);
+        }
+    }
+}
+
+std::map<std::string, RenderProfileTiming> RenderProfile::GetModelEffects(const std::string& model) const
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    auto it = _modelEffects.find(model);
+    if (it == _modelEffects.end())
+    {
+        return std::map<std::string, RenderProfileTiming>();
+    }
+    return it->second;
+}
+
+static std::string JSONString(const std::string& s)
+{
+    std::string res = "\"";
+    for (auto c : s)
+    {
+        switch (c)
+        {
+        case '"': res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\n': res += "\\n"; break;
+        case '\r': res += "\\r"; break;
+        case '\t': res += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                res += wxString::Format("\\u%04x", (int)c).ToStdString();
+            }
+            else
+            {
+                res += c;
+            }
+            break;
+        }
+    }
+    return res + "\"";
+}
+
+static std::string CSVString(const std::string& s)
+{
+    if (s.find_first_of(",\"\r\n") == std::string::npos) return s;
+
+    std::string res = "\"";
+    for (auto c : s)
+    {
+        if (c == '"') res += '"';
+        res += c;
+    }
+    return res + "\"";
+}
+
+static std::string TimingAsJSON(const RenderProfileTiming& t)
+{
+    std::string res = wxString::Format("{\"count\":%llu,\"totalMS\":%.3f,\"avgMS\":%.3f,\"maxMS\":%.3f,\"histogram\":[",
+        t.GetCount(), t.GetTotalUS() / 1000.0, t.GetAverageMS(), t.GetMaxUS() / 1000.0).ToStdString();
+    for (int b = 0; b < RenderProfileHistogram::NUM_BUCKETS; ++b)
+    {
+        if (b != 0) res += ",";
+        res += wxString::Format("%llu", t.GetHistogram().GetCount(b)).ToStdString();
+    }
+    return res + "]}";
+}
+
+static std::string TimingAsCSV(const std::string& type, const std::string& name, const std::string& detail, const RenderProfileTiming& t)
+{
+    std::string res = CSVString(type) + "," + CSVString(name) + "," + CSVString(detail) +
+        wxString::Format(",%llu,%.3f,%.3f,%.3f", t.GetCount(), t.GetTotalUS() / 1000.0, t.GetAverageMS(), t.GetMaxUS() / 1000.0).ToStdString();
+    for (int b = 0; b < RenderProfileHistogram::NUM_BUCKETS; ++b)
+    {
+        res += wxString::Format(",%llu", t.GetHistogram().GetCount(b)).ToStdString();
+    }
+    return res + "\n";
+}
+
+std::string RenderProfile::AsJSON() const
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    std::string res = "{\n";
+    res += "  \"title\": " + JSONString(_title) + ",\n";
+    res += wxString::Format("  \"startFrame\": %d,\n  \"endFrame\": %d,\n  \"elapsedMS\": %lld,\n", _startFrame, _endFrame, _elapsedMS).ToStdString();
+    res += "  \"buckets\": [";
+    for (int b = 0; b < RenderProfileHistogram::NUM_BUCKETS; ++b)
+    {
+        if (b != 0) res += ",";
+        res += JSONString(RenderProfileHistogram::GetBucketLabel(b));
+    }
+    res += "],\n";
+    res += "  \"total\": {\"frames\":" + TimingAsJSON(_total.frames) +
+           ",\"wait\":" + TimingAsJSON(_total.wait) +
+           ",\"calcOutput\":" + TimingAsJSON(_total.calcOutput) +
+           ",\"mainThread\":" + TimingAsJSON(_total.mainThread) + "},\n";
+
+    res += "  \"effects\": [";
+    bool first = true;
+    for (auto it = _effects.begin(); it != _effects.end(); ++it)
+    {
+        res += first ? "\n" : ",\n";
+        first = false;
+        res += "    {\"name\":" + JSONString(it->first) + ",\"render\":" + TimingAsJSON(it->second) + "}";
+    }
+    res += "\n  ],\n";
+
+    res += "  \"models\": [";
+    first = true;
+    for (auto it = _models.begin(); it != _models.end(); ++it)
+    {
+        const RenderModelProfile& m = it->second;
+        res += first ? "\n" : ",\n";
+        first = false;
+        res += "    {\"name\":" + JSONString(it->first) +
+               ",\"frames\":" + TimingAsJSON(m.frames) +
+               ",\"wait\":" + TimingAsJSON(m.wait) +
+               ",\"calcOutput\":" + TimingAsJSON(m.calcOutput) +
+               ",\"mainThread\":" + TimingAsJSON(m.mainThread) +
+               ",\"layers\":[";
+        for (size_t l = 0; l < m.layers.size(); ++l)
+        {
+            if (l != 0) res += ",";
+            res += TimingAsJSON(m.layers[l]);
+        }
+        res += "],\"effects\":[";
+        auto me = _modelEffects.find(it->first);
+        if (me != _modelEffects.end())
+        {
+            for (auto e = me->second.begin(); e != me->second.end(); ++e)
+            {
+                if (e != me->second.begin()) res += ",";
+                res += "{\"name\":" + JSONString(e->first) + ",\"render\":" + TimingAsJSON(e->second) + "}";
+            }
+        }
+        res += "]}";
+    }
+    res += "\n  ]\n}\n";
+    return res;
+}
+
+std::string RenderProfile::AsCSV() const
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    std::string res = "Type,Name,Detail,Count,Total ms,Average ms,Max ms";
+    for (int b = 0; b < RenderProfileHistogram::NUM_BUCKETS; ++b)
+    {
+        res += "," + RenderProfileHistogram::GetBucketLabel(b);
+    }
+    res += "\n";
+
+    res += TimingAsCSV("Total", _title, "Frame", _total.frames);
+    res += TimingAsCSV("Total", _title, "Wait", _total.wait);
+    res += TimingAsCSV("Total", _title, "CalcOutput", _total.calcOutput);
+    res += TimingAsCSV("Total", _title, "MainThread", _total.mainThread);
+    for (auto it = _effects.begin(); it != _effects.end(); ++it)
+    {
+        res += TimingAsCSV("Effect", it->first, "Render", it->second);
+    }
+    for (auto it = _models.begin(); it != _models.end(); ++it)
+    {
+        const RenderModelProfile& m = it->second;
+        res += TimingAsCSV("Model", it->first, "Frame", m.frames);
+        res += TimingAsCSV("Model", it->first, "Wait", m.wait);
+        res += TimingAsCSV("Model", it->first, "CalcOutput", m.calcOutput);
+        res += TimingAsCSV("Model", it->first, "MainThread", m.mainThread);
+        for (size_t l = 0; l < m.layers.size(); ++l)
+        {
+            if (m.layers[l].GetCount() > 0)
+            {
+                res += TimingAsCSV("Layer", it->first, wxString::Format("%d", (int)l + 1).ToStdString(), m.layers[l]);
+            }
+        }
+        auto me = _modelEffects.find(it->first);
+        if (me != _modelEffects.end())
+        {
+            for (auto e = me->second.begin(); e != me->second.end(); ++e)
+            {
+                res += TimingAsCSV("ModelEffect", it->first, e->first, e->second);
+            }
+        }
+    }
+    return res;
+}
+
+std::string RenderProfile::AsText(int maxRows) const
+{
+    std::unique_lock<std::mutex> lock(_lock);
+
+    std::string res = wxString::Format("%s: frames %d-%d rendered in %.1fs\n", _title, _startFrame, _endFrame, _elapsedMS / 1000.0).ToStdString();
+    res += wxString::Format("Model frames %llu, %.1fs rendering, %.1fs waiting on other models, %.1fs in CalcOutput, %.1fs on the main thread.\n",
+        _total.frames.GetCount(), _total.frames.GetTotalUS() / 1000000.0, _total.wait.GetTotalUS() / 1000000.0,
+        _total.calcOutput.GetTotalUS() / 1000000.0, _total.mainThread.GetTotalUS() / 1000000.0).ToStdString();
+
+    res += "\nModel frame times:\n";
+    for (int b = 0; b < RenderProfileHistogram::NUM_BUCKETS; ++b)
+    {
+        if (_total.frames.GetHistogram().GetCount(b) > 0)
+        {
+            res += wxString::Format("    %-8s %llu\n", RenderProfileHistogram::GetBucketLabel(b), _total.frames.GetHistogram().GetCount(b)).ToStdString();
+        }
+    }
+
+    std::vector<std::pair<long long, std::string>> sorted;
+    for (auto it = _effects.begin(); it != _effects.end(); ++it)
+    {
+        sorted.push_back(std::make_pair(it->second.GetTotalUS(), it->first));
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+    res += "\nSlowest effects (total, calls, average, max):\n";
+    for (int i = 0; i < (int)sorted.size() && i < maxRows; ++i)
+    {
+        const RenderProfileTiming& t = _effects.at(sorted[i].second);
+        res += wxString::Format("    %-20s %8.1fs %8llu %8.2fms %8.1fms\n", sorted[i].second, t.GetTotalUS() / 1000000.0, t.GetCount(), t.GetAverageMS(), t.GetMaxUS() / 1000.0).ToStdString();
+    }
+
+    sorted.clear();
+    for (auto it = _models.begin(); it != _models.end(); ++it)
+    {
+        sorted.push_back(std::make_pair(it->second.frames.GetTotalUS(), it->first));
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+    res += "\nSlowest models (total, average frame, max frame, waiting):\n";
+    for (int i = 0; i < (int)sorted.size() && i < maxRows; ++i)
+    {
+        const RenderModelProfile& m = _models.at(sorted[i].second);
+        res += wxString::Format("    %-20s %8.1fs %8.2fms %8.1fms %8.1fs\n", sorted[i].second, m.frames.GetTotalUS() / 1000000.0, m.frames.GetAverageMS(), m.frames.GetMaxUS() / 1000.0, m.wait.GetTotalUS() / 1000000.0).ToStdString();
+    }
+    return res;
+}
+
+void RenderProfile::Log() const
+{
+    static log4cpp::Category &logger_render = log4cpp::Category::getInstance(std::string("log_render"));
+    if (logger_render.isInfoEnabled())
+    {
+        logger_render.info("Render profile\n%s", (const char *)AsText().c_str());
+    }
+}
+
+bool RenderProfile::Save(const std::string& jsonFile, const std::string& csvFile) const
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    bool res = true;
+    if (jsonFile != "")
+    {
+        wxFile f;
+        if (f.Create(jsonFile, true) && f.Write(AsJSON()))
+        {
+            logger_base.debug("Render profile saved to %s.", (const char *)jsonFile.c_str());
+        }
+        else
+        {
+            logger_base.warn("Unable to save render profile to %s.", (const char *)jsonFile.c_str());
+            res = false;
+        }
+    }
+    if (csvFile != "")
+    {
+        wxFile f;
+        if (f.Create(csvFile, true) && f.Write(AsCSV()))
+        {
+            logger_base.debug("Render profile saved to %s.", (const char *)csvFile.c_str());
+        }
+        else
+        {
+            logger_base.warn("Unable to save render profile to %s.", (const char *)csvFile.c_str());
+            res = false;
+        }
+    }
+    return res;
+}
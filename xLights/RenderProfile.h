@@ -0,0 +1,91 @@
+#ifndef RENDERPROFILE_H
+#define RENDERPROFILE_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <mutex>
+
+// Frame time histogram. Bucket n holds samples below BUCKET_LIMITS_US[n], the last bucket everything slower.
+class RenderProfileHistogram
+{
+public:
+    static const int NUM_BUCKETS = 12;
+
+    RenderProfileHistogram();
+    void Add(long long us);
+    void Merge(const RenderProfileHistogram& h);
+    unsigned long long GetCount(int bucket) const { return _counts[bucket]; }
+    static std::string GetBucketLabel(int bucket);
+
+private:
+    unsigned long long _counts[NUM_BUCKETS];
+};
+
+class RenderProfileTiming
+{
+public:
+    RenderProfileTiming() : _count(0), _totalUS(0), _maxUS(0) {}
+    void Add(long long us);
+    void Merge(const RenderProfileTiming& t);
+    unsigned long long GetCount() const { return _count; }
+    long long GetTotalUS() const { return _totalUS; }
+    long long GetMaxUS() const { return _maxUS; }
+    double GetAverageMS() const { return _count == 0 ? 0.0 : (double)_totalUS / _count / 1000.0; }
+    const RenderProfileHistogram& GetHistogram() const { return _histogram; }
+
+private:
+    unsigned long long _count;
+    long long _totalUS;
+    long long _maxUS;
+    RenderProfileHistogram _histogram;
+};
+
+// Everything one render job measured for its model. Owned by the job while it renders so no locking is needed.
+class RenderModelProfile
+{
+public:
+    RenderProfileTiming frames;      // whole frame for the model including submodels, strands and nodes
+    RenderProfileTiming wait;        // blocked in waitForFrame on models we overlap
+    RenderProfileTiming calcOutput;  // CalcOutput + GetColors
+    RenderProfileTiming mainThread;  // effects handed off to the main thread, from queueing to completion
+    std::vector<RenderProfileTiming> layers;
+    std::vector<RenderProfileTiming> effects; // indexed by effect index
+
+    void AddLayer(int layer, long long us);
+    void AddEffect(int effectIndex, long long us);
+    void Merge(const RenderModelProfile& p);
+};
+
+class RenderProfile
+{
+public:
+    RenderProfile(const std::string& title, int startFrame, int endFrame);
+
+    // called by each render job when it finishes. effectNames maps effect index to name.
+    void AddModel(const std::string& model, const RenderModelProfile& profile, const std::vector<std::string>& effectNames);
+    void SetElapsedMS(long long ms) { _elapsedMS = ms; }
+    long long GetElapsedMS() const { return _elapsedMS; }
+
+    // effect timings for one model, empty if the model was not rendered
+    std::map<std::string, RenderProfileTiming> GetModelEffects(const std::string& model) const;
+
+    std::string AsJSON() const;
+    std::string AsCSV() const;
+    std::string AsText(int maxRows = 15) const;
+    void Log() const;
+    bool Save(const std::string& jsonFile, const std::string& csvFile) const;
+
+private:
+    mutable std::mutex _lock;
+    std::string _title;
+    int _startFrame;
+    int _endFrame;
+    long long _elapsedMS;
+    RenderModelProfile _total;
+    std::map<std::string, RenderModelProfile> _models;
+    std::map<std::string, RenderProfileTiming> _effects;
+    std::map<std::string, std::map<std::string, RenderProfileTiming>> _modelEffects;
+};
+
+#endif
@@ -3,6 +3,7 @@
 //(*InternalHeaders(RenderProgressDialog)
 #include <wx/scrolwin.h>
 #include <wx/sizer.h>
+#include <wx/textctrl.h>
 #include <wx/intl.h>
 #include <wx/button.h>
 #include <wx/string.h>
@@ -10,6 +11,7 @@
 
 //(*IdInit(RenderProgressDialog)
 const long RenderProgressDialog::ID_SCROLLEDWINDOW1 = wxNewId();
+const long RenderProgressDialog::ID_TEXTCTRL_PROFILE = wxNewId();
 //*)
 
 BEGIN_EVENT_TABLE(RenderProgressDialog,wxDialog)
@@ -24,9 +26,10 @@ RenderProgressDialog::RenderProgressDialog(wxWindow* parent)
 	wxStdDialogButtonSizer* StdDialogButtonSizer1;
 
 	Create(parent, wxID_ANY, _("Rendering Progress"), wxDefaultPosition, wxDefaultSize, wxSTAY_ON_TOP|wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER, _T("wxID_ANY"));
-	FlexGridSizer1 = new wxFlexGridSizer(2, 1, 0, 0);
+	FlexGridSizer1 = new wxFlexGridSizer(3, 1, 0, 0);
 	FlexGridSizer1->AddGrowableCol(0);
 	FlexGridSizer1->AddGrowableRow(0);
+	FlexGridSizer1->AddGrowableRow(1);
 	scrolledWindow = new wxScrolledWindow(this, ID_SCROLLEDWINDOW1, wxDefaultPosition, wxDefaultSize, wxVSCROLL, _T("ID_SCROLLEDWINDOW1"));
 	scrolledWindowSizer = new wxFlexGridSizer(0, 2, 0, 0);
 	scrolledWindowSizer->AddGrowableCol(1);
@@ -34,6 +37,9 @@ RenderProgressDialog::RenderProgressDialog(wxWindow* parent)
 	scrolledWindowSizer->Fit(scrolledWindow);
 	scrolledWindowSizer->SetSizeHints(scrolledWindow);
 	FlexGridSizer1->Add(scrolledWindow, 1, wxALL|wxEXPAND, 5);
+	TextCtrl_Profile = new wxTextCtrl(this, ID_TEXTCTRL_PROFILE, wxEmptyString, wxDefaultPosition, wxSize(600,400), wxTE_MULTILINE|wxTE_READONLY|wxTE_DONTWRAP, wxDefaultValidator, _T("ID_TEXTCTRL_PROFILE"));
+	TextCtrl_Profile->Hide();
+	FlexGridSizer1->Add(TextCtrl_Profile, 1, wxALL|wxEXPAND, 5);
 	StdDialogButtonSizer1 = new wxStdDialogButtonSizer();
 	StdDialogButtonSizer1->AddButton(new wxButton(this, wxID_OK, wxEmptyString));
 	StdDialogButtonSizer1->Realize();
@@ -50,3 +56,14 @@ RenderProgressDialog::~RenderProgressDialog()
 	//*)
 }
 
+
+void RenderProgressDialog::ShowProfile(const std::string& report)
+{
+    SetTitle(_("Render Profile"));
+    scrolledWindow->Hide();
+    TextCtrl_Profile->SetFont(wxFont(wxFontInfo(9).Family(wxFONTFAMILY_TELETYPE)));
+    TextCtrl_Profile->SetValue(report);
+    TextCtrl_Profile->Show();
+    Layout();
+    Fit();
+}
@@ -1,8 +1,11 @@
 #ifndef RENDERPROGRESSDIALOG_H
 #define RENDERPROGRESSDIALOG_H
 
+#include <string>
+
 //(*Headers(RenderProgressDialog)
 #include <wx/dialog.h>
+class wxTextCtrl;
 class wxStdDialogButtonSizer;
 class wxScrolledWindow;
 class wxFlexGridSizer;
@@ -15,15 +18,20 @@ class RenderProgressDialog: public wxDialog
 		RenderProgressDialog(wxWindow* parent);
 		virtual ~RenderProgressDialog();
 
+		// switch the dialog from the progress gauges to a finished render's profile report
+		void ShowProfile(const std::string& report);
+
 		//(*Declarations(RenderProgressDialog)
 		wxFlexGridSizer* scrolledWindowSizer;
 		wxScrolledWindow* scrolledWindow;
+		wxTextCtrl* TextCtrl_Profile;
 		//*)
 
 	protected:
 
 		//(*Identifiers(RenderProgressDialog)
 		static const long ID_SCROLLEDWINDOW1;
+		static const long ID_TEXTCTRL_PROFILE;
 		//*)
 
 	public:
@@ -612,6 +612,7 @@ bool xLightsFrame::CloseSequence()
 
     // just in case there is still rendering going on
     AbortRender();
+    _sequenceOutput.Stop();
 
     _renderCache.CleanupCache(&mSequenceElements);
     _renderCache.SetSequence(fseqDirectory.ToStdString(), "");
@@ -732,7 +733,7 @@ void xLightsFrame::RenderIseqData(bool bottom_layers, ConvertLogDialog* plog)
                                               nullptr,                                    // filename not needed
                                               data_layer );                               // provide data layer for channel offsets
 
-                FileConverter::ReadFalconFile(read_params);
+                FileConverter::ReadDataLayer(read_params);
                 read_mode = ConvertParameters::READ_MODE_IGNORE_BLACK;
                 layers_rendered++;
             }
@@ -11,6 +11,8 @@
 
 #include <wx/wx.h>
 
+#include <shared_mutex>
+
 class FrameData {
     static const unsigned char _constzero;
     unsigned char _zero;
@@ -53,6 +55,7 @@ class SequenceData {
     unsigned int _numChannels;
     unsigned int _numFrames;
     unsigned int _frameTime;
+    std::shared_timed_mutex _frameLock;
 
     SequenceData(const SequenceData&);  //make sure we cannot "copy" these
     SequenceData &operator=(const SequenceData& rgb);
@@ -73,6 +76,10 @@ public:
     unsigned int FrameTime() const { return _frameTime;}
     bool IsValidData() const { return _data != nullptr; }
 
+    // Render jobs write their own channels of a frame holding this shared. Anything that needs a
+    // consistent copy of a frame while rendering may be going on holds it exclusively.
+    std::shared_timed_mutex& GetFrameLock() { return _frameLock; }
+
     // encodes contents of SeqData in channel order
     wxString base64_encode();
 };
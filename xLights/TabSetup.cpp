@@ -37,6 +37,7 @@
 #include "outputs/LOROptimisedOutput.h"
 #include "osxMacUtils.h"
 #include "UtilFunctions.h"
+#include "effects/PictureCache.h"
 
 #include <log4cpp/Category.hh>
 #include "MultiControllerUploadDialog.h"
@@ -54,6 +55,7 @@ const long xLightsFrame::ID_NETWORK_BEDESCRIPTION = wxNewId();
 const long xLightsFrame::ID_NETWORK_BESUPPRESSDUPLICATES = wxNewId();
 const long xLightsFrame::ID_NETWORK_BESUPPRESSDUPLICATESYES = wxNewId();
 const long xLightsFrame::ID_NETWORK_BESUPPRESSDUPLICATESNO = wxNewId();
+const long xLightsFrame::ID_NETWORK_BEPACKETGAP = wxNewId();
 const long xLightsFrame::ID_NETWORK_ADD = wxNewId();
 const long xLightsFrame::ID_NETWORK_BULKEDIT = wxNewId();
 const long xLightsFrame::ID_NETWORK_DELETE = wxNewId();
@@ -145,6 +147,9 @@ bool xLightsFrame::SetDir(const wxString& newdir)
     // remove any 3d viewpoints
     viewpoint_mgr.Clear();
 
+    // pictures from the old show folder wont be wanted again
+    PictureCache::Get().Clear();
+
     if (newdir != CurrentDir && "" != CurrentDir) {
         wxFileName kbf;
         kbf.AssignDir(CurrentDir);
@@ -684,6 +689,34 @@ void xLightsFrame::UpdateSelectedSuppressDuplicates(bool suppressDuplicates)
     }
 }
 
+void xLightsFrame::UpdateSelectedPacketGap()
+{
+    int item = GridNetwork->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+    Output* f = _outputManager.GetOutput(item);
+
+    // the largest gap of all the outputs on a controller is used for the whole controller
+    wxNumberEntryDialog dlg(this, "Minimum time between packets sent to the controller in microseconds.\nSpreads a frame out for controllers which drop packets.", "Packet gap", wxEmptyString, f->GetPacketGapUS(), 0, 10000);
+    if (dlg.ShowModal() == wxID_OK)
+    {
+        while (item != -1)
+        {
+            _outputManager.GetOutput(item)->SetPacketGapUS(dlg.GetValue());
+            item = GridNetwork->GetNextItem(item, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+        }
+
+        NetworkChange();
+        UpdateNetworkList(false);
+
+        item = GridNetwork->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+        while (item != -1)
+        {
+            GridNetwork->SetItemState(item, wxLIST_STATE_SELECTED, wxLIST_STATE_SELECTED);
+
+            item = GridNetwork->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+        }
+    }
+}
+
 void xLightsFrame::UpdateSelectedDescriptions()
 {
     int item = GridNetwork->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
@@ -1537,6 +1570,7 @@ void xLightsFrame::OnGridNetworkItemRClick(wxListEvent& event)
     mnuBulkEditSD->Connect(wxEVT_MENU, (wxObjectEventFunction)&xLightsFrame::OnNetworkPopup, nullptr, this);
 
     mnuBulkEdit->Append(ID_NETWORK_BESUPPRESSDUPLICATES, "Suppress duplicate frames", mnuBulkEditSD, "")->Enable(selcnt > 0);
+    mnuBulkEdit->Append(ID_NETWORK_BEPACKETGAP, "Packet gap")->Enable(selcnt > 0);
     mnuBulkEdit->Connect(wxEVT_MENU, (wxObjectEventFunction)&xLightsFrame::OnNetworkPopup, nullptr, this);
 
     wxMenuItem* ma =  mnu.Append(ID_NETWORK_ADD, "Insert After", mnuAdd, "");
@@ -1708,6 +1742,8 @@ void xLightsFrame::OnNetworkPopup(wxCommandEvent &event)
         UpdateSelectedSuppressDuplicates(true);
     } else if (id == ID_NETWORK_BESUPPRESSDUPLICATESNO) {
         UpdateSelectedSuppressDuplicates(false);
+    } else if (id == ID_NETWORK_BEPACKETGAP) {
+        UpdateSelectedPacketGap();
     } else if (id == ID_NETWORK_DELETE) {
         DeleteSelectedNetworks();
     } else if (id == ID_NETWORK_ACTIVATE) {
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include <curl/curl.h>
+#include <zlib.h>
 
 #include <wx/msgdlg.h>
 #include <wx/sstream.h>
@@ -12,7 +13,6 @@
 #include <wx/filename.h>
 #include <wx/wfstream.h>
 #include <wx/sckstrm.h>
-#include <wx/zstream.h>
 #include <wx/mstream.h>
 #include <wx/protocol/http.h>
 
@@ -78,7 +78,7 @@ PixelCapeInfo& FPP::GetCapeRules(const std::string& type)
     return CONTROLLER_TYPE_MAP.find(type) != CONTROLLER_TYPE_MAP.end() ? CONTROLLER_TYPE_MAP[type] : CONTROLLER_TYPE_MAP["PiHat"];
 }
 
-FPP::FPP(const std::string &ad) : majorVersion(0), minorVersion(0), outputFile(nullptr), parent(nullptr), ipAddress(ad), curl(nullptr), isFPP(true) {
+FPP::FPP(const std::string &ad) : majorVersion(0), minorVersion(0), outputFile(nullptr), parent(nullptr), uploader(nullptr), ipAddress(ad), curl(nullptr), isFPP(true) {
     wxIPV4address address;
     if (address.Hostname(ad)) {
         hostName = ad;
@@ -88,7 +88,7 @@ FPP::FPP(const std::string &ad) : majorVersion(0), minorVersion(0), outputFile(n
 
 
 FPP::FPP(const FPP &c)
-    : majorVersion(c.majorVersion), minorVersion(c.minorVersion), outputFile(nullptr), parent(nullptr), curl(nullptr),
+    : majorVersion(c.majorVersion), minorVersion(c.minorVersion), outputFile(nullptr), parent(nullptr), uploader(nullptr), curl(nullptr),
     hostName(c.hostName), description(c.description), ipAddress(c.ipAddress), fullVersion(c.fullVersion), platform(c.platform),
     model(c.model), ranges(c.ranges), mode(c.mode), pixelControllerType(c.pixelControllerType), username(c.username), password(c.password), isFPP(c.isFPP)
 {
@@ -389,227 +389,345 @@ int FPP::PostToURL(const std::string& url, const wxMemoryBuffer &val, const std:
 }
 
 
-bool FPP::uploadFile(const std::string &filename, const std::string &file, bool compress)  {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    static int bufLen = 1024*1024*4; //4MB buffer
-    
-    //we cannot use wxHTTP for a few reasons:
-    //1) It doesn't support transfers larger than 2GB, including all headers and boundaries and such
-    //2) It has no way to monitor the bytes transferred
-    //3) Cannot use wxSOCKET_NOWAIT_WRITE (which is much faster) as it doesn't actually check
-    //   if all the data was sent
-    //4) Nothing is virtual so cannot even subclass to fix issues
-    
-    wxString fn;
-    wxString ext;
-    
-    for (int a = 0; a < filename.length(); a++) {
-        wxChar ch = filename[a];
+// FPP expects the file field the way its upload page sends it
+static std::string EscapeUploadName(const std::string &filename) {
+    std::string fn;
+    for (auto ch : filename) {
         if (ch == '"') {
-            fn.Append("\\\"");
+            fn += "\\\"";
         } else {
-            fn.Append(ch);
+            fn += ch;
         }
     }
-    
-    wxIPV4address address;
-    address.Hostname(ipAddress);
-    address.Service(80);
-    
-    size_t fileLen = 0;
-    wxMemoryOutputStream mout;
-    
-    bool cancelled = false;
-    wxProgressDialog progress("FPP Upload", "Transferring " + filename + " to " + ipAddress, 1000, parent, wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_AUTO_HIDE);
-    logger_base.debug("FPP upload via http of %s.", (const char*)filename.c_str());
-    progress.Update(0, "Transferring " + filename + " to " + ipAddress, &cancelled);
-    int lastDone = 0;
-    
-    std::string ct = "Content-Type: application/octet-stream\r\n\r\n";
-    
-    if (compress) {
-        logger_base.debug("Uploading it compressed.");
-        //determine size of gzipped data
-        progress.Show();
-        unsigned char *rbuf = new unsigned char[bufLen];
-        wxFile f_in(file);
-        wxZlibOutputStream zlib(mout, wxZ_DEFAULT_COMPRESSION, wxZLIB_GZIP);
-        size_t total = f_in.Length();
-        size_t read = 0;
-        while (!f_in.Eof()) {
-            size_t t = f_in.Read(rbuf, bufLen);
-            zlib.WriteAll(rbuf, t);
-            read += t;
-            
-            size_t f = read;
-            f *= 1000;
-            f /= total;
-            f /= 3;
-            if (f != lastDone) {
-                lastDone = f;
-                cancelled = !progress.Update(f, "Compressing " + filename, &cancelled);
-                wxYield();
-                if (cancelled) {
-                    delete [] rbuf;
-                    f_in.Close();
-                    return cancelled;
-                }
-            }
+    return fn;
+}
+
+#define FPP_UPLOAD_BOUNDARY "----WebKitFormBoundaryb29a7c2fe47b9481"
+#define FPP_UPLOAD_BUFFER_SIZE (256 * 1024)
+
+// One file being sent to jqupload.php. The multipart body is produced piece by piece from
+// the read callback so neither the file nor its compressed form is ever held in memory.
+class FPPUploadFile {
+public:
+    FPPUploadFile(FPP *f, const std::string &fn, const std::string &fl, bool c, bool r)
+        : fpp(f), filename(fn), file(fl), compress(c), removeWhenDone(r), fileLen(0), fileRead(0),
+          curl(nullptr), headers(nullptr), state(0), pos(0), zlibInit(false), eof(false) {
+        errorBuffer[0] = 0;
+        wxULongLong sz = wxFileName::GetSize(file);
+        if (sz != wxInvalidSize) {
+            fileLen = sz.GetValue();
         }
-        zlib.Close();
-        fileLen = mout.GetOutputStreamBuffer()->GetIntPosition();
-        //printf("compressed: %zu to %zu    %zu\n", total, fileLen, fileLen*100/total);
-        mout.GetOutputStreamBuffer()->SetIntPosition(0);
-        fn += ".gz";
-        ext = ".gz";
-        ct = "Content-Type: application/z-gzip\r\n\r\n";
-        
-        delete [] rbuf;
-    } else {
-        logger_base.debug("Uploading it uncompressed.");
-        compress = false;
-        wxFile f_in(file);
-        fileLen = f_in.Length();
     }
-    
-    wxSocketClient socket(wxSOCKET_NOWAIT_WRITE);
-    if (socket.Connect(address)) {
-        progress.Show();
-        
-        const std::string bound = "----WebKitFormBoundaryb29a7c2fe47b9481";
-        
-        wxMemoryBuffer memBuffPost;
-        addString(memBuffPost, "\r\n--");
-        addString(memBuffPost, bound);
-        addString(memBuffPost,"\r\nContent-Disposition: form-data; name=\"\"\r\n\r\nundefined\r\n--");
-        addString(memBuffPost, bound);
-        addString(memBuffPost,"\r\nContent-Disposition: form-data; name=\"\"\r\n\r\nundefined\r\n--");
-        addString(memBuffPost, bound);
-        addString(memBuffPost, "--\r\n");
-        
-        wxMemoryBuffer memBuffHeader;
-        addString(memBuffHeader, "POST /jqupload.php HTTP/1.1\r\n");
-        addString(memBuffHeader, "Host: " + ipAddress + "\r\n");
-        addString(memBuffHeader, "Connection: close\r\n");
-        addString(memBuffHeader, "Accept: application/json, text/javascript, */*; q=0.01\r\n");
-        addString(memBuffHeader, "Origin: http://" + ipAddress + "\r\n");
-        addString(memBuffHeader, "X-Requested-With: XMLHttpRequest\r\n");
-        addString(memBuffHeader, "Content-Type: multipart/form-data; boundary=" + bound + "\r\n");
-        addString(memBuffHeader, "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_14_1) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/70.0.3538.77 Safari/537.36\r\n");
-        addString(memBuffHeader, "DNT: 1\r\n");
-        addString(memBuffHeader, "Referer: http://" + ipAddress + "/uploadfile.php\r\n");
-        addString(memBuffHeader, "Accept-Language: en-US,en;q=0.9\r\n");
-        
-        
-        unsigned char *rbuf = new unsigned char[bufLen];
-        
-        
-        std::string cd = "Content-Disposition: form-data; name=\"myfile\"; filename=\"";
-        cd += fn.ToStdString();
-        cd += "\"\r\n";
-        wxMemoryBuffer memBuffPre;
-        addString(memBuffPre, "--");
-        addString(memBuffPre, bound);
-        addString(memBuffPre, "\r\n");
-        addString(memBuffPre, cd);
-        addString(memBuffPre, ct);
-        
-        size_t totalLen = fileLen + memBuffPre.GetDataLen() + memBuffPost.GetDataLen();
-        size_t totalWritten = 0;
-        addString(memBuffHeader, wxString::Format("Content-Length: %zu\r\n\r\n", totalLen));
-        
-        size_t len = memBuffHeader.GetDataLen();
-        const char *data = (const char *) memBuffHeader.GetData();
-        socket.Write(data, len);
-        size_t written = socket.LastWriteCount();
-        while (written < len) {
-            socket.Write(&data[written], len - written);
-            written += socket.LastWriteCount();
+    ~FPPUploadFile() {
+        Close();
+        if (removeWhenDone) {
+            ::wxRemoveFile(file);
         }
-        
-        len = memBuffPre.GetDataLen();
-        data = (const char *) memBuffPre.GetData();
-        socket.Write(data, len);
-        written = socket.LastWriteCount();
-        while (written < len) {
-            socket.Write(&data[written], len - written);
-            written += socket.LastWriteCount();
+    }
+
+    std::string GetUploadName() const {
+        return compress ? filename + ".gz" : filename;
+    }
+    bool Start();
+    void Close();
+    size_t Read(char *buf, size_t size);
+
+    FPP *fpp;
+    std::string filename;
+    std::string file;
+    bool compress;
+    bool removeWhenDone;
+    uint64_t fileLen;
+    uint64_t fileRead;
+
+    CURL *curl;
+    std::string response;
+    char errorBuffer[CURL_ERROR_SIZE];
+
+private:
+    struct curl_slist *headers;
+    wxFile in;
+    std::string pre;
+    std::string post;
+    int state; // 0 = pre, 1 = file, 2 = post, 3 = done
+    size_t pos;
+    z_stream zs;
+    bool zlibInit;
+    bool eof;
+    std::vector<uint8_t> inBuf;
+};
+
+static size_t upload_reader(char *buffer, size_t size, size_t nitems, void *data) {
+    return ((FPPUploadFile*)data)->Read(buffer, size * nitems);
+}
+
+bool FPPUploadFile::Start() {
+    if (!in.Open(file)) {
+        return false;
+    }
+    if (compress) {
+        memset(&zs, 0, sizeof(zs));
+        // 15 + 16 gives a gzip header which is what FPP expects of a .gz file
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
         }
-        totalWritten += written;
-        
-        int totalReadFromFile = 0;
-        wxFile f_in(file);
-        while (totalReadFromFile < fileLen) {
-            size_t iRead = 0;
-            if (compress) {
-                iRead = mout.GetOutputStreamBuffer()->Read(rbuf, bufLen);
+        zlibInit = true;
+        inBuf.resize(FPP_UPLOAD_BUFFER_SIZE);
+    }
+
+    pre = "--" FPP_UPLOAD_BOUNDARY "\r\n";
+    pre += "Content-Disposition: form-data; name=\"myfile\"; filename=\"" + EscapeUploadName(GetUploadName()) + "\"\r\n";
+    pre += compress ? "Content-Type: application/z-gzip\r\n\r\n" : "Content-Type: application/octet-stream\r\n\r\n";
+    post = "\r\n--" FPP_UPLOAD_BOUNDARY "\r\nContent-Disposition: form-data; name=\"\"\r\n\r\nundefined\r\n--";
+    post += FPP_UPLOAD_BOUNDARY "\r\nContent-Disposition: form-data; name=\"\"\r\n\r\nundefined\r\n--" FPP_UPLOAD_BOUNDARY "--\r\n";
+
+    std::string url = "http://" + fpp->ipAddress + "/jqupload.php";
+    curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, upload_reader);
+    curl_easy_setopt(curl, CURLOPT_READDATA, this);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, buffer_writer);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, &errorBuffer);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, this);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 5000);
+    // no overall timeout as big files take a while, give up if nothing moves for a minute
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+
+    headers = curl_slist_append(headers, "Content-Type: multipart/form-data; boundary=" FPP_UPLOAD_BOUNDARY);
+    headers = curl_slist_append(headers, "Accept: application/json, text/javascript, */*; q=0.01");
+    headers = curl_slist_append(headers, "X-Requested-With: XMLHttpRequest");
+    headers = curl_slist_append(headers, ("Origin: http://" + fpp->ipAddress).c_str());
+    headers = curl_slist_append(headers, ("Referer: http://" + fpp->ipAddress + "/uploadfile.php").c_str());
+    headers = curl_slist_append(headers, "Expect:");
+    if (compress) {
+        // compressed size isnt known until the end so send it chunked
+        headers = curl_slist_append(headers, "Transfer-Encoding: chunked");
+    } else {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)(pre.size() + fileLen + post.size()));
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    return true;
+}
+
+void FPPUploadFile::Close() {
+    if (curl) {
+        curl_easy_cleanup(curl);
+        curl = nullptr;
+    }
+    if (headers) {
+        curl_slist_free_all(headers);
+        headers = nullptr;
+    }
+    if (zlibInit) {
+        deflateEnd(&zs);
+        zlibInit = false;
+    }
+    if (in.IsOpened()) {
+        in.Close();
+    }
+}
+
+size_t FPPUploadFile::Read(char *buf, size_t size) {
+    size_t done = 0;
+    while (done < size && state != 3) {
+        if (state == 0 || state == 2) {
+            const std::string &s = state == 0 ? pre : post;
+            size_t n = std::min(size - done, s.size() - pos);
+            memcpy(&buf[done], &s[pos], n);
+            pos += n;
+            done += n;
+            if (pos == s.size()) {
+                pos = 0;
+                state++;
+            }
+        } else if (!compress) {
+            ssize_t n = in.Read(&buf[done], size - done);
+            if (n <= 0) {
+                state = 2;
             } else {
-                iRead = f_in.Read(rbuf, bufLen);
+                fileRead += n;
+                done += n;
             }
-            totalReadFromFile += iRead;
-            if (iRead) {
-                socket.Write(rbuf, iRead);
-                written = socket.LastWriteCount();
-                while (written < iRead) {
-                    socket.Write(&rbuf[written], iRead - written);
-                    written += socket.LastWriteCount();
+        } else {
+            if (zs.avail_in == 0 && !eof) {
+                ssize_t n = in.Read(&inBuf[0], inBuf.size());
+                if (n <= 0) {
+                    eof = true;
+                    n = 0;
                 }
+                fileRead += n;
+                zs.next_in = &inBuf[0];
+                zs.avail_in = n;
             }
-            
-            totalWritten += written;
-            
-            size_t donePct = totalWritten;
-            donePct *= compress ? 600 : 1000;
-            donePct /= totalLen;
-            if (compress) {
-                donePct += 333;
-            }
-            //printf("%ld / %ld    (%ld)\n", totalWritten, totalLen, donePct);
-            if (donePct != lastDone) {
-                lastDone = donePct;
-                cancelled = !progress.Update(donePct, "Transferring " + filename + " to " + ipAddress, &cancelled);
-                wxYield();
-            }
-            if (cancelled) {
-                delete [] rbuf;
-                f_in.Close();
-                socket.Close();
-                return cancelled;
+            zs.next_out = (Bytef*)&buf[done];
+            zs.avail_out = size - done;
+            int ret = deflate(&zs, eof ? Z_FINISH : Z_NO_FLUSH);
+            done = size - zs.avail_out;
+            if (ret == Z_STREAM_END) {
+                state = 2;
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                return CURL_READFUNC_ABORT;
             }
         }
-        f_in.Close();
-        
-        len = memBuffPost.GetDataLen();
-        data = (const char *) memBuffPost.GetData();
-        socket.Write(data, len);
-        written = socket.LastWriteCount();
-        while (written < len) {
-            socket.Write(&data[written], len - written);
-            written += socket.LastWriteCount();
+    }
+    return done;
+}
+
+FPPUploader::FPPUploader() : totalBytes(0), doneBytes(0), failures(0) {
+    curlMulti = curl_multi_init();
+}
+
+FPPUploader::~FPPUploader() {
+    Cancel();
+    curl_multi_cleanup(curlMulti);
+}
+
+void FPPUploader::Add(FPP *fpp, const std::string &filename, const std::string &file, bool compress, bool removeWhenDone) {
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.debug("FPP upload via http of %s to %s%s.", (const char*)filename.c_str(), (const char*)fpp->ipAddress.c_str(), compress ? " compressed" : "");
+
+    FPPUploadFile *f = new FPPUploadFile(fpp, filename, file, compress, removeWhenDone);
+    totalBytes += f->fileLen;
+    queued.push_back(f);
+    StartNext(fpp);
+}
+
+void FPPUploader::StartNext(FPP *fpp) {
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    for (auto f : active) {
+        if (f->fpp == fpp) {
+            // one at a time to each instance
+            return;
         }
-        logger_base.debug("Uploaded.");
-        if (compress) {
-            progress.Update(999, "Decompressing " + filename, &cancelled);
-            logger_base.debug("Decompressing.");
+    }
+    for (auto it = queued.begin(); it != queued.end(); ) {
+        FPPUploadFile *f = *it;
+        if (f->fpp != fpp) {
+            ++it;
+            continue;
         }
-        socket.Read(rbuf, bufLen-1);
-        int i = socket.LastReadCount();
-        rbuf[i] = 0;
-        
-        if (strstr((char *)rbuf, fn.c_str()) != nullptr) {
-            //upload OK, now rename
-            std::string val;
-            GetURLAsString("/fppxml.php?command=moveFile&file=" + URLEncode(filename + ext), val);
-            logger_base.debug("Renaming done.");
+        it = queued.erase(it);
+        if (f->Start()) {
+            active.push_back(f);
+            curl_multi_add_handle(curlMulti, f->curl);
+            return;
         }
-        progress.Update(1000, wxEmptyString, &cancelled);
-        delete [] rbuf;
-        
-        socket.Close();
-        return cancelled;
+        logger_base.warn("FPP upload of %s failed ... file could not be opened.", (const char*)f->file.c_str());
+        failures++;
+        doneBytes += f->fileLen;
+        delete f;
     }
-    
-    return true;
+}
+
+void FPPUploader::Finished(FPPUploadFile *f, bool ok) {
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    active.remove(f);
+    doneBytes += f->fileLen;
+
+    FPP *fpp = f->fpp;
+    if (ok && f->response.find(EscapeUploadName(f->GetUploadName())) != std::string::npos) {
+        //upload OK, now rename
+        std::string val;
+        fpp->GetURLAsString("/fppxml.php?command=moveFile&file=" + URLEncode(f->GetUploadName()), val);
+        logger_base.debug("FPP upload of %s to %s done.", (const char*)f->filename.c_str(), (const char*)fpp->ipAddress.c_str());
+    } else {
+        failures++;
+        logger_base.warn("FPP upload of %s to %s failed. %s", (const char*)f->filename.c_str(), (const char*)fpp->ipAddress.c_str(), f->errorBuffer);
+    }
+    delete f;
+    StartNext(fpp);
+}
+
+bool FPPUploader::Pump(int waitMS) {
+    int running = 0;
+    curl_multi_perform(curlMulti, &running);
+
+    struct CURLMsg *m;
+    int msgq = 0;
+    while ((m = curl_multi_info_read(curlMulti, &msgq))) {
+        if (m->msg == CURLMSG_DONE) {
+            CURL *e = m->easy_handle;
+            bool ok = m->data.result == CURLE_OK;
+            char *f = nullptr;
+            curl_easy_getinfo(e, CURLINFO_PRIVATE, &f);
+            curl_multi_remove_handle(curlMulti, e);
+            Finished((FPPUploadFile*)f, ok);
+        }
+    }
+    if (running && waitMS > 0) {
+        curl_multi_wait(curlMulti, nullptr, 0, waitMS, nullptr);
+    }
+    return IsDone();
+}
+
+void FPPUploader::Cancel() {
+    for (auto f : active) {
+        curl_multi_remove_handle(curlMulti, f->curl);
+        delete f;
+    }
+    active.clear();
+    for (auto f : queued) {
+        delete f;
+    }
+    queued.clear();
+}
+
+int FPPUploader::GetProgress() const {
+    if (totalBytes == 0) {
+        return IsDone() ? 1000 : 0;
+    }
+    uint64_t done = doneBytes;
+    for (auto f : active) {
+        done += f->fileRead;
+    }
+    return (int)std::min(done * 1000 / totalBytes, (uint64_t)1000);
+}
+
+std::string FPPUploader::GetStatus() const {
+    std::string status;
+    for (auto f : active) {
+        int pct = f->fileLen == 0 ? 100 : (int)(f->fileRead * 100 / f->fileLen);
+        if (status != "") {
+            status += "\n";
+        }
+        status += (f->fpp->hostName != "" ? f->fpp->hostName : f->fpp->ipAddress) + ": " + f->filename + " " + std::to_string(pct) + "%";
+    }
+    if (!queued.empty()) {
+        status += "\n" + std::to_string(queued.size()) + " more files queued";
+    }
+    return status;
+}
+
+bool FPP::uploadFile(const std::string &filename, const std::string &file, bool compress)  {
+    //we cannot use wxHTTP for a few reasons:
+    //1) It doesn't support transfers larger than 2GB, including all headers and boundaries and such
+    //2) It has no way to monitor the bytes transferred
+    //3) It would need the whole compressed file in memory before sending
+    FPPUploader up;
+    up.Add(this, filename, file, compress, false);
+
+    bool cancelled = false;
+    wxProgressDialog progress("FPP Upload", "Transferring " + filename + " to " + ipAddress, 1000, parent, wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_AUTO_HIDE);
+    progress.Show();
+    int lastDone = 0;
+    while (!up.Pump(100)) {
+        int donePct = std::min(up.GetProgress(), 999);
+        if (donePct != lastDone) {
+            lastDone = donePct;
+            cancelled = !progress.Update(donePct, "Transferring " + filename + " to " + ipAddress, &cancelled);
+        }
+        wxYield();
+        if (cancelled) {
+            up.Cancel();
+            return cancelled;
+        }
+    }
+    progress.Update(1000, wxEmptyString, &cancelled);
+    // a failed transfer is reported the same way as a cancelled one
+    return cancelled || up.GetFailures() != 0;
 }
 
 
@@ -670,6 +788,10 @@ bool FPP::uploadOrCopyFile(const std::string &filename,
     if (IsDrive()) {
         return copyFile(filename, file, dir);
     }
+    if (uploader != nullptr) {
+        uploader->Add(this, filename, file, compress, false);
+        return false;
+    }
     return uploadFile(filename, file, compress);
 }
 
@@ -752,8 +874,13 @@ bool FPP::FinalizeUploadSequence() {
         delete outputFile;
         outputFile = nullptr;
         if (tempFileName != "") {
-            cancelled = uploadOrCopyFile(baseSeqName, tempFileName, uploadCompressed, "sequences");
-            ::wxRemoveFile(tempFileName);
+            if (uploader != nullptr) {
+                // the uploader removes the temp file once its sent
+                uploader->Add(this, baseSeqName, tempFileName, uploadCompressed, true);
+            } else {
+                cancelled = uploadOrCopyFile(baseSeqName, tempFileName, uploadCompressed, "sequences");
+                ::wxRemoveFile(tempFileName);
+            }
             tempFileName = "";
         }
     }
@@ -13,7 +13,10 @@ class wxJSONValue;
 class FSEQFile;
 class wxMemoryBuffer;
 typedef void CURL;
+typedef void CURLM;
 class wxWindow;
+class FPPUploader;
+class FPPUploadFile;
 
 class PixelCapeInfo : public ControllerRules {
 public:
@@ -84,8 +87,9 @@ public:
 };
 
 class FPP {
+    friend class FPPUploader;
     public:
-    FPP() : majorVersion(0), minorVersion(0), outputFile(nullptr), parent(nullptr), curl(nullptr), isFPP(true) {}
+    FPP() : majorVersion(0), minorVersion(0), outputFile(nullptr), parent(nullptr), uploader(nullptr), curl(nullptr), isFPP(true) {}
     FPP(const std::string &address);
     FPP(const FPP &c);
     virtual ~FPP();
@@ -111,6 +115,8 @@ class FPP {
     bool isFPP;
 
     wxWindow *parent;
+    // if set uploads are queued on it rather than sent before returning
+    FPPUploader *uploader;
 
     bool AuthenticateAndUpdateVersions();
     void LoadPlaylists(std::list<std::string> &playlists);
@@ -184,4 +190,34 @@ private:
     std::string curlInputBuffer;
 };
 
+// Sends files to any number of FPP instances at the same time, one file at a time per instance.
+// Files are read, and gzipped if asked, as they are sent so memory use doesnt depend on file size.
+// Everything runs on the calling thread from Pump.
+class FPPUploader {
+public:
+    FPPUploader();
+    virtual ~FPPUploader();
+
+    void Add(FPP *fpp, const std::string &filename, const std::string &file, bool compress, bool removeWhenDone);
+    // transfers for up to waitMS, returns true once everything queued has been sent
+    bool Pump(int waitMS);
+    void Cancel();
+
+    bool IsDone() const { return queued.empty() && active.empty(); }
+    int GetProgress() const; // 0-1000 over everything queued so far
+    std::string GetStatus() const; // a line for each instance still transferring
+    int GetFailures() const { return failures; }
+
+private:
+    void StartNext(FPP *fpp);
+    void Finished(FPPUploadFile *file, bool ok);
+
+    CURLM *curlMulti;
+    std::list<FPPUploadFile*> queued;
+    std::list<FPPUploadFile*> active;
+    uint64_t totalBytes;
+    uint64_t doneBytes;
+    int failures;
+};
+
 #endif
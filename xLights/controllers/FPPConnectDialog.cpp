@@ -493,6 +493,17 @@ void FPPConnectDialog::OnButton_UploadClick(wxCommandEvent& event)
         std::string rowStr = std::to_string(row);
         doUpload[row] = GetCheckValue(CHECK_COL + rowStr);
     }
+
+    // sequences and media go to every instance at once and carry on transferring while
+    // the next sequence is generated
+    FPPUploader uploader;
+    row = 0;
+    for (auto &inst : instances) {
+        if (doUpload[row]) {
+            inst->uploader = &uploader;
+        }
+        row++;
+    }
     for (int fs = 0; fs < CheckListBox_Sequences->GetItemCount(); fs++) {
         if (CheckListBox_Sequences->IsItemChecked(fs)) {
             std::string fseq = CheckListBox_Sequences->GetItemText(fs);
@@ -528,10 +539,11 @@ void FPPConnectDialog::OnButton_UploadClick(wxCommandEvent& event)
                     }
                     
                     for (int frame = 0; frame < seq->getNumFrames() && !cancelled; frame++) {
+                        uploader.Pump(0);
                         int donePct = frame * 1000 / seq->getNumFrames();
                         if (donePct != lastDone) {
                             lastDone = donePct;
-                            cancelled |= !prgs.Update(donePct, "Generating " + fseq, &cancelled);
+                            cancelled |= !prgs.Update(donePct, "Generating " + fseq + "\n" + uploader.GetStatus(), &cancelled);
                             wxYield();
                         }
 
@@ -571,6 +583,24 @@ void FPPConnectDialog::OnButton_UploadClick(wxCommandEvent& event)
             delete seq;
         }
     }
+    if (!cancelled && !uploader.IsDone()) {
+        wxProgressDialog prgs("FPP Upload", "Transferring", 1000, this, wxPD_CAN_ABORT | wxPD_APP_MODAL);
+        prgs.Show();
+        while (!cancelled && !uploader.Pump(100)) {
+            cancelled |= !prgs.Update(std::min(uploader.GetProgress(), 999), uploader.GetStatus(), &cancelled);
+            wxYield();
+        }
+        prgs.Hide();
+    }
+    if (cancelled) {
+        uploader.Cancel();
+    } else if (uploader.GetFailures() != 0) {
+        wxMessageBox(wxString::Format("%d files failed to upload. See the log for details.", uploader.GetFailures()), "FPP Upload", wxOK | wxICON_WARNING, this);
+    }
+    for (auto &inst : instances) {
+        inst->uploader = nullptr;
+    }
+
     row = 0;
     xLightsFrame* frame = static_cast<xLightsFrame*>(GetParent());
     wxJSONValue outputs = FPP::CreateOutputUniverseFile(_outputManager);
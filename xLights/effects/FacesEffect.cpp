@@ -12,8 +12,6 @@
 #include "../xLightsMain.h" 
 #include "PicturesEffect.h"
 
-#include <wx/tokenzr.h>
-
 #include "../../include/corofaces.xpm"
 
 #include <log4cpp/Category.hh>
@@ -25,7 +23,6 @@ class FacesRenderCache : public EffectRenderCache {
 public:
     int blinkEndTime;
     int nextBlinkTime;
-    std::map<std::string, int> nodeNameCache;
 
     FacesRenderCache() : blinkEndTime(0), nextBlinkTime(0) {
     }
@@ -35,9 +32,6 @@ public:
             delete it->second;;
         }
     }
-    void Clear() {
-        nodeNameCache.clear();
-    }
     RenderBuffer* GetImage(std::string key)
     {
         if (_imageCache.find(key) != _imageCache.end())
@@ -696,7 +690,6 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
     if (buffer.needToInit) {
         buffer.needToInit = false;
         elements->AddRenderDependency(trackName, buffer.cur_model);
-        cache->Clear();
     }
     std::string eyes = eyesIn;
 
@@ -726,12 +719,6 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
         return;
     }
 
-    if (cache->nodeNameCache.empty()) {
-        for (int x = 0; x < model_info->GetNodeCount(); x++) {
-            cache->nodeNameCache[model_info->GetNodeName(x, true)] = x;
-        }
-    }
-
     std::string definition = faceDefinition;
     if (definition == "Default" && !model_info->faceInfo.empty() && model_info->faceInfo.begin()->first != "") {
         definition = model_info->faceInfo.begin()->first;
@@ -752,7 +739,8 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
             found = true;
         }
     }
-    std::string modelType = found ? model_info->faceInfo[definition]["Type"] : definition;
+    std::shared_ptr<const FaceStateNodes> faceNodes = found ? model_info->GetFaceNodes(definition) : nullptr;
+    std::string modelType = faceNodes != nullptr ? faceNodes->type : definition;
     if (modelType == "") {
         modelType = definition;
     }
@@ -895,7 +883,7 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
     xlColor color;
     buffer.palette.GetColor(0, color); //use first color for mouth; user must make sure it matches model node type
 
-    bool customColor = found ? model_info->faceInfo[definition]["CustomColors"] == "1" : false;
+    bool customColor = faceNodes != nullptr && faceNodes->customColors;
 
     std::vector<std::string> todo;
     std::vector<xlColor> colors;
@@ -903,13 +891,7 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
         todo.push_back("Mouth-" + phoneme);
         colorOffset = 1;
         if (customColor) {
-            std::string cname = model_info->faceInfo[definition]["Mouth-" + phoneme + "-Color"];
-            if (cname == "") {
-                colors.push_back(xlWHITE);
-            }
-            else {
-                colors.push_back(xlColor(cname));
-            }
+            colors.push_back(faceNodes->GetColor("Mouth-" + phoneme));
         }
         else {
             colors.push_back(color);
@@ -921,13 +903,7 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
     if (eyes == "Open" || eyes == "Auto") {
         todo.push_back("Eyes-Open");
         if (customColor) {
-            std::string cname = model_info->faceInfo[definition]["Eyes-Open-Color"];
-            if (cname == "") {
-                colors.push_back(xlWHITE);
-            }
-            else {
-                colors.push_back(xlColor(cname));
-            }
+            colors.push_back(faceNodes->GetColor("Eyes-Open"));
         }
         else {
             colors.push_back(color);
@@ -936,13 +912,7 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
     else if (eyes == "Closed") {
         todo.push_back("Eyes-Closed");
         if (customColor) {
-            std::string cname = model_info->faceInfo[definition]["Eyes-Closed-Color"];
-            if (cname == "") {
-                colors.push_back(xlWHITE);
-            }
-            else {
-                colors.push_back(xlColor(cname));
-            }
+            colors.push_back(faceNodes->GetColor("Eyes-Closed"));
         }
         else {
             colors.push_back(color);
@@ -957,13 +927,7 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
     if (face_outline) {
         todo.insert(todo.begin(), "FaceOutline");
         if (customColor) {
-            std::string cname = model_info->faceInfo[definition]["FaceOutline-Color"];
-            if (cname == "") {
-                colors.insert(colors.begin(), xlWHITE);
-            }
-            else {
-                colors.insert(colors.begin(), xlColor(cname));
-            }
+            colors.insert(colors.begin(), faceNodes->GetColor("FaceOutline"));
         }
         else {
             colors.insert(colors.begin(), color);
@@ -985,19 +949,15 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
         }
         std::string key = "Mouth-" + phoneme + "-Eyes";
         std::string picture = "";
-        if (model_info->faceInfo[definition].find(key + e) != model_info->faceInfo[definition].end())
-        {
-            picture = model_info->faceInfo[definition][key + e];
-        }
-        if (picture == "" && e == "Closed") {
-            if (model_info->faceInfo[definition].find(key + "Open") != model_info->faceInfo[definition].end())
-            {
-                picture = model_info->faceInfo[definition][key + "Open"];
+        if (faceNodes != nullptr) {
+            picture = faceNodes->GetImage(key + e);
+            if (picture == "" && e == "Closed") {
+                picture = faceNodes->GetImage(key + "Open");
             }
         }
         std::string dirstr = "none"; /*RENDER_PICTURE_NONE*/
         std::string stf = "Scale To Fit";
-        if (model_info->faceInfo[definition]["ImagePlacement"] == "Centered") {
+        if (faceNodes != nullptr && faceNodes->imagePlacement == FaceStateNodes::IMAGE_PLACEMENT::CENTERED) {
             dirstr = "none"; /*RENDER_PICTURE_NONE */
             stf = "No Scaling";
         }
@@ -1029,42 +989,12 @@ void FacesEffect::RenderFaces(RenderBuffer &buffer,
             }
         }
     }
+    if (faceNodes == nullptr) {
+        return;
+    }
     for (size_t t = 0; t < todo.size(); t++) {
-        std::string channels = model_info->faceInfo[definition][todo[t]];
-        wxStringTokenizer wtkz(channels, ",");
-        while (wtkz.HasMoreTokens()) {
-            wxString valstr = wtkz.GetNextToken();
-
-            if (type == 0) {
-                auto it2 = cache->nodeNameCache.find(valstr.ToStdString());
-                if (it2 != cache->nodeNameCache.end()) {
-                    int n = it2->second;
-                    buffer.SetNodePixel(n, colors[t]);
-                }
-            }
-            else if (type == 1) {
-                int start, end;
-                if (valstr.Contains("-")) {
-                    int idx = valstr.Index('-');
-                    start = wxAtoi(valstr.Left(idx));
-                    end = wxAtoi(valstr.Right(valstr.size() - idx - 1));
-                    if (end < start)
-                    {
-                        std::swap(start, end);
-                    }
-                }
-                else {
-                    start = end = wxAtoi(valstr);
-                }
-                if (start > end) {
-                    start = end;
-                }
-                start--;
-                end--;
-                for (int n = start; n <= end; n++) {
-                    buffer.SetNodePixel(n, colors[t]);
-                }
-            }
+        for (auto n : faceNodes->GetNodes(todo[t])) {
+            buffer.SetNodePixel(n, colors[t]);
         }
     }
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include <wx/filename.h>
 
+#include <algorithm>
+
 #undef max
 
 //#define DEBUG_GIF
@@ -31,60 +33,46 @@ GIFImage::GIFImage(const std::string& filename, bool suppressBackground)
     DoCreate(filename);
 }
 
-int GIFImage::GetMSUntilNextFrame(int msec, bool loop)
+int GIFImage::WrapTime(int msec, bool loop) const
 {
-    if (loop)
+    if (loop && _totalTime > 0 && msec >= _totalTime)
     {
-        while (msec >= _totalTime)
-        {
-            msec -= _totalTime;
-        }
+        msec %= _totalTime;
     }
+    return msec;
+}
 
-    if (msec > _totalTime) return -1;
+int GIFImage::GetMSUntilNextFrame(int msec, bool loop) const
+{
+    msec = WrapTime(msec, loop);
+    if (msec >= _totalTime) return -1;
 
-    for (auto it = _frameTimes.begin(); it != _frameTimes.end(); ++it)
-    {
-        if (msec < *it)
-        {
-            return *it - msec;
-        }
-        msec -= *it;
-    }
+    int frame = CalcFrameForTime(msec, false);
+    if (frame == -1) return -1;
 
-    return -1; // we shouldn't get here
+    return _frameStarts[frame] + _frameTimes[frame] - msec;
 }
 
-int GIFImage::CalcFrameForTime(int msec, bool loop)
+int GIFImage::CalcFrameForTime(int msec, bool loop) const
 {
-	if (loop)
-	{
-		while (msec >= _totalTime)
-		{
-			msec -= _totalTime;
-		}
-	}
+    msec = WrapTime(msec, loop);
 
-	if (msec > _totalTime) return -1;
+	if (msec > _totalTime || _frameStarts.empty()) return -1;
 
-	int frame = 0;
-	for (auto it = _frameTimes.begin(); it != _frameTimes.end(); ++it)
-	{
-		if (msec < *it)
-		{
-			return frame;
-		}
-		msec -= *it;
-		frame++;
-	}
-
-	return frame-1; // we shouldn't get here
+    // the last frame which starts at or before msec
+    auto it = std::upper_bound(_frameStarts.begin(), _frameStarts.end(), (long)msec);
+    if (it == _frameStarts.begin()) return 0;
+    return (int)(it - _frameStarts.begin()) - 1;
 }
 
 void GIFImage::ReadFrameProperties()
 {
     wxLogNull logNo;  // suppress popups from gif images.
     _totalTime = 0;
+    _frameTimes.clear();
+    _frameStarts.clear();
+    _frameSizes.clear();
+    _frameOffsets.clear();
 	for (size_t i = 0; i < _gifDecoder.GetFrameCount(); ++i)
 	{
 		long frametime = _gifDecoder.GetDelay(i);
@@ -100,6 +88,12 @@ void GIFImage::ReadFrameProperties()
             _frameTimes.push_back(100);
         }
     }
+    long start = 0;
+    for (auto it = _frameTimes.begin(); it != _frameTimes.end(); ++it)
+    {
+        _frameStarts.push_back(start);
+        start += *it;
+    }
 }
 
 void GIFImage::DoCreate(const std::string& filename)
@@ -2,7 +2,7 @@
 #define GIFIMAGE_H
 
 #include <string>
-#include <list>
+#include <vector>
 #include <wx/gifdecod.h>
 #include <wx/wfstream.h>
 #include <wx/image.h>
@@ -11,9 +11,10 @@ class GIFImage
 {
 	wxGIFDecoder _gifDecoder;
 	wxImage _lastImage;
-	std::list<long> _frameTimes;
-    std::list<wxSize> _frameSizes;
-    std::list<wxPoint> _frameOffsets;
+	std::vector<long> _frameTimes;
+    std::vector<long> _frameStarts; // time each frame starts so frames can be found by binary search
+    std::vector<wxSize> _frameSizes;
+    std::vector<wxPoint> _frameOffsets;
     wxColour _backgroundColour;
     wxSize _gifSize;
 	long _totalTime;
@@ -24,7 +25,7 @@ class GIFImage
     bool _ok;
 	
 	void ReadFrameProperties();
-    int CalcFrameForTime(int msec, bool loop);
+    int WrapTime(int msec, bool loop) const;
     wxPoint LoadRawImageFrame(wxImage& image, int frame, wxAnimationDisposal& disposal);
     void CopyImageToImage(wxImage& to, wxImage& from, wxPoint offset, bool overlay, bool dontaddtransparency = false);
     void DoCreate(const std::string& filename);
@@ -34,9 +35,13 @@ class GIFImage
 		virtual ~GIFImage();
 		wxImage GetFrame(int frame);
 		wxImage GetFrameForTime(int msec, bool loop);
-        int GetMSUntilNextFrame(int msec, bool loop);
+        int CalcFrameForTime(int msec, bool loop) const;
+        int GetMSUntilNextFrame(int msec, bool loop) const;
         std::string GetFilename() const { return _filename; }
         bool IsOk() const { return _ok; }
+        int GetFrameCount() const { return _frameTimes.size(); }
+        wxSize GetImageSize() const { return _gifSize; }
+        bool IsSuppressBackground() const { return _suppressBackground; }
 
 		static bool IsGIF(const std::string& filename);
 };
@@ -0,0 +1,247 @@
+#include "PictureCache.h"
+#include "GIFImage.h"
+
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include <log4cpp/Category.hh>
+
+PictureCache& PictureCache::Get()
+{
+    static PictureCache cache;
+    return cache;
+}
+
+PictureCache::PictureCache() : _bytes(0), _budget((size_t)PICTURE_CACHE_BUDGET_MB * 1024 * 1024), _tick(0)
+{
+}
+
+std::string PictureCache::GetFileKey(const std::string& filename)
+{
+    wxFileName fn(filename);
+    if (!fn.FileExists())
+    {
+        return filename;
+    }
+    return filename + "|" + fn.GetModificationTime().Format("%Y%m%d%H%M%S").ToStdString();
+}
+
+size_t PictureCache::GetBytes(const wxImage& image)
+{
+    size_t pixels = (size_t)image.GetWidth() * image.GetHeight();
+    return pixels * (image.HasAlpha() ? 4 : 3);
+}
+
+bool PictureCache::Find(const std::string& key, wxImage& image, int* imageCount)
+{
+    std::shared_ptr<const wxImage> cached;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _images.find(key);
+        if (it == _images.end())
+        {
+            return false;
+        }
+        it->second.lastUsed = ++_tick;
+        cached = it->second.image;
+        if (imageCount != nullptr)
+        {
+            *imageCount = it->second.imageCount;
+        }
+    }
+    image = cached->Copy();
+    return true;
+}
+
+void PictureCache::Add(const std::string& key, const wxImage& image, int imageCount)
+{
+    if (!image.IsOk()) return;
+
+    CachedImage ci;
+    ci.image = std::make_shared<const wxImage>(image.Copy());
+    ci.imageCount = imageCount;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    auto it = _images.find(key);
+    if (it != _images.end())
+    {
+        _bytes -= GetBytes(*it->second.image);
+    }
+    ci.lastUsed = ++_tick;
+    _bytes += GetBytes(*ci.image);
+    _images[key] = ci;
+    Evict();
+}
+
+// must be called with the lock held
+void PictureCache::Evict()
+{
+    while (_bytes > _budget && !_images.empty())
+    {
+        auto oldest = _images.begin();
+        for (auto it = _images.begin(); it != _images.end(); ++it)
+        {
+            if (it->second.lastUsed < oldest->second.lastUsed)
+            {
+                oldest = it;
+            }
+        }
+        _bytes -= GetBytes(*oldest->second.image);
+        _images.erase(oldest);
+    }
+
+    while (true)
+    {
+        int unused = 0;
+        auto oldest = _gifs.end();
+        for (auto it = _gifs.begin(); it != _gifs.end(); ++it)
+        {
+            if (it->second.gif.use_count() == 1)
+            {
+                unused++;
+                if (oldest == _gifs.end() || it->second.lastUsed < oldest->second.lastUsed)
+                {
+                    oldest = it;
+                }
+            }
+        }
+        if (unused <= PICTURE_CACHE_MAX_UNUSED_GIFS) break;
+        _gifs.erase(oldest);
+    }
+}
+
+wxImage PictureCache::GetImage(const std::string& fileKey, const std::string& filename, int& imageCount)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    wxImage image;
+    std::string key = "image|" + fileKey;
+    if (Find(key, image, &imageCount))
+    {
+        return image;
+    }
+
+    wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
+
+    // There seems to be a bug on linux where this function crashes occasionally
+#ifdef LINUX
+    logger_base.debug("About to count images in bitmap %s.", (const char *)filename.c_str());
+#endif
+    imageCount = wxImage::GetImageCount(filename);
+    if (imageCount <= 0)
+    {
+        logger_base.error("Image %s reports %d frames which is invalid. Overriding it to be 1.", (const char *)filename.c_str(), imageCount);
+
+        // override it to 1
+        imageCount = 1;
+    }
+
+    if (!image.LoadFile(filename, wxBITMAP_TYPE_ANY, 0))
+    {
+        logger_base.error("Error loading image file: %s.", (const char *)filename.c_str());
+        return wxImage();
+    }
+
+    Add(key, image, imageCount);
+    return image;
+}
+
+std::shared_ptr<GIFImage> PictureCache::GetGIF(const std::string& fileKey, const std::string& filename, bool suppressBackground)
+{
+    std::string key = "gif|" + fileKey + (suppressBackground ? "|S" : "|B");
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _gifs.find(key);
+        if (it != _gifs.end())
+        {
+            it->second.lastUsed = ++_tick;
+            return it->second.gif;
+        }
+    }
+
+    // decoding can be slow so dont hold the lock
+    std::shared_ptr<GIFImage> gif = std::make_shared<GIFImage>(filename, suppressBackground);
+    if (!gif->IsOk())
+    {
+        return gif;
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+    auto it = _gifs.find(key);
+    if (it != _gifs.end())
+    {
+        // someone else decoded it at the same time
+        it->second.lastUsed = ++_tick;
+        return it->second.gif;
+    }
+    CachedGIF cg;
+    cg.gif = gif;
+    cg.lock = std::make_shared<std::mutex>();
+    cg.lastUsed = ++_tick;
+    _gifs[key] = cg;
+    Evict();
+    return gif;
+}
+
+wxImage PictureCache::GetGIFFrame(const std::string& fileKey, const std::shared_ptr<GIFImage>& gif, int frame)
+{
+    if (frame < 0)
+    {
+        return wxImage(gif->GetImageSize());
+    }
+
+    std::string gifKey = "gif|" + fileKey + (gif->IsSuppressBackground() ? "|S" : "|B");
+    std::string key = gifKey + wxString::Format("|%d", frame).ToStdString();
+    wxImage image;
+    if (Find(key, image))
+    {
+        return image;
+    }
+
+    std::shared_ptr<std::mutex> gifLock;
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _gifs.find(gifKey);
+        if (it != _gifs.end() && it->second.gif == gif)
+        {
+            gifLock = it->second.lock;
+        }
+    }
+
+    if (gifLock == nullptr)
+    {
+        // not one of ours so nobody else is using it
+        wxImage f = gif->GetFrame(frame);
+        return f.Copy();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(*gifLock);
+        wxImage f = gif->GetFrame(frame);
+        image = f.Copy();
+    }
+    Add(key, image);
+    return image;
+}
+
+wxImage PictureCache::GetScaledImage(const std::string& source, const wxImage& image, int width, int height)
+{
+    std::string key = "scaled|" + source + wxString::Format("|%dx%d", width, height).ToStdString();
+    wxImage scaled;
+    if (Find(key, scaled))
+    {
+        return scaled;
+    }
+
+    scaled = image.Scale(width, height);
+    Add(key, scaled);
+    return scaled;
+}
+
+void PictureCache::Clear()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _images.clear();
+    _gifs.clear();
+    _bytes = 0;
+}
@@ -0,0 +1,71 @@
+#ifndef PICTURECACHE_H
+#define PICTURECACHE_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <wx/image.h>
+
+class GIFImage;
+
+// default memory budget for decoded and scaled images
+#define PICTURE_CACHE_BUDGET_MB 256
+// GIF decoders no render buffer is using which are kept in case they are needed again
+#define PICTURE_CACHE_MAX_UNUSED_GIFS 16
+
+// Process wide cache of decoded pictures, GIF frames and rescaled copies of them so the same
+// picture on many models or in many effects is only decoded and scaled once.
+// wxImage reference counting is not thread safe so images are deep copied in and out of the cache.
+// Copies out are made after the lock is released so render threads only queue on the lookup.
+class PictureCache
+{
+public:
+    static PictureCache& Get();
+
+    // Identifies a version of a file. Changes when the file is modified.
+    static std::string GetFileKey(const std::string& filename);
+
+    // Frame 0 of the file. imageCount is set to the number of images in the file.
+    wxImage GetImage(const std::string& fileKey, const std::string& filename, int& imageCount);
+    std::shared_ptr<GIFImage> GetGIF(const std::string& fileKey, const std::string& filename, bool suppressBackground);
+    wxImage GetGIFFrame(const std::string& fileKey, const std::shared_ptr<GIFImage>& gif, int frame);
+
+    // source identifies the unscaled image, typically a file key plus frame
+    wxImage GetScaledImage(const std::string& source, const wxImage& image, int width, int height);
+
+    // drops everything ... GIFs still in use stay alive with their users
+    void Clear();
+
+private:
+    class CachedImage
+    {
+    public:
+        std::shared_ptr<const wxImage> image; // never changed once cached so can be copied without the lock
+        int imageCount = 1;
+        unsigned long long lastUsed = 0;
+    };
+    class CachedGIF
+    {
+    public:
+        std::shared_ptr<GIFImage> gif;
+        std::shared_ptr<std::mutex> lock; // GIFImage decodes incrementally so only one frame at a time
+        unsigned long long lastUsed = 0;
+    };
+
+    PictureCache();
+    bool Find(const std::string& key, wxImage& image, int* imageCount = nullptr);
+    void Add(const std::string& key, const wxImage& image, int imageCount = 1);
+    void Evict();
+    static size_t GetBytes(const wxImage& image);
+
+    std::mutex _lock;
+    std::map<std::string, CachedImage> _images;
+    std::map<std::string, CachedGIF> _gifs;
+    size_t _bytes;
+    size_t _budget;
+    unsigned long long _tick;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include "../models/Model.h"
 #include "../UtilFunctions.h"
 #include "GIFImage.h"
+#include "PictureCache.h"
 #include "../xLightsMain.h" 
 
 #include <log4cpp/Category.hh>
@@ -218,14 +219,8 @@ typedef std::vector< std::pair<wxPoint, xlColor> > PixelVector;
 
 class PicturesRenderCache : public EffectRenderCache {
 public:
-    PicturesRenderCache() : imageCount(0), frame(0),  gifImage(nullptr), maxmovieframes(0) {};
-    virtual ~PicturesRenderCache()
-    {
-        if (gifImage != nullptr) {
-            delete gifImage;
-            gifImage = nullptr;
-        }
-    };
+    PicturesRenderCache() : imageCount(0), frame(0), maxmovieframes(0) {};
+    virtual ~PicturesRenderCache() {};
 
     wxImage image;
     wxImage rawimage;
@@ -233,7 +228,8 @@ public:
     int frame;
     int maxmovieframes;
     wxString PictureName;
-    GIFImage* gifImage;
+    std::string PictureKey; // identifies the version of the picture in the PictureCache
+    std::shared_ptr<GIFImage> gifImage;
     std::vector<PixelVector> PixelsByFrame;
 };
 
@@ -492,7 +488,7 @@ void PicturesEffect::Render(RenderBuffer &buffer,
     PicturesRenderCache *cache = GetCache(buffer);
     wxImage &image = cache->image;
     wxImage &rawimage = cache->rawimage;
-    GIFImage*& gifImage = cache->gifImage;
+    std::shared_ptr<GIFImage>& gifImage = cache->gifImage;
     std::vector<PixelVector> &PixelsByFrame = cache->PixelsByFrame;
     int &frame = cache->frame;
 
@@ -562,24 +558,11 @@ void PicturesEffect::Render(RenderBuffer &buffer,
         buffer.needToInit = false;
         scale_image = true;
 
-        wxLogNull logNo;  // suppress popups from png images. See http://trac.wxwidgets.org/ticket/15331
-
-        // There seems to be a bug on linux where this function crashes occasionally
-#ifdef LINUX
-        logger_base.debug("About to count images in bitmap %s.", (const char *)NewPictureName.c_str());
-#endif
-        cache->imageCount = wxImage::GetImageCount(NewPictureName);
-        if (cache->imageCount <= 0)
-        {
-            logger_base.error("Image %s reports %d frames which is invalid. Overriding it to be 1.", (const char *)NewPictureName.c_str(), cache->imageCount);
-
-            // override it to 1
-            cache->imageCount = 1;
-        }
-
-        if (!image.LoadFile(NewPictureName, wxBITMAP_TYPE_ANY, 0))
+        // decoding is shared with every other buffer showing the same picture
+        cache->PictureKey = PictureCache::GetFileKey(NewPictureName.ToStdString());
+        image = PictureCache::Get().GetImage(cache->PictureKey, NewPictureName.ToStdString(), cache->imageCount);
+        if (!image.IsOk())
         {
-            logger_base.error("Error loading image file: %s.", (const char *)NewPictureName.c_str());
             image.Create(5, 5, true);
         }
 
@@ -591,21 +574,15 @@ void PicturesEffect::Render(RenderBuffer &buffer,
 #ifdef DEBUG_GIF
             logger_base.debug("Preparing GIF file for reading: %s", (const char *)NewPictureName.c_str());
 #endif
-            if (gifImage != nullptr && gifImage->GetFilename() != NewPictureName)
-            {
-                delete gifImage;
-                gifImage = nullptr;
-            }
-            gifImage = new GIFImage(NewPictureName.ToStdString(), suppressGIFBackground);
+            gifImage = PictureCache::Get().GetGIF(cache->PictureKey, NewPictureName.ToStdString(), suppressGIFBackground);
 
             if (!gifImage->IsOk())
             {
-                delete gifImage;
-                gifImage = nullptr;
+                gifImage.reset();
                 return;
             }
 
-            image = gifImage->GetFrame(0);
+            image = PictureCache::Get().GetGIFFrame(cache->PictureKey, gifImage, 0);
             rawimage = image;
         }
 
@@ -613,20 +590,27 @@ void PicturesEffect::Render(RenderBuffer &buffer,
             return;
     }
 
+    // identifies rawimage so rescaled copies can be shared
+    std::string source = cache->PictureKey;
     if (cache->imageCount > 1) {
 
         //animated Gif,
         scale_image = true;
 
+        if (gifImage == nullptr)
+            return;
+
+        int gifFrame;
         if (loopGIF)
         {
-            image = gifImage->GetFrameForTime((buffer.curPeriod - buffer.curEffStartPer) * buffer.frameTimeInMs * frameRateAdj, true);
+            gifFrame = gifImage->CalcFrameForTime((buffer.curPeriod - buffer.curEffStartPer) * buffer.frameTimeInMs * frameRateAdj, true);
         }
         else
         {
-            int ii = cache->imageCount * buffer.GetEffectTimeIntervalPosition(frameRateAdj) * 0.99;
-            image = gifImage->GetFrame(ii);
+            gifFrame = cache->imageCount * buffer.GetEffectTimeIntervalPosition(frameRateAdj) * 0.99;
         }
+        image = PictureCache::Get().GetGIFFrame(cache->PictureKey, gifImage, gifFrame);
+        source += wxString::Format("|%s|%d", suppressGIFBackground ? "S" : "B", gifFrame).ToStdString();
 
         rawimage = image;
 
@@ -647,8 +631,7 @@ void PicturesEffect::Render(RenderBuffer &buffer,
 
     if (scale_to_fit == "Scale To Fit" && (BufferWi != imgwidth || BufferHt != imght))
     {
-        image = rawimage;
-        image.Rescale(BufferWi, BufferHt);
+        image = PictureCache::Get().GetScaledImage(source, rawimage, BufferWi, BufferHt);
         imgwidth = image.GetWidth();
         imght = image.GetHeight();
         yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
@@ -660,7 +643,7 @@ void PicturesEffect::Render(RenderBuffer &buffer,
         float xr = (float)BufferWi / (float)image.GetWidth();
         float yr = (float)BufferHt / (float)image.GetHeight();
         float sc = std::min(xr, yr);
-        image.Rescale(image.GetWidth() * sc, image.GetHeight() * sc);
+        image = PictureCache::Get().GetScaledImage(source, rawimage, image.GetWidth() * sc, image.GetHeight() * sc);
         imgwidth = image.GetWidth();
         imght = image.GetHeight();
         yoffset = (BufferHt + imght) / 2; //centered if sizes don't match
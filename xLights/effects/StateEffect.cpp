@@ -158,19 +158,6 @@ void StateEffect::Render(Effect *effect, SettingsMap &SettingsMap, RenderBuffer
     );
 }
 
-std::string StateEffect::FindState(std::map<std::string, std::string>& map, std::string name)
-{
-    for (auto it2 : map)
-    {
-        if (EndsWith(it2.first, "-Name") && it2.second == name)
-        {
-            return it2.first.substr(0, it2.first.size() - 5);
-        }
-    }
-
-    return "";
-}
-
 void StateEffect::RenderState(RenderBuffer &buffer,
                              SequenceElements *elements, const std::string &faceDefinition,
                              const std::string& Phoneme, const std::string &trackName, const std::string& mode, const std::string& colourmode)
@@ -226,17 +213,11 @@ void StateEffect::RenderState(RenderBuffer &buffer,
         return;
     }
 
-    std::string modelType = found ? model_info->stateInfo[definition]["Type"] : definition;
-    if (modelType == "") {
-        modelType = definition;
-    }
-
-    int type = 1;
-
-    if ("SingleNode" == modelType) {
-        type = 0;
-    } else if ("NodeRange" == modelType) {
-        type = 1;
+    // compiled once per definition so the node lists dont need parsing every frame
+    std::shared_ptr<const FaceStateNodes> stateNodes = found ? model_info->GetStateNodes(definition) : nullptr;
+    if (stateNodes == nullptr)
+    {
+        return;
     }
 
     std::string tstates = Phoneme;
@@ -291,13 +272,7 @@ void StateEffect::RenderState(RenderBuffer &buffer,
             wxString token = tkz.GetNextToken();
             if (token == "*" || token == "<ALL>")
             {
-                for (auto it2 : model_info->stateInfo[definition])
-                {
-                    if (EndsWith(it2.first, "-Name") && it2.second != "")
-                    {
-                        sstates.push_back(Lower(it2.second));
-                    }
-                }
+                sstates.insert(sstates.end(), stateNodes->stateNames.begin(), stateNodes->stateNames.end());
             }
             else
             {
@@ -444,13 +419,7 @@ void StateEffect::RenderState(RenderBuffer &buffer,
             wxString token = tkz.GetNextToken();
             if (token == "*" || token == "<ALL>")
             {
-                for (auto it2 : model_info->stateInfo[definition])
-                {
-                    if (EndsWith(it2.first, "-Name") && it2.second != "")
-                    {
-                        sstates.push_back(Lower(it2.second));
-                    }
-                }
+                sstates.insert(sstates.end(), stateNodes->stateNames.begin(), stateNodes->stateNames.end());
             }
             else
             {
@@ -466,16 +435,14 @@ void StateEffect::RenderState(RenderBuffer &buffer,
         }
     }
 
-    bool customColor = found ? model_info->stateInfo[definition]["CustomColors"] == "1" : false;
-
     // process each token
     for (size_t i = 0; i < sstates.size(); i++)
     {
-        // get the channels
-        std::string statename = FindState(model_info->stateInfo[definition], sstates[i]);
-        std::string channels = model_info->stateInfo[definition][statename];
+        // get the nodes
+        std::string statename = stateNodes->FindState(sstates[i]);
+        const std::vector<int>& nodes = stateNodes->GetNodes(statename);
 
-        if (statename != "" && channels != "")
+        if (statename != "" && !nodes.empty())
         {
             xlColor color;
             if (colourmode == "Graduate")
@@ -492,52 +459,13 @@ void StateEffect::RenderState(RenderBuffer &buffer,
                 int statenum = wxAtoi(statename.substr(1));
                 buffer.palette.GetColor((statenum - 1) % buffer.GetColorCount(), color);
             }
-            if (customColor) {
-                std::string cname = model_info->stateInfo[definition][statename + "-Color"];
-                if (cname == "") {
-                    color = xlWHITE;
-                }
-                else {
-                    color = xlColor(cname);
-                }
+            if (stateNodes->customColors) {
+                color = stateNodes->GetColor(statename);
             }
 
-            wxStringTokenizer wtkz(channels, ",");
-            while (wtkz.HasMoreTokens())
+            for (auto n : nodes)
             {
-                wxString valstr = wtkz.GetNextToken();
-
-                if (type == 0) {
-                    for (size_t n = 0; n < model_info->GetNodeCount(); n++) {
-                        wxString nn = model_info->GetNodeName(n, true);
-                        if (nn == valstr) {
-                            buffer.SetNodePixel(n, color);
-                        }
-                    }
-                }
-                else if (type == 1) {
-                    int start, end;
-                    if (valstr.Contains("-")) {
-                        int idx = valstr.Index('-');
-                        start = wxAtoi(valstr.Left(idx));
-                        end = wxAtoi(valstr.Right(valstr.size() - idx - 1));
-                        if (end < start)
-                        {
-                            std::swap(start, end);
-                        }
-                    }
-                    else {
-                        start = end = wxAtoi(valstr);
-                    }
-                    if (start > end) {
-                        start = end;
-                    }
-                    start--;
-                    end--;
-                    for (int n = start; n <= end; n++) {
-                        buffer.SetNodePixel(n, color);
-                    }
-                }
+                buffer.SetNodePixel(n, color);
             }
         }
     }
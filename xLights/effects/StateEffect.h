@@ -25,7 +25,6 @@ class StateEffect : public RenderableEffect
     private:
         void RenderState(RenderBuffer &buffer, SequenceElements *elements, const std::string &faceDefintion,
                          const std::string &Phoneme, const std::string &track, const std::string& mode, const std::string& colourmode);
-    std::string FindState(std::map<std::string, std::string>& map, std::string name);
 };
 
 #endif // StateEFFECT_H
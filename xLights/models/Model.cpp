@@ -109,6 +109,7 @@ public:
         if (dlg.ShowModal() == wxID_OK) {
             m_model->faceInfo.clear();
             dlg.GetFaceInfo(m_model->faceInfo);
+            m_model->ClearFaceStateNodes();
             wxVariant v(CLICK_TO_EDIT);
             SetValue(v);
             return true;
@@ -131,6 +132,7 @@ public:
         if (dlg.ShowModal() == wxID_OK) {
             m_model->stateInfo.clear();
             dlg.GetStateInfo(m_model->stateInfo);
+            m_model->ClearFaceStateNodes();
             wxVariant v(CLICK_TO_EDIT);
             SetValue(v);
             return true;
@@ -1173,12 +1175,14 @@ void Model::AddFace(wxXmlNode* n)
 {
     ParseFaceInfo(n, faceInfo);
     Model::WriteFaceInfo(ModelXml, faceInfo);
+    ClearFaceStateNodes();
 }
 
 void Model::AddState(wxXmlNode* n)
 {
     ParseStateInfo(n, stateInfo);
     Model::WriteStateInfo(ModelXml, stateInfo);
+    ClearFaceStateNodes();
 }
 
 void Model::AddSubmodel(wxXmlNode* n)
@@ -1273,6 +1277,175 @@ wxString Model::SerialiseState() const
     return res;
 }
 
+const std::vector<int>& FaceStateNodes::GetNodes(const std::string& key) const
+{
+    static const std::vector<int> none;
+    auto it = nodes.find(key);
+    return it == nodes.end() ? none : it->second;
+}
+
+xlColor FaceStateNodes::GetColor(const std::string& key) const
+{
+    auto it = colors.find(key);
+    return it == colors.end() ? xlWHITE : it->second;
+}
+
+std::string FaceStateNodes::GetImage(const std::string& key) const
+{
+    auto it = images.find(key);
+    return it == images.end() ? "" : it->second;
+}
+
+std::string FaceStateNodes::FindState(const std::string& name) const
+{
+    auto it = states.find(name);
+    return it == states.end() ? "" : it->second;
+}
+
+// Node lists are comma separated. Ranges are 1 based "start-end" and either way round.
+static void AddNodeRange(const wxString& valstr, int nodeCount, std::vector<int>& nodes)
+{
+    int start, end;
+    if (valstr.Contains("-")) {
+        int idx = valstr.Index('-');
+        start = wxAtoi(valstr.Left(idx));
+        end = wxAtoi(valstr.Right(valstr.size() - idx - 1));
+        if (end < start) {
+            std::swap(start, end);
+        }
+    }
+    else {
+        start = end = wxAtoi(valstr);
+    }
+    start = std::max(start - 1, 0);
+    end = std::min(end - 1, nodeCount - 1);
+    for (int n = start; n <= end; n++) {
+        nodes.push_back(n);
+    }
+}
+
+std::shared_ptr<const FaceStateNodes> Model::CompileFaceStateNodes(const std::map<std::string, std::string>& info, const std::string& definition, bool state) const
+{
+    auto res = std::make_shared<FaceStateNodes>();
+    res->changeCount = changeCount;
+
+    auto t = info.find("Type");
+    if (t != info.end()) {
+        res->type = t->second;
+    }
+    std::string type = res->type == "" ? definition : res->type;
+    if (type == "SingleNode" || (!state && type == "Coro")) {
+        res->nodeType = FaceStateNodes::NODE_TYPE::SINGLE_NODE;
+    }
+    else if (type == "NodeRange" || state) {
+        res->nodeType = FaceStateNodes::NODE_TYPE::NODE_RANGE;
+    }
+
+    // faces light the last node with a name, states light all of them
+    std::map<std::string, std::vector<int>> nodesByName;
+    int nodeCount = GetNodeCount();
+    if (res->nodeType == FaceStateNodes::NODE_TYPE::SINGLE_NODE) {
+        for (int x = 0; x < nodeCount; x++) {
+            auto& n = nodesByName[GetNodeName(x, true)];
+            if (!state) n.clear();
+            n.push_back(x);
+        }
+    }
+
+    for (const auto& it : info) {
+        const std::string& key = it.first;
+        if (key == "Type") {
+        }
+        else if (key == "CustomColors") {
+            res->customColors = it.second == "1";
+        }
+        else if (key == "ImagePlacement") {
+            if (it.second == "Centered") res->imagePlacement = FaceStateNodes::IMAGE_PLACEMENT::CENTERED;
+        }
+        else if (EndsWith(key, "-Color")) {
+            if (it.second != "") {
+                res->colors[key.substr(0, key.size() - 6)] = xlColor(it.second);
+            }
+        }
+        else if (state && EndsWith(key, "-Name")) {
+            // first definition of a name wins
+            res->states.emplace(it.second, key.substr(0, key.size() - 5));
+            if (it.second != "") {
+                res->stateNames.push_back(Lower(it.second));
+            }
+        }
+        else if (!state && (EndsWith(key, "-EyesOpen") || EndsWith(key, "-EyesClosed"))) {
+            res->images[key] = it.second;
+        }
+        else if (it.second != "" && res->nodeType != FaceStateNodes::NODE_TYPE::NONE) {
+            auto& nodes = res->nodes[key];
+            wxStringTokenizer wtkz(it.second, ",");
+            while (wtkz.HasMoreTokens()) {
+                wxString valstr = wtkz.GetNextToken();
+                if (res->nodeType == FaceStateNodes::NODE_TYPE::SINGLE_NODE) {
+                    auto n = nodesByName.find(valstr.ToStdString());
+                    if (n != nodesByName.end()) {
+                        nodes.insert(nodes.end(), n->second.begin(), n->second.end());
+                    }
+                }
+                else {
+                    AddNodeRange(valstr, nodeCount, nodes);
+                }
+            }
+        }
+    }
+    return res;
+}
+
+std::shared_ptr<const FaceStateNodes> Model::GetFaceNodes(const std::string& definition) const
+{
+    {
+        std::lock_guard<std::mutex> lock(faceStateNodesLock);
+        auto it = faceNodes.find(definition);
+        if (it != faceNodes.end() && it->second->changeCount == changeCount) {
+            return it->second;
+        }
+    }
+
+    auto info = faceInfo.find(definition);
+    if (info == faceInfo.end()) {
+        return nullptr;
+    }
+    auto res = CompileFaceStateNodes(info->second, definition, false);
+
+    std::lock_guard<std::mutex> lock(faceStateNodesLock);
+    faceNodes[definition] = res;
+    return res;
+}
+
+std::shared_ptr<const FaceStateNodes> Model::GetStateNodes(const std::string& definition) const
+{
+    {
+        std::lock_guard<std::mutex> lock(faceStateNodesLock);
+        auto it = stateNodes.find(definition);
+        if (it != stateNodes.end() && it->second->changeCount == changeCount) {
+            return it->second;
+        }
+    }
+
+    auto info = stateInfo.find(definition);
+    if (info == stateInfo.end()) {
+        return nullptr;
+    }
+    auto res = CompileFaceStateNodes(info->second, definition, true);
+
+    std::lock_guard<std::mutex> lock(faceStateNodesLock);
+    stateNodes[definition] = res;
+    return res;
+}
+
+void Model::ClearFaceStateNodes()
+{
+    std::lock_guard<std::mutex> lock(faceStateNodesLock);
+    faceNodes.clear();
+    stateNodes.clear();
+}
+
 std::string Model::ComputeStringStartChannel(int i) {
     if (i == 0) {
         return ModelXml->GetAttribute("StartChannel", "1").ToStdString();
@@ -1772,6 +1945,7 @@ void Model::SetFromXml(wxXmlNode* ModelNode, bool zb) {
     wxXmlNode *f = ModelNode->GetChildren();
     faceInfo.clear();
     stateInfo.clear();
+    ClearFaceStateNodes();
     wxXmlNode * dimmingCurveNode = nullptr;
     wxXmlNode * controllerConnectionNode = nullptr;
     while (f != nullptr) {
@@ -2409,6 +2583,61 @@ void Model::ApplyTransform(const std::string &type,
     }
 }
 
+struct Model::RenderLayout {
+    std::vector<NodeBaseClassPtr> nodes;
+    int bufferWi = 0;
+    int bufferHt = 0;
+    unsigned long changeCount = 0;
+};
+
+void Model::ClearRenderLayoutCache() {
+    std::lock_guard<std::mutex> lock(renderLayoutLock);
+    renderLayouts.clear();
+}
+
+void Model::GetRenderBufferNodes(const std::string &type, const std::string &camera,
+    const std::string &transform,
+    std::vector<NodeBaseClassPtr> &newNodes, int &bufferWi, int &bufferHt) const {
+
+    // Layouts that are just a copy of the model nodes gain nothing from a cache. 3D cameras can
+    // also be moved without the model changing so those are always rebuilt.
+    bool simple = type == DEFAULT && transform == "None" && GetDisplayAs() != "ModelGroup";
+    if (!newNodes.empty() || camera != "2D" || simple) {
+        InitRenderBufferNodes(type, camera, transform, newNodes, bufferWi, bufferHt);
+        return;
+    }
+
+    unsigned long changeCount = GetRenderLayoutChangeCount();
+    std::string key = type + "|" + transform;
+    std::shared_ptr<const RenderLayout> layout;
+    {
+        std::lock_guard<std::mutex> lock(renderLayoutLock);
+        auto it = renderLayouts.find(key);
+        if (it != renderLayouts.end() && it->second->changeCount == changeCount) {
+            layout = it->second;
+        }
+    }
+
+    if (layout == nullptr) {
+        // built outside the lock ... if two threads race they just both build it
+        auto l = std::make_shared<RenderLayout>();
+        InitRenderBufferNodes(type, camera, transform, l->nodes, l->bufferWi, l->bufferHt);
+        l->changeCount = changeCount;
+        layout = l;
+
+        std::lock_guard<std::mutex> lock(renderLayoutLock);
+        renderLayouts[key] = layout;
+    }
+
+    // nodes carry the colours being rendered so every buffer gets its own copy
+    newNodes.reserve(layout->nodes.size());
+    for (const auto &it : layout->nodes) {
+        newNodes.push_back(NodeBaseClassPtr(it->clone()));
+    }
+    bufferWi = layout->bufferWi;
+    bufferHt = layout->bufferHt;
+}
+
 void Model::InitRenderBufferNodes(const std::string &type, const std::string &camera,
     const std::string &transform,
     std::vector<NodeBaseClassPtr> &newNodes, int &bufferWi, int &bufferHt) const {
@@ -3317,9 +3546,184 @@ void Model::ApplyTransparency(xlColor &color, int transparency) const
     }
 }
 
+// Where DisplayModelOnWindow puts the vertices for each node. During playback only the colours
+// change so the positions are worked out once and reused until the model changes.
+struct Model::PreviewGeometry {
+    unsigned long changeCount = 0;
+    size_t nodeCount = 0;
+    bool is_3d = false;
+    int pixelStyle = 0;
+    int pixelSize = 0;
+    unsigned int coordsPerVertex = 2;
+    std::vector<float> vertices;
+    std::vector<std::pair<int, int>> nodeVertices; // node and how many vertices it has, in draw order
+};
+
+void Model::InvalidatePreviewGeometry() {
+    previewGeometry[0] = nullptr;
+    previewGeometry[1] = nullptr;
+}
+
+std::shared_ptr<Model::PreviewGeometry> Model::BuildPreviewGeometry(bool is_3d, bool allowSelected, unsigned int coordsPerVertex) {
+    auto geometry = std::make_shared<PreviewGeometry>();
+    geometry->changeCount = changeCount;
+    geometry->nodeCount = Nodes.size();
+    geometry->is_3d = is_3d;
+    geometry->pixelStyle = pixelStyle;
+    geometry->pixelSize = pixelSize;
+    geometry->coordsPerVertex = coordsPerVertex;
+
+    ModelScreenLocation& screenLocation = GetModelScreenLocation();
+    screenLocation.PrepareToDraw(is_3d, allowSelected);
+    screenLocation.UpdateBoundingBox(Nodes);
+
+    // same order and the same vertices as DisplayModelOnWindow
+    std::vector<int> order;
+    order.reserve(Nodes.size());
+    int first = 0;
+    int last = Nodes.size();
+    int buffFirst = -1;
+    int buffLast = -1;
+    bool left = true;
+    while (first < last) {
+        int n;
+        if (left) {
+            n = first;
+            first++;
+            if (NodeRenderOrder() == 1) {
+                if (buffFirst == -1) {
+                    buffFirst = Nodes[n]->Coords[0].bufX;
+                }
+                if (first < Nodes.size() && buffFirst != Nodes[first]->Coords[0].bufX) {
+                    left = false;
+                }
+            }
+        } else {
+            last--;
+            n = last;
+            if (buffLast == -1) {
+                buffLast = Nodes[n]->Coords[0].bufX;
+            }
+            if (last > 0 && buffFirst != Nodes[last - 1]->Coords[0].bufX) {
+                left = true;
+            }
+        }
+        order.push_back(n);
+    }
+
+    DrawGLUtils::xlVertexColorAccumulator va;
+    if (coordsPerVertex == 3) {
+        va.SetCoordsPerVertex(3);
+    }
+    for (auto n : order) {
+        unsigned int start = va.count;
+        size_t CoordCount = GetCoordCount(n);
+        for (size_t c2 = 0; c2 < CoordCount; c2++) {
+            float sx = Nodes[n]->Coords[c2].screenX;
+            float sy = Nodes[n]->Coords[c2].screenY;
+            float sz = Nodes[n]->Coords[c2].screenZ;
+            if (pixelStyle < 2) {
+                screenLocation.TranslatePoint(sx, sy, sz);
+                va.AddVertex(sx, sy, sz, xlBLACK);
+            } else if (coordsPerVertex == 3) {
+                va.AddTrianglesCircle(sx, sy, sz, ((float)pixelSize) / 2.0f, xlBLACK, xlBLACK,
+                                      [&screenLocation](float &x, float &y, float &z) {
+                                          screenLocation.TranslatePoint(x, y, z);
+                                      });
+            } else {
+                screenLocation.TranslatePoint(sx, sy, sz);
+                va.AddTrianglesCircle(sx, sy, ((float)pixelSize) / 2.0f, xlBLACK, xlBLACK);
+            }
+        }
+        geometry->nodeVertices.push_back(std::pair<int, int>(n, va.count - start));
+    }
+    geometry->vertices.assign(va.vertices, va.vertices + va.count * coordsPerVertex);
+    return geometry;
+}
+
+// Playback version of DisplayModelOnWindow. Copies in the saved vertex positions and only
+// works out the colours. Returns false if the model has to be drawn the long way.
+bool Model::DisplayPreviewGeometry(ModelPreview* preview, DrawGLUtils::xlAccumulator &sva, DrawGLUtils::xlAccumulator &tva, bool is_3d, bool allowSelected) {
+    if (splitRGB) {
+        // how many vertices a node has depends on its colour
+        return false;
+    }
+
+    std::shared_ptr<PreviewGeometry> &geometry = previewGeometry[sva.coordsPerVertex == 3 ? 1 : 0];
+    if (geometry == nullptr || geometry->changeCount != changeCount || geometry->nodeCount != Nodes.size()
+        || geometry->is_3d != is_3d || geometry->pixelStyle != pixelStyle || geometry->pixelSize != pixelSize
+        || geometry->coordsPerVertex != sva.coordsPerVertex) {
+        geometry = BuildPreviewGeometry(is_3d, allowSelected, sva.coordsPerVertex);
+    }
+
+    bool needTransparent = false;
+    if (pixelStyle == 3 || transparency != 0 || blackTransparency != 0) {
+        needTransparent = true;
+    }
+    DrawGLUtils::xlAccumulator &va = needTransparent ? tva : sva;
+    unsigned int vcount = geometry->vertices.size() / geometry->coordsPerVertex;
+    if (vcount == 0) {
+        return true;
+    }
+    va.PreAlloc(vcount);
+    memcpy(&va.vertices[va.count * va.coordsPerVertex], &geometry->vertices[0], geometry->vertices.size() * sizeof(float));
+
+    uint8_t *colors = &va.colors[va.count * 4];
+    xlColor color;
+    for (const auto &nv : geometry->nodeVertices) {
+        int n = nv.first;
+        Nodes[n]->GetColor(color);
+        if (Nodes[n]->model->modelDimmingCurve != nullptr) {
+            Nodes[n]->model->modelDimmingCurve->reverse(color);
+        }
+        if (Nodes[n]->model->StrobeRate) {
+            int r = rand() % 5;
+            if (r != 0) {
+                color = xlBLACK;
+            }
+        }
+        int trans = color == xlBLACK ? blackTransparency : transparency;
+        xlColor ccolor(color);
+        ApplyTransparency(ccolor, trans);
+        if (pixelStyle < 2) {
+            for (int v = 0; v < nv.second; v++) {
+                *colors++ = ccolor.red;
+                *colors++ = ccolor.green;
+                *colors++ = ccolor.blue;
+                *colors++ = ccolor.alpha;
+            }
+        } else {
+            // circles are triangles of two edge vertices then the centre
+            xlColor ecolor(color);
+            ApplyTransparency(ecolor, pixelStyle == 2 ? trans : 100);
+            for (int v = 0; v < nv.second; v++) {
+                const xlColor &vc = (v % 3) == 2 ? ccolor : ecolor;
+                *colors++ = vc.red;
+                *colors++ = vc.green;
+                *colors++ = vc.blue;
+                *colors++ = vc.alpha;
+            }
+        }
+    }
+    va.count += vcount;
+
+    if (pixelStyle > 1) {
+        va.Finish(GL_TRIANGLES);
+    } else {
+        va.Finish(GL_POINTS, pixelStyle == 1 ? GL_POINT_SMOOTH : 0, preview->calcPixelSize(pixelSize));
+    }
+    return true;
+}
+
 // display model using colors stored in each node
 // used when preview is running
 void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulator &sva, DrawGLUtils::xlAccumulator &tva, bool is_3d, const xlColor *c, bool allowSelected) {
+    if (c != nullptr) {
+        // drawn in the layout where it may be being moved about
+        InvalidatePreviewGeometry();
+    } else if (DisplayPreviewGeometry(preview, sva, tva, is_3d, allowSelected)) {
+        return;
+    }
     size_t NodeCount = Nodes.size();
     xlColor color;
     if (c != nullptr) {
@@ -3456,6 +3860,12 @@ void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulat
 // display model using colors stored in each node
 // used when preview is running
 void Model::DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xl3Accumulator &sva, DrawGLUtils::xl3Accumulator &tva, bool is_3d, const xlColor *c, bool allowSelected) {
+    if (c != nullptr) {
+        // drawn in the layout where it may be being moved about
+        InvalidatePreviewGeometry();
+    } else if (DisplayPreviewGeometry(preview, sva, tva, is_3d, allowSelected)) {
+        return;
+    }
     size_t NodeCount = Nodes.size();
     xlColor color;
     if (c != nullptr) {
@@ -4286,6 +4696,7 @@ bool Model::CleanupFileLocations(xLightsFrame* frame)
             }
         }
         Model::WriteFaceInfo(ModelXml, faceInfo);
+        ClearFaceStateNodes();
     }
 
     return BaseObject::CleanupFileLocations(frame) || rc;
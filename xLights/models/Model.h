@@ -5,6 +5,8 @@
 #include <map>
 #include <vector>
 #include <list>
+#include <memory>
+#include <mutex>
 
 #include "ModelScreenLocation.h"
 #include "../Color.h"
@@ -42,6 +44,31 @@ enum {
     GRIDCHANGE_MARK_DIRTY_AND_REFRESH = 0x0003
 };
 
+// A face or state definition with its node lists resolved to node indexes. Built once by
+// Model::GetFaceNodes/GetStateNodes so effects dont reparse faceInfo/stateInfo every frame.
+class FaceStateNodes
+{
+public:
+    enum class NODE_TYPE { NONE, SINGLE_NODE, NODE_RANGE };
+    enum class IMAGE_PLACEMENT { SCALE_TO_FIT, CENTERED };
+
+    std::string type;                              // the Type attribute as written
+    NODE_TYPE nodeType = NODE_TYPE::NONE;
+    IMAGE_PLACEMENT imagePlacement = IMAGE_PLACEMENT::SCALE_TO_FIT;
+    bool customColors = false;
+    std::map<std::string, std::vector<int>> nodes; // eg Mouth-AI, Eyes-Open, s1
+    std::map<std::string, xlColor> colors;
+    std::map<std::string, std::string> images;     // eg Mouth-AI-EyesOpen
+    std::map<std::string, std::string> states;     // state name -> state key eg s1
+    std::vector<std::string> stateNames;           // lower case, what * and <ALL> expand to
+    unsigned long changeCount = 0;
+
+    const std::vector<int>& GetNodes(const std::string& key) const;
+    xlColor GetColor(const std::string& key) const; // white if no colour was set
+    std::string GetImage(const std::string& key) const;
+    std::string FindState(const std::string& name) const;
+};
+
 class Model : public BaseObject
 {
     friend class LayoutPanel;
@@ -96,6 +123,11 @@ public:
     std::map<std::string, std::map<std::string, std::string> > stateInfo;
     void AddFace(wxXmlNode* n);
     void AddState(wxXmlNode* n);
+    // nullptr if the model has no such definition
+    std::shared_ptr<const FaceStateNodes> GetFaceNodes(const std::string& definition) const;
+    std::shared_ptr<const FaceStateNodes> GetStateNodes(const std::string& definition) const;
+    // must be called after faceInfo or stateInfo is changed
+    void ClearFaceStateNodes();
     void AddSubmodel(wxXmlNode* n);
 
     wxString SerialiseSubmodel() const;
@@ -104,6 +136,11 @@ public:
     virtual void GetBufferSize(const std::string &type, const std::string &camera, const std::string &transform, int &BufferWi, int &BufferHi) const;
     virtual void InitRenderBufferNodes(const std::string &type, const std::string &camera, const std::string &transform,
                                        std::vector<NodeBaseClassPtr> &Nodes, int &BufferWi, int &BufferHi) const;
+    // InitRenderBufferNodes into an empty node list but reusing a layout cached on the model. Layouts are
+    // kept per buffer style and transform and are rebuilt when GetRenderLayoutChangeCount moves on.
+    void GetRenderBufferNodes(const std::string &type, const std::string &camera, const std::string &transform,
+                              std::vector<NodeBaseClassPtr> &Nodes, int &BufferWi, int &BufferHi) const;
+    virtual unsigned long GetRenderLayoutChangeCount() const { return changeCount; }
     const ModelManager &GetModelManager() const {
         return modelManager;
     }
@@ -271,6 +308,8 @@ public:
     int GetNumberFromChannelString(const std::string &sc, bool &valid, std::string& dependsonmodel) const;
     virtual void DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xlAccumulator &solidVa, DrawGLUtils::xlAccumulator &transparentVa, bool is_3d = false, const xlColor *color = NULL, bool allowSelected = false);
     virtual void DisplayModelOnWindow(ModelPreview* preview, DrawGLUtils::xl3Accumulator &solidVa3, DrawGLUtils::xl3Accumulator &transparentVa3, bool is_3d = false, const xlColor *color =  NULL, bool allowSelected = false);
+    // forget the vertex positions kept for playback so they are recalculated on the next frame
+    void InvalidatePreviewGeometry();
     virtual void DisplayEffectOnWindow(ModelPreview* preview, double pointSize);
     virtual int NodeRenderOrder() {return 0;}
     wxString GetNodeNear(ModelPreview* preview, wxPoint pt);
@@ -388,6 +427,23 @@ public:
 
 protected:
     int maxVertexCount;
+
+    void ClearRenderLayoutCache();
+
+private:
+    struct PreviewGeometry;
+    std::shared_ptr<PreviewGeometry> previewGeometry[2]; // 2D and 3D accumulators
+    std::shared_ptr<PreviewGeometry> BuildPreviewGeometry(bool is_3d, bool allowSelected, unsigned int coordsPerVertex);
+    bool DisplayPreviewGeometry(ModelPreview* preview, DrawGLUtils::xlAccumulator &sva, DrawGLUtils::xlAccumulator &tva, bool is_3d, bool allowSelected);
+
+    std::shared_ptr<const FaceStateNodes> CompileFaceStateNodes(const std::map<std::string, std::string>& info, const std::string& definition, bool state) const;
+    mutable std::mutex faceStateNodesLock;
+    mutable std::map<std::string, std::shared_ptr<const FaceStateNodes>> faceNodes;
+    mutable std::map<std::string, std::shared_ptr<const FaceStateNodes>> stateNodes;
+
+    struct RenderLayout;
+    mutable std::mutex renderLayoutLock;
+    mutable std::map<std::string, std::shared_ptr<const RenderLayout>> renderLayouts;
 };
 
 template <class ScreenLocation>
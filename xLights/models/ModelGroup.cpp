@@ -246,6 +246,7 @@ bool ModelGroup::Reset(bool zeroBased) {
     models.clear();
     modelNames.clear();
     changeCount = 0;
+    ClearRenderLayoutCache();
     wxArrayString mn = wxSplit(ModelXml->GetAttribute("models"), ',');
     int nc = 0;
     for (int x = 0; x < mn.size(); x++) {
@@ -543,6 +544,15 @@ void ModelGroup::CheckForChanges() const {
     }
 }
 
+// a group layout changes whenever any of the models in it do
+unsigned long ModelGroup::GetRenderLayoutChangeCount() const {
+    unsigned long l = 0;
+    for (auto it = models.begin(); it != models.end(); ++it) {
+        l += (*it)->GetRenderLayoutChangeCount();
+    }
+    return l;
+}
+
 void ModelGroup::GetBufferSize(const std::string &tp, const std::string &camera, const std::string &transform, int &BufferWi, int &BufferHt) const {
     CheckForChanges();
     std::string type = tp;
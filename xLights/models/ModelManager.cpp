@@ -1,5 +1,10 @@
 #include <wx/xml/xml.h>
 #include <wx/msgdlg.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+#include <list>
+#include <set>
 
 #include "ModelManager.h"
 #include "Model.h"
@@ -27,6 +32,7 @@
 #include "../xLightsMain.h"
 #include "UtilFunctions.h"
 #include "outputs/Output.h"
+#include "../Parallel.h"
 
 #include <log4cpp/Category.hh>
 
@@ -161,23 +167,150 @@ bool ModelManager::IsModelOverlapping(Model* model) const
     return false;
 }
 
+// Models whose start channel is chained to another model. Submodel references depend on the parent model.
+static std::set<std::string> GetStartChannelDependencies(wxXmlNode* node)
+{
+    std::set<std::string> res;
+    std::string name = node->GetAttribute("name").ToStdString();
+    std::list<std::string> channels;
+    channels.push_back(node->GetAttribute("StartChannel", "1").ToStdString());
+    if (node->GetAttribute("Advanced") == "1") {
+        for (int i = 0; node->HasAttribute(Model::StartChanAttrName(i)); i++) {
+            channels.push_back(node->GetAttribute(Model::StartChanAttrName(i)).ToStdString());
+        }
+    }
+    for (auto it = channels.begin(); it != channels.end(); ++it) {
+        const std::string& sc = *it;
+        size_t colon = sc.find(':');
+        if (colon == std::string::npos || colon < 2 || (sc[0] != '>' && sc[0] != '@' && sc[0] != '<')) {
+            continue;
+        }
+        std::string dep = sc.substr(1, colon - 1);
+        if (dep.find('/') != std::string::npos) {
+            dep = dep.substr(0, dep.find('/'));
+        }
+        if (dep != name) {
+            res.insert(dep);
+        }
+    }
+    return res;
+}
+
+// Splits the model nodes into waves where every model only depends on models in earlier waves
+// so all the models in a wave can be initialised in parallel. Chains and missing models which
+// can never be satisfied end up in the returned leftovers which must be initialised serially.
+static std::vector<std::vector<wxXmlNode*>> GetInitWaves(const std::vector<wxXmlNode*>& nodes, std::vector<wxXmlNode*>& leftovers)
+{
+    std::vector<std::vector<wxXmlNode*>> waves;
+
+    std::set<std::string> names;
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        names.insert((*it)->GetAttribute("name").ToStdString());
+    }
+
+    std::list<std::pair<wxXmlNode*, std::set<std::string>>> pending;
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        std::set<std::string> deps;
+        for (auto& d : GetStartChannelDependencies(*it)) {
+            // models which dont exist will never be satisfied but also never change under us
+            if (names.find(d) != names.end()) {
+                deps.insert(d);
+            }
+        }
+        pending.push_back({ *it, deps });
+    }
+
+    std::set<std::string> done;
+    while (!pending.empty()) {
+        std::vector<wxXmlNode*> wave;
+        for (auto it = pending.begin(); it != pending.end(); ) {
+            bool ready = true;
+            for (auto& d : it->second) {
+                if (done.find(d) == done.end()) {
+                    ready = false;
+                    break;
+                }
+            }
+            if (ready) {
+                wave.push_back(it->first);
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (wave.empty()) {
+            break;
+        }
+        for (auto it = wave.begin(); it != wave.end(); ++it) {
+            done.insert((*it)->GetAttribute("name").ToStdString());
+        }
+        waves.push_back(wave);
+    }
+
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        leftovers.push_back(it->first);
+    }
+    return waves;
+}
+
 void ModelManager::LoadModels(wxXmlNode *modelNode, int previewW, int previewH) {
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    wxStopWatch sw;
+
     clear();
     previewWidth = previewW;
     previewHeight = previewH;
     this->modelNode = modelNode;
-    int countValid = 0;
+
+    // where names are duplicated the last model wins
+    std::map<std::string, wxXmlNode*> byName;
     for (wxXmlNode* e=modelNode->GetChildren(); e!=nullptr; e=e->GetNext()) {
         if (e->GetName() == "model") {
             std::string name = e->GetAttribute("name").ToStdString();
             if (!name.empty()) {
-                Model *m = createAndAddModel(e, previewW, previewH);
-                if (m != nullptr) {
-                    countValid += m->CouldComputeStartChannel ? 1 : 0;
-                }
+                byName[name] = e;
             }
         }
     }
+    std::vector<wxXmlNode*> nodes;
+    for (wxXmlNode* e=modelNode->GetChildren(); e!=nullptr; e=e->GetNext()) {
+        if (e->GetName() == "model") {
+            auto it = byName.find(e->GetAttribute("name").ToStdString());
+            if (it != byName.end() && it->second == e) {
+                nodes.push_back(e);
+            }
+        }
+    }
+
+    // Models in a wave only look up models from earlier waves which are already in the
+    // models map, so they can be created in parallel without anything changing under them.
+    std::vector<wxXmlNode*> leftovers;
+    auto waves = GetInitWaves(nodes, leftovers);
+    int countValid = 0;
+    for (auto& wave : waves) {
+        std::vector<Model*> created(wave.size(), nullptr);
+        parallel_for(0, wave.size(), [this, &wave, &created, previewW, previewH](int i) {
+            created[i] = CreateModel(wave[i], previewW, previewH);
+        });
+        for (size_t i = 0; i < wave.size(); i++) {
+            if (created[i] == nullptr) {
+                // recreate on this thread so the error is shown
+                created[i] = CreateModel(wave[i], previewW, previewH);
+            }
+            AddModel(created[i]);
+            if (created[i] != nullptr) {
+                countValid += created[i]->CouldComputeStartChannel ? 1 : 0;
+            }
+        }
+    }
+    for (auto it = leftovers.begin(); it != leftovers.end(); ++it) {
+        Model *m = createAndAddModel(*it, previewW, previewH);
+        if (m != nullptr) {
+            countValid += m->CouldComputeStartChannel ? 1 : 0;
+        }
+    }
+    logger_base.debug("Loaded %d models in %d waves and %d serially in %ldms.", (int)(nodes.size() - leftovers.size()), (int)waves.size(), (int)leftovers.size(), sw.Time());
+
     while (countValid != models.size()) {
         int newCountValid = 0;
         for (auto it = models.begin(); it != models.end(); ++it) {
@@ -257,14 +390,42 @@ void ModelManager::OldRecalcStartChannels() const {
     for (auto it = models.begin(); it != models.end(); ++it) {
         it->second->CouldComputeStartChannel = false;
     }
+    std::vector<wxXmlNode*> nodes;
+    std::map<wxXmlNode*, Model*> byNode;
     for (auto it = models.begin(); it != models.end(); ++it) {
         if( it->second->GetDisplayAs() != "ModelGroup" ) {
-            it->second->SetFromXml(it->second->GetModelXml());
-            countValid += it->second->CouldComputeStartChannel ? 1 : 0;
+            nodes.push_back(it->second->GetModelXml());
+            byNode[it->second->GetModelXml()] = it->second;
         } else {
             countValid++;
         }
     }
+
+    // a model only reads the models it is chained to which were all recalculated in earlier waves
+    std::vector<wxXmlNode*> leftovers;
+    auto waves = GetInitWaves(nodes, leftovers);
+    waves.push_back(leftovers);
+    for (size_t w = 0; w < waves.size(); w++) {
+        std::vector<Model*> wave;
+        for (auto it = waves[w].begin(); it != waves[w].end(); ++it) {
+            wave.push_back(byNode[*it]);
+        }
+        auto init = [&wave](int i) {
+            if (wave[i] != nullptr) {
+                wave[i]->SetFromXml(wave[i]->GetModelXml());
+            }
+        };
+        if (w == waves.size() - 1) {
+            for (size_t i = 0; i < wave.size(); i++) {
+                init(i);
+            }
+        } else {
+            parallel_for(0, wave.size(), init);
+        }
+        for (auto it = wave.begin(); it != wave.end(); ++it) {
+            countValid += (*it != nullptr && (*it)->CouldComputeStartChannel) ? 1 : 0;
+        }
+    }
     while (countValid != models.size()) {
         int newCountValid = 0;
         for (auto it = models.begin(); it != models.end(); ++it) {
@@ -735,7 +896,10 @@ Model *ModelManager::CreateModel(wxXmlNode *node, int previewW, int previewH, bo
     } else if (type == "Spinner") {
         model = new SpinnerModel(node, *this, zeroBased);
     } else {
-        DisplayError(wxString::Format("'%s' is not a valid model type for model '%s'", type, node->GetAttribute("name")).ToStdString());
+        // models are created in parallel on load, the caller recreates failures on the main thread to report them
+        if (wxThread::IsMain()) {
+            DisplayError(wxString::Format("'%s' is not a valid model type for model '%s'", type, node->GetAttribute("name")).ToStdString());
+        }
         return nullptr;
     }
     model->GetModelScreenLocation().previewW = previewW;
@@ -130,6 +130,17 @@ public:
     unsigned int GetChanCount() const {
         return chanCnt;
     }
+    // true if the node just copies c[] to and from the channels at offsets[] ... the render output
+    // flattens these nodes rather than calling through the virtual functions for every frame
+    virtual bool IsChannelMapped() const {
+        return true;
+    }
+    const uint8_t *GetColorComponents() const {
+        return c;
+    }
+    uint8_t GetChannelOffset(int component) const {
+        return offsets[component];
+    }
     bool IsVisible() const {
         return Coords.size() > 0;
     }
@@ -311,6 +322,9 @@ public:
     virtual NodeBaseClass *clone() const override {
         return new NodeClassCustom(*this);
     }
+    virtual bool IsChannelMapped() const override {
+        return false;
+    }
 private:
     HSVValue hsv;
     std::string type;
@@ -355,6 +369,9 @@ public:
     virtual NodeBaseClass *clone() const override {
         return new NodeClassIntensity(*this);
     }
+    virtual bool IsChannelMapped() const override {
+        return false;
+    }
 private:
     HSVValue hsv;
     std::string type;
@@ -385,6 +402,9 @@ public:
     virtual NodeBaseClass *clone() const override {
         return new NodeClassWhite(*this);
     }
+    virtual bool IsChannelMapped() const override {
+        return false;
+    }
 };
 class NodeClassRGBW : public NodeBaseClass
 {
@@ -408,6 +428,9 @@ public:
     virtual NodeBaseClass *clone() const override {
         return new NodeClassRGBW(*this);
     }
+    virtual bool IsChannelMapped() const override {
+        return false;
+    }
 private:
     uint8_t wOffset;
     uint8_t wIndex;
@@ -18,6 +18,7 @@ public:
     virtual void MoveHandle3D(ModelPreview* preview, int handle, bool ShiftKeyPressed, bool CtrlKeyPressed, int mouseX, int mouseY, bool latch, bool scale_z) override {}
 
     virtual const std::string &GetLayoutGroup() const override { return parent->GetLayoutGroup(); }
+    virtual unsigned long GetRenderLayoutChangeCount() const override { return changeCount + parent->GetRenderLayoutChangeCount(); }
 
     virtual void AddProperties(wxPropertyGridInterface *grid, OutputManager* outputManager) override {}
     virtual bool SupportsExportAsCustom() const override { return false; }
@@ -276,6 +276,7 @@ void ArtNetOutput::EndFrame(int suppressFrames)
     if (_changed || NeedToOutput(suppressFrames))
     {
         _data[12] = _sequenceNum;
+        PacePacket();
         _datagram->SendTo(_remoteAddr, _data, ARTNET_PACKET_LEN - (512 - _channels));
         _sequenceNum = _sequenceNum == 255 ? 0 : _sequenceNum + 1;
         FrameOutput();
@@ -322,8 +323,7 @@ void ArtNetOutput::SetManyChannels(long channel, unsigned char data[], long size
 
 void ArtNetOutput::AllOff()
 {
-    memset(&_data[ARTNET_PACKET_HEADERLEN], 0x00, _channels);
-    _changed = true;
+    ClearChannels(&_data[ARTNET_PACKET_HEADERLEN], _channels);
 }
 #pragma endregion Data Setting
 
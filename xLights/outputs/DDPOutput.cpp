@@ -21,6 +21,9 @@ DDPOutput::DDPOutput(wxXmlNode* node) : IPOutput(node)
     _channelsPerPacket = wxAtoi(node->GetAttribute("ChannelsPerPacket"));
     _keepChannelNumbers = wxAtoi(node->GetAttribute("KeepChannelNumbers"));
     _sequenceNum = 0;
+    _changedStart = 0;
+    _changedEnd = 0;
+    _framesSinceFull = 9999;
     _datagram = nullptr;
     memset(_data, 0, sizeof(_data));
 }
@@ -34,6 +37,9 @@ DDPOutput::DDPOutput() : IPOutput()
     _sequenceNum = 0;
     _datagram = nullptr;
     _keepChannelNumbers = true;
+    _changedStart = 0;
+    _changedEnd = 0;
+    _framesSinceFull = 9999;
     memset(_data, 0, sizeof(_data));
 }
 
@@ -176,7 +182,10 @@ bool DDPOutput::Open()
         _ok = false;
         return false;
     }
-    AllOff();
+    memset(_fulldata, 0x00, _channels);
+    _changedStart = _channels;
+    _changedEnd = 0;
+    _framesSinceFull = 9999;
 
     _ok = IPOutput::Open();
 
@@ -232,11 +241,16 @@ void DDPOutput::EndFrame(int suppressFrames)
 {
     if (!_enabled || _suspend || _datagram == nullptr) return;
 
-    if (_changed || NeedToOutput(suppressFrames))
+    // DDP carries the offset of the data so when only some channels changed just they are sent ...
+    // except every so often when everything is sent in case the controller missed something
+    bool full = NeedToOutput(suppressFrames) || _framesSinceFull >= suppressFrames;
+
+    if (full || (_changed && _changedEnd > _changedStart))
     {
-        long index = 0;
-        long chan = _keepChannelNumbers ? (_startChannel - 1) : 0;
-        long tosend = _channels;
+        long start = full ? 0 : _changedStart;
+        long index = start;
+        long chan = (_keepChannelNumbers ? (_startChannel - 1) : 0) + start;
+        long tosend = (full ? _channels : _changedEnd) - start;
 
         while (tosend > 0)
         {
@@ -271,6 +285,7 @@ void DDPOutput::EndFrame(int suppressFrames)
 
             memcpy(&_data[10], _fulldata + index, thissend);
 
+            PacePacket();
             _datagram->SendTo(_remoteAddr, &_data[0], DDP_PACKET_LEN - (1440 - thissend));
             _sequenceNum = _sequenceNum == 15 ? 1 : _sequenceNum + 1;
 
@@ -279,10 +294,14 @@ void DDPOutput::EndFrame(int suppressFrames)
             chan += thissend;
         }
         FrameOutput();
+        _changedStart = _channels;
+        _changedEnd = 0;
+        _framesSinceFull = full ? 0 : _framesSinceFull + 1;
     }
     else
     {
         SkipFrame();
+        _framesSinceFull++;
     }
 }
 #pragma endregion Frame Handling
@@ -295,7 +314,7 @@ void DDPOutput::SetOneChannel(long channel, unsigned char data)
     if ((channel < _channels) && (*(_fulldata + channel) != data))
     {
         *(_fulldata + channel) = data;
-        _changed = true;
+        MarkChanged(channel, channel + 1);
     }
 }
 
@@ -315,16 +334,30 @@ void DDPOutput::SetManyChannels(long channel, unsigned char data[], long size)
     }
     else
     {
-        memcpy(_fulldata + channel, data, chs);
-        _changed = true;
+        // narrow it down to the channels that actually changed
+        long first = 0;
+        while (_fulldata[channel + first] == data[first]) first++;
+        long last = chs;
+        while (_fulldata[channel + last - 1] == data[last - 1]) last--;
+
+        memcpy(_fulldata + channel + first, data + first, last - first);
+        MarkChanged(channel + first, channel + last);
     }
 }
 
 void DDPOutput::AllOff()
 {
     if (_fulldata == nullptr) return;
-    memset(_fulldata, 0x00, _channels);
-    _changed = true;
+
+    for (long i = 0; i < _channels; i++)
+    {
+        if (_fulldata[i] != 0x00)
+        {
+            memset(_fulldata, 0x00, _channels);
+            MarkChanged(0, _channels);
+            return;
+        }
+    }
 }
 #pragma endregion Data Setting
 
@@ -5,6 +5,8 @@
 #include <wx/sckaddr.h>
 #include <wx/socket.h>
 
+#include <algorithm>
+
 // ******************************************************
 // * This class represents a single universe for DDP
 // ******************************************************
@@ -38,6 +40,11 @@ class DDPOutput : public IPOutput
     int _channelsPerPacket;
     bool _keepChannelNumbers;
     uint8_t* _fulldata;
+    long _changedStart; // range of channels changed since they were last sent
+    long _changedEnd;
+    int _framesSinceFull; // frames since every channel was sent
+
+    void MarkChanged(long start, long end) { _changedStart = std::min(_changedStart, start); _changedEnd = std::max(_changedEnd, end); _changed = true; }
 
     // These are used for DDP sync
     static bool __initialised;
@@ -445,6 +445,7 @@ void E131Output::EndFrame(int suppressFrames)
         if (_changed || NeedToOutput(suppressFrames))
         {
             _data[111] = _sequenceNum;
+            PacePacket();
             _datagram->SendTo(_remoteAddr, _data, E131_PACKET_LEN - (512 - _channels));
             _sequenceNum = _sequenceNum == 255 ? 0 : _sequenceNum + 1;
             FrameOutput();
@@ -556,8 +557,7 @@ void E131Output::AllOff()
     }
     else
     {
-        memset(&_data[E131_PACKET_HEADERLEN], 0x00, _channels);
-        _changed = true;
+        ClearChannels(&_data[E131_PACKET_HEADERLEN], _channels);
     }
 }
 #pragma endregion Data Setting
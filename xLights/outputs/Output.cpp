@@ -18,6 +18,8 @@
 #include "../UtilFunctions.h"
 #include "OutputManager.h"
 
+#include <thread>
+
 #pragma region Constructors and Destructors
 Output::Output(Output* output)
 {
@@ -32,9 +34,11 @@ Output::Output(Output* output)
     _universe = 0;
     _lastOutputTime = 0;
     _skippedFrames = 9999;
+    _pacer = nullptr;
     _autoSize = false;
 
     _suppressDuplicateFrames = output->IsSuppressDuplicateFrames();
+    _packetGapUS = output->GetPacketGapUS();
     _dirty = output->IsDirty();
     _enabled = output->IsEnabled();
     _description = output->GetDescription();
@@ -60,9 +64,11 @@ Output::Output(wxXmlNode* node)
     _ok = true;
     _lastOutputTime = 0 ;
     _skippedFrames = 9999;
+    _pacer = nullptr;
 
     _enabled = (node->GetAttribute("Enabled", "Yes") == "Yes");
     _suppressDuplicateFrames = (node->GetAttribute("SuppressDuplicates", "No") == "Yes");
+    _packetGapUS = wxAtoi(node->GetAttribute("PacketGap", "0"));
     _description = UnXmlSafe(node->GetAttribute("Description"));
     _channels = wxAtoi(node->GetAttribute("MaxChannels"));
     _controller = UnXmlSafe(node->GetAttribute("Controller"));
@@ -88,8 +94,10 @@ Output::Output()
     _ip = "";
     _ok = true;
     _suppressDuplicateFrames = false;
+    _packetGapUS = 0;
     _lastOutputTime = 0;
     _skippedFrames = 9999;
+    _pacer = nullptr;
 }
 #pragma endregion Constructors and Destructors
 
@@ -106,6 +114,11 @@ void Output::Save(wxXmlNode* node)
         node->AddAttribute("SuppressDuplicates", "Yes");
     }
 
+    if (_packetGapUS != 0)
+    {
+        node->AddAttribute("PacketGap", wxString::Format(wxT("%i"), _packetGapUS));
+    }
+
     if (_description != "")
     {
         node->AddAttribute("Description", XmlSafe(_description));
@@ -258,6 +271,45 @@ void Output::SetManyChannels(long channel, unsigned char data[], long size)
 }
 #pragma endregion Data Setting
 
+void PacketPacer::Wait()
+{
+    // sleeps are too coarse for small gaps so only sleep for the bulk of it
+    auto now = std::chrono::steady_clock::now();
+    if (_next - now > std::chrono::milliseconds(2))
+    {
+        std::this_thread::sleep_for(_next - now - std::chrono::milliseconds(1));
+    }
+    while (std::chrono::steady_clock::now() < _next)
+    {
+        std::this_thread::yield();
+    }
+    _next = std::chrono::steady_clock::now() + std::chrono::microseconds(_gapUS);
+}
+
+// collections pass it on so each universe is paced rather than the collection as a whole
+void Output::SetPacer(PacketPacer* pacer)
+{
+    _pacer = pacer;
+    for (auto it : GetOutputs())
+    {
+        it->SetPacer(pacer);
+    }
+}
+
+// zeroes the channel data only flagging the packet as changed if something was on
+void Output::ClearChannels(unsigned char* data, long size)
+{
+    for (long i = 0; i < size; i++)
+    {
+        if (data[i] != 0x00)
+        {
+            memset(&data[i], 0x00, size - i);
+            _changed = true;
+            return;
+        }
+    }
+}
+
 void Output::FrameOutput()
 {
     _lastOutputTime = wxGetUTCTimeMillis();
@@ -4,6 +4,8 @@
 #include <wx/window.h>
 #include <wx/time.h>
 
+#include <chrono>
+
 class ModelManager;
 class OutputManager;
 class wxXmlNode;
@@ -35,6 +37,19 @@ typedef enum
     PING_UNKNOWN
 } PINGSTATE;
 
+// Spaces out the packets sent to one controller so it does not get them in bursts
+class PacketPacer
+{
+    int _gapUS;
+    std::chrono::steady_clock::time_point _next;
+
+public:
+    PacketPacer(int gapUS) : _gapUS(gapUS), _next(std::chrono::steady_clock::now()) {}
+
+    // call immediately before sending each packet
+    void Wait();
+};
+
 class Output
 {
 protected:
@@ -56,6 +71,8 @@ protected:
     long _timer_msec;
     bool _ok;
     bool _suppressDuplicateFrames;
+    int _packetGapUS; // minimum gap between packets sent to the controller
+    PacketPacer* _pacer; // paces the packets of the frame being sent ... null when there is no gap
     wxLongLong _lastOutputTime;
     int _skippedFrames;
     bool _changed; // set to true when something in the packed has changed
@@ -63,6 +80,8 @@ protected:
     #pragma endregion Member Variables
 
     virtual void Save(wxXmlNode* node);
+    void ClearChannels(unsigned char* data, long size);
+    void PacePacket() { if (_pacer != nullptr) _pacer->Wait(); }
 
 public:
 
@@ -86,10 +105,14 @@ public:
     long GetStartChannel() const { return _startChannel; }
     long GetActualEndChannel() const { return _startChannel + _channels - 1; }
     void Suspend(bool suspend) { _suspend = suspend; }
+    bool IsSuspended() const { return _suspend; }
     virtual long GetEndChannel() const { return _startChannel + _channels - 1; }
     std::string GetDescription() const { return _description; }
     void SetDescription(const std::string& description) { _description = description; _dirty = true; }
     void SetSuppressDuplicateFrames(const bool suppressDuplicateFrames) { _suppressDuplicateFrames = suppressDuplicateFrames; _dirty = true; }
+    int GetPacketGapUS() const { return _packetGapUS; }
+    void SetPacketGapUS(int packetGapUS) { _packetGapUS = packetGapUS; _dirty = true; }
+    void SetPacer(PacketPacer* pacer);
     std::string GetIP() const { return _ip; }
     void SetIP(const std::string& ip);
     std::string GetCommPort() const { return _commPort; }
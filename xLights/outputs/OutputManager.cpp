@@ -10,10 +10,92 @@
 #include "DDPOutput.h"
 #include "TestPreset.h"
 #include "../osxMacUtils.h"
-#include "../Parallel.h"
 
 #include <log4cpp/Category.hh>
 
+#include <thread>
+#include <chrono>
+
+#pragma region Controller Transmitter
+// Sends the outputs of one controller on its own thread so controllers are sent to at the same time
+// without competing with rendering for the parallel job pool. Packets to the controller can be spaced
+// out so small controllers are not hit with a whole frame of universes at once.
+class ControllerTransmitter
+{
+    OutputManager* _outputManager;
+    std::string _name;
+    std::list<Output*> _outputs;
+    int _packetGapUS;
+    int _suppressFrames;
+    bool _pending;
+    bool _stop;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    std::thread _thread;
+
+    void Run()
+    {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+        logger_base.debug("Controller transmit thread %s started.", (const char *)_name.c_str());
+
+        std::unique_lock<std::mutex> lock(_lock);
+        while (true)
+        {
+            _signal.wait(lock, [this] { return _pending || _stop; });
+            if (_stop) break;
+
+            std::list<Output*> outputs = _outputs;
+            int packetGapUS = _packetGapUS;
+            int suppressFrames = _suppressFrames;
+            lock.unlock();
+
+            // the outputs wait on the pacer just before each packet they actually send
+            PacketPacer pacer(packetGapUS);
+            for (auto it : outputs)
+            {
+                if (packetGapUS > 0) it->SetPacer(&pacer);
+                it->EndFrame(suppressFrames);
+                if (packetGapUS > 0) it->SetPacer(nullptr);
+            }
+
+            lock.lock();
+            _pending = false;
+            _outputManager->TransmitComplete();
+        }
+
+        logger_base.debug("Controller transmit thread %s stopped.", (const char *)_name.c_str());
+    }
+
+public:
+    ControllerTransmitter(OutputManager* outputManager, const std::string& name) :
+        _outputManager(outputManager), _name(name), _packetGapUS(0), _suppressFrames(0), _pending(false), _stop(false)
+    {
+        _thread = std::thread([this] { Run(); });
+    }
+
+    ~ControllerTransmitter()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _stop = true;
+            _signal.notify_all();
+        }
+        _thread.join();
+    }
+
+    // hands over a frame. The outputs must not be touched until the output manager is told it is sent
+    void Transmit(const std::list<Output*>& outputs, int packetGapUS, int suppressFrames)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _outputs = outputs;
+        _packetGapUS = packetGapUS;
+        _suppressFrames = suppressFrames;
+        _pending = true;
+        _signal.notify_all();
+    }
+};
+#pragma endregion Controller Transmitter
+
 int OutputManager::_lastSecond = -10;
 int OutputManager::_currentSecond = -10;
 int OutputManager::_lastSecondCount = 0;
@@ -30,10 +112,13 @@ OutputManager::OutputManager()
     _syncUniverse = 0;
     _outputting = false;
     _suppressFrames = 0;
+    _transmitting = 0;
 }
 
 OutputManager::~OutputManager()
 {
+    DeleteTransmitters();
+
     // destroy all out output objects
     DeleteAllOutputs();
 }
@@ -603,6 +688,7 @@ void OutputManager::DeleteOutput(Output* output)
 {
     if (std::find(_outputs.begin(), _outputs.end(), output) == _outputs.end()) return;
 
+    WaitForTransmit();
     _dirty = true;
     _outputs.remove(output);
     delete output;
@@ -613,6 +699,7 @@ void OutputManager::DeleteOutput(Output* output)
 // This will actually delete the outputs objects so they should not be accessed after this call
 void OutputManager::DeleteAllOutputs()
 {
+    WaitForTransmit();
     _dirty = true;
 
     for (auto it : _outputs)
@@ -796,6 +883,7 @@ void OutputManager::Replace(Output* replacethis, Output* withthis)
 void OutputManager::StartFrame(long msec)
 {
     if (!_outputting) return;
+    WaitForTransmit();
     if (!_outputCriticalSection.TryEnter()) return;
     for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
     {
@@ -807,6 +895,7 @@ void OutputManager::StartFrame(long msec)
 void OutputManager::ResetFrame()
 {
     if (!_outputting) return;
+    WaitForTransmit();
     if (!_outputCriticalSection.TryEnter()) return;
     for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
     {
@@ -818,14 +907,13 @@ void OutputManager::ResetFrame()
 void OutputManager::EndFrame()
 {
     if (!_outputting) return;
+    WaitForTransmit();
     if (!_outputCriticalSection.TryEnter()) return;
 
-    if (_parallelTransmission)
+    if (UseTransmitThreads())
     {
-        std::function<void(Output*&, int)> f = [this](Output*&o, int n) {
-            o->EndFrame(_suppressFrames);
-        };
-        parallel_for(_outputs, f);
+        // sync packets are sent by whichever controller finishes last
+        TransmitFrame();
     }
     else
     {
@@ -833,8 +921,14 @@ void OutputManager::EndFrame()
         {
             (*it)->EndFrame(_suppressFrames);
         }
+        SendSync();
     }
 
+    _outputCriticalSection.Leave();
+}
+
+void OutputManager::SendSync()
+{
     if (IsSyncEnabled())
     {
         if (_syncUniverse != 0)
@@ -855,7 +949,81 @@ void OutputManager::EndFrame()
             DDPOutput::SendSync();
         }
     }
-    _outputCriticalSection.Leave();
+}
+
+bool OutputManager::UseTransmitThreads() const
+{
+    if (_parallelTransmission) return true;
+
+    for (auto it : _outputs)
+    {
+        if (it->GetPacketGapUS() > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void OutputManager::TransmitFrame()
+{
+    // outputs are grouped every frame so it doesnt matter if they have been changed since the last one
+    std::map<std::string, std::list<Output*>> controllers;
+    std::map<std::string, int> packetGaps;
+    for (auto it : _outputs)
+    {
+        std::string name = it->IsIpOutput() ? it->GetIP() : it->GetCommPort();
+        controllers[name].push_back(it);
+        packetGaps[name] = std::max(packetGaps[name], it->GetPacketGapUS());
+    }
+
+    if (controllers.empty())
+    {
+        SendSync();
+        return;
+    }
+
+    _transmitting = controllers.size();
+    for (auto& it : controllers)
+    {
+        auto t = _transmitters.find(it.first);
+        if (t == _transmitters.end())
+        {
+            t = _transmitters.emplace(it.first, new ControllerTransmitter(this, it.first)).first;
+        }
+        t->second->Transmit(it.second, packetGaps[it.first], _suppressFrames);
+    }
+}
+
+void OutputManager::TransmitComplete()
+{
+    std::unique_lock<std::mutex> lock(_transmitLock);
+    if (_transmitting == 1)
+    {
+        // last one done ... only count it once the sync is out
+        SendSync();
+    }
+    _transmitting--;
+    _transmitDone.notify_all();
+}
+
+// Outputs hold the data being sent so nothing can change them until the controllers are done
+void OutputManager::WaitForTransmit()
+{
+    if (_transmitting == 0) return;
+
+    std::unique_lock<std::mutex> lock(_transmitLock);
+    _transmitDone.wait(lock, [this] { return _transmitting == 0; });
+}
+
+void OutputManager::DeleteTransmitters()
+{
+    WaitForTransmit();
+    for (auto it : _transmitters)
+    {
+        delete it.second;
+    }
+    _transmitters.clear();
 }
 #pragma endregion Frame Handling
 
@@ -912,10 +1080,13 @@ void OutputManager::StopOutput()
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
     if (!_outputting) return;
+    WaitForTransmit();
     if (!_outputCriticalSection.TryEnter()) return;
 
     logger_base.debug("Stopping light output.");
 
+    DeleteTransmitters();
+
     _outputting = false;
 
     for (auto it = _outputs.begin(); it != _outputs.end(); ++it)
@@ -933,6 +1104,7 @@ void OutputManager::StopOutput()
 #pragma region Data Setting
 void OutputManager::AllOff(bool send)
 {
+    WaitForTransmit();
     if (!_outputCriticalSection.TryEnter()) return;
     for (auto it : _outputs)
     {
@@ -948,6 +1120,7 @@ void OutputManager::AllOff(bool send)
 // channel here is zero based
 void OutputManager::SetOneChannel(long channel, unsigned char data)
 {
+    WaitForTransmit();
     long sc = 0;
     Output* output = GetLevel1Output(channel + 1, sc);
     if (output != nullptr)
@@ -963,6 +1136,7 @@ void OutputManager::SetOneChannel(long channel, unsigned char data)
 void OutputManager::SetManyChannels(long channel, unsigned char* data, long size)
 {
     if (size == 0) return;
+    WaitForTransmit();
 
     long stch;
     Output* o = GetLevel1Output(channel + 1, stch);
@@ -2,12 +2,17 @@
 #define OUTPUTMANAGER_H
 
 #include <list>
+#include <map>
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <wx/thread.h>
 
 class Output;
 class Controller;
 class TestPreset;
+class ControllerTransmitter;
 
 #define NETWORKSFILE "xlights_networks.xml";
 
@@ -24,6 +29,10 @@ class OutputManager
     bool _parallelTransmission;
     bool _outputting; // true if we are currently sending out data
     wxCriticalSection _outputCriticalSection; // used to protect areas that must be single threaded
+    std::map<std::string, ControllerTransmitter*> _transmitters; // one per controller when transmitting on threads
+    std::atomic_int _transmitting; // controllers still sending the last frame
+    std::mutex _transmitLock;
+    std::condition_variable _transmitDone;
     #pragma endregion Member Variables
 
     static int _lastSecond;
@@ -34,6 +43,13 @@ class OutputManager
     static bool _isInteractive;
 
     bool SetGlobalOutputtingFlag(bool state, bool force = false);
+    void SendSync();
+    bool UseTransmitThreads() const;
+    void TransmitFrame();
+    void TransmitComplete();
+    void WaitForTransmit();
+    void DeleteTransmitters();
+    friend class ControllerTransmitter;
 
 public:
 
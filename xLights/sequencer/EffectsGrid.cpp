@@ -597,12 +597,14 @@ void EffectsGrid::OnGridPopup(wxCommandEvent& event)
             }
         }
         phoneme_layer->DeleteSelectedEffects(mSequenceElements->get_undo_mgr());
+        std::vector<Effect*> words;
         for (int x = 0; x < layer->GetEffectCount(); x++) {
             word_effect = layer->GetEffect(x);
             if (word_effect->GetSelected() != EFFECT_NOT_SELECTED) {
-                mSequenceElements->BreakdownWord(phoneme_layer, word_effect->GetStartTimeMS(), word_effect->GetEndTimeMS(), word_effect->GetEffectName());
+                words.push_back(word_effect);
             }
         }
+        mSequenceElements->BreakdownWords(phoneme_layer, words);
         element->SetCollapsed(false);
         wxCommandEvent eventRowHeaderChanged(EVT_ROW_HEADINGS_CHANGED);
         wxPostEvent(mParent, eventRowHeaderChanged);
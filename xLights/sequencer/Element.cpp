@@ -50,6 +50,9 @@ void Element::SetName(const std::string &name)
 {
     mName = name;
     changeCount++;
+    if (parent != nullptr) {
+        parent->InvalidateElementIndex();
+    }
     listener->IncrementChangeCount(this);
 }
 
@@ -376,6 +379,14 @@ ModelElement::~ModelElement()
 void ModelElement::RemoveAllSubModels()
 {
     mSubModels.clear();
+    SubModelsChanged();
+}
+
+void ModelElement::SubModelsChanged()
+{
+    if (GetSequenceElements() != nullptr) {
+        GetSequenceElements()->InvalidateElementIndex();
+    }
 }
 
 void ModelElement::CleanupAfterRender() {
@@ -576,6 +587,7 @@ void ModelElement::Init(Model &model) {
         }
         mStrands[x]->InitFromModel(model);
     }
+    SubModelsChanged();
 }
 
 StrandElement* ModelElement::GetStrand(int index, bool create) {
@@ -583,6 +595,7 @@ StrandElement* ModelElement::GetStrand(int index, bool create) {
         StrandElement* new_layer = new StrandElement(this, mStrands.size());
         mStrands.push_back(new_layer);
         IncrementChangeCount(-1, -1);
+        SubModelsChanged();
     }
     if (index >= mStrands.size()) {
         return nullptr;
@@ -611,6 +624,7 @@ void ModelElement::RemoveSubModel(const std::string &name) {
         if (name == (*a)->GetName()) {
             delete *a;
             mSubModels.erase(a);
+            SubModelsChanged();
             break;
         }
     }
@@ -641,6 +655,7 @@ SubModelElement* ModelElement::GetSubModel(int i)
 
 void ModelElement::AddSubModel(SubModelElement* sme) {
     mSubModels.push_back(sme);
+    SubModelsChanged();
 }
 
 SubModelElement *ModelElement::GetSubModel(const std::string &name, bool create) {
@@ -656,6 +671,7 @@ SubModelElement *ModelElement::GetSubModel(const std::string &name, bool create)
     }
     if (create) {
         mSubModels.push_back(new SubModelElement(this, name));
+        SubModelsChanged();
         return mSubModels.back();
     }
     return nullptr;
@@ -260,6 +260,8 @@ class ModelElement : public Element
 
     protected:
     private:
+        void SubModelsChanged();
+
         bool mStrandsVisible = false;
         bool mSelected;
         std::vector<SubModelElement*> mSubModels;
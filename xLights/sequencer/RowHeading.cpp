@@ -1097,12 +1097,12 @@ void RowHeading::BreakdownTimingWords(TimingElement* element)
     }
     EffectLayer* word_layer = element->GetEffectLayer(1);
     EffectLayer* phoneme_layer = element->AddEffectLayer();
+    std::vector<Effect*> words;
     for( int i = 0; i < word_layer->GetEffectCount(); i++ )
     {
-        Effect* effect = word_layer->GetEffect(i);
-        std::string word = effect->GetEffectName();
-        mSequenceElements->BreakdownWord(phoneme_layer, effect->GetStartTimeMS(), effect->GetEndTimeMS(), word);
+        words.push_back(word_layer->GetEffect(i));
     }
+    mSequenceElements->BreakdownWords(phoneme_layer, words);
     wxCommandEvent eventRowHeaderChanged(EVT_ROW_HEADINGS_CHANGED);
     wxPostEvent(GetParent(), eventRowHeaderChanged);
 }
@@ -53,6 +53,8 @@ SequenceElements::SequenceElements(xLightsFrame *f)
     mModelsNode = nullptr;
     mChangeCount = 0;
     mMasterViewChangeCount = 0;
+    mElementIndexChangeCount = 0;
+    mElementIndexValid = false;
     mCurrentView = 0;
     std::vector<Element*> master_view;
     mAllViews.push_back(master_view); // first view must remain as master view that determines render order
@@ -260,6 +262,13 @@ bool SequenceElements::ElementExists(const std::string &elementName, int view)
 {
     if (view >= mAllViews.size()) return false;
 
+    if (view == MASTER_VIEW)
+    {
+        // top level elements are indexed by their plain name
+        Element* el = GetElement(elementName);
+        return el != nullptr && el->GetType() != ELEMENT_TYPE_SUBMODEL && el->GetType() != ELEMENT_TYPE_STRAND;
+    }
+
     for (size_t i = 0; i < mAllViews[view].size(); i++)
     {
         if (mAllViews[view][i]->GetName() == elementName)
@@ -397,18 +406,21 @@ int SequenceElements::GetElementIndex(const std::string &name, int view)
     return -1;
 }
 
-Element* SequenceElements::GetElement(const std::string &name) const
+// Must be called with mElementIndexLock held. Walks the master view in the same order the
+// old linear search did so where names collide the first match still wins.
+void SequenceElements::BuildElementIndex() const
 {
-    if (mAllViews.size() == 0) return nullptr;
+    mElementIndex.clear();
+    mElementIndexValid = true;
+    mElementIndexChangeCount = mMasterViewChangeCount;
+    if (mAllViews.size() == 0) return;
 
+    mElementIndex.reserve(mAllViews[MASTER_VIEW].size() * 2);
     for (size_t i = 0; i < mAllViews[MASTER_VIEW].size(); ++i)
     {
         Element *el = mAllViews[MASTER_VIEW][i];
-        if (name == el->GetFullName())
-        {
-            return mAllViews[MASTER_VIEW][i];
-        }
-        else if (el->GetType() == ELEMENT_TYPE_MODEL) {
+        mElementIndex.emplace(el->GetFullName(), el);
+        if (el->GetType() == ELEMENT_TYPE_MODEL) {
             ModelElement* mel = dynamic_cast<ModelElement*>(el);
             if (mel != nullptr)
             {
@@ -416,16 +428,32 @@ Element* SequenceElements::GetElement(const std::string &name) const
                     SubModelElement* sme = mel->GetSubModel(x);
                     if (sme != nullptr)
                     {
-                        if (sme->GetFullName() == name) {
-                            return sme;
-                        }
+                        mElementIndex.emplace(sme->GetFullName(), sme);
                     }
                 }
             }
         }
     }
+}
 
-    return nullptr;
+Element* SequenceElements::GetElement(const std::string &name) const
+{
+    if (mAllViews.size() == 0) return nullptr;
+
+    std::unique_lock<std::mutex> lock(mElementIndexLock);
+    if (!mElementIndexValid || mElementIndexChangeCount != mMasterViewChangeCount)
+    {
+        BuildElementIndex();
+    }
+
+    auto it = mElementIndex.find(name);
+    if (it != mElementIndex.end() && it->second->GetFullName() != name)
+    {
+        // something was renamed without telling us
+        BuildElementIndex();
+        it = mElementIndex.find(name);
+    }
+    return it == mElementIndex.end() ? nullptr : it->second;
 }
 
 Element* SequenceElements::GetElement(size_t index, int view) const
@@ -1099,6 +1127,9 @@ void SequenceElements::PopulateView(const std::string &models, int view)
     if (view >= mAllViews.size()) return;
 
     mAllViews[view].clear();
+    if (view == MASTER_VIEW) {
+        InvalidateElementIndex();
+    }
 
     if(models.length()> 0)
     {
@@ -1992,9 +2023,33 @@ bool removechar(std::string& word, char remove)
 void SequenceElements::BreakdownWord(EffectLayer* phoneme_layer, int start_time, int end_time, const std::string& word)
 {
     xframe->dictionary.LoadDictionaries(xframe->CurrentDir, xframe);
-    wxArrayString phonemes;
-    xframe->dictionary.BreakdownWord(word, phonemes);
-    if (phonemes.Count() > 0)
+    std::vector<std::vector<std::string>> phonemes;
+    xframe->dictionary.BreakdownWords({ word }, phonemes);
+    AddPhonemes(phoneme_layer, start_time, end_time, phonemes[0]);
+}
+
+void SequenceElements::BreakdownWords(EffectLayer* phoneme_layer, const std::vector<Effect*>& words)
+{
+    xframe->dictionary.LoadDictionaries(xframe->CurrentDir, xframe);
+
+    std::vector<std::string> names;
+    names.reserve(words.size());
+    for (const auto& it : words)
+    {
+        names.push_back(it->GetEffectName());
+    }
+    std::vector<std::vector<std::string>> phonemes;
+    xframe->dictionary.BreakdownWords(names, phonemes);
+
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        AddPhonemes(phoneme_layer, words[i]->GetStartTimeMS(), words[i]->GetEndTimeMS(), phonemes[i]);
+    }
+}
+
+void SequenceElements::AddPhonemes(EffectLayer* phoneme_layer, int start_time, int end_time, const std::vector<std::string>& phonemes)
+{
+    if (phonemes.size() > 0)
     {
         int countShort = 0;
         for (auto it: phonemes)
@@ -2002,19 +2057,19 @@ void SequenceElements::BreakdownWord(EffectLayer* phoneme_layer, int start_time,
             if (it == "etc" || it == "MBP") countShort++;
         }
 
-        double default_interval_ms = (end_time - start_time) / phonemes.Count(); // the interval if we just split everything evenly
+        double default_interval_ms = (end_time - start_time) / phonemes.size(); // the interval if we just split everything evenly
         double short_interval = 50; // our preferred interval for MBP/etc
         if (default_interval_ms < 50)
         {
             short_interval = GetMinPeriod();
         }
         // our adjusted interval for non MBP/etc once split evenly
-        double adjusted_interval = (end_time - start_time - countShort * short_interval) / (phonemes.Count() - countShort);
+        double adjusted_interval = (end_time - start_time - countShort * short_interval) / (phonemes.size() - countShort);
 
         int phoneme_start_time = start_time;
         int shorts = 0;
         int longs = 0;
-        for (auto phoneme : phonemes)
+        for (const auto& phoneme : phonemes)
         {
             if (phoneme == "etc" || phoneme == "MBP")
             {
@@ -2035,7 +2090,7 @@ void SequenceElements::BreakdownWord(EffectLayer* phoneme_layer, int start_time,
             // only create phonemes with duration
             if (phoneme_end_time > phoneme_start_time)
             {
-                phoneme_layer->AddEffect(0, phoneme.ToStdString(), "", "", phoneme_start_time, phoneme_end_time, EFFECT_NOT_SELECTED, false);
+                phoneme_layer->AddEffect(0, phoneme, "", "", phoneme_start_time, phoneme_end_time, EFFECT_NOT_SELECTED, false);
             }
             phoneme_start_time = phoneme_end_time;
         }
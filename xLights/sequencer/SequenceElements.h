@@ -8,6 +8,8 @@
 #include <set>
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include "wx/xml/xml.h"
 #include "wx/filename.h"
 #include "UndoManager.h"
@@ -123,6 +125,8 @@ public:
     void ImportLyrics(TimingElement* element, wxWindow* parent);
     void BreakdownPhrase(EffectLayer* word_layer, int start_time, int end_time, const std::string& phrase);
     void BreakdownWord(EffectLayer* phoneme_layer, int start_time, int end_time, const std::string& word);
+    // looks up all the words together which is much faster than one at a time for a whole track
+    void BreakdownWords(EffectLayer* phoneme_layer, const std::vector<Effect*>& words);
 
     // Selected Ranges
     int GetSelectedRangeCount();
@@ -173,6 +177,8 @@ public:
     virtual void IncrementChangeCount(Element *el);
     unsigned int GetChangeCount() const { return mChangeCount; }
     unsigned int GetMasterViewChangeCount() const { return mMasterViewChangeCount; }
+    // called by elements when a name, submodel or strand changes so lookups by full name see it
+    void InvalidateElementIndex() { mElementIndexValid = false; }
 
     bool HasPapagayoTiming() const { return hasPapagayoTiming; }
 
@@ -202,8 +208,16 @@ private:
         int &rowIndex, int &selectedTimingRow, int &timingRowCount, int &timingColorIndex);
 
     void ClearAllViews();
+    void BuildElementIndex() const;
+    void AddPhonemes(EffectLayer* phoneme_layer, int start_time, int end_time, const std::vector<std::string>& phonemes);
     std::vector<std::vector <Element*> > mAllViews;
 
+    // full name -> element for the master view including submodels and strands
+    mutable std::mutex mElementIndexLock;
+    mutable std::unordered_map<std::string, Element*> mElementIndex;
+    mutable unsigned int mElementIndexChangeCount;
+    mutable std::atomic<bool> mElementIndexValid;
+
     // A vector of all the visible elements that may not be on screen
     // because they all do not fit. The timing elements will always
     // be the first in this list.
@@ -0,0 +1,111 @@
+#include "SequenceOutputThread.h"
+#include "../outputs/OutputManager.h"
+#include "../SequenceData.h"
+#include "../AudioManager.h"
+
+#include <algorithm>
+#include <shared_mutex>
+
+#include <log4cpp/Category.hh>
+
+SequenceOutputThread::SequenceOutputThread(OutputManager* outputManager, SequenceData* seqData) :
+    _outputManager(outputManager), _seqData(seqData), _running(false), _stop(false),
+    _positionMS(0), _positionTime(std::chrono::steady_clock::now()), _speed(1.0), _audio(nullptr)
+{
+}
+
+SequenceOutputThread::~SequenceOutputThread()
+{
+    Stop();
+}
+
+void SequenceOutputThread::Play(long ms, AudioManager* audio, float speed)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _positionMS = ms;
+        _positionTime = std::chrono::steady_clock::now();
+        _speed = speed;
+        _audio = audio;
+    }
+
+    if (!_running)
+    {
+        logger_base.debug("Starting sequence output thread at %ldms.", ms);
+        _stop = false;
+        _running = true;
+        _thread = std::thread(&SequenceOutputThread::Run, this);
+    }
+}
+
+void SequenceOutputThread::Stop()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    if (!_running) return;
+
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _signal.notify_all();
+    _thread.join();
+    _running = false;
+    logger_base.debug("Sequence output thread stopped.");
+}
+
+// must be called with the lock held
+long SequenceOutputThread::GetPosition()
+{
+    if (_audio != nullptr)
+    {
+        return _audio->Tell();
+    }
+
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _positionTime).count();
+    return _positionMS + (long)(elapsed * _speed);
+}
+
+void SequenceOutputThread::Run()
+{
+    int lastFrame = -1;
+
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_stop)
+    {
+        long ms = GetPosition();
+        bool audio = _audio != nullptr;
+        float speed = _speed;
+        lock.unlock();
+
+        long frameTime = std::max(1u, _seqData->FrameTime());
+        int frame = ms < 0 ? -1 : std::min((long)_seqData->NumFrames() - 1, ms / frameTime);
+        if (frame >= 0 && frame != lastFrame)
+        {
+            // take a consistent copy as render jobs may be writing into the frame
+            {
+                std::unique_lock<std::shared_timed_mutex> frameLock(_seqData->GetFrameLock());
+                const unsigned char* data = &(*_seqData)[frame][0];
+                _frame.assign(data, data + _seqData->NumChannels());
+            }
+            _outputManager->StartFrame(ms);
+            _outputManager->SetManyChannels(0, _frame.data(), _frame.size());
+            _outputManager->EndFrame();
+            lastFrame = frame;
+        }
+
+        // sleep until the next frame is due
+        long wait = ms < 0 ? -ms : frameTime - (ms % frameTime);
+        if (speed > 0) wait = (long)(wait / speed);
+        if (audio)
+        {
+            // the audio position only moves as the device consumes buffers so check it more often
+            wait = std::min(wait, 5L);
+        }
+
+        lock.lock();
+        _signal.wait_for(lock, std::chrono::milliseconds(std::max(1L, wait)), [this] { return (bool)_stop; });
+    }
+}
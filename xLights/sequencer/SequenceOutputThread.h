@@ -0,0 +1,52 @@
+#ifndef SEQUENCEOUTPUTTHREAD_H
+#define SEQUENCEOUTPUTTHREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class OutputManager;
+class SequenceData;
+class AudioManager;
+
+// Sends frames of sequence data to the lights on its own thread while the sequencer plays so the
+// output timing does not depend on how long the GUI takes to render effects and redraw previews.
+// The frame sent follows the audio when it is playing otherwise it follows a clock extrapolated
+// from the last position the GUI reported.
+// Nothing else may use the output manager while this is running so stop it first.
+class SequenceOutputThread
+{
+public:
+    SequenceOutputThread(OutputManager* outputManager, SequenceData* seqData);
+    virtual ~SequenceOutputThread();
+
+    // Starts the thread if it is not running and updates the play position. Call on each timer tick while playing.
+    // audio should only be passed while it is playing.
+    void Play(long ms, AudioManager* audio, float speed);
+    void Stop();
+    bool IsRunning() const { return _running; }
+
+private:
+    void Run();
+    long GetPosition();
+
+    OutputManager* _outputManager;
+    SequenceData* _seqData;
+    std::thread _thread;
+    std::atomic_bool _running;
+    std::atomic_bool _stop;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    std::vector<unsigned char> _frame; // copy of the frame being sent so rendering can carry on
+
+    // play clock ... protected by _lock
+    long _positionMS;
+    std::chrono::steady_clock::time_point _positionTime;
+    float _speed;
+    AudioManager* _audio;
+};
+
+#endif
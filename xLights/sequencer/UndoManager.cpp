@@ -1,68 +1,115 @@
 #include "UndoManager.h"
 #include "Element.h"
+#include "Effect.h"
+#include "EffectLayer.h"
 #include "SequenceElements.h"
 #include <log4cpp/Category.hh>
+#include <algorithm>
+#include <map>
+#include <tuple>
 
-DeletedEffectInfo::DeletedEffectInfo( const std::string &element_name_, int layer_index_, const std::string &name_, const std::string &settings_,
-                                      const std::string &palette_, int &startTimeMS_, int &endTimeMS_, int Selected_, bool Protected_ )
-: element_name(element_name_), layer_index(layer_index_), name(name_), settings(settings_),
+// by default keep up to this much undo history
+#define DEFAULT_UNDO_MEMORY_LIMIT (256 * 1024 * 1024)
+
+static size_t StringMemoryUsage(const std::string& s)
+{
+    // short strings live inside the object
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+static size_t DeltaMemoryUsage(const std::vector<UndoSettingDelta>& delta)
+{
+    size_t res = delta.capacity() * sizeof(UndoSettingDelta);
+    for (const auto& it : delta)
+    {
+        res += StringMemoryUsage(it.value);
+    }
+    return res;
+}
+
+DeletedEffectInfo::DeletedEffectInfo( UndoNameId element_id_, int layer_index_, UndoNameId name_id_, const std::string &settings_,
+                                      const std::string &palette_, int startTimeMS_, int endTimeMS_, int Selected_, bool Protected_ )
+: element_id(element_id_), layer_index(layer_index_), name_id(name_id_), settings(settings_),
   palette(palette_), startTimeMS(startTimeMS_), endTimeMS(endTimeMS_), Selected(Selected_), Protected(Protected_)
 {
 }
 
-AddedEffectInfo::AddedEffectInfo( const std::string &element_name_, int layer_index_, int id_ )
-: element_name(element_name_), layer_index(layer_index_), id(id_)
+size_t DeletedEffectInfo::GetMemoryUsage() const
 {
+    return sizeof(DeletedEffectInfo) + StringMemoryUsage(settings) + StringMemoryUsage(palette);
 }
 
-MovedEffectInfo::MovedEffectInfo( const std::string &element_name_, int layer_index_, int id_, int &startTimeMS_, int &endTimeMS_ )
-: element_name(element_name_), layer_index(layer_index_), id(id_), startTimeMS(startTimeMS_), endTimeMS(endTimeMS_)
+AddedEffectInfo::AddedEffectInfo( UndoNameId element_id_, int layer_index_, int id_ )
+: element_id(element_id_), layer_index(layer_index_), id(id_)
 {
 }
 
-ModifiedEffectInfo::ModifiedEffectInfo( const std::string &element_name_, int layer_index_, int id_, const std::string &settings_, const std::string &palette_ )
-: element_name(element_name_), layer_index(layer_index_), id(id_), settings(settings_), palette(palette_), effectName(""), effectType(-1)
+MovedEffectInfo::MovedEffectInfo( UndoNameId element_id_, int layer_index_, int id_, int startTimeMS_, int endTimeMS_ )
+: element_id(element_id_), layer_index(layer_index_), id(id_), startTimeMS(startTimeMS_), endTimeMS(endTimeMS_)
 {
 }
 
+ModifiedEffectInfo::ModifiedEffectInfo( UndoNameId element_id_, int layer_index_, int id_, const std::string &settings_, const std::string &palette_ )
+: element_id(element_id_), layer_index(layer_index_), id(id_), compacted(false), settings(settings_), palette(palette_), effectName(0), effectType(-1)
+{
+}
 
-ModifiedEffectInfo::ModifiedEffectInfo( const std::string &element_name_, int layer_index_, Effect *ef)
-: element_name(element_name_), layer_index(layer_index_), id(ef->GetID()),
-    settings(ef->GetSettingsAsString()), palette(ef->GetPaletteAsString()), effectName(ef->GetEffectName()), effectType(ef->GetEffectIndex())
+ModifiedEffectInfo::ModifiedEffectInfo( UndoNameId element_id_, int layer_index_, Effect *ef, UndoNameId effectName_ )
+: element_id(element_id_), layer_index(layer_index_), id(ef->GetID()), compacted(false),
+    settings(ef->GetSettingsAsString()), palette(ef->GetPaletteAsString()), effectName(effectName_), effectType(ef->GetEffectIndex())
 {
 }
 
+size_t ModifiedEffectInfo::GetMemoryUsage() const
+{
+    return sizeof(ModifiedEffectInfo) + StringMemoryUsage(settings) + StringMemoryUsage(palette) + DeltaMemoryUsage(settings_delta) + DeltaMemoryUsage(palette_delta);
+}
+
 UndoStep::UndoStep( UNDO_ACTIONS action )
-: undo_action(action)
+: undo_action(action), deleted_effect_info(nullptr), added_effect_info(nullptr), moved_effect_info(nullptr), modified_effect_info(nullptr)
 {
 }
 
 UndoStep::UndoStep( UNDO_ACTIONS action, DeletedEffectInfo* effect_info )
-: undo_action(action)
+: undo_action(action), deleted_effect_info(effect_info), added_effect_info(nullptr), moved_effect_info(nullptr), modified_effect_info(nullptr)
 {
-    deleted_effect_info.push_back(effect_info);
 }
 
 UndoStep::UndoStep( UNDO_ACTIONS action, AddedEffectInfo* effect_info )
-: undo_action(action)
+: undo_action(action), deleted_effect_info(nullptr), added_effect_info(effect_info), moved_effect_info(nullptr), modified_effect_info(nullptr)
 {
-    added_effect_info.push_back(effect_info);
 }
 
 UndoStep::UndoStep( UNDO_ACTIONS action, MovedEffectInfo* effect_info )
-: undo_action(action)
+: undo_action(action), deleted_effect_info(nullptr), added_effect_info(nullptr), moved_effect_info(effect_info), modified_effect_info(nullptr)
 {
-    moved_effect_info.push_back(effect_info);
 }
 
 UndoStep::UndoStep( UNDO_ACTIONS action, ModifiedEffectInfo* effect_info )
-: undo_action(action)
+: undo_action(action), deleted_effect_info(nullptr), added_effect_info(nullptr), moved_effect_info(nullptr), modified_effect_info(effect_info)
+{
+}
+
+UndoStep::~UndoStep()
 {
-    modified_effect_info.push_back(effect_info);
+    delete deleted_effect_info;
+    delete added_effect_info;
+    delete moved_effect_info;
+    delete modified_effect_info;
+}
+
+size_t UndoStep::GetMemoryUsage() const
+{
+    size_t res = sizeof(UndoStep);
+    if (deleted_effect_info != nullptr) res += deleted_effect_info->GetMemoryUsage();
+    if (added_effect_info != nullptr) res += sizeof(AddedEffectInfo);
+    if (moved_effect_info != nullptr) res += sizeof(MovedEffectInfo);
+    if (modified_effect_info != nullptr) res += modified_effect_info->GetMemoryUsage();
+    return res;
 }
 
 UndoManager::UndoManager(SequenceElements* parent)
-: mParentSequence(parent), mCaptureUndo(false)
+: mParentSequence(parent), mCaptureUndo(false), mMemoryUsage(0), mMemoryLimit(DEFAULT_UNDO_MEMORY_LIMIT)
 {
 }
 
@@ -79,6 +126,47 @@ void UndoManager::SetCaptureUndo( bool value )
     mCaptureUndo = value;
 }
 
+void UndoManager::SetMemoryLimit(size_t bytes)
+{
+    mMemoryLimit = bytes;
+}
+
+UndoNameId UndoManager::Intern(const std::string& name)
+{
+    auto it = mNameIds.find(name);
+    if (it != mNameIds.end())
+    {
+        return it->second;
+    }
+    UndoNameId id = mNames.size();
+    mNames.push_back(name);
+    mNameIds[name] = id;
+    return id;
+}
+
+Effect* UndoManager::FindEffect(UndoNameId element_id, int layer_index, int id) const
+{
+    Element* element = mParentSequence->GetElement(GetName(element_id));
+    if (element == nullptr) return nullptr;
+    EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(layer_index);
+    if (el == nullptr) return nullptr;
+    return el->GetEffectFromID(id);
+}
+
+void UndoManager::PushStep(UndoStep* step)
+{
+    mMemoryUsage += step->GetMemoryUsage();
+    mUndoSteps.push_back(step);
+}
+
+void UndoManager::PopStep()
+{
+    UndoStep* step = mUndoSteps.back();
+    mUndoSteps.pop_back();
+    mMemoryUsage -= std::min(mMemoryUsage, step->GetMemoryUsage());
+    delete step;
+}
+
 void UndoManager::RemoveUnusedMarkers()
 {
     if( mUndoSteps.size() > 0 )
@@ -87,7 +175,7 @@ void UndoManager::RemoveUnusedMarkers()
         // delete any marker stragglers
         if( last_action->undo_action == UNDO_MARKER )
         {
-            mUndoSteps.pop_back();
+            PopStep();
         }
     }
 }
@@ -112,6 +200,9 @@ void UndoManager::Clear() {
         delete mUndoSteps[i];
     }
     mUndoSteps.clear();
+    mMemoryUsage = 0;
+    mNames.clear();
+    mNameIds.clear();
 }
 bool UndoManager::CanUndo()
 {
@@ -119,46 +210,172 @@ bool UndoManager::CanUndo()
     return mUndoSteps.size() > 0;
 }
 
+void UndoManager::BuildDelta(const SettingsMap& before, const SettingsMap& after, std::vector<UndoSettingDelta>& delta)
+{
+    // both maps are sorted so walk them together
+    auto b = before.begin();
+    auto a = after.begin();
+    while (b != before.end() || a != after.end())
+    {
+        if (a == after.end() || (b != before.end() && b->first < a->first))
+        {
+            delta.emplace_back(Intern(b->first), true, b->second);
+            ++b;
+        }
+        else if (b == before.end() || a->first < b->first)
+        {
+            delta.emplace_back(Intern(a->first), false, "");
+            ++a;
+        }
+        else
+        {
+            if (a->second != b->second)
+            {
+                delta.emplace_back(Intern(b->first), true, b->second);
+            }
+            ++a;
+            ++b;
+        }
+    }
+    delta.shrink_to_fit();
+}
+
+void UndoManager::ApplyDelta(SettingsMap& settings, const std::vector<UndoSettingDelta>& delta) const
+{
+    for (const auto& it : delta)
+    {
+        if (it.existed)
+        {
+            settings[GetName(it.key)] = it.value;
+        }
+        else
+        {
+            settings.erase(GetName(it.key));
+        }
+    }
+}
+
+// The group at the end of the list is complete and its changes applied so the full before
+// images of modified effects can be reduced to just the keys that changed. Work backwards
+// so an effect modified more than once in the group is diffed against the state the later
+// change started from rather than its final state.
+void UndoManager::CompactLastGroup()
+{
+    std::map<std::tuple<UndoNameId, int, int>, std::pair<SettingsMap, SettingsMap>> after;
+
+    for (auto it = mUndoSteps.rbegin(); it != mUndoSteps.rend() && (*it)->undo_action != UNDO_MARKER; ++it)
+    {
+        ModifiedEffectInfo* info = (*it)->modified_effect_info;
+        if (info == nullptr || info->compacted) continue;
+
+        auto key = std::make_tuple(info->element_id, info->layer_index, info->id);
+        auto a = after.find(key);
+        if (a == after.end())
+        {
+            Effect* eff = FindEffect(info->element_id, info->layer_index, info->id);
+            if (eff == nullptr)
+            {
+                // undo cant find it either so there is nothing to gain
+                continue;
+            }
+            a = after.emplace(key, std::pair<SettingsMap, SettingsMap>()).first;
+            eff->CopySettingsMap(a->second.first);
+            a->second.second.Parse(eff->GetPaletteAsString());
+        }
+
+        mMemoryUsage -= std::min(mMemoryUsage, (*it)->GetMemoryUsage());
+
+        SettingsMap before;
+        before.Parse(info->settings);
+        BuildDelta(before, a->second.first, info->settings_delta);
+        a->second.first = before;
+
+        before.Parse(info->palette);
+        BuildDelta(before, a->second.second, info->palette_delta);
+        a->second.second = before;
+
+        info->compacted = true;
+        std::string().swap(info->settings);
+        std::string().swap(info->palette);
+
+        mMemoryUsage += (*it)->GetMemoryUsage();
+    }
+}
+
+// Drop whole groups from the oldest end until we are back under the limit. The most recent
+// group is always kept.
+void UndoManager::EvictOldSteps()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    size_t evicted = 0;
+    while (mMemoryUsage > mMemoryLimit)
+    {
+        size_t end = 1;
+        while (end < mUndoSteps.size() && mUndoSteps[end]->undo_action != UNDO_MARKER)
+        {
+            ++end;
+        }
+        if (end >= mUndoSteps.size()) break;
+
+        for (size_t i = 0; i < end; ++i)
+        {
+            UndoStep* step = mUndoSteps.front();
+            mUndoSteps.pop_front();
+            mMemoryUsage -= std::min(mMemoryUsage, step->GetMemoryUsage());
+            delete step;
+        }
+        evicted++;
+    }
+
+    if (evicted > 0)
+    {
+        logger_base.debug("Undo history over %d MB ... discarded %d oldest undo steps.", (int)(mMemoryLimit / (1024 * 1024)), (int)evicted);
+    }
+}
+
 void UndoManager::CreateUndoStep()
 {
     RemoveUnusedMarkers();
+    CompactLastGroup();
+    EvictOldSteps();
     UndoStep* action = new UndoStep(UNDO_MARKER);
-    mUndoSteps.push_back(action);
+    PushStep(action);
 }
 
 void UndoManager::CaptureEffectToBeDeleted( const std::string &element_name, int layer_index, const std::string &name, const std::string &settings,
                                             const std::string &palette, int startTimeMS, int endTimeMS, int Selected, bool Protected )
 {
-    DeletedEffectInfo* effect_undo_action = new DeletedEffectInfo( element_name, layer_index, name, settings, palette, startTimeMS, endTimeMS, Selected, Protected );
+    DeletedEffectInfo* effect_undo_action = new DeletedEffectInfo( Intern(element_name), layer_index, Intern(name), settings, palette, startTimeMS, endTimeMS, Selected, Protected );
     UndoStep* action = new UndoStep(UNDO_EFFECT_DELETED, effect_undo_action);
-    mUndoSteps.push_back(action);
+    PushStep(action);
 }
 
 void UndoManager::CaptureAddedEffect( const std::string &element_name, int layer_index, int id )
 {
-    AddedEffectInfo* effect_undo_action = new AddedEffectInfo( element_name, layer_index, id );
+    AddedEffectInfo* effect_undo_action = new AddedEffectInfo( Intern(element_name), layer_index, id );
     UndoStep* action = new UndoStep(UNDO_EFFECT_ADDED, effect_undo_action);
-    mUndoSteps.push_back(action);
+    PushStep(action);
 }
 
 void UndoManager::CaptureEffectToBeMoved( const std::string &element_name, int layer_index, int id, int startTimeMS, int endTimeMS )
 {
-    MovedEffectInfo* effect_undo_action = new MovedEffectInfo( element_name, layer_index, id, startTimeMS, endTimeMS );
+    MovedEffectInfo* effect_undo_action = new MovedEffectInfo( Intern(element_name), layer_index, id, startTimeMS, endTimeMS );
     UndoStep* action = new UndoStep(UNDO_EFFECT_MOVED, effect_undo_action);
-    mUndoSteps.push_back(action);
+    PushStep(action);
 }
 
 void UndoManager::CaptureModifiedEffect( const std::string &element_name, int layer_index, int id, const std::string &settings, const std::string &palette )
 {
-    ModifiedEffectInfo* effect_undo_action = new ModifiedEffectInfo( element_name, layer_index, id, settings, palette );
+    ModifiedEffectInfo* effect_undo_action = new ModifiedEffectInfo( Intern(element_name), layer_index, id, settings, palette );
     UndoStep* action = new UndoStep(UNDO_EFFECT_MODIFIED, effect_undo_action);
-    mUndoSteps.push_back(action);
+    PushStep(action);
 }
 void UndoManager::CaptureModifiedEffect( const std::string &element_name, int layer_index, Effect *ef )
 {
-    ModifiedEffectInfo* effect_undo_action = new ModifiedEffectInfo( element_name, layer_index, ef );
+    ModifiedEffectInfo* effect_undo_action = new ModifiedEffectInfo( Intern(element_name), layer_index, ef, Intern(ef->GetEffectName()) );
     UndoStep* action = new UndoStep(UNDO_EFFECT_MODIFIED, effect_undo_action);
-    mUndoSteps.push_back(action);
+    PushStep(action);
 }
 void UndoManager::UndoLastStep()
 {
@@ -174,54 +391,57 @@ void UndoManager::UndoLastStep()
             break;
         case UNDO_EFFECT_DELETED:
         {
-            Element* element = mParentSequence->GetElement(next_action->deleted_effect_info[0]->element_name);
+            DeletedEffectInfo* info = next_action->deleted_effect_info;
+            Element* element = mParentSequence->GetElement(GetName(info->element_id));
             if (element != nullptr)
             {
-                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(next_action->deleted_effect_info[0]->layer_index);
+                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(info->layer_index);
                 if (el != nullptr)
                 {
                     el->AddEffect(0,
-                        next_action->deleted_effect_info[0]->name,
-                        next_action->deleted_effect_info[0]->settings,
-                        next_action->deleted_effect_info[0]->palette,
-                        next_action->deleted_effect_info[0]->startTimeMS,
-                        next_action->deleted_effect_info[0]->endTimeMS,
-                        next_action->deleted_effect_info[0]->Selected,
-                        next_action->deleted_effect_info[0]->Protected);
+                        GetName(info->name_id),
+                        info->settings,
+                        info->palette,
+                        info->startTimeMS,
+                        info->endTimeMS,
+                        info->Selected,
+                        info->Protected);
                 }
             }
         }
             break;
         case UNDO_EFFECT_ADDED:
             {
-            Element* element = mParentSequence->GetElement(next_action->added_effect_info[0]->element_name);
+            AddedEffectInfo* info = next_action->added_effect_info;
+            Element* element = mParentSequence->GetElement(GetName(info->element_id));
             if (element != nullptr)
             {
-                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(next_action->added_effect_info[0]->layer_index);
+                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(info->layer_index);
                 if (el != nullptr)
                 {
-                    el->DeleteEffect(next_action->added_effect_info[0]->id);
+                    el->DeleteEffect(info->id);
                 }
             }
             }
             break;
         case UNDO_EFFECT_MOVED:
             {
-            Element* element = mParentSequence->GetElement(next_action->moved_effect_info[0]->element_name);
+            MovedEffectInfo* info = next_action->moved_effect_info;
+            Element* element = mParentSequence->GetElement(GetName(info->element_id));
             if (element != nullptr)
             {
-                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(next_action->moved_effect_info[0]->layer_index);
+                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(info->layer_index);
                 if (el == nullptr)
                 {
-                    logger_base.warn("UndoLastStep:UNDO_EFFECT_MOVED Element not found %d.", next_action->moved_effect_info[0]->layer_index);
+                    logger_base.warn("UndoLastStep:UNDO_EFFECT_MOVED Element not found %d.", info->layer_index);
                 }
                 else
                 {
-                    Effect* eff = el->GetEffectFromID(next_action->moved_effect_info[0]->id);
+                    Effect* eff = el->GetEffectFromID(info->id);
                     if (eff != nullptr)
                     {
-                        eff->SetStartTimeMS(next_action->moved_effect_info[0]->startTimeMS);
-                        eff->SetEndTimeMS(next_action->moved_effect_info[0]->endTimeMS);
+                        eff->SetStartTimeMS(info->startTimeMS);
+                        eff->SetEndTimeMS(info->endTimeMS);
                     }
                 }
             }
@@ -229,32 +449,47 @@ void UndoManager::UndoLastStep()
             break;
         case UNDO_EFFECT_MODIFIED:
         {
-            Element* element = mParentSequence->GetElement(next_action->modified_effect_info[0]->element_name);
+            ModifiedEffectInfo* info = next_action->modified_effect_info;
+            Element* element = mParentSequence->GetElement(GetName(info->element_id));
             if (element != nullptr)
             {
-                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(next_action->modified_effect_info[0]->layer_index);
+                EffectLayer* el = element->GetEffectLayerFromExclusiveIndex(info->layer_index);
                 if (el == nullptr)
                 {
-                    logger_base.warn("UndoLastStep:UNDO_EFFECT_MODIFIED Element not found %d.", next_action->moved_effect_info[0]->layer_index);
+                    logger_base.warn("UndoLastStep:UNDO_EFFECT_MODIFIED Element not found %d.", info->layer_index);
                 }
                 else
                 {
-                    Effect* eff = el->GetEffectFromID(next_action->modified_effect_info[0]->id);
+                    Effect* eff = el->GetEffectFromID(info->id);
                     if (eff != nullptr)
                     {
-                        if (next_action->modified_effect_info[0]->effectType >= 0) {
-                            eff->SetEffectName(next_action->modified_effect_info[0]->effectName);
-                            eff->SetEffectIndex(next_action->modified_effect_info[0]->effectType);
+                        if (info->effectType >= 0) {
+                            eff->SetEffectName(GetName(info->effectName));
+                            eff->SetEffectIndex(info->effectType);
+                        }
+                        if (info->compacted)
+                        {
+                            SettingsMap settings;
+                            eff->CopySettingsMap(settings);
+                            ApplyDelta(settings, info->settings_delta);
+                            SettingsMap palette;
+                            palette.Parse(eff->GetPaletteAsString());
+                            ApplyDelta(palette, info->palette_delta);
+                            eff->SetSettings(settings.AsString(), false);
+                            eff->SetPalette(palette.AsString());
+                        }
+                        else
+                        {
+                            eff->SetSettings(info->settings, false);
+                            eff->SetPalette(info->palette);
                         }
-                        eff->SetSettings(next_action->modified_effect_info[0]->settings, false);
-                        eff->SetPalette(next_action->modified_effect_info[0]->palette);
                     }
                 }
             }
          }
             break;
         }
-        mUndoSteps.pop_back();
+        PopStep();
     }
 }
 
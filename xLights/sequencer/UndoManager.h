@@ -3,9 +3,15 @@
 
 #include "wx/wx.h"
 #include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
 
 class SequenceElements;
 class Effect;
+class SettingsMap;
+class UndoManager;
 
 enum UNDO_ACTIONS
 {
@@ -16,55 +22,76 @@ enum UNDO_ACTIONS
     UNDO_EFFECT_MOVED
 };
 
+// Element names, effect names and setting keys are interned by the undo manager so
+// records only hold a small id
+typedef uint32_t UndoNameId;
+
 class DeletedEffectInfo
 {
 public:
-    std::string element_name;
+    UndoNameId element_id;
     int layer_index;
-    std::string name;
+    UndoNameId name_id;
     std::string settings;
     std::string palette;
     int startTimeMS;
     int endTimeMS;
     int Selected;
     bool Protected;
-    DeletedEffectInfo( const std::string &element_name_, int layer_index_, const std::string &name_, const std::string &settings_,
-                       const std::string &palette_, int &startTimeMS_, int &endTimeMS_, int Selected_, bool Protected_ );
+    DeletedEffectInfo( UndoNameId element_id_, int layer_index_, UndoNameId name_id_, const std::string &settings_,
+                       const std::string &palette_, int startTimeMS_, int endTimeMS_, int Selected_, bool Protected_ );
+    size_t GetMemoryUsage() const;
 };
 
 class AddedEffectInfo
 {
 public:
-    std::string element_name;
+    UndoNameId element_id;
     int layer_index;
     int id;
-    AddedEffectInfo( const std::string &element_name_, int layer_index_, int id_ );
+    AddedEffectInfo( UndoNameId element_id_, int layer_index_, int id_ );
 };
 
 class MovedEffectInfo
 {
 public:
-    std::string element_name;
+    UndoNameId element_id;
     int layer_index;
     int id;
     int startTimeMS;
     int endTimeMS;
-    MovedEffectInfo( const std::string &element_name_, int layer_index_, int id_, int &startTimeMS_, int &endTimeMS_ );
+    MovedEffectInfo( UndoNameId element_id_, int layer_index_, int id_, int startTimeMS_, int endTimeMS_ );
+};
+
+// The value a setting had before a change. If the key did not exist before then undo removes it.
+class UndoSettingDelta
+{
+public:
+    UndoNameId key;
+    bool existed;
+    std::string value;
+    UndoSettingDelta( UndoNameId key_, bool existed_, const std::string &value_ ) : key(key_), existed(existed_), value(value_) {}
 };
 
+// Captured with the full settings and palette the effect had before the change. Once the
+// undo group is complete the record is compacted to just the keys that actually changed.
 class ModifiedEffectInfo
 {
 public:
-    std::string element_name;
+    UndoNameId element_id;
     int layer_index;
     int id;
+    bool compacted;
     std::string settings;
     std::string palette;
-    std::string effectName;
+    std::vector<UndoSettingDelta> settings_delta;
+    std::vector<UndoSettingDelta> palette_delta;
+    UndoNameId effectName;
     int effectType;
-    
-    ModifiedEffectInfo( const std::string &element_name_, int layer_index_, int id_, const std::string &settings_, const std::string &palette_ );
-    ModifiedEffectInfo( const std::string &element_name_, int layer_index_, Effect *ef);
+
+    ModifiedEffectInfo( UndoNameId element_id_, int layer_index_, int id_, const std::string &settings_, const std::string &palette_ );
+    ModifiedEffectInfo( UndoNameId element_id_, int layer_index_, Effect *ef, UndoNameId effectName_ );
+    size_t GetMemoryUsage() const;
 };
 
 class UndoStep
@@ -75,12 +102,19 @@ public:
     UndoStep( UNDO_ACTIONS action, AddedEffectInfo* effect_info );
     UndoStep( UNDO_ACTIONS action, MovedEffectInfo* effect_info );
     UndoStep( UNDO_ACTIONS action, ModifiedEffectInfo* effect_info );
+    virtual ~UndoStep();
+
+    size_t GetMemoryUsage() const;
 
     UNDO_ACTIONS undo_action;
-    std::vector<DeletedEffectInfo*> deleted_effect_info;
-    std::vector<AddedEffectInfo*> added_effect_info;
-    std::vector<MovedEffectInfo*> moved_effect_info;
-    std::vector<ModifiedEffectInfo*> modified_effect_info;
+    DeletedEffectInfo* deleted_effect_info;
+    AddedEffectInfo* added_effect_info;
+    MovedEffectInfo* moved_effect_info;
+    ModifiedEffectInfo* modified_effect_info;
+
+private:
+    UndoStep(const UndoStep&) = delete;
+    UndoStep& operator=(const UndoStep&) = delete;
 };
 
 class UndoManager
@@ -88,7 +122,7 @@ class UndoManager
     public:
         explicit UndoManager(SequenceElements* parent);
         virtual ~UndoManager();
-    
+
         void Clear();
         void RemoveUnusedMarkers();
         bool ChangeCaptured();
@@ -99,6 +133,11 @@ class UndoManager
         bool GetCaptureUndo() { return mCaptureUndo; }
         std::string GetUndoString();
 
+        // oldest undo groups are discarded once the history uses more than this
+        void SetMemoryLimit(size_t bytes);
+        size_t GetMemoryLimit() const { return mMemoryLimit; }
+        size_t GetMemoryUsage() const { return mMemoryUsage; }
+
         void CaptureEffectToBeDeleted( const std::string &element_name, int layer_index, const std::string &name, const std::string &settings,
                                        const std::string &palette, int startTimeMS, int endTimeMS, int Selected, bool Protected );
 
@@ -110,10 +149,23 @@ class UndoManager
     protected:
 
     private:
-        std::vector<UndoStep*> mUndoSteps;
+        UndoNameId Intern(const std::string& name);
+        const std::string& GetName(UndoNameId id) const { return mNames[id]; }
+        Effect* FindEffect(UndoNameId element_id, int layer_index, int id) const;
+        void PushStep(UndoStep* step);
+        void PopStep();
+        void CompactLastGroup();
+        void EvictOldSteps();
+        void BuildDelta(const SettingsMap& before, const SettingsMap& after, std::vector<UndoSettingDelta>& delta);
+        void ApplyDelta(SettingsMap& settings, const std::vector<UndoSettingDelta>& delta) const;
+
+        std::deque<UndoStep*> mUndoSteps;
         SequenceElements* mParentSequence;
         bool mCaptureUndo;
-
+        size_t mMemoryUsage;
+        size_t mMemoryLimit;
+        std::vector<std::string> mNames;
+        std::unordered_map<std::string, UndoNameId> mNameIds;
 };
 
 #endif // UNDOMANAGER_H
@@ -206,6 +206,7 @@ void xLightsFrame::InitSequencer()
             logger_base.info("Number of channels has changed ... reallocating sequence data memory.");
 
             AbortRender();
+            _sequenceOutput.Stop();
 
             wxString mss = CurrentSeqXmlFile->GetSequenceTiming();
             int ms = wxAtoi(mss);
@@ -1629,6 +1630,7 @@ void xLightsFrame::DoStopSequence()
         mainSequencer->UpdateTimeDisplay(playStartTime, _fps);
     }
     playType = PLAY_TYPE_STOPPED;
+    _sequenceOutput.Stop();
     if( CheckBoxLightOutput->IsChecked()) {
         _outputManager.AllOff();
     }
@@ -2087,6 +2089,11 @@ void xLightsFrame::TimerRgbSeq(long msec)
     // Update play status so sequencer grid can allow dropping timings during playback
     mainSequencer->SetPlayStatus(playType);
 
+    // the output thread only sends while the sequence is playing ... paused lights stay as they are
+    if (playType != PLAY_TYPE_MODEL) {
+        _sequenceOutput.Stop();
+    }
+
     // return if play is stopped
     if (playType == PLAY_TYPE_STOPPED || CurrentSeqXmlFile == nullptr) {
         return;
@@ -2132,9 +2139,11 @@ void xLightsFrame::TimerRgbSeq(long msec)
     if (playType == PLAY_TYPE_MODEL) {
 
         int current_play_time;
+        AudioManager* audio = nullptr;
 		if (CurrentSeqXmlFile->GetSequenceType() == "Media" && CurrentSeqXmlFile->GetMedia() != nullptr && CurrentSeqXmlFile->GetMedia()->GetPlayingState() == MEDIAPLAYINGSTATE::PLAYING)
 		{
-			current_play_time = CurrentSeqXmlFile->GetMedia()->Tell();
+            audio = CurrentSeqXmlFile->GetMedia();
+			current_play_time = audio->Tell();
             curt = current_play_time;
         } else
 		{
@@ -2157,6 +2166,11 @@ void xLightsFrame::TimerRgbSeq(long msec)
 			}
         }
 
+        // the lights are driven from their own thread so they dont wait on the previews and grid below
+        if (CheckBoxLightOutput->IsChecked() && _outputManager.IsOutputting()) {
+            _sequenceOutput.Play(curt, audio, playAnimation ? playSpeed : 1.0);
+        }
+
         int frame = curt / SeqData.FrameTime();
         fpsEvents.push_back(FPSEvent(frame));
         size_t fpsSize = fpsEvents.size();
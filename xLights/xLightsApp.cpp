@@ -24,6 +24,7 @@
 #include "xLightsVersion.h"
 #include "Parallel.h"
 #include "UtilFunctions.h"
+#include "RenderBenchmark.h"
 
 #include <log4cpp/Category.hh>
 #include <log4cpp/PropertyConfigurator.hh>
@@ -469,12 +470,15 @@ bool xLightsApp::OnInit()
 //TODO: maybe use wxCmdLineParser instead?
 //do this before instantiating xLightsFrame so it can use info gathered here
     wxString unrecog, info;
+    wxString benchmarkFile, benchmarkBaseline;
 
     static const wxCmdLineEntryDesc cmdLineDesc [] =
     {
         { wxCMD_LINE_SWITCH, "h", "help", "displays help on the command line parameters", wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
         { wxCMD_LINE_SWITCH, "d", "debug", "enable debug mode"},
         { wxCMD_LINE_SWITCH, "r", "render", "render files and exit"},
+        { wxCMD_LINE_OPTION, "b", "benchmark", "run the render benchmark, save the results to this csv file and exit" },
+        { wxCMD_LINE_OPTION, "", "baseline", "render benchmark results csv to compare against" },
         { wxCMD_LINE_OPTION, "m", "media", "specify media directory"},
         { wxCMD_LINE_OPTION, "s", "show", "specify show directory" },
         { wxCMD_LINE_OPTION, "g", "opengl", "specify OpenGL version" },
@@ -576,6 +580,16 @@ bool xLightsApp::OnInit()
             logger_base.info("-s: Show directory set to %s.", (const char *)showDir.c_str());
             info += _("Setting show directory to ") + showDir + "\n";
         }
+        if (parser.Found("b", &benchmarkFile)) {
+            logger_base.info("-b: Render benchmark results to %s.", (const char *)benchmarkFile.c_str());
+            parser.Found("baseline", &benchmarkBaseline);
+            showDir = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "xLightsBenchmark";
+            if (!RenderBenchmark::CreateShowFolder(showDir.ToStdString())) {
+                DisplayError(_("Unable to create the render benchmark show folder ") + showDir);
+                return false;
+            }
+            mediaDir = showDir;
+        }
         if (parser.Found("m", &mediaDir)) {
             logger_base.info("-m: Media directory set to %s.", (const char *)mediaDir.c_str());
             info += _("Setting media directory to ") + mediaDir + "\n";
@@ -599,7 +613,7 @@ bool xLightsApp::OnInit()
             }
             sequenceFiles.push_back(sequenceFile);
         }
-        if (!parser.Found("r") && !parser.Found("o") && !info.empty())
+        if (!parser.Found("r") && !parser.Found("o") && !parser.Found("b") && !info.empty())
         {
             DisplayInfo(info); //give positive feedback*/
         }
@@ -614,7 +628,24 @@ bool xLightsApp::OnInit()
     wxInitAllImageHandlers();
     if (wxsOK)
     {
+        // the benchmark show folder must not replace the users show folder or recent list
+        wxConfigBase* config = wxConfigBase::Get();
+        std::map<wxString, wxString> savedDirs;
+        if (!benchmarkFile.IsEmpty())
+        {
+            savedDirs["LastDir"] = config->Read("LastDir");
+            savedDirs["MediaDir"] = config->Read("MediaDir");
+            for (int i = 0; i < MRU_LENGTH; i++)
+            {
+                wxString mru_name = wxString::Format("mru%d", i);
+                savedDirs[mru_name] = config->Read(mru_name);
+            }
+        }
     	xLightsFrame* Frame = new xLightsFrame(nullptr);
+        for (auto it = savedDirs.begin(); it != savedDirs.end(); ++it)
+        {
+            config->Write(it->first, it->second);
+        }
         if (Frame->CurrentDir == "")
         {
             return false;
@@ -632,6 +663,11 @@ bool xLightsApp::OnInit()
         topFrame->_renderMode = true;
         topFrame->CallAfter(&xLightsFrame::OpenRenderAndSaveSequences, sequenceFiles, true);
     }
+    else if (!benchmarkFile.IsEmpty()) {
+        logger_base.info("-b: Render benchmark mode is ON");
+        topFrame->_renderMode = true;
+        topFrame->CallAfter(&xLightsFrame::RunRenderBenchmark, benchmarkFile, benchmarkBaseline);
+    }
 
     if (parser.Found("o"))
     {
@@ -69,6 +69,7 @@
 #include "models/SubModel.h"
 #include "effects/FacesEffect.h"
 #include "effects/StateEffect.h"
+#include "effects/PictureCache.h"
 
 // Linux needs this
 #include <wx/stdpaths.h>
@@ -525,7 +526,7 @@ void AddEffectToolbarButtons(EffectManager &manager, xlAuiToolBar *EffectsToolBa
 }
 
 xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(this), AllModels(&_outputManager, this), AllObjects(this),
-    layoutPanel(nullptr), color_mgr(this), _xFadeSocket(nullptr), jobPool("RenderPool")
+    layoutPanel(nullptr), color_mgr(this), _xFadeSocket(nullptr), jobPool("RenderPool"), _sequenceOutput(&_outputManager, &SeqData)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
     logger_base.debug("xLightsFrame being constructed.");
@@ -1622,6 +1623,12 @@ xLightsFrame::xLightsFrame(wxWindow* parent, wxWindowID id) : mSequenceElements(
     MenuItem_MedVol->Check(playVolume == 66);
     MenuItem_QuietVol->Check(playVolume == 33);
     MenuItem_VQuietVol->Check(playVolume == 10);
+
+    int undoMemoryMB = 256;
+    config->Read("xLightsUndoMemoryMB", &undoMemoryMB, 256);
+    undoMemoryMB = std::max(undoMemoryMB, 16);
+    mSequenceElements.get_undo_mgr().SetMemoryLimit((size_t)undoMemoryMB * 1024 * 1024);
+    logger_base.debug("Undo history limit: %dMB.", undoMemoryMB);
     
     logger_base.debug("xLightsFrame constructor creating sequencer.");
 
@@ -2223,6 +2230,7 @@ xLightsFrame::~xLightsFrame()
     }
 
     selectedEffect = nullptr;
+    _sequenceOutput.Stop();
     _outputManager.DeleteAllOutputs();
 
     wxConfigBase* config = wxConfigBase::Get();
@@ -2368,7 +2376,13 @@ void xLightsFrame::OnTimer1Trigger(wxTimerEvent& event)
 {
     wxTimeSpan ts = wxDateTime::UNow() - starttime;
     long curtime = ts.GetMilliseconds().ToLong();
-    _outputManager.StartFrame(curtime);
+
+    // while the sequence plays the output thread owns the output manager
+    bool outputOnTimer = !_sequenceOutput.IsRunning();
+    if (outputOnTimer)
+    {
+        _outputManager.StartFrame(curtime);
+    }
     switch (Notebook1->GetSelection())
     {
     case NEWSEQUENCER:
@@ -2382,7 +2396,10 @@ void xLightsFrame::OnTimer1Trigger(wxTimerEvent& event)
     default:
         break;
     }
-    _outputManager.EndFrame();
+    if (outputOnTimer && !_sequenceOutput.IsRunning())
+    {
+        _outputManager.EndFrame();
+    }
 }
 
 void xLightsFrame::OnBitmapButtonTabInfoClick(wxCommandEvent& event)
@@ -2575,6 +2592,7 @@ void xLightsFrame::OnButtonLightsOffClick(wxCommandEvent& event)
 {
     if (_outputManager.IsOutputting())
     {
+        _sequenceOutput.Stop();
         CheckBoxLightOutput->SetValue(false);
         _outputManager.AllOff();
         _outputManager.StopOutput();
@@ -2587,6 +2605,7 @@ bool xLightsFrame::EnableOutputs(bool ignoreCheck)
 {
     bool ok = true;
 
+    _sequenceOutput.Stop();
     if (CheckBoxLightOutput->IsChecked() && !_outputManager.IsOutputting())
     {
         if (!ignoreCheck && _outputManager.IsOutputOpenInAnotherProcess())
@@ -3718,6 +3737,7 @@ void xLightsFrame::UpdateSequenceLength()
         wxString mss = CurrentSeqXmlFile->GetSequenceTiming();
         int ms = wxAtoi(mss);
 
+        _sequenceOutput.Stop();
         SeqData.init(GetMaxNumChannels(), CurrentSeqXmlFile->GetSequenceDurationMS() / ms, ms);
         mSequenceElements.IncrementChangeCount(nullptr);
 
@@ -3755,6 +3775,7 @@ void xLightsFrame::OnActionTestMenuItemSelected(wxCommandEvent& event)
 	if (output)
 	{
         logger_base.debug("Test: Turning off output to lights.");
+        _sequenceOutput.Stop();
         _outputManager.AllOff();
         CheckBoxLightOutput->SetValue(false);
         EnableOutputs();
@@ -3853,6 +3874,7 @@ void xLightsFrame::OnMenu_GenerateCustomModelSelected(wxCommandEvent& event)
     bool output = CheckBoxLightOutput->IsChecked();
     if (output)
     {
+        _sequenceOutput.Stop();
         _outputManager.AllOff();
         CheckBoxLightOutput->SetValue(false);
         EnableOutputs();
@@ -7356,7 +7378,8 @@ void xLightsFrame::ValidateWindow()
 
 void xLightsFrame::TimerOutput(int period)
 {
-    if (CheckBoxLightOutput->IsChecked())
+    // the sequence output thread owns the output manager while it runs
+    if (CheckBoxLightOutput->IsChecked() && !_sequenceOutput.IsRunning())
     {
         _outputManager.SetManyChannels(0, &SeqData[period][0], SeqData.NumChannels());
     }
@@ -9008,6 +9031,7 @@ wxString xLightsFrame::ProcessXFadeMessage(wxString msg)
     else if (msg == "TURN_LIGHTS_OFF")
     {
         logger_base.debug("xFade turning lights off.");
+        _sequenceOutput.Stop();
         _outputManager.AllOff();
         CheckBoxLightOutput->SetValue(false);
         EnableOutputs();
@@ -9136,6 +9160,7 @@ void xLightsFrame::OnMenuItemUserDictSelected(wxCommandEvent& event)
 void xLightsFrame::OnMenuItem_PurgeRenderCacheSelected(wxCommandEvent& event)
 {
     _renderCache.Purge(&mSequenceElements, true);
+    PictureCache::Get().Clear();
 }
 
 void xLightsFrame::OnMenuItem_RenderCache(wxCommandEvent& event)
@@ -45,6 +45,7 @@
 #include <wx/socket.h>
 
 #include <unordered_map>
+#include <memory>
 #include <map>
 #include <set>
 #include <vector>
@@ -70,7 +71,9 @@
 #include "PhonemeDictionary.h"
 #include "xLightsXmlFile.h"
 #include "sequencer/EffectsGrid.h"
+#include "sequencer/SequenceOutputThread.h"
 #include "RenderCache.h"
+#include "RenderProfile.h"
 
 class EffectTreeDialog;
 class ConvertDialog;
@@ -1155,9 +1158,11 @@ public:
     void UpdateSelectedChannels();
     void UpdateSelectedDescriptions();
     void UpdateSelectedSuppressDuplicates(bool suppressDuplicates);
+    void UpdateSelectedPacketGap();
 
     void OnProgressBarDoubleClick(wxMouseEvent& event);
     std::list<RenderProgressInfo *>renderProgressInfo;
+    std::unique_ptr<RenderProfile> _lastRenderProfile;
     std::queue<RenderEvent*> mainThreadRenderEvents;
     std::mutex renderEventLock;
 
@@ -1196,6 +1201,7 @@ public:
     void ReadXlightsFile(const wxString& FileName, wxString *mediaFilename = nullptr);
     void ReadFalconFile(const wxString& FileName, ConvertDialog* convertdlg);
     void WriteFalconPiFile(const wxString& filename); //  Falcon Pi Player *.pseq
+    void WriteFalconPiControllerFiles(const wxString& filename); // sparse *.fseq per controller
     OutputManager* GetOutputManager() { return &_outputManager; };
 
 private:
@@ -1231,6 +1237,7 @@ public:
     std::string GetSelectedLayoutPanelPreview() const;
     void UpdateRenderStatus();
     void LogRenderStatus();
+    const RenderProfile* GetLastRenderProfile() const { return _lastRenderProfile.get(); }
     bool RenderEffectFromMap(Effect *effect, int layer, int period, SettingsMap& SettingsMap,
                              PixelBufferClass &buffer, bool &ResetEffectState,
                              bool bgThread = false, RenderEvent *event = nullptr);
@@ -1294,6 +1301,7 @@ protected:
     void BackupDirectory(wxString sourceDir, wxString targetDirName, wxString lastCreatedDirectory, bool forceallfiles, std::string& errors);
     void CreateMissingDirectories(wxString targetDirName, wxString lastCreatedDirectory, std::string& errors);
     void OpenRenderAndSaveSequences(const wxArrayString &filenames, bool exitOnDone);
+    void RunRenderBenchmark(const wxString& resultsFile, const wxString& baselineFile);
     void AddAllModelsToSequence();
     void ShowPreviewTime(long ElapsedMSec);
     void PreviewOutput(int period);
@@ -1368,6 +1376,7 @@ private:
     int AutoSaveInterval;
     int BackupPurgeDays;
     JobPool jobPool;
+    SequenceOutputThread _sequenceOutput; // sends frames to the lights while the sequence plays
 
     Model *playModel;
     int playType;
@@ -1570,6 +1579,7 @@ private:
     static const long ID_NETWORK_BESUPPRESSDUPLICATES;
     static const long ID_NETWORK_BESUPPRESSDUPLICATESYES;
     static const long ID_NETWORK_BESUPPRESSDUPLICATESNO;
+    static const long ID_NETWORK_BEPACKETGAP;
     static const long ID_NETWORK_ADD;
     static const long ID_NETWORK_BULKEDIT;
     static const long ID_NETWORK_DELETE;
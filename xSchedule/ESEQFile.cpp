@@ -4,8 +4,23 @@
 #include <log4cpp/Category.hh>
 #include "../xLights/UtilFunctions.h"
 
+#ifdef __WXMSW__
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// overlays are blended a tile at a time so the show buffer stays in cache while every layer is applied
+#define ESEQ_TILE_SIZE (3 * 4096)
+
 ESEQFile::ESEQFile()
 {
+    _mapped = nullptr;
+    _mappedSize = 0;
+#ifdef __WXMSW__
+    _mapping = nullptr;
+#endif
     _offset = 0;
     _channelsPerFrame = 0;
     _filename = "";
@@ -18,6 +33,11 @@ ESEQFile::ESEQFile()
 
 ESEQFile::ESEQFile(const std::string& filename)
 {
+    _mapped = nullptr;
+    _mappedSize = 0;
+#ifdef __WXMSW__
+    _mapping = nullptr;
+#endif
     _offset = 0;
     _channelsPerFrame = 0;
     _filename = FixFile("", filename);
@@ -35,8 +55,63 @@ ESEQFile::~ESEQFile()
 }
 
 
+bool ESEQFile::MapFile()
+{
+    _mappedSize = _fh->Length();
+    if (_mappedSize == 0) return false;
+
+#ifdef __WXMSW__
+    HANDLE file = (HANDLE)_get_osfhandle(_fh->fd());
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    _mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping == nullptr) return false;
+
+    _mapped = (const uint8_t*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (_mapped == nullptr)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+        return false;
+    }
+#else
+    void* p = mmap(nullptr, _mappedSize, PROT_READ, MAP_SHARED, _fh->fd(), 0);
+    if (p == MAP_FAILED) return false;
+
+    madvise(p, _mappedSize, MADV_WILLNEED);
+    _mapped = (const uint8_t*)p;
+#endif
+
+    return true;
+}
+
+void ESEQFile::UnmapFile()
+{
+    if (_mapped != nullptr)
+    {
+#ifdef __WXMSW__
+        UnmapViewOfFile(_mapped);
+#else
+        munmap((void*)_mapped, _mappedSize);
+#endif
+        _mapped = nullptr;
+    }
+
+#ifdef __WXMSW__
+    if (_mapping != nullptr)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+#endif
+
+    _mappedSize = 0;
+}
+
 void ESEQFile::Close()
 {
+    UnmapFile();
+
     if (_fh != nullptr)
     {
         _fh->Close();
@@ -114,11 +189,27 @@ void ESEQFile::Load(const std::string& filename)
             _offset = ReadInt32(_fh);
             _modelSize = ReadInt32(_fh); // model size
             //_frames = ReadInt32(_fh);
+
+            if (_channelsPerFrame == 0)
+            {
+                logger_base.error("ESEQ file %s has no channels.", (const char *)_filename.c_str());
+                Close();
+                return;
+            }
+
             _frameBuffer = (uint8_t*)malloc(_channelsPerFrame);
 
             wxFileName fn(_filename);
             _frames = (size_t)(fn.GetSize().ToULong() - _frame0Offset) / _channelsPerFrame;
 
+            // frames are then read straight out of the mapping rather than seeking and reading every frame
+            if (!MapFile())
+            {
+                logger_base.debug("ESEQ file %s could not be memory mapped ... it will be read a frame at a time.", (const char *)_filename.c_str());
+                UnmapFile();
+            }
+
+            _ok = true;
             logger_base.info("ESEQ file %s opened.", (const char *)_filename.c_str());
         }
         else
@@ -134,9 +225,14 @@ void ESEQFile::Load(const std::string& filename)
     }
 }
 
-void ESEQFile::ReadData(uint8_t* buffer, size_t buffersize, size_t frame, APPLYMETHOD applyMethod)
+const uint8_t* ESEQFile::GetFrame(size_t frame)
 {
-    if (frame >= _frames) return; // cant read past end of file
+    if (frame >= _frames) return nullptr; // cant read past end of file
+
+    if (_mapped != nullptr)
+    {
+        return _mapped + _frame0Offset + _channelsPerFrame * frame;
+    }
 
     if (_fh->Tell() != _frame0Offset + _channelsPerFrame * frame)
     {
@@ -147,5 +243,102 @@ void ESEQFile::ReadData(uint8_t* buffer, size_t buffersize, size_t frame, APPLYM
     // read in the frame from disk
     _fh->Read(_frameBuffer, _channelsPerFrame);
 
-    Blend(buffer, buffersize, _frameBuffer, _modelSize, applyMethod, _offset - 1);
+    return _frameBuffer;
+}
+
+bool ESEQFile::GetLayer(size_t frame, APPLYMETHOD applyMethod, ESEQLayer& layer)
+{
+    const uint8_t* data = GetFrame(frame);
+    if (data == nullptr) return false;
+
+    layer._data = data;
+    layer._offset = _offset > 0 ? _offset - 1 : 0;
+    layer._size = std::min(_modelSize, _channelsPerFrame);
+    layer._applyMethod = applyMethod;
+
+    return true;
+}
+
+void ESEQFile::ReadData(uint8_t* buffer, size_t buffersize, size_t frame, APPLYMETHOD applyMethod)
+{
+    ESEQLayer layer;
+    if (!GetLayer(frame, applyMethod, layer)) return;
+
+    Blend(buffer, buffersize, (uint8_t*)layer._data, layer._size, layer._applyMethod, layer._offset);
+}
+
+static bool IsPixelMethod(APPLYMETHOD applyMethod)
+{
+    return applyMethod == APPLYMETHOD::METHOD_OVERWRITEIFBLACK ||
+        applyMethod == APPLYMETHOD::METHOD_MASKPIXEL ||
+        applyMethod == APPLYMETHOD::METHOD_UNMASKPIXEL;
+}
+
+// Blend a set of overlays in order in a single pass over the channels they cover. Result is identical to
+// blending each layer in turn.
+void ESEQFile::BlendLayers(uint8_t* buffer, size_t buffersize, const std::vector<ESEQLayer>& layers)
+{
+    if (layers.size() == 0) return;
+
+    if (layers.size() == 1)
+    {
+        auto& l = layers.front();
+        Blend(buffer, buffersize, (uint8_t*)l._data, l._size, l._applyMethod, l._offset);
+        return;
+    }
+
+    size_t start = buffersize;
+    size_t end = 0;
+    bool pixelMethods = false;
+    size_t residue = 0;
+    bool tile = true;
+    for (auto it = layers.begin(); it != layers.end(); ++it)
+    {
+        if (it->_offset >= buffersize) continue;
+
+        start = std::min(start, it->_offset);
+        end = std::max(end, std::min(buffersize, it->_offset + it->_size));
+
+        // pixel based methods must not have a pixel split across tiles ... if the layers dont agree on
+        // where pixels start then just do it in one go
+        if (IsPixelMethod(it->_applyMethod))
+        {
+            if (!pixelMethods)
+            {
+                pixelMethods = true;
+                residue = it->_offset % 3;
+            }
+            else if (it->_offset % 3 != residue)
+            {
+                tile = false;
+            }
+        }
+    }
+
+    size_t tileStart = start;
+    while (tileStart < end)
+    {
+        size_t tileEnd = end;
+        if (tile && tileStart + ESEQ_TILE_SIZE < end)
+        {
+            tileEnd = tileStart + ESEQ_TILE_SIZE;
+            if (pixelMethods)
+            {
+                while (tileEnd % 3 != residue) ++tileEnd;
+                tileEnd = std::min(tileEnd, end);
+            }
+        }
+
+        for (auto it = layers.begin(); it != layers.end(); ++it)
+        {
+            size_t ls = std::max(tileStart, it->_offset);
+            size_t le = std::min(std::min(tileEnd, buffersize), it->_offset + it->_size);
+            if (ls < le)
+            {
+                Blend(buffer + ls, le - ls, (uint8_t*)it->_data + (ls - it->_offset), le - ls, it->_applyMethod);
+            }
+        }
+
+        tileStart = tileEnd;
+    }
 }
@@ -4,8 +4,18 @@
 #include <string>
 #include <wx/file.h>
 #include <list>
+#include <vector>
 #include "Blend.h"
 
+// One frame of an effect sequence ready to be blended into the show buffer
+struct ESEQLayer
+{
+    const uint8_t* _data;
+    size_t _offset; // 0 based
+    size_t _size;
+    APPLYMETHOD _applyMethod;
+};
+
 class ESEQFile
 {
 	std::string _filename;
@@ -17,6 +27,14 @@ class ESEQFile
     uint8_t* _frameBuffer;
     size_t _frame0Offset;
     bool _ok;
+    const uint8_t* _mapped; // whole file mapped into memory when the platform allows
+    size_t _mappedSize;
+#ifdef __WXMSW__
+    void* _mapping;
+#endif
+
+    bool MapFile();
+    void UnmapFile();
 
     public:
 
@@ -30,6 +48,9 @@ class ESEQFile
 		virtual ~ESEQFile();
 		int GetLengthFrames() const { return _frames; }
 		void ReadData(uint8_t* buffer, size_t buffersize, size_t frame, APPLYMETHOD applyMethod);
+        const uint8_t* GetFrame(size_t frame);
+        bool GetLayer(size_t frame, APPLYMETHOD applyMethod, ESEQLayer& layer);
+        static void BlendLayers(uint8_t* buffer, size_t buffersize, const std::vector<ESEQLayer>& layers);
 		bool IsOk() const { return _ok; }
 		size_t GetChannels() const { return _channelsPerFrame; }
 		size_t GetOffset() const { return _offset; }
@@ -7,6 +7,7 @@
 
 #include <wx/msgdlg.h>
 #include <wx/generic/textdlgg.h>
+#include <wx/numdlg.h>
 #include "../xLights/outputs/IPOutput.h"
 #include "../xLights/UtilFunctions.h"
 
@@ -23,8 +24,10 @@ BEGIN_EVENT_TABLE(FPPRemotesDialog,wxDialog)
 	//*)
 END_EVENT_TABLE()
 
-FPPRemotesDialog::FPPRemotesDialog(wxWindow* parent, std::list<std::string> remotes, wxWindowID id,const wxPoint& pos,const wxSize& size)
+FPPRemotesDialog::FPPRemotesDialog(wxWindow* parent, std::list<std::string> remotes, std::map<std::string, int> latencies, wxWindowID id,const wxPoint& pos,const wxSize& size)
 {
+    _latencies = latencies;
+
 	//(*Initialize(FPPRemotesDialog)
 	wxFlexGridSizer* FlexGridSizer2;
 	wxFlexGridSizer* FlexGridSizer1;
@@ -151,6 +154,25 @@ void FPPRemotesDialog::EditItem(int item)
 
             if (!duplicate)
             {
+                std::string newip = dlg.GetValue().ToStdString();
+                int latency = 0;
+                if (_latencies.find(ip.ToStdString()) != _latencies.end())
+                {
+                    latency = _latencies[ip.ToStdString()];
+                    _latencies.erase(ip.ToStdString());
+                }
+
+                // Remotes that are slow to react to sync can be sent a position this far ahead
+                wxNumberEntryDialog ldlg(this, "Extra latency to allow for this remote (ms)", "Latency", "Remote Latency", latency, -1000, 1000);
+                if (ldlg.ShowModal() == wxID_OK)
+                {
+                    latency = ldlg.GetValue();
+                }
+                if (latency != 0)
+                {
+                    _latencies[newip] = latency;
+                }
+
                 if (item == -1)
                 {
                     ListBox_Remotes->AppendAndEnsureVisible(dlg.GetValue());
@@ -176,6 +198,22 @@ std::list<std::string> FPPRemotesDialog::GetRemotes()
     return res;
 }
 
+std::map<std::string, int> FPPRemotesDialog::GetLatencies()
+{
+    std::map<std::string, int> res;
+
+    for (size_t i = 0; i < ListBox_Remotes->GetCount(); ++i)
+    {
+        auto ip = ListBox_Remotes->GetString(i).ToStdString();
+        if (_latencies.find(ip) != _latencies.end())
+        {
+            res[ip] = _latencies[ip];
+        }
+    }
+
+    return res;
+}
+
 void FPPRemotesDialog::ValidateWindow()
 {
     if (ListBox_Remotes->GetSelection() != wxNOT_FOUND)
@@ -9,14 +9,18 @@
 //*)
 
 #include <list>
+#include <map>
 
 class FPPRemotesDialog: public wxDialog
 {
+    std::map<std::string, int> _latencies;
+
 	public:
 
-		FPPRemotesDialog(wxWindow* parent, std::list<std::string> remotes, wxWindowID id=wxID_ANY,const wxPoint& pos=wxDefaultPosition,const wxSize& size=wxDefaultSize);
+		FPPRemotesDialog(wxWindow* parent, std::list<std::string> remotes, std::map<std::string, int> latencies, wxWindowID id=wxID_ANY,const wxPoint& pos=wxDefaultPosition,const wxSize& size=wxDefaultSize);
 		virtual ~FPPRemotesDialog();
         std::list<std::string> GetRemotes();
+        std::map<std::string, int> GetLatencies();
 
 		//(*Declarations(FPPRemotesDialog)
 		wxListBox* ListBox_Remotes;
@@ -102,6 +102,14 @@ void PlayListItemESEQ::Frame(uint8_t* buffer, size_t size, size_t ms, size_t fra
     }
 }
 
+// Used by the step so all its ESEQs can be blended together
+bool PlayListItemESEQ::GetLayer(size_t ms, size_t framems, bool outputframe, ESEQLayer& layer)
+{
+    if (!outputframe || _ESEQFile == nullptr) return false;
+
+    return _ESEQFile->GetLayer(ms / framems, _applyMethod, layer);
+}
+
 void PlayListItemESEQ::Start(long stepLengthMS)
 {
     PlayListItem::Start(stepLengthMS);
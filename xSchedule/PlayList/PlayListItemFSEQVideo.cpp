@@ -621,7 +621,7 @@ void PlayListItemFSEQVideo::Frame(uint8_t* buffer, size_t size, size_t ms, size_
                     adjustedMS -= videoLength;
                 }
 
-                _window->SetImage(CachedVideoReader::FadeImage(_cachedVideoReader->GetNextFrame(adjustedMS), brightness));
+                _window->SetImage(_cachedVideoReader->GetNextFrame(adjustedMS, brightness));
             }
         }
         else
@@ -635,7 +635,7 @@ void PlayListItemFSEQVideo::Frame(uint8_t* buffer, size_t size, size_t ms, size_
                 }
 
                 AVFrame* img = _videoReader->GetNextFrame(adjustedMS, framems);
-                _window->SetImage(CachedVideoReader::FadeImage(CachedVideoReader::CreateImageFromFrame(img, _size), brightness));
+                _window->SetImage(CachedVideoReader::CreateImageFromFrame(img, _size, brightness));
             }
         }
         if (sw.Time() > framems / 2)
@@ -238,7 +238,7 @@ void PlayListItemVideo::Frame(uint8_t* buffer, size_t size, size_t ms, size_t fr
                     adjustedMS -= videoLength;
                 }
 
-                _window->SetImage(CachedVideoReader::FadeImage(_cachedVideoReader->GetNextFrame(adjustedMS), brightness));
+                _window->SetImage(_cachedVideoReader->GetNextFrame(adjustedMS, brightness));
             }
         }
         else
@@ -252,7 +252,7 @@ void PlayListItemVideo::Frame(uint8_t* buffer, size_t size, size_t ms, size_t fr
                 }
 
                 AVFrame* img = _videoReader->GetNextFrame(adjustedMS, framems);
-                _window->SetImage(CachedVideoReader::FadeImage(CachedVideoReader::CreateImageFromFrame(img, _size), brightness));
+                _window->SetImage(CachedVideoReader::CreateImageFromFrame(img, _size, brightness));
             }
         }
 
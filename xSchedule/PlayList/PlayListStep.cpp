@@ -467,10 +467,29 @@ bool PlayListStep::Frame(uint8_t* buffer, size_t size, bool outputframe)
 
     wxStopWatch sw;
     // we do this backwards to ensure the right render order
+    // consecutive ESEQs are gathered up and blended together in one pass
+    _eseqLayers.clear();
     for (auto it = _items.rbegin(); it != _items.rend(); ++it)
     {
-        (*it)->Frame(buffer, size, frameMS, msPerFrame, outputframe);
+        if ((*it)->GetTitle() == "ESEQ")
+        {
+            ESEQLayer layer;
+            if (((PlayListItemESEQ*)(*it))->GetLayer(frameMS, msPerFrame, outputframe, layer))
+            {
+                _eseqLayers.push_back(layer);
+            }
+        }
+        else
+        {
+            if (_eseqLayers.size() > 0)
+            {
+                ESEQFile::BlendLayers(buffer, size, _eseqLayers);
+                _eseqLayers.clear();
+            }
+            (*it)->Frame(buffer, size, frameMS, msPerFrame, outputframe);
+        }
     }
+    ESEQFile::BlendLayers(buffer, size, _eseqLayers);
 
     if (sw.Time() > (float)msPerFrame * 0.8)
     {
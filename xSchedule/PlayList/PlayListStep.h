@@ -4,6 +4,8 @@
 #include <string>
 #include <wx/wx.h>
 #include <mutex>
+#include <vector>
+#include "../ESEQFile.h"
 
 class OutputManager;
 class PlayListItemText;
@@ -30,6 +32,7 @@ protected:
     wxUint32 _suspend;
     int _loops;
     bool _everyStep;
+    std::vector<ESEQLayer> _eseqLayers; // reused every frame
 #pragma endregion Member Variables
 
     std::string FormatTime(size_t timems, bool ms = false) const;
@@ -135,6 +135,11 @@ ScheduleOptions::ScheduleOptions(OutputManager* outputManager, wxXmlNode* node,
         else if (n->GetName() == "FPPRemote")
         {
             _fppRemotes.push_back(n->GetAttribute("IP").ToStdString());
+            int latency = wxAtoi(n->GetAttribute("LatencyMS", "0"));
+            if (latency != 0)
+            {
+                _fppRemoteLatency[n->GetAttribute("IP").ToStdString()] = latency;
+            }
         }
         else if (n->GetName() == "OSC")
         {
@@ -319,6 +324,11 @@ wxXmlNode* ScheduleOptions::Save()
     {
         wxXmlNode* n = new wxXmlNode(nullptr, wxXML_ELEMENT_NODE, "FPPRemote");
         n->AddAttribute("IP", wxString(it));
+        auto latency = _fppRemoteLatency.find(it);
+        if (latency != _fppRemoteLatency.end() && latency->second != 0)
+        {
+            n->AddAttribute("LatencyMS", wxString::Format("%d", latency->second));
+        }
         res->AddChild(n);
     }
 
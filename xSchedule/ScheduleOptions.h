@@ -1,6 +1,7 @@
 #ifndef SCHEDULEOPTIONS_H
 #define SCHEDULEOPTIONS_H
 #include <list>
+#include <map>
 #include <string>
 #include <vector>
 #include "MatrixMapper.h"
@@ -172,6 +173,7 @@ class ScheduleOptions
     std::list<MatrixMapper*> _matrices;
     std::list<VirtualMatrix*> _virtualMatrices;
     std::list<std::string> _fppRemotes;
+    std::map<std::string, int> _fppRemoteLatency; // extra ms to lead each remote by
     std::string _audioDevice;
     OSCOptions* _oscOptions;
     TestOptions* _testOptions;
@@ -234,6 +236,8 @@ class ScheduleOptions
         std::list<std::string> GetFPPRemotes() const { return _fppRemotes; }
         void SetWebServerPort(int port) { if (_port != port) { _port = port; _changeCount++; } }
         void SetFPPRemotes(std::list<std::string> remotes) { _fppRemotes = remotes; _changeCount++; } 
+        std::map<std::string, int> GetFPPRemoteLatencies() const { return _fppRemoteLatency; }
+        void SetFPPRemoteLatencies(const std::map<std::string, int>& latencies) { if (latencies != _fppRemoteLatency) { _fppRemoteLatency = latencies; _changeCount++; } }
         std::string GetWWWRoot() const { return _wwwRoot; }
         std::string GetAudioDevice() const { return _audioDevice; }
         std::string GetDefaultRoot() const;
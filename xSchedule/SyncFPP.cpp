@@ -8,11 +8,195 @@
 #include "Control.h"
 #include "../xLights/outputs/IPOutput.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// This must be below the wx includes
+#ifdef __WXMSW__
+    #include <winsock2.h>
+    typedef wxUIntPtr ProbeSocket;
+    #define INVALID_PROBESOCKET ((ProbeSocket)INVALID_SOCKET)
+    #define CLOSE_SOCKET(s) closesocket(s)
+    #define PROBE_CONNREFUSED WSAECONNREFUSED
+    typedef int socklen_t;
+#else
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+    typedef int ProbeSocket;
+    #define INVALID_PROBESOCKET ((ProbeSocket)-1)
+    #define CLOSE_SOCKET(s) close(s)
+    #define PROBE_CONNREFUSED ECONNREFUSED
+#endif
+
 #define FPP_MEDIA_SYNC_INTERVAL_MS 500
 #define FPP_SEQ_SYNC_INTERVAL_FRAMES 16
 #define FPP_SEQ_SYNC_INTERVAL_INITIAL_FRAMES 4
 #define FPP_SEQ_SYNC_INITIAL_NUMBER_OF_FRAMES 32
 
+// every remote is probed once in this period
+#define FPP_PROBE_INTERVAL_MS 30000
+#define FPP_PROBE_TIMEOUT_MS 1000
+#define FPP_PROBE_PORT 80
+// anything slower than this is a busy web server not the network so it is not added to the lead
+#define FPP_PROBE_MAX_DELAY_MS 50
+
+// Estimates the one way network delay to each remote by timing a TCP handshake with its web server.
+// FPP does not answer sync packets so this is the cheapest response we can get out of it. Runs on
+// its own thread blocked on the probe socket so the handshake completion time is exact.
+class FPPLatencyProbe
+{
+    std::vector<std::pair<std::string, uint32_t>> _remotes; // remote and its address in network order
+    std::map<std::string, double> _delayMS; // protected by _lock
+    std::thread _thread;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    bool _stop = false;
+
+    void Measured(const std::string& remote, std::chrono::steady_clock::duration rtt)
+    {
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+        double delay = std::chrono::duration_cast<std::chrono::microseconds>(rtt).count() / 2000.0;
+        if (delay > FPP_PROBE_MAX_DELAY_MS)
+        {
+            logger_base.debug("FPP remote %s one way delay %.2fms ignored as too slow.", (const char*)remote.c_str(), delay);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _delayMS.find(remote);
+        if (it == _delayMS.end())
+        {
+            _delayMS[remote] = delay;
+        }
+        else
+        {
+            // smooth it out so one slow response does not jerk the remote around
+            it->second = (it->second * 3.0 + delay) / 4.0;
+        }
+        logger_base.debug("FPP remote %s one way delay %.2fms.", (const char*)remote.c_str(), _delayMS[remote]);
+    }
+
+    void Probe(const std::pair<std::string, uint32_t>& remote)
+    {
+        ProbeSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_PROBESOCKET) return;
+
+#ifdef __WXMSW__
+        u_long mode = 1;
+        ioctlsocket(s, FIONBIO, &mode);
+#else
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+        sockaddr_in addr;
+        memset(&addr, 0x00, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(FPP_PROBE_PORT);
+        addr.sin_addr.s_addr = remote.second;
+
+        auto started = std::chrono::steady_clock::now();
+        if (connect(s, (sockaddr*)&addr, sizeof(addr)) == 0)
+        {
+            Measured(remote.first, std::chrono::steady_clock::now() - started);
+        }
+#ifdef __WXMSW__
+        else if (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+        else if (errno == EINPROGRESS)
+#endif
+        {
+            fd_set writefds;
+            fd_set exceptfds;
+            FD_ZERO(&writefds);
+            FD_ZERO(&exceptfds);
+            FD_SET(s, &writefds);
+            FD_SET(s, &exceptfds);
+            timeval tv = { FPP_PROBE_TIMEOUT_MS / 1000, (FPP_PROBE_TIMEOUT_MS % 1000) * 1000 };
+
+            if (select((int)s + 1, nullptr, &writefds, &exceptfds, &tv) > 0)
+            {
+                auto rtt = std::chrono::steady_clock::now() - started;
+
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+
+                // a refusal is as good a response as an accept
+                if (err == 0 || err == PROBE_CONNREFUSED)
+                {
+                    Measured(remote.first, rtt);
+                }
+            }
+        }
+        CLOSE_SOCKET(s);
+    }
+
+    void Run()
+    {
+        size_t next = 0;
+        std::unique_lock<std::mutex> lock(_lock);
+        while (!_stop)
+        {
+            lock.unlock();
+            Probe(_remotes[next]);
+            next = (next + 1) % _remotes.size();
+            lock.lock();
+
+            _signal.wait_for(lock, std::chrono::milliseconds(FPP_PROBE_INTERVAL_MS / _remotes.size()), [this] { return _stop; });
+        }
+    }
+
+public:
+
+    FPPLatencyProbe(const std::list<std::string>& remotes)
+    {
+        for (auto it : remotes)
+        {
+            wxIPV4address addr;
+            if (addr.Hostname(it))
+            {
+                _remotes.push_back({ it, inet_addr(addr.IPAddress().c_str()) });
+            }
+        }
+
+        if (_remotes.size() > 0)
+        {
+            _thread = std::thread(&FPPLatencyProbe::Run, this);
+        }
+    }
+
+    virtual ~FPPLatencyProbe()
+    {
+        if (_thread.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _stop = true;
+            }
+            _signal.notify_all();
+            _thread.join();
+        }
+    }
+
+    // whole ms only so sub millisecond LAN delays add nothing
+    int GetDelayMS(const std::string& remote)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        auto it = _delayMS.find(remote);
+        if (it == _delayMS.end()) return 0;
+        return (int)it->second;
+    }
+};
+
 void SyncBroadcastFPP::SendSync(uint32_t frameMS, uint32_t stepLengthMS, uint32_t stepMS, uint32_t playlistMS, const std::string& fseq, const std::string& media, const std::string& step, const std::string& timeItem) const
 {
     static std::string lastfseq = "";
@@ -335,7 +519,12 @@ void SyncUnicastFPP::SendFPPSync(const std::string& item, uint32_t stepMS, uint3
     {
         for (auto it : _remotes)
         {
-            SendUnicastSync(it, fn.GetFullName().ToStdString(), stepMS, frameMS, pktType);
+            size_t ms = stepMS;
+            if (pktType == SYNC_PKT_SYNC)
+            {
+                ms = std::max(0, (int)stepMS + GetRemoteLeadMS(it));
+            }
+            SendUnicastSync(it, fn.GetFullName().ToStdString(), ms, frameMS, pktType);
         }
     }
 }
@@ -352,6 +541,28 @@ SyncUnicastFPP::SyncUnicastFPP(SyncUnicastFPP&& from) : SyncBase(from)
     _fppUnicastSocket = from._fppUnicastSocket;
     from._fppUnicastSocket = nullptr; // this is a transfer of ownership
     _remotes = from._remotes;
+    _latency = from._latency;
+    _probe = from._probe;
+    from._probe = nullptr;
+}
+
+// how far ahead of our position a remote needs to be told we are so it lands in sync
+int SyncUnicastFPP::GetRemoteLeadMS(const std::string& ip) const
+{
+    int lead = 0;
+
+    auto it = _latency.find(ip);
+    if (it != _latency.end())
+    {
+        lead += it->second;
+    }
+
+    if (_probe != nullptr)
+    {
+        lead += _probe->GetDelayMS(ip);
+    }
+
+    return lead;
 }
 
 SyncBroadcastFPP::~SyncBroadcastFPP()
@@ -365,6 +576,12 @@ SyncBroadcastFPP::~SyncBroadcastFPP()
 
 SyncUnicastFPP::~SyncUnicastFPP()
 {
+    if (_probe != nullptr)
+    {
+        delete _probe;
+        _probe = nullptr;
+    }
+
     if (_fppUnicastSocket != nullptr) {
         _fppUnicastSocket->Close();
         delete _fppUnicastSocket;
@@ -437,8 +654,11 @@ SyncUnicastFPP::SyncUnicastFPP(SYNCMODE sm, REMOTEMODE rm, const ScheduleOptions
         }
 
         _remotes = options.GetFPPRemotes();
+        _latency = options.GetFPPRemoteLatencies();
         if (_remotes.size() > 0)
         {
+            _probe = new FPPLatencyProbe(_remotes);
+
             _fppUnicastSocket = new wxDatagramSocket(localaddr, wxSOCKET_NOWAIT);
             if (_fppUnicastSocket == nullptr)
             {
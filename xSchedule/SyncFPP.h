@@ -4,8 +4,10 @@
 #include "SyncManager.h"
 #include "ScheduleOptions.h"
 #include <wx/socket.h>
+#include <map>
 
 class ListenerManager;
+class FPPLatencyProbe;
 
 class SyncBroadcastFPP : public SyncBase
 {
@@ -28,7 +30,10 @@ class SyncUnicastFPP : public SyncBase
 {
     wxDatagramSocket* _fppUnicastSocket = nullptr;
     std::list<std::string> _remotes;
+    std::map<std::string, int> _latency; // configured extra lead per remote
+    FPPLatencyProbe* _probe = nullptr;
 
+    int GetRemoteLeadMS(const std::string& ip) const;
     void SendUnicastSync(const std::string& ip, const std::string& syncItem, size_t msec, size_t frameMS, int action) const;
     void SendFPPSync(const std::string& item, uint32_t stepMS, uint32_t frameMS) const;
 
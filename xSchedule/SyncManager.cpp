@@ -8,6 +8,161 @@
 #include "SyncMIDI.h"
 #include "SyncArtNet.h"
 
+#include <log4cpp/Category.hh>
+#include <wx/thread.h>
+
+class SyncThread : public wxThread
+{
+    SyncManager* _syncManager;
+
+public:
+
+    SyncThread(SyncManager* syncManager) : wxThread(wxTHREAD_JOINABLE), _syncManager(syncManager) {}
+
+    virtual void* Entry() override
+    {
+        _syncManager->SyncLoop();
+        return nullptr;
+    }
+};
+
+SyncManager::SyncManager(ScheduleManager* scheduleManager) : _scheduleManager(scheduleManager)
+{
+    _stopSyncThread = false;
+    _sent = 0;
+    _late = 0;
+    _coalesced = 0;
+    StartSyncThread();
+}
+
+SyncManager::~SyncManager()
+{
+    StopSyncThread();
+    _remote = nullptr;
+    ClearMasters();
+}
+
+void SyncManager::StartSyncThread()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    _syncThread = new SyncThread(this);
+    if (_syncThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        logger_base.error("Failed to start sync thread.");
+        delete _syncThread;
+        _syncThread = nullptr;
+    }
+}
+
+void SyncManager::StopSyncThread()
+{
+    if (_syncThread != nullptr)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_pendingLock);
+            _stopSyncThread = true;
+        }
+        _pendingSignal.notify_all();
+        _syncThread->Wait();
+        delete _syncThread;
+        _syncThread = nullptr;
+    }
+}
+
+void SyncManager::SyncLoop()
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+    logger_base.debug("Sync thread started.");
+
+    while (true)
+    {
+        std::list<PendingSync> pending;
+        {
+            std::unique_lock<std::mutex> lock(_pendingLock);
+            _pendingSignal.wait(lock, [this] { return _pending.size() > 0 || _stopSyncThread; });
+            if (_pending.size() == 0) break;
+            pending.swap(_pending);
+        }
+
+        for (auto& it : pending)
+        {
+            DoSendSync(it);
+        }
+    }
+
+    logger_base.debug("Sync thread exiting.");
+}
+
+void SyncManager::DoSendSync(const PendingSync& sync)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+
+    std::unique_lock<std::recursive_mutex> lock(_mastersLock);
+
+    if (sync._stop)
+    {
+        for (auto& it : _masters)
+        {
+            it->SendStop();
+        }
+
+        if (_sent > 0)
+        {
+            logger_base.debug("Sync packets sent %ld, late %ld, coalesced %ld.", (long)_sent, (long)_late, (long)_coalesced);
+        }
+        return;
+    }
+
+    uint32_t age = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - sync._captured).count();
+    if (age > std::max((uint32_t)1, sync._frameMS / 2))
+    {
+        _late++;
+    }
+
+    // move the position on by however long it waited so the remotes get where we are now
+    uint32_t stepMS = sync._stepMS;
+    if (stepMS != 0 && stepMS != 0xFFFFFFFF)
+    {
+        stepMS += age;
+    }
+    uint32_t playlistMS = sync._playlistMS;
+    if (playlistMS != 0)
+    {
+        playlistMS += age;
+    }
+
+    for (auto& it : _masters)
+    {
+        it->SendSync(sync._frameMS, sync._stepLengthMS, stepMS, playlistMS, sync._fseq, sync._media, sync._step, sync._timeItem);
+    }
+    _sent++;
+}
+
+void SyncManager::Queue(const PendingSync& sync)
+{
+    {
+        std::unique_lock<std::mutex> lock(_pendingLock);
+
+        // a newer position in the same item replaces one that has not gone yet ... starts and stops always go
+        if (!sync._stop && sync._stepMS != 0 && sync._stepMS != 0xFFFFFFFF && _pending.size() > 0)
+        {
+            auto& last = _pending.back();
+            if (!last._stop && last._stepMS != 0 && last._stepMS != 0xFFFFFFFF && last._fseq == sync._fseq && last._media == sync._media)
+            {
+                last = sync;
+                _coalesced++;
+                lock.unlock();
+                _pendingSignal.notify_one();
+                return;
+            }
+        }
+
+        _pending.push_back(sync);
+    }
+    _pendingSignal.notify_one();
+}
+
 std::unique_ptr<SyncBase> SyncManager::CreateSync(SYNCMODE sm, REMOTEMODE rm) const
 {
     if (sm == SYNCMODE::OSCMASTER || rm == REMOTEMODE::OSCSLAVE)
@@ -40,12 +195,14 @@ std::unique_ptr<SyncBase> SyncManager::CreateSync(SYNCMODE sm, REMOTEMODE rm) co
 
 void SyncManager::AddMaster(SYNCMODE sm)
 {
+    std::unique_lock<std::recursive_mutex> lock(_mastersLock);
     RemoveMaster(sm);
     _masters.emplace_back(CreateSync(sm, REMOTEMODE::DISABLED));
 }
 
 void SyncManager::RemoveMaster(SYNCMODE sm)
 {
+    std::unique_lock<std::recursive_mutex> lock(_mastersLock);
     for (auto it = begin(_masters); it != end(_masters); ++it)
     {
         if ((*it)->IsMode(sm))
@@ -72,17 +229,39 @@ void SyncManager::ClearRemote()
 
 void SyncManager::ClearMasters()
 {
+    std::unique_lock<std::recursive_mutex> lock(_mastersLock);
     while (_masters.size() > 0)
     {
         _masters.remove(_masters.front());
     }
 }
 
-void SyncManager::SendSync(uint32_t frameMS, uint32_t stepLengthMS, uint32_t stepMS, uint32_t playlistMS, const std::string& fseq, const std::string& media, const std::string& step, const std::string& timeItem) const
-{ 
-    for (auto& it : _masters)
+void SyncManager::SendSync(uint32_t frameMS, uint32_t stepLengthMS, uint32_t stepMS, uint32_t playlistMS, const std::string& fseq, const std::string& media, const std::string& step, const std::string& timeItem)
+{
     {
-        it->SendSync(frameMS, stepLengthMS, stepMS, playlistMS, fseq, media, step, timeItem);
+        std::unique_lock<std::recursive_mutex> lock(_mastersLock);
+        if (_masters.size() == 0) return;
+    }
+
+    PendingSync sync;
+    sync._stop = false;
+    sync._frameMS = frameMS;
+    sync._stepLengthMS = stepLengthMS;
+    sync._stepMS = stepMS;
+    sync._playlistMS = playlistMS;
+    sync._fseq = fseq;
+    sync._media = media;
+    sync._step = step;
+    sync._timeItem = timeItem;
+    sync._captured = std::chrono::steady_clock::now();
+
+    if (_syncThread == nullptr)
+    {
+        DoSendSync(sync);
+    }
+    else
+    {
+        Queue(sync);
     }
 }
 
@@ -147,6 +326,7 @@ void SyncManager::Start(int mode, REMOTEMODE remoteMode)
 
 bool SyncManager::IsMaster(SYNCMODE mode) const
 {
+    std::unique_lock<std::recursive_mutex> lock(_mastersLock);
     bool res = false;
 
     for (auto& it: _masters)
@@ -157,10 +337,22 @@ bool SyncManager::IsMaster(SYNCMODE mode) const
     return res;
 }
 
-void SyncManager::SendStop() const
+void SyncManager::SendStop()
 {
-    for (auto& it : _masters)
+    PendingSync sync;
+    sync._stop = true;
+    sync._frameMS = 50;
+    sync._stepLengthMS = 0;
+    sync._stepMS = 0xFFFFFFFF;
+    sync._playlistMS = 0;
+    sync._captured = std::chrono::steady_clock::now();
+
+    if (_syncThread == nullptr)
+    {
+        DoSendSync(sync);
+    }
+    else
     {
-        it->SendStop();
+        Queue(sync);
     }
 }
@@ -4,9 +4,14 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 class ScheduleOptions;
 class ScheduleManager;
+class SyncThread;
 
 enum class TIMECODEFORMAT
 {
@@ -59,31 +64,64 @@ class SyncBase
         bool IsRemoteMode(REMOTEMODE mode) const { return _remoteMode == mode; }
 };
 
+// A sync position captured on the frame thread waiting to be sent by the sync thread
+struct PendingSync
+{
+    bool _stop;
+    uint32_t _frameMS;
+    uint32_t _stepLengthMS;
+    uint32_t _stepMS;
+    uint32_t _playlistMS;
+    std::string _fseq;
+    std::string _media;
+    std::string _step;
+    std::string _timeItem;
+    std::chrono::steady_clock::time_point _captured;
+};
+
 class SyncManager
 {
+    friend class SyncThread;
+
 	std::list<std::unique_ptr<SyncBase>> _masters;
 	std::unique_ptr<SyncBase> _remote = nullptr;
 	ScheduleManager* _scheduleManager = nullptr;
+    mutable std::recursive_mutex _mastersLock;
+
+    // sync packets are sent from their own thread so frame jitter does not reach the remotes
+    SyncThread* _syncThread = nullptr;
+    std::mutex _pendingLock;
+    std::condition_variable _pendingSignal;
+    std::list<PendingSync> _pending;
+    std::atomic<bool> _stopSyncThread;
+    std::atomic<long> _sent;
+    std::atomic<long> _late;
+    std::atomic<long> _coalesced;
 
     std::unique_ptr<SyncBase> CreateSync(SYNCMODE sm, REMOTEMODE rm) const;
+    void StartSyncThread();
+    void StopSyncThread();
+    void SyncLoop();
+    void DoSendSync(const PendingSync& sync);
+    void Queue(const PendingSync& sync);
 
 	public:
 
-		SyncManager(ScheduleManager* scheduleManager) : _scheduleManager(scheduleManager) {}
-        virtual ~SyncManager() {
-            _remote = nullptr;
-            ClearMasters(); 
-        }
+		SyncManager(ScheduleManager* scheduleManager);
+        virtual ~SyncManager();
 
 		void AddMaster(SYNCMODE sm);
         void RemoveMaster(SYNCMODE sm);
 		void SetRemote(REMOTEMODE rm);
         void ClearRemote();
         void ClearMasters();
-        void SendSync(uint32_t frameMS, uint32_t stepLengthMS, uint32_t stepMS, uint32_t playlistMS, const std::string& fseq, const std::string& media, const std::string& step, const std::string& timeItem) const; // send out to all masters
+        void SendSync(uint32_t frameMS, uint32_t stepLengthMS, uint32_t stepMS, uint32_t playlistMS, const std::string& fseq, const std::string& media, const std::string& step, const std::string& timeItem); // send out to all masters
         void Start(int mode, REMOTEMODE remoteMode);
         bool IsSlave() const { return _remote != nullptr; }
         bool IsMaster(SYNCMODE mode) const;
-        void SendStop() const;
+        void SendStop();
+        long GetSyncSent() const { return _sent; }
+        long GetSyncLate() const { return _late; }
+        long GetSyncCoalesced() const { return _coalesced; }
 };
 #endif
@@ -1,4 +1,5 @@
 #include "VideoCache.h"
+#include <atomic>
 #include "../xLights/VideoReader.h"
 #include <log4cpp/Category.hh>
 #include "../xLights/UtilFunctions.h"
@@ -12,8 +13,8 @@ class CVRThread : public wxThread
     int _maxFrames;
     std::mutex _access;
     wxSize _size;
-    bool _stop;
-    bool _running;
+    std::atomic_bool _stop;
+    std::atomic_bool _running;
     VideoReader* _videoReader;
     int _frameMS;
     CachedVideoReader* _cvr;
@@ -26,7 +27,7 @@ class CVRThread : public wxThread
     }
 
 public:
-    CVRThread(CachedVideoReader* cvr, int maxFrames, const std::string& videoFile, long startMillisecond, int frameMS, const wxSize& size, bool keepAspectRatio)
+    CVRThread(CachedVideoReader* cvr, int maxFrames, const std::string& videoFile, long startMillisecond, int frameMS, const wxSize& size, bool keepAspectRatio) : wxThread(wxTHREAD_JOINABLE)
     {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         _cvr = cvr;
@@ -60,26 +61,9 @@ public:
             }
         }
     }
+    // the owner waits for the thread to exit before deleting it
     virtual ~CVRThread()
     {
-        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
-        if (_running && !_stop)
-        {
-            logger_base.debug("Asking video reading thread %s (%dx%d) to stop", (const char *)_videoFile.c_str(), _size.GetWidth(), _size.GetHeight());
-            _stop = true;
-            std::unique_lock<std::mutex> mutLock(_access);
-            _signal.notify_all();
-        }
-
-        // now wait for exit
-        while (_running)
-        {
-            wxMilliSleep(1);
-        }
-
-        logger_base.debug("Video reading thread %s (%dx%d) has stopped.", (const char *)_videoFile.c_str(), _size.GetWidth(), _size.GetHeight());
-
         if (_videoReader != nullptr)
         {
             delete _videoReader;
@@ -94,8 +78,8 @@ public:
     {
         static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         logger_base.debug("Asking video reading thread %s (%dx%d) to stop", (const char *)_videoFile.c_str(), _size.GetWidth(), _size.GetHeight());
-        _stop = true;
         std::unique_lock<std::mutex> mutLock(_access);
+        _stop = true;
         _signal.notify_all();
     }
 
@@ -113,8 +97,6 @@ public:
             long currentStart = GetCurrentStart();
             if (lastStart != currentStart)
             {
-                _cvr->PurgeCachePriorTo(currentStart);
-
                 lastStart = currentStart;
                 long end = std::min((long)currentStart + _maxFrames * _frameMS, (long)_videoReader->GetLengthMS());
 #ifdef VIDEO_EXTRALOGGING
@@ -129,7 +111,7 @@ public:
                         wxStopWatch sw;
 
                         //_videoReader->Seek(i);
-                        _cvr->CacheImage(i, CachedVideoReader::CreateImageFromFrame(_videoReader->GetNextFrame(i), _size));
+                        _cvr->CacheFrame(i, _videoReader->GetNextFrame(i));
 
                         if (sw.Time() > _frameMS)
                         {
@@ -152,7 +134,7 @@ public:
                 logger_base.debug("Video reading thread %s (%dx%d) waiting for start time to change.", (const char *)_videoFile.c_str(), _size.GetWidth(), _size.GetHeight());
 #endif
                 std::unique_lock<std::mutex> accessLock(_access);
-                _signal.wait(accessLock);
+                _signal.wait(accessLock, [this, lastStart] { return _stop || _currentStart != lastStart; });
 #ifdef VIDEO_EXTRALOGGING
                 logger_base.debug("Video reading thread %s (%dx%d) start time changed.", (const char *)_videoFile.c_str(), _size.GetWidth(), _size.GetHeight());
 #endif
@@ -188,85 +170,127 @@ void CachedVideoReader::Done()
 
 CachedVideoReader::~CachedVideoReader()
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-
     if (_thread != nullptr)
     {
 #ifdef VIDEO_EXTRALOGGING
+        static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
         logger_base.debug("Cached Video Reader destructor asking thread to stop. %s", (const char *)_videoFile.c_str());
 #endif
+        // the thread writes into the frame ring so it must be gone before the ring is. It checks for
+        // stop between frames so this waits for at most one frame decode.
         _thread->Stop();
-        // threads delete themselves when stopped
+        _thread->Wait();
+        delete _thread;
+        _thread = nullptr;
+    }
+}
+
+#define TIMEOUT(a) a / 2
 
-        bool done = false;
+// one pass copy of RGB data scaling it by brightness 0-100
+static void CopyFaded(const unsigned char* src, unsigned char* dst, size_t bytes, int brightness)
+{
+    if (brightness >= 100)
+    {
+        memcpy(dst, src, bytes);
+    }
+    else if (brightness <= 0)
+    {
+        memset(dst, 0x00, bytes);
+    }
+    else
+    {
+        unsigned char btable[256];
+        for (int i = 0; i < 256; i++)
         {
-            std::unique_lock<std::mutex> locker(_cacheAccess);
-            done = _done;
+            btable[i] = i * brightness / 100;
         }
+        for (size_t i = 0; i < bytes; i++)
+        {
+            dst[i] = btable[src[i]];
+        }
+    }
+}
 
+void CachedVideoReader::CacheFrame(long millisecond, AVFrame* frame)
+{
 #ifdef VIDEO_EXTRALOGGING
-        logger_base.debug("Cached Video Reader destructor initial check shows thread is done. %s", done ? "TRUE" : "FALSE");
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 #endif
 
-        // we will wait up to 2 seconds for this to happen because this can go bad
-        int i = 0;
-        while (!done && ++i < 2000)
+    long f = millisecond / _frameTime;
+    CachedFrame* slot = nullptr;
+    while (slot == nullptr)
+    {
         {
-            wxMilliSleep(1);
-
             std::unique_lock<std::mutex> locker(_cacheAccess);
-            done = _done;
+            CachedFrame& cf = _cache[f % _cache.size()];
+            if (cf.frame == f)
+            {
+#ifdef VIDEO_EXTRALOGGING
+                logger_base.debug("Cache already had the image.");
+#endif
+                return;
+            }
+            if (!cf.reading)
+            {
+                // claim it so nobody reads it while we write
+                cf.frame = -1;
+                slot = &cf;
+            }
         }
-
-        if (!done)
+        if (slot == nullptr)
         {
-            logger_base.warn("Cached Video Reader destructor ... thread never finished");
+            // only ever a single frame copy
+            wxMilliSleep(1);
         }
-        else
+    }
+
+    if (frame != nullptr)
+    {
+        slot->width = frame->width;
+        slot->height = frame->height;
+        slot->data.resize((size_t)slot->width * slot->height * 3);
+        for (int y = 0; y < slot->height; y++)
         {
-#ifdef VIDEO_EXTRALOGGING
-            logger_base.debug("Cached Video Reader destructor thread seems to be done.");
-#endif
+            memcpy(&slot->data[(size_t)y * slot->width * 3], frame->data[0] + (size_t)y * frame->linesize[0], slot->width * 3);
         }
-
-        //delete _thread;
-        //_thread = nullptr;
     }
-
+    else
     {
-        std::unique_lock<std::mutex> locker(_cacheAccess);
+        slot->width = _size.GetWidth();
+        slot->height = _size.GetHeight();
+        slot->data.resize((size_t)slot->width * slot->height * 3);
+        memset(slot->data.data(), 0x00, slot->data.size());
+    }
 
+    std::unique_lock<std::mutex> locker(_cacheAccess);
+    slot->frame = f;
 #ifdef VIDEO_EXTRALOGGING
-        logger_base.debug("Cached Video Reader destructor clearing cache.");
+    logger_base.debug("Cached image for time %ld.", millisecond);
 #endif
-
-        _cache.clear();
-    }
 }
 
-#define TIMEOUT(a) a / 2
-
-void CachedVideoReader::CacheImage(long millisecond, const wxImage& image)
+bool CachedVideoReader::CopyFrame(long frame, wxImage& image, int brightness)
 {
-#ifdef VIDEO_EXTRALOGGING
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-#endif
-
-    std::unique_lock<std::mutex> locker(_cacheAccess);
-    auto it = _cache.find(millisecond);
-    if (it == _cache.end())
-    {
-#ifdef VIDEO_EXTRALOGGING
-        logger_base.debug("Cached image for time %ld.", millisecond);
-#endif
-        _cache[millisecond] = image.Copy();
-    }
-    else
+    CachedFrame* slot = nullptr;
     {
-#ifdef VIDEO_EXTRALOGGING
-        logger_base.debug("Cache already had the image.");
-#endif
+        std::unique_lock<std::mutex> locker(_cacheAccess);
+        CachedFrame& cf = _cache[frame % _cache.size()];
+        if (cf.frame != frame)
+        {
+            return false;
+        }
+        cf.reading = true;
+        slot = &cf;
     }
+
+    image.Create(slot->width, slot->height, false);
+    CopyFaded(slot->data.data(), image.GetData(), slot->data.size(), brightness);
+
+    std::unique_lock<std::mutex> locker(_cacheAccess);
+    slot->reading = false;
+    return true;
 }
 
 void CachedVideoReader::SetLengthMS(long lengthMS)
@@ -275,11 +299,11 @@ void CachedVideoReader::SetLengthMS(long lengthMS)
     _lengthMS = lengthMS;
 }
 
-wxImage CachedVideoReader::GetNextFrame(long ms)
+wxImage CachedVideoReader::GetNextFrame(long ms, int brightness)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
 
-    if (_thread == nullptr || ms > _lengthMS)
+    if (_thread == nullptr || ms > _lengthMS || ms < 0)
     {
         return wxImage(_size);
     }
@@ -290,11 +314,10 @@ wxImage CachedVideoReader::GetNextFrame(long ms)
     _thread->SetNewStart(ms);
 
     {
-        std::unique_lock<std::mutex> locker(_cacheAccess);
-        auto it = _cache.find(ms);
-        if (it != _cache.end())
+        wxImage image;
+        if (CopyFrame(ms / _frameTime, image, brightness))
         {
-            return it->second.Copy();
+            return image;
         }
     }
 
@@ -308,13 +331,10 @@ wxImage CachedVideoReader::GetNextFrame(long ms)
             wxMilliSleep(2);
             i += 2;
 
+            wxImage image;
+            if (CopyFrame(ms / _frameTime, image, brightness))
             {
-                std::unique_lock<std::mutex> locker(_cacheAccess);
-                auto it = _cache.find(ms);
-                if (it != _cache.end())
-                {
-                    return it->second.Copy();
-                }
+                return image;
             }
         }
     }
@@ -323,12 +343,16 @@ wxImage CachedVideoReader::GetNextFrame(long ms)
     return wxImage(_size);
 }
 
-wxImage CachedVideoReader::CreateImageFromFrame(AVFrame* frame, const wxSize& size)
+wxImage CachedVideoReader::CreateImageFromFrame(AVFrame* frame, const wxSize& size, int brightness)
 {
     if (frame != nullptr)
     {
-        wxImage img(frame->width, frame->height, (unsigned char *)frame->data[0], true);
+        wxImage img(frame->width, frame->height, false);
         img.SetType(wxBitmapType::wxBITMAP_TYPE_BMP);
+        for (int y = 0; y < frame->height; y++)
+        {
+            CopyFaded(frame->data[0] + (size_t)y * frame->linesize[0], img.GetData() + (size_t)y * frame->width * 3, frame->width * 3, brightness);
+        }
         return img;
     }
     else
@@ -338,72 +362,19 @@ wxImage CachedVideoReader::CreateImageFromFrame(AVFrame* frame, const wxSize& si
     }
 }
 
-wxImage CachedVideoReader::FadeImage(const wxImage& image, int brightness)
-{
-    unsigned char btable[256];
-
-    wxImage faded;
-
-    if (!image.IsOk() || brightness == 0)
-    {
-        // create a blank image if it is invalid or faded to black
-        faded.Create(image.GetWidth(), image.GetHeight());
-    }
-    else
-    {
-        faded = image.Copy();
-        if (brightness != 100)
-        {
-            for (int i = 0; i < 256; i++)
-            {
-                btable[i] = i * brightness / 100;
-            }
-
-            unsigned char * pdata = faded.GetData();
-
-            for (int i = 0; i < faded.GetWidth() * faded.GetHeight() * 3; i++)
-            {
-                *(pdata + i) = btable[*(pdata + i)];
-            }
-        }
-    }
-
-    return faded;
-}
-
 bool CachedVideoReader::HasFrame(long millisecond)
 {
     std::unique_lock<std::mutex> locker(_cacheAccess);
-    auto it = _cache.find(millisecond);
-    return (it != _cache.end());
+    long f = millisecond / _frameTime;
+    return _cache[f % _cache.size()].frame == f;
 }
 
 #define CALCCACHESIZE(a) 5 * 1000 / a
-void CachedVideoReader::PurgeCachePriorTo(long start)
-{
-    std::unique_lock<std::mutex> locker(_cacheAccess);
-
-    auto it = _cache.begin();
-    while (it != _cache.end())
-    {
-        if (it->first < start)
-        {
-            auto next = it;
-            ++next;
-            _cache.erase(it);
-            it = next;
-        }
-        else
-        {
-            ++it;
-        }
-    }
-}
-
 CachedVideoReader::CachedVideoReader(const std::string& videoFile, long startMillisecond, int frameTime, const wxSize& size, bool keepAspectRatio)
 {
     _done = false;
-    _maxItems = CALCCACHESIZE(frameTime);
+    _maxItems = std::max(2, CALCCACHESIZE(frameTime));
+    _cache.resize(_maxItems);
     _frameTime = frameTime;
     _videoFile = FixFile("", videoFile);
     _size = size;
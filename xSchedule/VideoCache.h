@@ -4,7 +4,7 @@
 #include <mutex>
 #include <wx/wx.h>
 #include <string>
-#include <map>
+#include <vector>
 #include "../xLights/JobPool.h"
 
 class VideoReader;
@@ -14,7 +14,18 @@ struct AVFrame;
 
 class CachedVideoReader
 {
-    std::map<long, wxImage> _cache;
+    class CachedFrame
+    {
+    public:
+        long frame = -1; // frame number held or -1 if the slot is empty or being written
+        bool reading = false; // being copied out so it must not be overwritten
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> data; // RGB, allocated the first time the slot is used then reused
+    };
+
+    // ring of decoded frames ahead of the play head. Frame n is held in slot n % size
+    std::vector<CachedFrame> _cache;
     std::mutex _cacheAccess;
     int _maxItems;
     CVRThread* _thread;
@@ -24,21 +35,22 @@ class CachedVideoReader
     long _lengthMS;
     bool _done;
 
+    bool CopyFrame(long frame, wxImage& image, int brightness);
+
 public:
     CachedVideoReader(const std::string& videoFile, long startMillisecond, int frameTime, const wxSize& size, bool keepAspectRatio);
     virtual ~CachedVideoReader();
 
-    static wxImage CreateImageFromFrame(AVFrame* frame, const wxSize& size);
-    static wxImage FadeImage(const wxImage& image, int brightness);
+    // brightness 0-100 is applied as the frame is copied
+    static wxImage CreateImageFromFrame(AVFrame* frame, const wxSize& size, int brightness = 100);
 
     bool HasFrame(long millisecond);
-    void CacheImage(long millisecond, const wxImage& image);
+    void CacheFrame(long millisecond, AVFrame* frame);
     void SetLengthMS(long lengthMS);
     void Done();
-    void PurgeCachePriorTo(long start);
 
     long GetLengthMS() const { return _lengthMS; };
-    wxImage GetNextFrame(long ms);
+    wxImage GetNextFrame(long ms, int brightness = 100);
 };
 
 #endif // VIDEOCACHE_H
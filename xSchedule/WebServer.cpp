@@ -15,6 +15,7 @@
 
 #undef WXUSINGDLL
 #include "wxJSON/jsonreader.h"
+#include "wxJSON/jsonwriter.h"
 
 //#define DETAILED_LOGGING
 
@@ -22,6 +23,10 @@ bool __apiOnly = false;
 std::string __password = "";
 std::list<std::string> __Loggedin;
 int __loginTimeout = 30;
+WebServer* __webServer = nullptr;
+
+// polling clients get the playing status straight from the server thread
+#define STATUS_URI "/xScheduleQuery?Query=GetPlayingStatus"
 
 void RemoveFromValid(HttpConnection& connection)
 {
@@ -709,6 +714,28 @@ void MyMessageHandler(HttpConnection& connection, WebSocketMessage& message)
                 result = d;
             }
         }
+        else if (type == "subscribe")
+        {
+            // {"Type":"subscribe","Status":"delta"} ... status pushes become {"statusdelta":{...}} holding only changed values
+            wxString st = root.Get("Status", defaultValue).AsString().Lower();
+            wxString r = root.Get("Reference", defaultValue).AsString();
+            if (!CheckLoggedIn(connection))
+            {
+                result = "{\"result\":\"not logged in\",\"subscribe\":\"" + st + "\",\"reference\":\"" + r + "\",\"ip\":\"" + connection.Address().IPAddress() + "\"}";
+            }
+            else if (st != "delta" && st != "full")
+            {
+                result = "{\"result\":\"failed\",\"reference\":\"" + r + "\",\"message\":\"Unknown status subscription.\"}";
+            }
+            else
+            {
+                if (__webServer != nullptr)
+                {
+                    __webServer->SubscribeToStatusDeltas(connection, st == "delta");
+                }
+                result = "{\"result\":\"ok\",\"reference\":\"" + r + "\",\"subscribe\":\"" + st + "\"}";
+            }
+        }
         else if ((plugin = ((xScheduleFrame*)wxTheApp->GetTopWindow())->GetWebPluginRequest(type)) != "")
         {
             wxString c = root.Get("Command", defaultValue).AsString();
@@ -745,35 +772,200 @@ void WebServer::SendMessageToAllWebSockets(const wxString& message)
     }
     reentry = true;
 
-    for (auto it = _connections.begin(); it != _connections.end(); ++it)
+    // sends are queued on the connection and written by the server thread
+    WebSocketMessage wsm(message);
+    for (const auto& it : GetWebSockets())
     {
-        if ((*it).second->IsWebSocket())
+        if (it->SendMessage(wsm))
         {
-            WebSocketMessage wsm(message);
-            if (it->second->SendMessage(wsm))
-            {
-                UpdateValid(*it->second);
-            }
-            else
-            {
-                RemoveFromValid(*it->second);
-            }
+            UpdateValid(*it);
+        }
+        else
+        {
+            RemoveFromValid(*it);
         }
     }
 
     reentry = false;
 }
 
-bool WebServer::IsSomeoneListening() const
+static bool IsSubscriber(const std::list<std::weak_ptr<HttpConnection>>& subscribers, const HttpConnection* connection)
+{
+    for (const auto& it : subscribers)
+    {
+        auto c = it.lock();
+        if (c != nullptr && c.get() == connection) return true;
+    }
+    return false;
+}
+
+void WebServer::SubscribeToStatusDeltas(HttpConnection& connection, bool subscribe)
 {
-    for (auto it : _connections)
+    auto remove = [&connection](std::list<std::weak_ptr<HttpConnection>>& subscribers)
     {
-        if (it.second->IsWebSocket())
+        subscribers.remove_if([&connection](const std::weak_ptr<HttpConnection>& it) {
+            auto c = it.lock();
+            return c == nullptr || c.get() == &connection;
+        });
+    };
+    remove(_deltaSubscribers);
+    remove(_newDeltaSubscribers);
+
+    if (subscribe)
+    {
+        // they get one full status before the deltas start
+        _newDeltaSubscribers.push_back(connection.shared_from_this());
+    }
+}
+
+wxString WebServer::BuildStatusDelta(const wxString& status)
+{
+    wxJSONValue root;
+    wxJSONReader reader;
+    if (reader.Parse(status, &root) > 0 || !root.IsObject())
+    {
+        _lastStatus.clear();
+        return "";
+    }
+
+    std::map<wxString, wxString> current;
+    wxJSONWriter writer(wxJSONWRITER_NONE);
+    auto members = root.GetMemberNames();
+    for (const auto& it : members)
+    {
+        wxString value;
+        writer.Write(root[it], value);
+        current[it] = value;
+    }
+
+    wxString delta;
+    for (const auto& it : current)
+    {
+        auto last = _lastStatus.find(it.first);
+        if (last == _lastStatus.end() || last->second != it.second)
         {
-            return true;
+            if (delta != "") delta += ",";
+            delta += "\"" + it.first + "\":" + it.second;
         }
     }
-    return false;
+    for (const auto& it : _lastStatus)
+    {
+        if (current.find(it.first) == current.end())
+        {
+            if (delta != "") delta += ",";
+            delta += "\"" + it.first + "\":null";
+        }
+    }
+
+    _lastStatus = current;
+
+    if (delta == "") return "";
+    return "{\"statusdelta\":{" + delta + "}}";
+}
+
+void WebServer::PublishStatus(const wxString& status)
+{
+    // only serve the status without asking the schedule manager when the query needs no login
+    if (__password == "")
+    {
+        SetCachedResponse(STATUS_URI, status);
+    }
+    else
+    {
+        ClearCachedResponse(STATUS_URI);
+    }
+
+    auto sockets = GetWebSockets();
+    if (sockets.empty())
+    {
+        _lastStatus.clear();
+        return;
+    }
+
+    std::list<HttpConnectionPtr> full;
+    std::list<HttpConnectionPtr> deltas;
+    for (const auto& it : sockets)
+    {
+        if (IsSubscriber(_newDeltaSubscribers, it.get()))
+        {
+            full.push_back(it);
+            _deltaSubscribers.push_back(it);
+        }
+        else if (IsSubscriber(_deltaSubscribers, it.get()))
+        {
+            deltas.push_back(it);
+        }
+        else
+        {
+            full.push_back(it);
+        }
+    }
+    _newDeltaSubscribers.clear();
+    _deltaSubscribers.remove_if([](const std::weak_ptr<HttpConnection>& it) { return it.expired(); });
+
+    WebSocketMessage wsm(status);
+    for (const auto& it : full)
+    {
+        if (it->SendMessage(wsm))
+        {
+            UpdateValid(*it);
+        }
+        else
+        {
+            RemoveFromValid(*it);
+        }
+    }
+
+    // deltas go out at most once a second
+    wxLongLong now = wxGetLocalTimeMillis();
+    if (deltas.empty() || now - _lastDeltaSent < 1000) return;
+    _lastDeltaSent = now;
+
+    wxString delta = BuildStatusDelta(status);
+    if (delta == "") return;
+
+    WebSocketMessage dwsm(delta);
+    for (const auto& it : deltas)
+    {
+        if (it->SendMessage(dwsm))
+        {
+            UpdateValid(*it);
+        }
+        else
+        {
+            RemoveFromValid(*it);
+        }
+    }
+}
+
+bool WebServer::IsSomeoneListening() const
+{
+    return HasWebSockets();
+}
+
+void WebServer::UpdateStaticContent()
+{
+    wxString wwwroot = xScheduleFrame::GetScheduleManager()->GetOptions()->GetWWWRoot();
+
+    if (__apiOnly || wwwroot == "")
+    {
+        SetStaticContent("", "");
+        return;
+    }
+
+#ifdef __WXMSW__
+    wxString d = wxFileName(wxStandardPaths::Get().GetExecutablePath()).GetPath();
+#elif __LINUX__
+    wxString d = wxStandardPaths::Get().GetDataDir();
+    if (!wxDir::Exists(d)) {
+        d = wxFileName(wxStandardPaths::Get().GetExecutablePath()).GetPath();
+    }
+#else
+    wxString d = wxStandardPaths::Get().GetResourcesDir();
+#endif
+
+    // files under the web root are served by the server thread ... the request handler only sees the rest
+    SetStaticContent("/" + wwwroot + "/", d);
 }
 
 WebServer::WebServer(int port, bool apionly, const wxString& password, int mins)
@@ -795,17 +987,22 @@ WebServer::WebServer(int port, bool apionly, const wxString& password, int mins)
         logger_base.error("Error starting web server.");
         wxMessageBox("Error starting web server. You may already have a program listening on port " + wxString::Format(wxT("%i"), port));
     }
+
+    UpdateStaticContent();
+    __webServer = this;
 }
 
 WebServer::~WebServer()
 {
     wxLogNull logNo; //kludge: avoid "error 0" message from wxWidgets after new file is written
+    if (__webServer == this) __webServer = nullptr;
     Stop();
 }
 
 void WebServer::SetAPIOnly(bool apiOnly)
 {
     __apiOnly = apiOnly;
+    UpdateStaticContent();
 }
 
 void WebServer::SetPasswordTimeout(int mins)
@@ -816,4 +1013,8 @@ void WebServer::SetPasswordTimeout(int mins)
 void WebServer::SetPassword(const wxString& password)
 {
     __password = password;
+    if (__password != "")
+    {
+        ClearCachedResponse(STATUS_URI);
+    }
 }
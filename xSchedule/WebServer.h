@@ -3,6 +3,9 @@
 
 #include "wxHTTPServer/wxhttpserver.h"
 
+#include <list>
+#include <map>
+
 class WebServer : HttpServer
 {
 
@@ -14,7 +17,18 @@ public:
         void SetPasswordTimeout(int mins);
         void SetPassword(const wxString& password);
         void SendMessageToAllWebSockets(const wxString& message);
+        void PublishStatus(const wxString& status);
         bool IsSomeoneListening() const;
+        void SubscribeToStatusDeltas(HttpConnection& connection, bool subscribe);
+
+    protected:
+        void UpdateStaticContent();
+        wxString BuildStatusDelta(const wxString& status);
+
+        std::list<std::weak_ptr<HttpConnection>> _deltaSubscribers;
+        std::list<std::weak_ptr<HttpConnection>> _newDeltaSubscribers;
+        std::map<wxString, wxString> _lastStatus;
+        wxLongLong _lastDeltaSent = 0;
 };
 
 #endif
@@ -19,144 +19,304 @@
 #include <wx/base64.h>
 #include <wx/filename.h>
 
-HttpConnection::HttpConnection(HttpServer *server, wxSocketBase *socket) :
+#include <algorithm>
+
+// This must be below the wx includes
+#ifdef __WXMSW__
+	#include <winsock2.h>
+	#define SOCKET_WOULDBLOCK() (WSAGetLastError() == WSAEWOULDBLOCK)
+	#define CLOSE_SOCKET(s) closesocket(s)
+#else
+	#include <sys/socket.h>
+	#include <unistd.h>
+	#include <errno.h>
+	#define SOCKET_WOULDBLOCK() (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	#define CLOSE_SOCKET(s) close(s)
+#endif
+
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0
+#endif
+
+#include <log4cpp/Category.hh>
+
+//#define DETAILED_LOGGING
+
+HttpConnection::HttpConnection(HttpServer *server, HttpSocket socket, const IPaddress &address) :
 	_server(server),
 	_socket(socket),
+	_address(address),
 	_isWebSocket(false),
-	_message(NULL)
+	_closed(false),
+	_awaitingResponse(false),
+	_message(nullptr),
+	_lastActivity(wxGetLocalTimeMillis()),
+	_outputPos(0),
+	_closeAfterWrite(false)
 {
-	if (!_socket->GetPeer(_address))
-		wxLogMessage(_("accepted a new connection from <unknown> (socket %d)"), socket->GetSocket());
-	else
-		wxLogMessage(_("accepted a new connection from %s:%u (socket %d)"), _address.IPAddress(), _address.Service(), socket->GetSocket());
+#ifdef DETAILED_LOGGING
+	static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+	logger_base.debug("accepted a new connection from %s:%u (socket %d)", (const char *)_address.IPAddress().c_str(), _address.Service(), (int)_socket);
+#endif
 }
 
 HttpConnection::~HttpConnection()
 {
-	wxLogMessage(_("connection closed (socket %d)"), _socket->GetSocket());
+#ifdef DETAILED_LOGGING
+	static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+	logger_base.debug("connection closed (socket %d)", (int)_socket);
+#endif
+
+	Shutdown();
+
+	if (_message)
+		delete _message;
 }
 
-bool HttpConnection::HandleRequest()
+void HttpConnection::Shutdown()
 {
-	_socket->SetFlags(wxSOCKET_NOWAIT);
+	_closed = true;
 
-	wxMemoryBuffer input;
-	char           buffer[1024];
+	if (_socket != (HttpSocket)-1)
+	{
+		CLOSE_SOCKET(_socket);
+		_socket = (HttpSocket)-1;
+	}
+}
+
+bool HttpConnection::OnReadable()
+{
+	char buffer[8192];
 
-	do
+	for (;;)
 	{
-		_socket->Read(buffer, sizeof(buffer));
-		input.AppendData(buffer, _socket->LastReadCount());
-	} while (_socket->LastReadCount() > 0);
+		int read = recv(_socket, buffer, sizeof(buffer), 0);
 
-	if (_isWebSocket)
+		if (read > 0)
+		{
+			_input.AppendData(buffer, read);
+			if (_input.GetDataLen() > _server->_context.MaxRequestSize)
+			{
+				HttpRequest request(*this);
+				HttpResponse response(*this, request, HttpStatus::RequestEntityTooLarge);
+				response.AddHeader("Connection", "close");
+				SendResponse(response);
+				_input.SetDataLen(0);
+				return true;
+			}
+		}
+		else if (read == 0)
+		{
+			// peer closed the connection
+			return false;
+		}
+		else
+		{
+			if (SOCKET_WOULDBLOCK())
+				break;
+			return false;
+		}
+	}
+
+	_lastActivity = wxGetLocalTimeMillis();
+
+	return ProcessInput();
+}
+
+bool HttpConnection::OnWritable()
+{
+	std::unique_lock<std::mutex> lock(_outputLock);
+
+	if (_outputPos >= _output.size())
+		return !_closeAfterWrite;
+
+	while (_outputPos < _output.size())
 	{
-		return ParseFrame(input);
+		int sent = send(_socket, _output.data() + _outputPos, (int)(_output.size() - _outputPos), MSG_NOSIGNAL);
+
+		if (sent > 0)
+		{
+			_outputPos += sent;
+		}
+		else if (sent < 0 && SOCKET_WOULDBLOCK())
+		{
+			return true;
+		}
+		else
+		{
+			return false;
+		}
 	}
-	else
+
+	_output.clear();
+	_outputPos = 0;
+	_lastActivity = wxGetLocalTimeMillis();
+
+	return !_closeAfterWrite;
+}
+
+bool HttpConnection::HasPendingOutput()
+{
+	std::unique_lock<std::mutex> lock(_outputLock);
+	return _outputPos < _output.size();
+}
+
+bool HttpConnection::IsIdle(wxLongLong now) const
+{
+	// websockets are kept open ... they are closed by the client
+	if (_isWebSocket || _awaitingResponse)
+		return false;
+
+	return (now - _lastActivity) > (wxLongLong)_server->_context.KeepAliveTimeout * 1000;
+}
+
+bool HttpConnection::QueueOutput(const void *data, size_t length, bool closeAfter)
+{
+	if (_closed)
+		return false;
+
 	{
-		HttpRequest request(*this, wxString((char *)input.GetData(), input.GetDataLen()));
+		std::unique_lock<std::mutex> lock(_outputLock);
+		if (_closeAfterWrite)
+			return false;
+		_output.append((const char *)data, length);
+		_closeAfterWrite = closeAfter;
+	}
 
-		if (request.Method() == "GET")
+	_server->Wake();
+	return true;
+}
+
+bool HttpConnection::ProcessInput()
+{
+	while (_input.GetDataLen() > 0 && !_closed)
+	{
+		if (_isWebSocket)
 		{
-			if (request["Upgrade"].CmpNoCase("websocket") == 0)
-			{
-				if (!request["Host"].IsEmpty() && !request["Connection"].IsEmpty() &&
-					!request["Sec-WebSocket-Key"].IsEmpty() && !request["Sec-WebSocket-Version"].IsEmpty())
-					return WebSocketHandshake(request);
-				else
-                {
-                    HttpResponse hr(*this, request, HttpStatus::BadRequest);
-					return SendResponse(hr);
-                }
-			}
-			else
-			{
-				if (_server->_context.RequestHandler)
-				{
-					if (_server->_context.RequestHandler(*this, request))
-						return true;
-				}
-
-				wxString fileName(_server->_context.DefaultDirectory);
-				fileName += wxFILE_SEP_PATH;
-
-				if (request.URI() == "/")
-				{
-					for (size_t i = 0; i < _server->_context.DefaultDocuments.Count(); i++)
-					{
-						if (wxFileName::FileExists(fileName + _server->_context.DefaultDocuments[i]))
-						{
-							fileName += _server->_context.DefaultDocuments[i];
-							break;
-						}
-					}
-				}
-				else
-					fileName += request.URI().Mid(1);
-
-				HttpResponse response(*this, request, fileName);
-
-				return SendResponse(response);
-			}
+			size_t consumed = 0;
+			if (!ParseFrame(consumed))
+				return false;
+
+			// frame is not complete yet
+			if (consumed == 0)
+				return true;
+
+			size_t remaining = _input.GetDataLen() - consumed;
+			memmove(_input.GetData(), (char *)_input.GetData() + consumed, remaining);
+			_input.SetDataLen(remaining);
 		}
 		else
 		{
-			// all others requests are routed to custom implementations
-			if (_server->_context.RequestHandler)
-			{
-				if (_server->_context.RequestHandler(*this, request))
-					return true;
-			}
+			// requests are answered in order so dont look at the next one until this one has been answered
+			if (_awaitingResponse)
+				return true;
+
+			const char *data = (const char *)_input.GetData();
+			size_t length = _input.GetDataLen();
+
+			static const char *separator = "\r\n\r\n";
+			const char *end = std::search(data, data + length, separator, separator + 4);
+			if (end == data + length)
+				return true;
+			size_t headerEnd = end - data + 4;
+
+			size_t contentLength = 0;
+			std::string lower(data, headerEnd);
+			std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+			size_t cl = lower.find("\r\ncontent-length:");
+			if (cl != std::string::npos)
+				contentLength = strtoul(lower.c_str() + cl + 17, nullptr, 10);
+
+			if (headerEnd + contentLength > length)
+				return true;
+
+			HttpRequest request(*this, wxString(data, headerEnd + contentLength));
+
+			size_t remaining = length - headerEnd - contentLength;
+			memmove(_input.GetData(), (char *)_input.GetData() + headerEnd + contentLength, remaining);
+			_input.SetDataLen(remaining);
+
+			if (!ProcessRequest(request))
+				return false;
 		}
 	}
 
-	return false;
+	return true;
+}
+
+bool HttpConnection::ProcessRequest(HttpRequest &request)
+{
+	if (request.Method() == "GET" && request["Upgrade"].CmpNoCase("websocket") == 0)
+	{
+		if (!request["Host"].IsEmpty() && !request["Connection"].IsEmpty() &&
+			!request["Sec-WebSocket-Key"].IsEmpty() && !request["Sec-WebSocket-Version"].IsEmpty())
+			return WebSocketHandshake(request);
+		else
+		{
+			HttpResponse hr(*this, request, HttpStatus::BadRequest);
+			return SendResponse(hr);
+		}
+	}
+
+	if (request.Method() == "GET")
+	{
+		if (_server->TryServeCached(*this, request))
+			return true;
+
+		if (_server->TryServeStatic(*this, request))
+			return true;
+	}
+
+	// everything else needs the application
+	_awaitingResponse = true;
+	_server->DispatchRequest(*this, request);
+
+	return true;
 }
 
 bool HttpConnection::SendResponse(HttpResponse &response)
 {
-    _socket->SetFlags(wxSOCKET_WAITALL);
-	wxString row = wxString::Format("%s %d %s\r\n", response.Version(), response.Status().Code(), response.Status().Description());
-	_socket->Write(row.ToAscii(), row.Length());
-    if (_socket->Error()) {
-        _socket->SetFlags(wxSOCKET_NOWAIT);
-        return false;
-    }
+	bool hasLength = !response[wxString("Content-Length")].IsEmpty();
+	bool hasConnection = !response[wxString("Connection")].IsEmpty();
+	bool switching = response.Status().Code() == HttpStatus::SwitchingProtocols;
+	bool keepAlive = switching || (response._request.KeepAlive() && response[wxString("Connection")].CmpNoCase("close") != 0);
+
+	wxString head = wxString::Format("%s %d %s\r\n", response.Version(), response.Status().Code(), response.Status().Description());
 
 	for (size_t i = 0; i < response.Headers().Count(); i++)
 	{
-		wxString header = response[i];
-		_socket->Write(header.ToAscii(), header.Length());
-        if (_socket->Error()) {
-            _socket->SetFlags(wxSOCKET_NOWAIT);
-            return false;
-        }
+		head += response[i];
 	}
 
-	_socket->Write("\r\n", 2);
-    if (_socket->Error()) {
-        _socket->SetFlags(wxSOCKET_NOWAIT);
-        return false;
-    }
-    
+	// with keep-alive the client needs to know where the response ends
+	if (!switching)
+	{
+		if (!hasLength)
+			head += wxString::Format("Content-Length: %zu\r\n", response._content.GetDataLen());
+		if (!hasConnection)
+			head += wxString::Format("Connection: %s\r\n", keepAlive ? "keep-alive" : "close");
+	}
+
+	head += "\r\n";
+
+	std::string out(head.ToAscii());
 	if (!response._content.IsEmpty())
+		out.append((const char *)response._content.GetData(), response._content.GetDataLen());
+
+	bool res = QueueOutput(out.data(), out.size(), !keepAlive);
+
+	// let the server thread move on to the next request on this connection
+	if (_awaitingResponse)
 	{
-		_socket->Write(response._content.GetData(), response._content.GetDataLen());
-        if (_socket->Error()) {
-            _socket->SetFlags(wxSOCKET_NOWAIT);
-            return false;
-        }
+		_awaitingResponse = false;
+		_server->Wake();
 	}
 
-    _socket->SetFlags(wxSOCKET_NOWAIT);
-	return true;
+	return res;
 }
 
 bool HttpConnection::SendMessage(WebSocketMessage &message)
 {
-    // As we are just writing dont set it to wait
-    //_socket->SetFlags(wxSOCKET_WAITALL);
 	wxMemoryBuffer header;
 
 	header.AppendByte((wxUint8)0x80 | message._type); // final + type
@@ -165,11 +325,13 @@ bool HttpConnection::SendMessage(WebSocketMessage &message)
 	{
 		wxUint64 tmp = message._content.GetDataLen();
 		header.AppendByte(127);
+		wxUint8 length[8];
 		for (int i = 7; i >= 0; i--)
 		{
-			header.AppendByte((wxUint8)(tmp & 0x0FF));
+			length[i] = (wxUint8)(tmp & 0x0FF);
 			tmp = tmp / 0x100;
 		}
+		header.AppendData(length, sizeof(length));
 	}
 	else if (message._content.GetDataLen() > 125)
 	{
@@ -182,122 +344,120 @@ bool HttpConnection::SendMessage(WebSocketMessage &message)
 		header.AppendByte((wxUint8) message._content.GetDataLen());
 	}
 
-	_socket->Write(header.GetData(), header.GetDataLen());
-    if (_socket->Error())
-    {
-        _socket->SetFlags(wxSOCKET_NOWAIT);
-        return false;
-    }
-
+	std::string out((const char *)header.GetData(), header.GetDataLen());
 	if (!message._content.IsEmpty())
-		_socket->Write(message._content.GetData(), message._content.GetDataLen());
+		out.append((const char *)message._content.GetData(), message._content.GetDataLen());
 
-    _socket->SetFlags(wxSOCKET_NOWAIT);
-    return !_socket->Error();
+	return QueueOutput(out.data(), out.size(), message._type == WebSocketMessage::Close);
 }
 
 bool HttpConnection::Close()
 {
-	wxASSERT(_socket);
+	if (_closed)
+		return false;
 
-	bool result = _socket->Close();
-	_socket = NULL;
+	_closed = true;
+	_server->Wake();
 
-	return result;
+	return true;
 }
 
-bool HttpConnection::ParseFrame(wxMemoryBuffer &buffer)
+bool HttpConnection::ParseFrame(size_t &consumed)
 {
-	if (buffer.GetDataLen() < 2)
+	const wxUint8 *buffer = (const wxUint8 *)_input.GetData();
+	size_t available = _input.GetDataLen();
+
+	consumed = 0;
+
+	if (available < 2)
+		return true;
+
+	bool final = buffer[0] & 0x80 ? true : false;
+
+	if (((buffer[0] & 0x40) != 0) || ((buffer[0] & 0x20) != 0) || ((buffer[0] & 0x10) != 0))
+	{
+		static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+		logger_base.warn("Web socket reserved bits must be 0.");
+		return false; // Invalid ws message
+	}
+
+	WebSocketMessage::Opcode type = (WebSocketMessage::Opcode)(buffer[0] & 0x0F);
+
+	wxUint64 length = buffer[1] & 0x7F;
+	size_t   start = 2;
+	wxUint8  mask[4] = { 0 };
+
+	if (length == 126)
+	{
+		if (available < 4)
+			return true;
+		length = (((wxUint64)buffer[2]) << 8) + buffer[3];
+		start = 4;
+	}
+	else if (length == 127)
+	{
+		if (available < 10)
+			return true;
+		length = 0;
+		for (int i = 0; i < 8; i++)
+			length = length * 0x100 + buffer[2 + i];
+		start = 10;
+	}
+
+	if (buffer[1] & 128)
+	{
+		if (available < start + 4)
+			return true;
+		memcpy(mask, &buffer[start], 4);
+		start += 4;
+	}
+
+	if (length > _server->_context.MaxRequestSize)
 		return false;
 
-    bool done = false;
-    int pos = 0;
+	// wait for the rest of the frame
+	if (available < start + length)
+		return true;
 
-    while (!done)
-    {
-        bool final = buffer[pos + 0] & 0x80 ? true : false;
-
-        if (((buffer[pos + 0] & 0x40) != 0) || ((buffer[pos + 0] & 0x20) != 0) || ((buffer[pos + 0] & 0x10) != 0))
-        {
-            wxLogWarning("reserved bits must be 0");
-            return false; // Invalid ws message
-        }
-
-        WebSocketMessage::Opcode type = (WebSocketMessage::Opcode)(buffer[pos + 0] & 0x0F);
-
-        if (!_message)
-            _message = new WebSocketMessage(type);
-
-        //ws_conn->close  = ((buffer[0] & 0x0F) == 0x08);
-        //ws_conn->ping   = ((buffer[0] & 0x0F) == 0x09);
-        //ws_conn->pong   = ((buffer[0] & 0x0F) == 0x0A);
-
-        if (type == WebSocketMessage::Ping)
-            wxLogMessage("received a PING message");
-
-        if (type == WebSocketMessage::Pong)
-            wxLogMessage("received a PONG message");
-
-        int length = buffer[pos + 1] & 0x7F;
-        int     start = 2;
-        wxUint8 mask[4] = { 0 };
-
-        if (length == 126)
-        {
-            length = ((((int)buffer[pos + 2]) << 8) + buffer[pos + 3]);
-            start = 4;
-        }
-        else if (length == 127)
-        {
-            length = 0;
-            for (int i = 0; i < 8; i++)
-                length = (wxUint64)length * 0x100 + buffer[pos + 2 + i];
-            start = 10;
-        }
-
-        if (buffer[pos + 1] & 128)
-        {
-            memcpy(mask, &(buffer[pos + start]), 4);
-            start += 4;
-        }
-
-        for (int i = 0; i < length; i++)
-            _message->_content.AppendByte(buffer[pos + start + i] ^ mask[i % 4]);
-
-        if (final && _server->_context.MessageHandler)
-        {
-            _server->_context.MessageHandler(*this, *_message);
-
-            switch (_message->_type)
-            {
-            case WebSocketMessage::Ping:
-            {
-                WebSocketMessage wsm(WebSocketMessage::Pong);
-                SendMessage(wsm);
-            }
-            break;
-            case WebSocketMessage::Close:
-            {
-                WebSocketMessage wsm(WebSocketMessage::Close);
-                SendMessage(wsm);
-            }
-            break;
-            default:
-            break;
-            }
-
-            delete _message;
-            _message = nullptr;
-        }
-
-        pos += start + length;
-
-        if (pos >= buffer.GetDataLen())
-        {
-            done = true;
-        }
-    }
+	if (!_message)
+		_message = new WebSocketMessage(type);
+
+	for (size_t i = 0; i < length; i++)
+		_message->_content.AppendByte(buffer[start + i] ^ mask[i % 4]);
+
+	consumed = start + (size_t)length;
+
+	if (final)
+	{
+		switch (_message->_type)
+		{
+		case WebSocketMessage::Ping:
+		{
+			WebSocketMessage wsm(WebSocketMessage::Pong);
+			wsm._content.AppendData(_message->_content.GetData(), _message->_content.GetDataLen());
+			SendMessage(wsm);
+			delete _message;
+		}
+		break;
+		case WebSocketMessage::Pong:
+			delete _message;
+			break;
+		case WebSocketMessage::Close:
+		{
+			WebSocketMessage wsm(WebSocketMessage::Close);
+			SendMessage(wsm);
+			// the application is still told about the close
+			_server->DispatchMessage(*this, _message);
+		}
+		break;
+		default:
+			// ownership passes to the main thread
+			_server->DispatchMessage(*this, _message);
+			break;
+		}
+
+		_message = nullptr;
+	}
 
 	return true;
 }
@@ -27,6 +27,12 @@ HttpContext::HttpContext() :
 	// default HTTP port
 	Port = 80;
 
+	// idle keep-alive connections are dropped after this many seconds
+	KeepAliveTimeout = 60;
+
+	// requests bigger than this are refused
+	MaxRequestSize = 16 * 1024 * 1024;
+
 	// default directory is cwd
 	DefaultDirectory = wxFileName::GetCwd();
 
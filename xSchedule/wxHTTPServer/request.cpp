@@ -41,8 +41,6 @@ void HttpRequest::Parse(const wxString &input)
 		if (tokens.Count() > 2)
 			_version = tokens[2].Trim(true).Trim(false);
 
-		wxLogMessage("new request: Method '%s', URI '%s', Version '%s'", _method, _uri, _version);
-
         int state = 0; // processing headers
 
 		for (size_t i = 1; i < rows.Count(); i++)
@@ -74,3 +72,19 @@ void HttpRequest::Parse(const wxString &input)
 		}
 	}
 }
+
+bool HttpRequest::KeepAlive() const
+{
+	wxString connection = _headers["Connection"].Lower();
+
+	// HTTP/1.1 is persistent unless the client says otherwise, HTTP/1.0 only if it asks
+	if (_version.CmpNoCase("HTTP/1.1") == 0)
+		return !connection.Contains("close");
+
+	return connection.Contains("keep-alive");
+}
+
+bool HttpRequest::AcceptsGzip() const
+{
+	return _headers["Accept-Encoding"].Lower().Contains("gzip");
+}
@@ -17,6 +17,150 @@
 #include <wx/filename.h>
 #include <wx/mimetype.h>
 #include <wx/wfstream.h>
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+
+// Static files are served from memory. The cache is shared by the server thread and the main thread and is
+// keyed on the file name; an entry is reloaded when the file modification time or size changes.
+#define FILE_CACHE_MAX_FILE_SIZE (4 * 1024 * 1024)
+#define FILE_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+struct CachedFile
+{
+	wxDateTime  modified;
+	wxULongLong size;
+	std::string content;
+	std::string gzipped;
+	wxString    mimeType;
+	bool        compressible = false;
+};
+
+static std::mutex __fileCacheLock;
+static std::map<wxString, std::shared_ptr<CachedFile>> __fileCache;
+static size_t __fileCacheSize = 0;
+
+static wxString GetMimeType(const wxString &fileName, bool &compressible)
+{
+	static const std::map<wxString, std::pair<const char *, bool>> knownTypes =
+	{
+		{ "html", { "text/html", true } },
+		{ "htm", { "text/html", true } },
+		{ "css", { "text/css", true } },
+		{ "js", { "application/javascript", true } },
+		{ "json", { "application/json", true } },
+		{ "txt", { "text/plain", true } },
+		{ "xml", { "text/xml", true } },
+		{ "svg", { "image/svg+xml", true } },
+		{ "map", { "application/json", true } },
+		{ "png", { "image/png", false } },
+		{ "jpg", { "image/jpeg", false } },
+		{ "jpeg", { "image/jpeg", false } },
+		{ "gif", { "image/gif", false } },
+		{ "ico", { "image/x-icon", false } },
+		{ "woff", { "font/woff", false } },
+		{ "woff2", { "font/woff2", false } },
+		{ "ttf", { "font/ttf", true } },
+		{ "eot", { "application/vnd.ms-fontobject", true } },
+		{ "mp3", { "audio/mpeg", false } },
+		{ "mp4", { "video/mp4", false } }
+	};
+
+	wxString ext = wxFileName(fileName).GetExt().Lower();
+	auto it = knownTypes.find(ext);
+	if (it != knownTypes.end())
+	{
+		compressible = it->second.second;
+		return it->second.first;
+	}
+
+	compressible = false;
+	wxString mimeType("text/plain");
+
+	// the mime types manager is not safe to use off the main thread
+	if (wxThread::IsMain())
+	{
+		wxFileType *fileType = wxTheMimeTypesManager->GetFileTypeFromExtension(ext);
+		if (fileType)
+		{
+			fileType->GetMimeType(&mimeType);
+			delete fileType;
+		}
+	}
+
+	return mimeType;
+}
+
+// Static files are compressed once when cached so they get the best level. Dynamic responses are
+// compressed on every request so they use the much cheaper default.
+static std::string Gzip(const void *data, size_t length, int level = wxZ_DEFAULT_COMPRESSION)
+{
+	wxMemoryOutputStream mos;
+	{
+		wxZlibOutputStream zos(mos, level, wxZLIB_GZIP);
+		zos.Write(data, length);
+		zos.Close();
+	}
+
+	std::string result;
+	result.resize(mos.GetSize());
+	mos.CopyTo(&result[0], result.size());
+	return result;
+}
+
+static std::shared_ptr<CachedFile> LoadFile(const wxString &fileName)
+{
+	wxFileName fn(fileName);
+	wxDateTime modified = fn.GetModificationTime();
+	wxULongLong size = fn.GetSize();
+
+	{
+		std::unique_lock<std::mutex> lock(__fileCacheLock);
+		auto it = __fileCache.find(fileName);
+		if (it != __fileCache.end())
+		{
+			if (it->second->modified == modified && it->second->size == size)
+				return it->second;
+
+			__fileCacheSize -= it->second->content.size() + it->second->gzipped.size();
+			__fileCache.erase(it);
+		}
+	}
+
+	wxFileInputStream stream(fileName);
+	if (!stream.IsOk())
+		return nullptr;
+
+	auto file = std::make_shared<CachedFile>();
+	file->modified = modified;
+	file->size = size;
+	file->mimeType = GetMimeType(fileName, file->compressible);
+
+	unsigned char buffer[8192];
+	do
+	{
+		stream.Read(buffer, sizeof(buffer));
+		file->content.append((const char *)buffer, stream.LastRead());
+	} while (stream.LastRead());
+
+	if (file->compressible && file->content.size() > 256)
+		file->gzipped = Gzip(file->content.data(), file->content.size(), wxZ_BEST_COMPRESSION);
+
+	if (file->content.size() <= FILE_CACHE_MAX_FILE_SIZE)
+	{
+		std::unique_lock<std::mutex> lock(__fileCacheLock);
+
+		// crude but bounded ... when the cache is full just start again
+		if (__fileCacheSize + file->content.size() + file->gzipped.size() > FILE_CACHE_MAX_SIZE)
+		{
+			__fileCache.clear();
+			__fileCacheSize = 0;
+		}
+		__fileCache[fileName] = file;
+		__fileCacheSize += file->content.size() + file->gzipped.size();
+	}
+
+	return file;
+}
 
 HttpResponse::HttpResponse(HttpConnection &connection, HttpRequest &request, HttpStatus::HttpStatusCode code /*= HttpStatus::NotFound*/) :
 	_connection(connection),
@@ -36,46 +180,45 @@ HttpResponse::HttpResponse(HttpConnection &connection, HttpRequest &request, con
 	MakeFromFile(fileName, charset);
 }
 
+void HttpResponse::AddStandardHeaders(const wxString &contentType)
+{
+	_headers.Add("Date", wxDateTime::Now().Format("%a, %d %b %Y %H:%M:%S GMT", wxDateTime::GMT0));
+	_headers.Add("Server", wxString::Format(SERVER_NAME "(" SERVER_VERSION ") (%s)", wxGetOsDescription()));
+	_headers.Add("Vary", "Accept-Encoding,Cookie");
+	_headers.Add("Cache-Control", "private, s-maxage=0, max-age=0, must-revalidate");
+	_headers.Add("Content-Type", contentType);
+	_headers.Add("Content-Length", wxString::Format("%zu", _content.GetDataLen()));
+	_headers.Add("Content-Language", "it");
+	_headers.Add("Connection", _request.KeepAlive() ? "keep-alive" : "close");
+}
+
 void HttpResponse::MakeFromFile(const wxString &fileName, const wxString &charset /*= wxEmptyString*/)
 {
 	if (!wxFileName::FileExists(fileName))
 		MakeFromCode(HttpStatus::NotFound);
 	else
 	{
-		wxFileInputStream stream(fileName);
+		auto file = LoadFile(fileName);
 
-		if (!stream.IsOk())
+		if (file == nullptr)
 			MakeFromCode(HttpStatus::BadRequest);
 		else
 		{
-			unsigned char buffer[1024];
+			wxString contentType = file->mimeType + (charset.IsEmpty() ? "" : ("; " + charset));
 
-			do
+			if (!file->gzipped.empty() && _request.AcceptsGzip())
 			{
-				stream.Read(buffer, sizeof(buffer));
-				_content.AppendData(buffer, stream.LastRead());
-			} while (stream.LastRead());
-
-			wxFileType *fileType = wxTheMimeTypesManager->GetFileTypeFromExtension(wxFileName(fileName).GetExt());
-			wxString    mimeType("text/plain");
-
-			if (fileType)
+				_content.AppendData(file->gzipped.data(), file->gzipped.size());
+				_headers.Add("Content-Encoding", "gzip");
+			}
+			else
 			{
-				fileType->GetMimeType(&mimeType);
-				delete fileType;
+				_content.AppendData(file->content.data(), file->content.size());
 			}
 
-			_headers.Add("Date", wxDateTime::Now().Format("%a, %d %b %Y %H:%M:%S GMT", wxDateTime::GMT0));
-			_headers.Add("Server", wxString::Format(SERVER_NAME "(" SERVER_VERSION ") (%s)", wxGetOsDescription()));
-			_headers.Add("Vary", "Accept-Encoding,Cookie");
-			_headers.Add("Cache-Control", "private, s-maxage=0, max-age=0, must-revalidate");
-			_headers.Add("Content-Type", mimeType + (charset.IsEmpty() ? "" : ("; " + charset)));
-			_headers.Add("Content-Length", wxString::Format("%zu", _content.GetDataLen()));
-			_headers.Add("Content-Language", "it");
-			_headers.Add("Connection", "close");
+			AddStandardHeaders(contentType);
 		}
 	}
-
 }
 
 void HttpResponse::MakeFromText(const wxString &text, const wxString &mimeType /*= "text/html"*/)
@@ -84,14 +227,23 @@ void HttpResponse::MakeFromText(const wxString &text, const wxString &mimeType /
 
 	_content.AppendData(buffer.data(), buffer.length());
 
-	_headers.Add("Date", wxDateTime::Now().Format("%a, %d %b %Y %H:%M:%S GMT", wxDateTime::GMT0));
-	_headers.Add("Server", wxString::Format(SERVER_NAME "(" SERVER_VERSION ") (%s)", wxGetOsDescription()));
-	_headers.Add("Vary", "Accept-Encoding,Cookie");
-	_headers.Add("Cache-Control", "private, s-maxage=0, max-age=0, must-revalidate");
-	_headers.Add("Content-Type", mimeType + "; utf-8");
-	_headers.Add("Content-Length", wxString::Format("%zu", _content.GetDataLen()));
-	_headers.Add("Content-Language", "it");
-	_headers.Add("Connection", "close");
+	AddStandardHeaders(mimeType + "; utf-8");
+}
+
+void HttpResponse::MakeFromData(const void *data, size_t length, const wxString &mimeType, bool compressible)
+{
+	if (compressible && length > 256 && _request.AcceptsGzip())
+	{
+		std::string gzipped = Gzip(data, length);
+		_content.AppendData(gzipped.data(), gzipped.size());
+		_headers.Add("Content-Encoding", "gzip");
+	}
+	else
+	{
+		_content.AppendData(data, length);
+	}
+
+	AddStandardHeaders(mimeType);
 }
 
 void HttpResponse::MakeFromCode(HttpStatus::HttpStatusCode code /*= HttpStatus::NotFound*/)
@@ -15,22 +15,196 @@
 #include "wxhttpserver.h"
 #include <log4cpp/Category.hh>
 
-//#define DETAILED_LOGGING
+#include <wx/filename.h>
+#include <wx/uri.h>
+
+#include <vector>
+
+// This must be below the wx includes
+#ifdef __WXMSW__
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	typedef int socklen_t;
+	#define INVALID_HTTPSOCKET ((HttpSocket)INVALID_SOCKET)
+	#define CLOSE_SOCKET(s) closesocket(s)
+	#define poll WSAPoll
+#else
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <arpa/inet.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <errno.h>
+	#ifdef __linux__
+		#include <sys/epoll.h>
+		#include <sys/eventfd.h>
+	#else
+		#include <poll.h>
+	#endif
+	#define INVALID_HTTPSOCKET ((HttpSocket)-1)
+	#define CLOSE_SOCKET(s) close(s)
+#endif
 
-#define SERVER_ID	100
-#define SOCKET_ID	101
+//#define DETAILED_LOGGING
 
 #include <wx/arrimpl.cpp>
 //WX_DEFINE_EXPORTED_OBJARRAY(HeadersCollection);
 WX_DEFINE_OBJARRAY(HeadersCollection)
 
-BEGIN_EVENT_TABLE(HttpServer, wxEvtHandler)
-	EVT_SOCKET(SERVER_ID, HttpServer::OnServerEvent)
-	EVT_SOCKET(SOCKET_ID, HttpServer::OnSocketEvent)
-END_EVENT_TABLE()
+static bool SetNonBlocking(HttpSocket socket)
+{
+#ifdef __WXMSW__
+	u_long mode = 1;
+	return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+	int flags = fcntl(socket, F_GETFL, 0);
+	return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+// Waits for socket readiness ... epoll on linux, poll (WSAPoll on windows) everywhere else
+class HttpPoller
+{
+public:
+	struct Event
+	{
+		HttpSocket socket;
+		bool       readable;
+		bool       writable;
+		bool       error;
+	};
+
+	HttpPoller()
+	{
+#ifdef __linux__
+		_epoll = epoll_create1(EPOLL_CLOEXEC);
+#endif
+	}
+
+	~HttpPoller()
+	{
+#ifdef __linux__
+		if (_epoll != -1)
+			close(_epoll);
+#endif
+	}
+
+	bool IsOk() const
+	{
+#ifdef __linux__
+		return _epoll != -1;
+#else
+		return true;
+#endif
+	}
+
+	void Add(HttpSocket socket)
+	{
+		_writeInterest[socket] = false;
+#ifdef __linux__
+		epoll_event ev = { 0 };
+		ev.events = EPOLLIN | EPOLLRDHUP;
+		ev.data.fd = socket;
+		epoll_ctl(_epoll, EPOLL_CTL_ADD, socket, &ev);
+#endif
+	}
+
+	void Remove(HttpSocket socket)
+	{
+		_writeInterest.erase(socket);
+#ifdef __linux__
+		epoll_event ev = { 0 };
+		epoll_ctl(_epoll, EPOLL_CTL_DEL, socket, &ev);
+#endif
+	}
+
+	void SetWriteInterest(HttpSocket socket, bool write)
+	{
+		auto it = _writeInterest.find(socket);
+		if (it == _writeInterest.end() || it->second == write)
+			return;
+		it->second = write;
+#ifdef __linux__
+		epoll_event ev = { 0 };
+		ev.events = EPOLLIN | EPOLLRDHUP | (write ? EPOLLOUT : 0);
+		ev.data.fd = socket;
+		epoll_ctl(_epoll, EPOLL_CTL_MOD, socket, &ev);
+#endif
+	}
+
+	void Wait(int timeoutMS, std::vector<Event> &events)
+	{
+		events.clear();
+
+#ifdef __linux__
+		epoll_event ready[64];
+		int count = epoll_wait(_epoll, ready, sizeof(ready) / sizeof(ready[0]), timeoutMS);
+		for (int i = 0; i < count; i++)
+		{
+			Event e;
+			e.socket = ready[i].data.fd;
+			e.readable = (ready[i].events & (EPOLLIN | EPOLLRDHUP)) != 0;
+			e.writable = (ready[i].events & EPOLLOUT) != 0;
+			e.error = (ready[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+			events.push_back(e);
+		}
+#else
+		_fds.clear();
+		for (const auto &it : _writeInterest)
+		{
+			pollfd fd;
+			fd.fd = it.first;
+			fd.events = POLLIN | (it.second ? POLLOUT : 0);
+			fd.revents = 0;
+			_fds.push_back(fd);
+		}
+
+		int count = poll(_fds.data(), (unsigned long)_fds.size(), timeoutMS);
+		for (size_t i = 0; count > 0 && i < _fds.size(); i++)
+		{
+			if (_fds[i].revents == 0)
+				continue;
+
+			Event e;
+			e.socket = _fds[i].fd;
+			e.readable = (_fds[i].revents & POLLIN) != 0;
+			e.writable = (_fds[i].revents & POLLOUT) != 0;
+			e.error = (_fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+			events.push_back(e);
+		}
+#endif
+	}
+
+private:
+	std::map<HttpSocket, bool> _writeInterest;
+#ifdef __linux__
+	int _epoll;
+#else
+	std::vector<pollfd> _fds;
+#endif
+};
+
+class HttpServerThread : public wxThread
+{
+	HttpServer *_server;
+
+public:
+	HttpServerThread(HttpServer *server) : wxThread(wxTHREAD_JOINABLE), _server(server) { }
+
+	virtual void *Entry() override
+	{
+		_server->Run();
+		return nullptr;
+	}
+};
 
 HttpServer::HttpServer() :
-	_server(NULL)
+	_server(INVALID_HTTPSOCKET),
+	_wakeSocket(INVALID_HTTPSOCKET),
+	_thread(nullptr),
+	_poller(nullptr),
+	_stop(false)
 {
 }
 
@@ -42,9 +216,8 @@ HttpServer::~HttpServer()
 bool HttpServer::Start(const HttpContext &context)
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    wxASSERT(!_server || (_server && _server->IsClosed()));
 
-	if (_server && _server->IsConnected())
+	if (_thread)
 		Stop();
 
 	_context = context;
@@ -55,54 +228,137 @@ bool HttpServer::Start(const HttpContext &context)
 	wxLogMessage(_("starting server on %s:%u..."), _address.IPAddress(), _address.Service());
     logger_base.info("starting server on %s:%u...", (const char *)_address.IPAddress().c_str(), _address.Service());
 
-	// Create the socket
-	_server = new wxSocketServer(_address, wxSOCKET_REUSEADDR);
+	// makes sure the platform socket library is started
+	wxSocketBase::Initialize();
 
-	// We use IsOk() here to see if the server is really listening
-    if (!_server->IsOk())
-    {
+	_server = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+#ifndef __WXMSW__
+	int reuse = 1;
+	setsockopt(_server, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+#endif
+
+	sockaddr_in addr;
+	memset(&addr, 0x00, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(_context.Port);
+
+	if (_server == INVALID_HTTPSOCKET ||
+		bind(_server, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+		listen(_server, SOMAXCONN) != 0 ||
+		!SetNonBlocking(_server))
+	{
         wxLogError(_("unable to start the server on the specified port"));
         logger_base.error(_("unable to start the server on the specified port"));
-    }
-	else
+		if (_server != INVALID_HTTPSOCKET)
+		{
+			CLOSE_SOCKET(_server);
+			_server = INVALID_HTTPSOCKET;
+		}
+		return false;
+	}
+
+	// the server thread sleeps in the poller ... this lets other threads wake it when there is output to send
+#ifdef __linux__
+	_wakeSocket = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+	_wakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (_wakeSocket != INVALID_HTTPSOCKET)
 	{
-		IPaddress address;
-        if (!_server->GetLocal(address))
-        {
-            wxLogError(_("unable to retrieve the address to which you are connected"));
-            logger_base.error(_("unable to retrieve the address to which you are connected"));
-        }
-        else
-        {
-            wxLogMessage(_("server running on %s:%u"), address.IPAddress(), address.Service());
-            logger_base.info("server running on %s:%u", (const char *)address.IPAddress().c_str(), address.Service());
-        }
+		sockaddr_in wake;
+		memset(&wake, 0x00, sizeof(wake));
+		wake.sin_family = AF_INET;
+		wake.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		wake.sin_port = 0;
+		socklen_t wakeLen = sizeof(wake);
+		if (bind(_wakeSocket, (sockaddr *)&wake, sizeof(wake)) != 0 ||
+			getsockname(_wakeSocket, (sockaddr *)&wake, &wakeLen) != 0 ||
+			connect(_wakeSocket, (sockaddr *)&wake, sizeof(wake)) != 0)
+		{
+			CLOSE_SOCKET(_wakeSocket);
+			_wakeSocket = INVALID_HTTPSOCKET;
+		}
+		else
+		{
+			SetNonBlocking(_wakeSocket);
+		}
+	}
+#endif
+
+	_poller = new HttpPoller();
+	if (!_poller->IsOk())
+	{
+		logger_base.error("unable to create the web server poller");
+		delete _poller;
+		_poller = nullptr;
+		CLOSE_SOCKET(_server);
+		_server = INVALID_HTTPSOCKET;
+		return false;
+	}
+
+	_poller->Add(_server);
+	if (_wakeSocket != INVALID_HTTPSOCKET)
+		_poller->Add(_wakeSocket);
+	else
+		logger_base.warn("web server wake socket could not be created ... responses will be delayed");
+
+	wxLogMessage(_("server running on %s:%u"), _address.IPAddress(), _address.Service());
+	logger_base.info("server running on %s:%u", (const char *)_address.IPAddress().c_str(), _address.Service());
 
-		// Setup the event handler and subscribe to connection events
-		_server->SetEventHandler(*this, SERVER_ID);
-		_server->SetNotify(wxSOCKET_CONNECTION_FLAG);
-		_server->Notify(true);
+	_stop = false;
+	_thread = new HttpServerThread(this);
+	if (_thread->Run() != wxTHREAD_NO_ERROR)
+	{
+		logger_base.error("Failed to start web server thread.");
+		delete _thread;
+		_thread = nullptr;
+		Stop();
+		return false;
 	}
 
-	return _server->IsOk();
+	return true;
 }
 
 bool HttpServer::Stop()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    
-    if (!_server) return false;
+
+    if (_server == INVALID_HTTPSOCKET) return false;
+
+	if (_thread)
+	{
+		_stop = true;
+		Wake();
+		_thread->Wait();
+		delete _thread;
+		_thread = nullptr;
+	}
 
     // close all open connections
-    for (auto it = _connections.begin(); it != _connections.end(); ++it)
-    {
-        it->second->Close();
-    }
+	{
+		std::unique_lock<std::mutex> lock(_connectionsLock);
+		for (auto it = _connections.begin(); it != _connections.end(); ++it)
+		{
+			it->second->Shutdown();
+		}
+		_connections.clear();
+	}
+
+	if (_wakeSocket != INVALID_HTTPSOCKET)
+	{
+		CLOSE_SOCKET(_wakeSocket);
+		_wakeSocket = INVALID_HTTPSOCKET;
+	}
 
-    _server->Notify(false);
-	_server->Close();
-	delete _server;
-    _server = nullptr;
+	CLOSE_SOCKET(_server);
+	_server = INVALID_HTTPSOCKET;
+
+	if (_poller)
+	{
+		delete _poller;
+		_poller = nullptr;
+	}
 
 	wxLogMessage(_("closed server on %s:%u"), _address.IPAddress(), _address.Service());
     logger_base.debug("closed server on %s:%u", (const char*)_address.IPAddress().c_str(), _address.Service());
@@ -110,127 +366,364 @@ bool HttpServer::Stop()
 	return true;
 }
 
-void HttpServer::OnServerEvent(wxSocketEvent& event)
+void HttpServer::Wake()
 {
-    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    wxStopWatch sw;
+	if (_wakeSocket == INVALID_HTTPSOCKET) return;
 
-    switch (event.GetSocketEvent())
-    {
-    case wxSOCKET_CONNECTION:
-#ifdef DETAILED_LOGGING
-        logger_base.info("OnServerEvent: wxSOCKET_CONNECTION");
+#ifdef __linux__
+	uint64_t one = 1;
+	if (write(_wakeSocket, &one, sizeof(one)) < 0)
+	{
+		// counter is already signalled
+	}
+#else
+	char one = 1;
+	send(_wakeSocket, &one, 1, 0);
 #endif
-        break;
-    default:
-#ifdef DETAILED_LOGGING
-        logger_base.info("OnServerEvent: unexpected event %d", event.GetSocketEvent());
+}
+
+void HttpServer::SetStaticContent(const wxString &uriPrefix, const wxString &directory)
+{
+	std::unique_lock<std::mutex> lock(_contentLock);
+	_staticPrefix = uriPrefix;
+	_staticDirectory = directory;
+}
+
+void HttpServer::SetCachedResponse(const wxString &uri, const wxString &content, const wxString &mimeType)
+{
+	wxScopedCharBuffer buffer = content.ToUTF8();
+
+	std::unique_lock<std::mutex> lock(_contentLock);
+	_cachedResponses[uri.Lower()] = { std::string(buffer.data(), buffer.length()), mimeType };
+}
+
+void HttpServer::ClearCachedResponse(const wxString &uri)
+{
+	std::unique_lock<std::mutex> lock(_contentLock);
+	_cachedResponses.erase(uri.Lower());
+}
+
+std::list<HttpConnectionPtr> HttpServer::GetWebSockets() const
+{
+	std::list<HttpConnectionPtr> res;
+
+	std::unique_lock<std::mutex> lock(_connectionsLock);
+	for (const auto &it : _connections)
+	{
+		if (it.second->IsWebSocket() && it.second->IsOpen())
+			res.push_back(it.second);
+	}
+
+	return res;
+}
+
+bool HttpServer::HasWebSockets() const
+{
+	std::unique_lock<std::mutex> lock(_connectionsLock);
+	for (const auto &it : _connections)
+	{
+		if (it.second->IsWebSocket() && it.second->IsOpen())
+			return true;
+	}
+
+	return false;
+}
+
+bool HttpServer::Accept()
+{
+	sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+
+	HttpSocket socket = accept(_server, (sockaddr *)&addr, &len);
+	if (socket == INVALID_HTTPSOCKET)
+		return false;
+
+	SetNonBlocking(socket);
+
+	int nodelay = 1;
+	setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+#ifdef SO_NOSIGPIPE
+	int nosigpipe = 1;
+	setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, (const char *)&nosigpipe, sizeof(nosigpipe));
 #endif
-        break;
-    }
 
-    // Accept new connection if there is one in the pending connections queue, else exit. We use Accept(false) for
-    // non-blocking accept (although if we got here, there should ALWAYS be a pending connection).
-    wxSocketBase *socket = _server->Accept(false);
+	IPaddress address;
+	address.Hostname(wxString(inet_ntoa(addr.sin_addr)));
+	address.Service(ntohs(addr.sin_port));
+
+	auto connection = std::make_shared<HttpConnection>(this, socket, address);
+	{
+		std::unique_lock<std::mutex> lock(_connectionsLock);
+		_connections[socket] = connection;
+	}
+	_poller->Add(socket);
 
-    if (socket)
-    {
 #ifdef DETAILED_LOGGING
-        logger_base.info("created socket client (socket %d)", socket->GetSocket());
+	static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+	logger_base.info("created socket client (socket %d)", (int)socket);
 #endif
 
-        HttpConnection *connection = nullptr;
+	return true;
+}
 
-        if (event.GetSocketEvent() == wxSOCKET_CONNECTION)
-        {
-            connection = new HttpConnection(this, socket);
-            _connections[socket] = connection;
-        }
-        else
-            connection = _connections[socket];
+void HttpServer::CloseConnection(HttpSocket socket)
+{
+	HttpConnectionPtr connection;
+	{
+		std::unique_lock<std::mutex> lock(_connectionsLock);
+		auto it = _connections.find(socket);
+		if (it == _connections.end())
+			return;
+		connection = it->second;
+		_connections.erase(it);
+	}
 
-        wxASSERT(connection != nullptr);
+	_poller->Remove(socket);
 
-        socket->SetEventHandler(*this, SOCKET_ID);
-        socket->SetNotify(wxSOCKET_INPUT_FLAG | wxSOCKET_LOST_FLAG);
-        socket->Notify(true);
-    }
-    else
-    {
-#ifdef DETAILED_LOGGING
-        logger_base.info("error, impossible to accept a new connection");
-#endif
-    }
+	// the main thread may still hold a reference ... it will just see a closed connection
+	connection->Shutdown();
 
 #ifdef DETAILED_LOGGING
-    logger_base.info("OnServerEvent Time %ld.", sw.Time());
+	static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+	logger_base.info("deleted socket client (socket %d)", (int)socket);
 #endif
 }
 
-void HttpServer::OnSocketEvent(wxSocketEvent& event)
+void HttpServer::Run()
 {
     static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
-    wxStopWatch sw;
+	logger_base.debug("Web server thread running.");
+
+	std::vector<HttpPoller::Event> events;
+	std::vector<HttpConnectionPtr> connections;
+	wxLongLong lastIdleCheck = wxGetLocalTimeMillis();
 
-	switch(event.GetSocketEvent())
+	while (!_stop)
 	{
-	case wxSOCKET_INPUT:
-#ifdef DETAILED_LOGGING
-        logger_base.info("OnSocketEvent: wxSOCKET_INPUT");
-#endif
-		break;
-	case wxSOCKET_LOST:
-#ifdef DETAILED_LOGGING
-        logger_base.info("OnSocketEvent: wxSOCKET_LOST");
-#endif
-		break;
-	default:
-#ifdef DETAILED_LOGGING
-        logger_base.info("OnServerEvent: unexpected event %d", event.GetSocketEvent());
+		// without a wake socket fall back to a short poll so queued output still goes out
+		_poller->Wait(_wakeSocket == INVALID_HTTPSOCKET ? 20 : 1000, events);
+
+		for (const auto &e : events)
+		{
+			if (e.socket == _server)
+			{
+				while (Accept()) { }
+				continue;
+			}
+
+			if (e.socket == _wakeSocket)
+			{
+				char buffer[64];
+#ifdef __linux__
+				while (read(_wakeSocket, buffer, sizeof(uint64_t)) > 0) { }
+#else
+				while (recv(_wakeSocket, buffer, sizeof(buffer), 0) > 0) { }
 #endif
-		break;
+				continue;
+			}
+
+			HttpConnectionPtr connection;
+			{
+				std::unique_lock<std::mutex> lock(_connectionsLock);
+				auto it = _connections.find(e.socket);
+				if (it != _connections.end())
+					connection = it->second;
+			}
+			if (connection == nullptr)
+				continue;
+
+			bool ok = !e.error || e.readable;
+			if (ok && e.readable)
+				ok = connection->OnReadable();
+			if (ok && e.writable)
+				ok = connection->OnWritable();
+			if (!ok)
+				CloseConnection(e.socket);
+		}
+
+		// now look after every connection ... other threads may have queued output, closed it or answered a request
+		connections.clear();
+		{
+			std::unique_lock<std::mutex> lock(_connectionsLock);
+			for (const auto &it : _connections)
+				connections.push_back(it.second);
+		}
+
+		wxLongLong now = wxGetLocalTimeMillis();
+		bool checkIdle = now - lastIdleCheck > 1000;
+		if (checkIdle)
+			lastIdleCheck = now;
+
+		for (const auto &connection : connections)
+		{
+			HttpSocket socket = connection->Socket();
+
+			if (connection->_closed || (checkIdle && connection->IsIdle(now)))
+			{
+				CloseConnection(socket);
+				continue;
+			}
+
+			// pick up requests that were held back while the previous one was being answered
+			if (!connection->_isWebSocket && !connection->_awaitingResponse && connection->_input.GetDataLen() > 0)
+			{
+				if (!connection->ProcessInput())
+				{
+					CloseConnection(socket);
+					continue;
+				}
+			}
+
+			if (!connection->OnWritable())
+			{
+				CloseConnection(socket);
+				continue;
+			}
+
+			_poller->SetWriteInterest(socket, connection->HasPendingOutput());
+		}
 	}
 
-	wxSocketBase *socket = event.GetSocket();
+	logger_base.debug("Web server thread exiting.");
+}
+
+bool HttpServer::TryServeCached(HttpConnection &connection, HttpRequest &request)
+{
+	std::string content;
+	wxString mimeType;
+	{
+		std::unique_lock<std::mutex> lock(_contentLock);
+		if (_cachedResponses.empty())
+			return false;
+
+		auto it = _cachedResponses.find(request.URI().Lower());
+		if (it == _cachedResponses.end())
+			return false;
+
+		content = it->second.first;
+		mimeType = it->second.second;
+	}
 
-	HttpConnection *connection = _connections[socket];
-	wxASSERT(connection != NULL);
+	HttpResponse response(connection, request, HttpStatus::OK);
+	response.MakeFromData(content.data(), content.size(), mimeType + "; utf-8", true);
+	connection.SendResponse(response);
 
-	// Now we process the event
-	switch(event.GetSocketEvent())
+	return true;
+}
+
+bool HttpServer::TryServeStatic(HttpConnection &connection, HttpRequest &request)
+{
+	wxString prefix;
+	wxString directory;
 	{
-	case wxSOCKET_INPUT:
-		{
-			// We disable input events, so that the test doesn't trigger wxSocketEvent again.
-			socket->SetNotify(wxSOCKET_LOST_FLAG);
-			socket->SetFlags(wxSOCKET_NOWAIT);
+		std::unique_lock<std::mutex> lock(_contentLock);
+		prefix = _staticPrefix;
+		directory = _staticDirectory;
+	}
 
-			connection->HandleRequest();
+	if (prefix.IsEmpty() || !request.URI().StartsWith(prefix))
+		return false;
 
-			// Enable input events again.
-			socket->SetNotify(wxSOCKET_LOST_FLAG | wxSOCKET_INPUT_FLAG);
-			break;
-		}
-	case wxSOCKET_LOST:
-		{
-			_connections.erase(_connections.find(socket));
-			delete connection;
+	wxString uri = wxURI(request.URI()).BuildUnescapedURI();
+	if (uri.Contains("?"))
+		uri = uri.BeforeFirst('?');
+
+	// directory indexes and anything trying to climb out of the directory go to the application
+	if (uri.Contains("..") || uri.EndsWith("/") || uri == prefix)
+		return false;
+
+	wxString file = directory + uri;
 
-			// Destroy() should be used instead of delete wherever possible, due to the fact that wxSocket uses 'delayed events'
-			// (see the documentation for wxPostEvent) and we don't want an event to arrive to the event handler (the frame,
-			// here) after the socket has been deleted. Also, we might be doing some other thing with the socket at the same
-			// time; for example, we might be in the middle of a test or something. Destroy() takes care of all this for us.
 #ifdef DETAILED_LOGGING
-            logger_base.info("deleted socket client (socket %d)", socket->GetSocket());
+	static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+	logger_base.info("Static file request = '%s' : '%s'.", (const char *)file.c_str(), (const char *)uri.c_str());
 #endif
-			socket->Destroy();
-			break;
+
+	HttpResponse response(connection, request, file);
+	connection.SendResponse(response);
+
+	return true;
+}
+
+void HttpServer::DispatchRequest(HttpConnection &connection, HttpRequest &request)
+{
+	HttpConnectionPtr ptr = connection.shared_from_this();
+	CallAfter([this, ptr, request]() mutable { HandleRequest(ptr, request); });
+}
+
+void HttpServer::DispatchMessage(HttpConnection &connection, WebSocketMessage *message)
+{
+	HttpConnectionPtr ptr = connection.shared_from_this();
+	std::shared_ptr<WebSocketMessage> msg(message);
+	CallAfter([this, ptr, msg]() { HandleMessage(ptr, *msg); });
+}
+
+void HttpServer::HandleRequest(HttpConnectionPtr connection, HttpRequest &request)
+{
+    static log4cpp::Category &logger_base = log4cpp::Category::getInstance(std::string("log_base"));
+	wxStopWatch sw;
+
+	if (!connection->IsOpen())
+		return;
+
+	bool handled = false;
+	if (_context.RequestHandler)
+		handled = _context.RequestHandler(*connection, request);
+
+	if (handled)
+	{
+		// the handler claimed it but never answered so dont leave the client waiting
+		if (connection->_awaitingResponse)
+		{
+			logger_base.warn("Request handler did not respond to %s.", (const char *)request.URI().c_str());
+			HttpResponse response(*connection, request, HttpStatus::InternalServerError);
+			connection->SendResponse(response);
 		}
-    default:
-        break;
+		return;
+	}
+
+	// the handler may have answered even if it says it didnt
+	if (!connection->_awaitingResponse)
+		return;
+
+	if (request.Method() == "GET")
+	{
+		wxString fileName(_context.DefaultDirectory);
+		fileName += wxFILE_SEP_PATH;
+
+		if (request.URI() == "/")
+		{
+			for (size_t i = 0; i < _context.DefaultDocuments.Count(); i++)
+			{
+				if (wxFileName::FileExists(fileName + _context.DefaultDocuments[i]))
+				{
+					fileName += _context.DefaultDocuments[i];
+					break;
+				}
+			}
+		}
+		else
+			fileName += request.URI().Mid(1);
+
+		HttpResponse response(*connection, request, fileName);
+		connection->SendResponse(response);
+	}
+	else
+	{
+		HttpResponse response(*connection, request, HttpStatus::NotFound);
+		connection->SendResponse(response);
 	}
 
 #ifdef DETAILED_LOGGING
-    logger_base.info("OnSocketEvent Time %ld.", sw.Time());
+    logger_base.info("HandleRequest Time %ld.", sw.Time());
 #endif
 }
+
+void HttpServer::HandleMessage(HttpConnectionPtr connection, WebSocketMessage &message)
+{
+	if (!connection->IsOpen())
+		return;
+
+	if (_context.MessageHandler)
+		_context.MessageHandler(*connection, message);
+}
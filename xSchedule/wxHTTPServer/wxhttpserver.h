@@ -23,6 +23,14 @@
 #include <wx/socket.h>
 #include <wx/dynarray.h>
 #include <wx/hash.h>
+#include <wx/thread.h>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 
 #define SERVER_NAME    "xLights Web Server"
 #define SERVER_VERSION "1.0"
@@ -34,6 +42,13 @@
 	typedef wxIPV4address IPaddress;
 #endif // wxUSE_IPV6
 
+// native socket handle used by the server event loop
+#ifdef __WXMSW__
+	typedef wxUIntPtr HttpSocket;
+#else
+	typedef int HttpSocket;
+#endif
+
 WX_DECLARE_STRING_HASH_MAP(wxString, wxHashString);
 
 // Forward declarations
@@ -45,6 +60,8 @@ class HttpConnection;
 class HttpRequest;
 class HttpResponse;
 class WebSocketMessage;
+class HttpServerThread;
+class HttpPoller;
 
 typedef bool (*RequestHandlerPtr)(HttpConnection &connection, HttpRequest &request);
 typedef void (*MessageHandlerPtr)(HttpConnection &connection, WebSocketMessage &message);
@@ -61,6 +78,10 @@ public:
 	wxString      DefaultDirectory;
 	// list of predefined documents
 	wxArrayString DefaultDocuments;
+	// seconds an idle keep-alive connection is held open
+	int           KeepAliveTimeout;
+	// largest request (headers + body) accepted before answering 413
+	size_t        MaxRequestSize;
 
 	// overridables
 	RequestHandlerPtr RequestHandler;
@@ -193,39 +214,59 @@ public:
 };
 
 // Connection class
-class /* WXDLLIMPEXP_BASE */ HttpConnection
+//
+// All socket I/O happens on the server thread. SendResponse/SendMessage may be called from any thread;
+// the data is queued on the connection and written out by the server thread.
+class /* WXDLLIMPEXP_BASE */ HttpConnection : public std::enable_shared_from_this<HttpConnection>
 {
 public:
-	HttpConnection(HttpServer *server, wxSocketBase *socket);
+	HttpConnection(HttpServer *server, HttpSocket socket, const IPaddress &address);
 	virtual ~HttpConnection();
 
-	virtual bool HandleRequest();
 	virtual bool SendResponse(HttpResponse &response);
 	virtual bool SendMessage(WebSocketMessage &message);
 	virtual bool Close();
 
 	// properties
-	inline bool IsOpen() { return (_socket && _socket->IsOk()); }
+	inline bool IsOpen() const { return !_closed; }
 	inline const HttpServer *Server() const { return _server; }
-	inline const wxSocketBase *Socket() const { return _socket; }
+	inline HttpSocket Socket() const { return _socket; }
 	inline const IPaddress &Address() { return _address; }
-	inline bool IsWebSocket() { return _isWebSocket; }
+	inline bool IsWebSocket() const { return _isWebSocket; }
 
 protected:
-	void ParseRequest(const wxString &content);
-	bool ParseFrame(wxMemoryBuffer &buffer);
+	// these are only called by the server thread
+	bool OnReadable();
+	bool OnWritable();
+	bool HasPendingOutput();
+	bool IsIdle(wxLongLong now) const;
+	bool ProcessInput();
+	bool ProcessRequest(HttpRequest &request);
+	bool ParseFrame(size_t &consumed);
 	bool WebSocketHandshake(HttpRequest &request);
+	bool QueueOutput(const void *data, size_t length, bool closeAfter = false);
+	void Shutdown();
 
 protected:
 	HttpServer       *_server;
-	wxSocketBase     *_socket;
+	HttpSocket        _socket;
 	IPaddress         _address;
-	bool              _isWebSocket;
+	std::atomic<bool> _isWebSocket;
+	std::atomic<bool> _closed;
+	std::atomic<bool> _awaitingResponse; // a request is with the request handler and input parsing is paused
 	WebSocketMessage *_message;
+	wxMemoryBuffer    _input;
+	wxLongLong        _lastActivity;
+
+	std::mutex        _outputLock;
+	std::string       _output;
+	size_t            _outputPos;
+	bool              _closeAfterWrite;
+
+	friend class HttpServer;
 };
 
-//WX_DECLARE_EXPORTED_HASH_MAP(wxSocketBase *, HttpConnection *, wxPointerHash, wxPointerEqual, ConnectionMap);
-WX_DECLARE_HASH_MAP(wxSocketBase *, HttpConnection *, wxPointerHash, wxPointerEqual, ConnectionMap);
+typedef std::shared_ptr<HttpConnection> HttpConnectionPtr;
 
 // HTTP request
 class /* WXDLLIMPEXP_BASE */ HttpRequest
@@ -252,6 +293,10 @@ public:
 	inline wxString Host() const { return _headers["Host"]; }
 	// client type identification: browser, producer, version...
     inline wxString UserAgent() const { return _headers["User-Agent"]; }
+	// true if the client wants the connection held open after the response
+	bool KeepAlive() const;
+	// true if the client will accept a gzip encoded response
+	bool AcceptsGzip() const;
 
 	inline wxString operator[](int index) const { return _headers[index]; }
 	inline wxString operator[](const wxString &key) const { return _headers[key]; }
@@ -281,6 +326,8 @@ public:
 	virtual void MakeFromText(const wxString &text, const wxString &mimeType = "text/html");
 	// make a response from status code (useful for server errors)
 	virtual void MakeFromCode(HttpStatus::HttpStatusCode code = HttpStatus::NotFound);
+	// make a response from bytes already in memory, gzip encoding them if the client accepts it
+	virtual void MakeFromData(const void *data, size_t length, const wxString &mimeType, bool compressible);
 
 	// properties
 
@@ -308,10 +355,16 @@ protected:
 	wxMemoryBuffer  _content;
 	HttpHeaders     _headers;
 
+	void AddStandardHeaders(const wxString &contentType);
+
 	friend class HttpConnection;
 };
 
 // Server main class
+//
+// The listening socket and all connections are serviced by an event loop on a dedicated thread (epoll on Linux,
+// poll elsewhere, WSAPoll on Windows). Requests that need the application (RequestHandler/MessageHandler) are handed to the main
+// thread one at a time per connection; static content and cached responses are answered on the server thread.
 class /* WXDLLIMPEXP_BASE */ HttpServer : public wxEvtHandler
 {
 public:
@@ -321,24 +374,54 @@ public:
 	bool Start(const HttpContext &context);
 	bool Stop();
 
+	// serve files under uriPrefix from directory on the server thread ... an empty prefix disables it
+	void SetStaticContent(const wxString &uriPrefix, const wxString &directory);
+	// answer GET requests for exactly this uri from the server thread with the given content
+	void SetCachedResponse(const wxString &uri, const wxString &content, const wxString &mimeType = "application/json");
+	void ClearCachedResponse(const wxString &uri);
+
+	// snapshot of the currently open web socket connections
+	std::list<HttpConnectionPtr> GetWebSockets() const;
+	bool HasWebSockets() const;
+
 	// properties
 
 	inline const HttpContext &Context() const { return _context; }
 
 protected:
-	// event handlers (these functions should _not_ be virtual)
-	void OnServerEvent(wxSocketEvent &event);
-	void OnSocketEvent(wxSocketEvent &event);
-    ConnectionMap   _connections;
+	// server thread
+	void Run();
+	void Wake();
+	bool Accept();
+	void CloseConnection(HttpSocket socket);
+	bool TryServeStatic(HttpConnection &connection, HttpRequest &request);
+	bool TryServeCached(HttpConnection &connection, HttpRequest &request);
+	void DispatchRequest(HttpConnection &connection, HttpRequest &request);
+	void DispatchMessage(HttpConnection &connection, WebSocketMessage *message);
+
+	// main thread
+	void HandleRequest(HttpConnectionPtr connection, HttpRequest &request);
+	void HandleMessage(HttpConnectionPtr connection, WebSocketMessage &message);
 
 private:
-	wxSocketServer *_server;
-	HttpContext     _context;
-	IPaddress       _address;
-
-	DECLARE_EVENT_TABLE()
+	HttpSocket         _server;
+	HttpSocket         _wakeSocket;
+	HttpContext        _context;
+	IPaddress          _address;
+	HttpServerThread  *_thread;
+	HttpPoller        *_poller;
+	std::atomic<bool>  _stop;
+
+	mutable std::mutex _connectionsLock;
+	std::map<HttpSocket, HttpConnectionPtr> _connections;
+
+	std::mutex         _contentLock;
+	wxString           _staticPrefix;
+	wxString           _staticDirectory;
+	std::map<wxString, std::pair<std::string, wxString>> _cachedResponses;
 
 	friend class HttpConnection;
+	friend class HttpServerThread;
 };
 
 // Complete WebSocket message (framing is managed by server)
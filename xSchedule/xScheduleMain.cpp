@@ -2585,11 +2585,12 @@ void xScheduleFrame::OnMenuItem_TestSelected(wxCommandEvent& event)
 
 void xScheduleFrame::OnMenuItem_EditFPPRemotesSelected(wxCommandEvent& event)
 {
-    FPPRemotesDialog dlg(this, __schedule->GetOptions()->GetFPPRemotes());
+    FPPRemotesDialog dlg(this, __schedule->GetOptions()->GetFPPRemotes(), __schedule->GetOptions()->GetFPPRemoteLatencies());
 
     dlg.ShowModal();
 
     __schedule->GetOptions()->SetFPPRemotes(dlg.GetRemotes());
+    __schedule->GetOptions()->SetFPPRemoteLatencies(dlg.GetLatencies());
 
     UIToMode();
 
@@ -3251,14 +3252,15 @@ void xScheduleFrame::SendStatus()
 
         if (_webServer != nullptr)
         {
-            if (_webServer->IsSomeoneListening())
+            if (__schedule->IsXyzzy() && _webServer->IsSomeoneListening())
             {
-                if (__schedule->IsXyzzy())
-                {
-                    __schedule->DoXyzzy("q", "", result, "");
-                }
-
-                _webServer->SendMessageToAllWebSockets(result);
+                wxString xyzzy;
+                __schedule->DoXyzzy("q", "", xyzzy, "");
+                _webServer->SendMessageToAllWebSockets(xyzzy);
+            }
+            else
+            {
+                _webServer->PublishStatus(result);
             }
         }
 